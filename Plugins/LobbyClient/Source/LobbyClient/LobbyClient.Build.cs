@@ -1,5 +1,6 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
+using System.IO;
 using UnrealBuildTool;
 
 public class LobbyClient : ModuleRules
@@ -11,6 +12,7 @@ public class LobbyClient : ModuleRules
 		PublicIncludePaths.AddRange(
 			new string[] {
 				// ... add public include paths required here ...
+				Path.Combine(ModuleDirectory, "LobbyGameInstanceSubsystem")
 			}
 			);
 				
@@ -42,10 +44,13 @@ public class LobbyClient : ModuleRules
 				"WebSockets", 
 				"OpenSSL", 
 				"Json", 
-				"JsonUtilities"
+				"JsonUtilities",
+				"UMG"
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);
+
+		AddEngineThirdPartyPrivateStaticDependencies(Target, "zlib");
 		
 		
 		DynamicallyLoadedModuleNames.AddRange(
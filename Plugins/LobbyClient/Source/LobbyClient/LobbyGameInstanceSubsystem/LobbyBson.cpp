@@ -0,0 +1,571 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LobbyBson.h"
+#include "LobbyJsonWriter.h"
+#include "Misc/Base64.h"
+#include "Serialization/JsonReader.h"
+
+namespace
+{
+	template <typename ValueType>
+	ValueType ReadValue(const UTF8CHAR* NewData)
+	{
+		ValueType R_Value;
+		FMemory::Memcpy(&R_Value, NewData, sizeof(ValueType));
+		return R_Value;
+	}
+
+	/**
+	 * Bytes of a value of NewType at NewData, INDEX_NONE if it does not fit NewRemaining or the type is unknown
+	 */
+	int32 GetValueSize(uint8 NewType, const UTF8CHAR* NewData, int32 NewRemaining)
+	{
+		int32 R_Size = INDEX_NONE;
+		switch (NewType)
+		{
+		case NGG_LOBBY_BSON::DOUBLE:
+		case NGG_LOBBY_BSON::DATE_TIME:
+		case NGG_LOBBY_BSON::TIMESTAMP:
+		case NGG_LOBBY_BSON::INT64:
+			R_Size = 8;
+			break;
+
+		case NGG_LOBBY_BSON::STRING:
+			if (NewRemaining >= 4)
+			{
+				const int32 Length = ReadValue<int32>(NewData);
+				R_Size = Length >= 1 && Length <= NewRemaining - 4 ? 4 + Length : INDEX_NONE;
+			}
+			break;
+
+		case NGG_LOBBY_BSON::DOCUMENT:
+		case NGG_LOBBY_BSON::ARRAY:
+			if (NewRemaining >= 4)
+			{
+				R_Size = ReadValue<int32>(NewData);
+			}
+			break;
+
+		case NGG_LOBBY_BSON::BINARY:
+			if (NewRemaining >= 4)
+			{
+				const int32 Length = ReadValue<int32>(NewData);
+				R_Size = Length >= 0 && Length <= NewRemaining - 5 ? 5 + Length : INDEX_NONE;
+			}
+			break;
+
+		case NGG_LOBBY_BSON::OBJECT_ID:
+			R_Size = 12;
+			break;
+
+		case NGG_LOBBY_BSON::BOOL:
+			R_Size = 1;
+			break;
+
+		case NGG_LOBBY_BSON::NULL_VALUE:
+			R_Size = 0;
+			break;
+
+		case NGG_LOBBY_BSON::INT32:
+			R_Size = 4;
+			break;
+
+		case NGG_LOBBY_BSON::DECIMAL128:
+			R_Size = 16;
+			break;
+
+		default:
+			break;
+		}
+		return R_Size >= 0 && R_Size <= NewRemaining ? R_Size : INDEX_NONE;
+	}
+}
+
+FLobbyBsonWriter::FLobbyBsonWriter(TArray<UTF8CHAR>& NewBuffer)
+	: Buffer(NewBuffer)
+{
+}
+
+void FLobbyBsonWriter::BeginObject()
+{
+	if (Scopes.Num() > 0)
+	{
+		BeginElement(NGG_LOBBY_BSON::DOCUMENT);
+	}
+	BeginScope(false);
+}
+
+void FLobbyBsonWriter::EndObject()
+{
+	check(Scopes.Num() > 0 && !Scopes.Last().bArray);
+	EndScope();
+}
+
+void FLobbyBsonWriter::BeginArray()
+{
+	// The root of a BSON value is always a document
+	check(Scopes.Num() > 0);
+	BeginElement(NGG_LOBBY_BSON::ARRAY);
+	BeginScope(true);
+}
+
+void FLobbyBsonWriter::EndArray()
+{
+	check(Scopes.Num() > 0 && Scopes.Last().bArray);
+	EndScope();
+}
+
+void FLobbyBsonWriter::WriteKey(FAnsiStringView NewKey)
+{
+	check(Scopes.Num() > 0 && !Scopes.Last().bArray && !bHasKey);
+	PendingKey.Reset();
+	PendingKey.Append(reinterpret_cast<const UTF8CHAR*>(NewKey.GetData()), NewKey.Len());
+	bHasKey = true;
+}
+
+void FLobbyBsonWriter::WriteString(FStringView NewValue)
+{
+	BeginElement(NGG_LOBBY_BSON::STRING);
+
+	// Transcoded straight into the buffer behind the length
+	const int32 LengthOffset = Buffer.Num();
+	Put<int32>(0);
+	const int32 Length = FPlatformString::ConvertedLength<UTF8CHAR>(NewValue.GetData(), NewValue.Len());
+	const int32 Start = Buffer.Num();
+	Buffer.AddUninitialized(Length);
+	FPlatformString::Convert(Buffer.GetData() + Start, Length, NewValue.GetData(), NewValue.Len());
+	Buffer.Add(UTF8CHAR(0));
+
+	const int32 LengthWithTerminator = Length + 1;
+	FMemory::Memcpy(Buffer.GetData() + LengthOffset, &LengthWithTerminator, sizeof(int32));
+}
+
+void FLobbyBsonWriter::WriteString(FUtf8StringView NewValue)
+{
+	BeginElement(NGG_LOBBY_BSON::STRING);
+	Put<int32>(NewValue.Len() + 1);
+	Buffer.Append(NewValue.GetData(), NewValue.Len());
+	Buffer.Add(UTF8CHAR(0));
+}
+
+void FLobbyBsonWriter::WriteNull()
+{
+	BeginElement(NGG_LOBBY_BSON::NULL_VALUE);
+}
+
+void FLobbyBsonWriter::WriteBool(bool bNewValue)
+{
+	BeginElement(NGG_LOBBY_BSON::BOOL);
+	Put<uint8>(bNewValue ? 1 : 0);
+}
+
+void FLobbyBsonWriter::WriteInt(int64 NewValue)
+{
+	if (NewValue >= MIN_int32 && NewValue <= MAX_int32)
+	{
+		BeginElement(NGG_LOBBY_BSON::INT32);
+		Put<int32>(static_cast<int32>(NewValue));
+	}
+	else
+	{
+		BeginElement(NGG_LOBBY_BSON::INT64);
+		Put<int64>(NewValue);
+	}
+}
+
+void FLobbyBsonWriter::WriteDouble(double NewValue)
+{
+	BeginElement(NGG_LOBBY_BSON::DOUBLE);
+	Put<double>(NewValue);
+}
+
+void FLobbyBsonWriter::WriteDocument(FUtf8StringView NewDocument)
+{
+	checkSlow(FLobbyBsonView::IsValid(NewDocument));
+	BeginElement(NGG_LOBBY_BSON::DOCUMENT);
+	Buffer.Append(NewDocument.GetData(), NewDocument.Len());
+}
+
+bool FLobbyBsonWriter::WriteJson(FStringView NewJson)
+{
+	// Everything is rolled back if the text turns out not to be JSON
+	const int32 BufferMark = Buffer.Num();
+	const int32 ScopeMark = Scopes.Num();
+	const FScope SavedScope = ScopeMark > 0 ? Scopes.Last() : FScope();
+	const TArray<UTF8CHAR, TInlineAllocator<64>> SavedKey = PendingKey;
+	const bool bHadKey = bHasKey;
+
+	TSharedRef<TJsonReader<TCHAR>> Reader = TJsonReaderFactory<TCHAR>::CreateFromView(NewJson);
+	EJsonNotation Notation = EJsonNotation::Error;
+	int32 Depth = 0;
+	bool bValid = true;
+	while (bValid && Reader->ReadNext(Notation))
+	{
+		const bool bClosing = Notation == EJsonNotation::ObjectEnd || Notation == EJsonNotation::ArrayEnd;
+		if (Depth > 0 && !bClosing && !Scopes.Last().bArray)
+		{
+			bValid = SetKey(Reader->GetIdentifier());
+		}
+		else if (Depth == 0 && ScopeMark == 0 && Notation != EJsonNotation::ObjectStart)
+		{
+			// A scalar or an array can not be the root document
+			bValid = false;
+		}
+		if (!bValid)
+		{
+			break;
+		}
+
+		switch (Notation)
+		{
+		case EJsonNotation::ObjectStart:
+			BeginObject();
+			++Depth;
+			break;
+
+		case EJsonNotation::ArrayStart:
+			BeginArray();
+			++Depth;
+			break;
+
+		case EJsonNotation::ObjectEnd:
+			EndObject();
+			--Depth;
+			break;
+
+		case EJsonNotation::ArrayEnd:
+			EndArray();
+			--Depth;
+			break;
+
+		case EJsonNotation::String:
+			WriteString(FStringView(Reader->GetValueAsString()));
+			break;
+
+		case EJsonNotation::Number:
+			WriteNumber(Reader->GetValueAsNumberString(), Reader->GetValueAsNumber());
+			break;
+
+		case EJsonNotation::Boolean:
+			WriteBool(Reader->GetValueAsBoolean());
+			break;
+
+		case EJsonNotation::Null:
+			WriteNull();
+			break;
+
+		default:
+			bValid = false;
+			break;
+		}
+	}
+
+	if (bValid && Depth == 0 && Reader->GetErrorMessage().IsEmpty() && Buffer.Num() > BufferMark)
+	{
+		return true;
+	}
+
+	Buffer.SetNum(BufferMark, EAllowShrinking::No);
+	Scopes.SetNum(ScopeMark, EAllowShrinking::No);
+	if (ScopeMark > 0)
+	{
+		Scopes.Last() = SavedScope;
+	}
+	PendingKey = SavedKey;
+	bHasKey = bHadKey;
+	return false;
+}
+
+void FLobbyBsonWriter::BeginElement(uint8 NewType)
+{
+	check(Scopes.Num() > 0);
+	Buffer.Add(static_cast<UTF8CHAR>(NewType));
+
+	FScope& Scope = Scopes.Last();
+	if (Scope.bArray)
+	{
+		ANSICHAR Digits[16];
+		const int32 Length = FCStringAnsi::Snprintf(Digits, UE_ARRAY_COUNT(Digits), "%d", Scope.NextIndex++);
+		Buffer.Append(reinterpret_cast<const UTF8CHAR*>(Digits), Length);
+	}
+	else
+	{
+		check(bHasKey);
+		Buffer.Append(PendingKey);
+		bHasKey = false;
+	}
+	Buffer.Add(UTF8CHAR(0));
+}
+
+void FLobbyBsonWriter::BeginScope(bool bNewArray)
+{
+	FScope& Scope = Scopes.AddDefaulted_GetRef();
+	Scope.Start = Buffer.Num();
+	Scope.bArray = bNewArray;
+	Put<int32>(0);
+}
+
+void FLobbyBsonWriter::EndScope()
+{
+	Buffer.Add(UTF8CHAR(0));
+	const int32 Start = Scopes.Pop(EAllowShrinking::No).Start;
+	const int32 Length = Buffer.Num() - Start;
+	FMemory::Memcpy(Buffer.GetData() + Start, &Length, sizeof(int32));
+}
+
+bool FLobbyBsonWriter::SetKey(FStringView NewKey)
+{
+	FTCHARToUTF8 Key(NewKey.GetData(), NewKey.Len());
+	const FUtf8StringView KeyView(reinterpret_cast<const UTF8CHAR*>(Key.Get()), Key.Length());
+	// Keys are C strings in BSON
+	int32 Unused;
+	if (KeyView.FindChar(UTF8CHAR(0), Unused))
+	{
+		return false;
+	}
+
+	PendingKey.Reset();
+	PendingKey.Append(KeyView.GetData(), KeyView.Len());
+	bHasKey = true;
+	return true;
+}
+
+void FLobbyBsonWriter::WriteNumber(const FString& NewNumber, double NewValue)
+{
+	// Integers keep every digit, int64 past 2^53 would not survive the double
+	int32 Unused;
+	const bool bFraction = NewNumber.FindChar(TEXT('.'), Unused) || NewNumber.FindChar(TEXT('e'), Unused) || NewNumber.FindChar(TEXT('E'), Unused);
+	if (!bFraction && NewNumber.Len() <= 18)
+	{
+		WriteInt(FCString::Atoi64(*NewNumber));
+	}
+	else
+	{
+		WriteDouble(NewValue);
+	}
+}
+
+FUtf8StringView FLobbyBsonView::FElement::AsString() const
+{
+	return Type == NGG_LOBBY_BSON::STRING ? Value.Mid(4, Value.Len() - 5) : FUtf8StringView();
+}
+
+int64 FLobbyBsonView::FElement::AsInt() const
+{
+	switch (Type)
+	{
+	case NGG_LOBBY_BSON::INT32:		return ReadValue<int32>(Value.GetData());
+	case NGG_LOBBY_BSON::INT64:
+	case NGG_LOBBY_BSON::DATE_TIME:	return ReadValue<int64>(Value.GetData());
+	case NGG_LOBBY_BSON::DOUBLE:	return static_cast<int64>(ReadValue<double>(Value.GetData()));
+	case NGG_LOBBY_BSON::BOOL:		return static_cast<uint8>(Value[0]) != 0 ? 1 : 0;
+	default:						return 0;
+	}
+}
+
+double FLobbyBsonView::FElement::AsDouble() const
+{
+	return Type == NGG_LOBBY_BSON::DOUBLE ? ReadValue<double>(Value.GetData()) : static_cast<double>(AsInt());
+}
+
+FLobbyBsonView FLobbyBsonView::FElement::AsDocument() const
+{
+	return Type == NGG_LOBBY_BSON::DOCUMENT || Type == NGG_LOBBY_BSON::ARRAY ? FLobbyBsonView(Value) : FLobbyBsonView();
+}
+
+bool FLobbyBsonView::IsValid(FUtf8StringView NewDocument)
+{
+	return IsValid(NewDocument, 0);
+}
+
+bool FLobbyBsonView::IsValid(FUtf8StringView NewDocument, int32 NewDepth)
+{
+	const int32 Length = NewDocument.Len();
+	if (NewDepth > NGG_LOBBY_BSON::MAX_DEPTH || Length < 5 || ReadValue<int32>(NewDocument.GetData()) != Length || NewDocument[Length - 1] != UTF8CHAR(0))
+	{
+		return false;
+	}
+
+	const UTF8CHAR* Data = NewDocument.GetData();
+	int32 Cursor = 4;
+	while (Cursor < Length - 1)
+	{
+		const uint8 Type = static_cast<uint8>(Data[Cursor++]);
+		while (Cursor < Length - 1 && Data[Cursor] != UTF8CHAR(0))
+		{
+			++Cursor;
+		}
+		if (Cursor >= Length - 1)
+		{
+			return false;
+		}
+		++Cursor;
+
+		// The terminator of the document is not part of any value
+		const int32 Size = GetValueSize(Type, Data + Cursor, Length - 1 - Cursor);
+		if (Size == INDEX_NONE)
+		{
+			return false;
+		}
+		if (Type == NGG_LOBBY_BSON::STRING && Data[Cursor + Size - 1] != UTF8CHAR(0))
+		{
+			return false;
+		}
+		if ((Type == NGG_LOBBY_BSON::DOCUMENT || Type == NGG_LOBBY_BSON::ARRAY) && !IsValid(FUtf8StringView(Data + Cursor, Size), NewDepth + 1))
+		{
+			return false;
+		}
+		Cursor += Size;
+	}
+	return Cursor == Length - 1;
+}
+
+bool FLobbyBsonView::Next(int32& InOutOffset, FElement& OutElement) const
+{
+	const int32 Length = Document.Len();
+	int32 Cursor = FMath::Max(InOutOffset, 4);
+	if (Cursor >= Length - 1)
+	{
+		return false;
+	}
+
+	const UTF8CHAR* Data = Document.GetData();
+	OutElement.Type = static_cast<uint8>(Data[Cursor++]);
+	const int32 KeyStart = Cursor;
+	while (Data[Cursor] != UTF8CHAR(0))
+	{
+		++Cursor;
+	}
+	OutElement.Key = FUtf8StringView(Data + KeyStart, Cursor - KeyStart);
+	++Cursor;
+
+	const int32 Size = GetValueSize(OutElement.Type, Data + Cursor, Length - 1 - Cursor);
+	if (Size == INDEX_NONE)
+	{
+		return false;
+	}
+	OutElement.Value = FUtf8StringView(Data + Cursor, Size);
+	InOutOffset = Cursor + Size;
+	return true;
+}
+
+bool FLobbyBsonView::Find(FAnsiStringView NewKey, FElement& OutElement) const
+{
+	const FUtf8StringView Key(reinterpret_cast<const UTF8CHAR*>(NewKey.GetData()), NewKey.Len());
+	int32 Offset = 0;
+	while (Next(Offset, OutElement))
+	{
+		if (OutElement.Key.Equals(Key, ESearchCase::CaseSensitive))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void FLobbyBsonView::WriteJson(FLobbyJsonWriter& NewWriter, bool bNewArray) const
+{
+	if (bNewArray)
+	{
+		NewWriter.BeginArray();
+	}
+	else
+	{
+		NewWriter.BeginObject();
+	}
+
+	FElement Element;
+	int32 Offset = 0;
+	while (Next(Offset, Element))
+	{
+		if (!bNewArray)
+		{
+			NewWriter.WriteEscapedKey(Element.Key);
+		}
+		WriteJsonValue(NewWriter, Element);
+	}
+
+	if (bNewArray)
+	{
+		NewWriter.EndArray();
+	}
+	else
+	{
+		NewWriter.EndObject();
+	}
+}
+
+void FLobbyBsonView::WriteJsonValue(FLobbyJsonWriter& NewWriter, const FElement& NewElement)
+{
+	switch (NewElement.Type)
+	{
+	case NGG_LOBBY_BSON::DOUBLE:
+		NewWriter.WriteDouble(NewElement.AsDouble());
+		break;
+
+	case NGG_LOBBY_BSON::STRING:
+		NewWriter.WriteString(NewElement.AsString());
+		break;
+
+	case NGG_LOBBY_BSON::DOCUMENT:
+	case NGG_LOBBY_BSON::ARRAY:
+		NewElement.AsDocument().WriteJson(NewWriter, NewElement.Type == NGG_LOBBY_BSON::ARRAY);
+		break;
+
+	case NGG_LOBBY_BSON::BINARY:
+	{
+		const FUtf8StringView Bytes = NewElement.Value.Mid(5);
+		NewWriter.BeginObject();
+		NewWriter.WriteKey("$binary");
+		NewWriter.BeginObject();
+		NewWriter.WriteKey("base64");
+		NewWriter.WriteString(FBase64::Encode(reinterpret_cast<const uint8*>(Bytes.GetData()), Bytes.Len()));
+		NewWriter.WriteKey("subType");
+		NewWriter.WriteString(BytesToHex(reinterpret_cast<const uint8*>(NewElement.Value.GetData() + 4), 1).ToLower());
+		NewWriter.EndObject();
+		NewWriter.EndObject();
+		break;
+	}
+
+	case NGG_LOBBY_BSON::OBJECT_ID:
+		NewWriter.BeginObject();
+		NewWriter.WriteKey("$oid");
+		NewWriter.WriteString(BytesToHex(reinterpret_cast<const uint8*>(NewElement.Value.GetData()), 12).ToLower());
+		NewWriter.EndObject();
+		break;
+
+	case NGG_LOBBY_BSON::BOOL:
+		NewWriter.WriteBool(NewElement.AsBool());
+		break;
+
+	case NGG_LOBBY_BSON::DATE_TIME:
+		NewWriter.BeginObject();
+		NewWriter.WriteKey("$date");
+		NewWriter.WriteInt(NewElement.AsInt());
+		NewWriter.EndObject();
+		break;
+
+	case NGG_LOBBY_BSON::INT32:
+	case NGG_LOBBY_BSON::INT64:
+		NewWriter.WriteInt(NewElement.AsInt());
+		break;
+
+	case NGG_LOBBY_BSON::TIMESTAMP:
+		NewWriter.BeginObject();
+		NewWriter.WriteKey("$timestamp");
+		NewWriter.BeginObject();
+		NewWriter.WriteKey("t");
+		NewWriter.WriteInt(ReadValue<uint32>(NewElement.Value.GetData() + 4));
+		NewWriter.WriteKey("i");
+		NewWriter.WriteInt(ReadValue<uint32>(NewElement.Value.GetData()));
+		NewWriter.EndObject();
+		NewWriter.EndObject();
+		break;
+
+	default:
+		// Decimal128 has no JSON form here, read it from the BSON if it matters
+		NewWriter.WriteNull();
+		break;
+	}
+}
@@ -0,0 +1,213 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FLobbyJsonWriter;
+
+/**
+ * The BSON element types the lobby reads and writes, see bsonspec.org
+ */
+namespace NGG_LOBBY_BSON
+{
+	enum EType : uint8
+	{
+		  DOUBLE     = 0x01
+		, STRING     = 0x02
+		, DOCUMENT   = 0x03
+		, ARRAY      = 0x04
+		, BINARY     = 0x05
+		, OBJECT_ID  = 0x07
+		, BOOL       = 0x08
+		, DATE_TIME  = 0x09
+		, NULL_VALUE = 0x0A
+		, INT32      = 0x10
+		, TIMESTAMP  = 0x11
+		, INT64      = 0x12
+		, DECIMAL128 = 0x13
+	};
+
+	/**
+	 * Deeper documents are refused, so a hostile frame can not exhaust the stack
+	 */
+	const int32 MAX_DEPTH = 64;
+};
+
+/**
+ * Writes BSON straight into a caller owned buffer, the way FLobbyJsonWriter writes JSON.
+ * The buffer is a UTF8CHAR array so a BSON envelope goes through the send queues and the frame writer
+ * like a JSON one. Document lengths are reserved when a document opens and patched when it closes.
+ */
+class LOBBYCLIENT_API FLobbyBsonWriter
+{
+public:
+
+	explicit FLobbyBsonWriter(TArray<UTF8CHAR>& NewBuffer);
+
+	/**
+	 * The outermost call starts the root document, nested calls need a key first
+	 */
+	void BeginObject();
+
+	void EndObject();
+
+	void BeginArray();
+
+	void EndArray();
+
+	/**
+	 * Key of the next value, array elements are numbered on their own
+	 */
+	void WriteKey(FAnsiStringView NewKey);
+
+	void WriteString(FStringView NewValue);
+
+	void WriteString(FUtf8StringView NewValue);
+
+	void WriteNull();
+
+	void WriteBool(bool bNewValue);
+
+	/**
+	 * Written as int32 when it fits, otherwise as int64
+	 */
+	void WriteInt(int64 NewValue);
+
+	void WriteDouble(double NewValue);
+
+	/**
+	 * Copy a document that is already BSON as one embedded document
+	 */
+	void WriteDocument(FUtf8StringView NewDocument);
+
+	/**
+	 * Convert JSON text into the same value as BSON, without building a DOM. Returns false and writes
+	 * nothing if the text is not valid JSON, or is a scalar where the root document is expected.
+	 */
+	bool WriteJson(FStringView NewJson);
+
+private:
+
+	struct FScope
+	{
+		int32 Start = 0;
+		int32 NextIndex = 0;
+		bool bArray = false;
+	};
+
+	/**
+	 * Type byte and key of the next element
+	 */
+	void BeginElement(uint8 NewType);
+
+	void BeginScope(bool bNewArray);
+
+	void EndScope();
+
+	bool SetKey(FStringView NewKey);
+
+	void WriteNumber(const FString& NewNumber, double NewValue);
+
+	template <typename ValueType>
+	void Put(ValueType NewValue)
+	{
+		static_assert(PLATFORM_LITTLE_ENDIAN, "BSON is little endian");
+		Buffer.Append(reinterpret_cast<const UTF8CHAR*>(&NewValue), sizeof(ValueType));
+	}
+
+	TArray<UTF8CHAR>& Buffer;
+
+	TArray<FScope, TInlineAllocator<16>> Scopes;
+
+	/**
+	 * BSON writes the key after the type byte, so it waits here for the value
+	 */
+	TArray<UTF8CHAR, TInlineAllocator<64>> PendingKey;
+
+	bool bHasKey = false;
+};
+
+/**
+ * Non-owning view of one BSON document. Check a received document with IsValid once,
+ * after that the accessors trust the lengths inside it.
+ */
+class LOBBYCLIENT_API FLobbyBsonView
+{
+public:
+
+	struct FElement
+	{
+		uint8 Type = NGG_LOBBY_BSON::NULL_VALUE;
+
+		FUtf8StringView Key;
+
+		/**
+		 * The value bytes behind the key
+		 */
+		FUtf8StringView Value;
+
+		/**
+		 * Without the length and the terminator, empty for anything but a string
+		 */
+		FUtf8StringView AsString() const;
+
+		/**
+		 * Numbers, booleans and dates, 0 for anything else
+		 */
+		int64 AsInt() const;
+
+		double AsDouble() const;
+
+		bool AsBool() const { return AsInt() != 0; }
+
+		/**
+		 * Documents and arrays, an empty view for anything else
+		 */
+		FLobbyBsonView AsDocument() const;
+	};
+
+	FLobbyBsonView() = default;
+
+	explicit FLobbyBsonView(FUtf8StringView NewDocument)
+		: Document(NewDocument)
+	{
+	}
+
+	explicit FLobbyBsonView(TConstArrayView<uint8> NewDocument)
+		: Document(reinterpret_cast<const UTF8CHAR*>(NewDocument.GetData()), NewDocument.Num())
+	{
+	}
+
+	/**
+	 * Every length, terminator and nested document checked against the bytes
+	 */
+	static bool IsValid(FUtf8StringView NewDocument);
+
+	bool IsEmpty() const { return Document.Len() <= 5; }
+
+	/**
+	 * Step through the elements in order, InOutOffset starts at 0
+	 */
+	bool Next(int32& InOutOffset, FElement& OutElement) const;
+
+	bool Find(FAnsiStringView NewKey, FElement& OutElement) const;
+
+	/**
+	 * The document as relaxed extended JSON, as an array if bNewArray is set
+	 */
+	void WriteJson(FLobbyJsonWriter& NewWriter, bool bNewArray = false) const;
+
+	FUtf8StringView GetBytes() const { return Document; }
+
+	/**
+	 * One element value as relaxed extended JSON
+	 */
+	static void WriteJsonValue(FLobbyJsonWriter& NewWriter, const FElement& NewElement);
+
+private:
+
+	static bool IsValid(FUtf8StringView NewDocument, int32 NewDepth);
+
+	FUtf8StringView Document;
+};
@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LobbyBufferPool.h"
+
+FLobbyMessageArena::FMark::FMark()
+	: Arena(FLobbyMessageArena::Get())
+	, Used(Arena.Used)
+{
+}
+
+FLobbyMessageArena::FMark::~FMark()
+{
+	Arena.Rewind(Used);
+}
+
+TArray<UTF8CHAR>& FLobbyMessageArena::FMark::AcquireText()
+{
+	return Arena.AcquireText();
+}
+
+FLobbyMessageArena& FLobbyMessageArena::Get()
+{
+	static thread_local FLobbyMessageArena Arena;
+	return Arena;
+}
+
+TArray<UTF8CHAR>& FLobbyMessageArena::AcquireText()
+{
+	if (Used == Buffers.Num())
+	{
+		Buffers.Add(new TArray<UTF8CHAR>());
+	}
+	TArray<UTF8CHAR>& R_Text = Buffers[Used++];
+	R_Text.Reset();
+	return R_Text;
+}
+
+void FLobbyMessageArena::Rewind(int32 NewUsed)
+{
+	for (int32 Index = NewUsed; Index < Used; ++Index)
+	{
+		if (Buffers[Index].GetAllocatedSize() > MAX_RETAINED_BYTES)
+		{
+			Buffers[Index].Empty();
+		}
+	}
+	Used = NewUsed;
+}
+
+FLobbyAllocationCounter::FLobbyAllocationCounter(int64& InOutAllocations)
+	: Allocations(InOutAllocations)
+	, TotalBefore(GetTotal())
+{
+}
+
+FLobbyAllocationCounter::~FLobbyAllocationCounter()
+{
+	Allocations += static_cast<int64>(GetTotal() - TotalBefore);
+}
+
+uint64 FLobbyAllocationCounter::GetTotal()
+{
+#if !UE_BUILD_SHIPPING
+	return FMalloc::TotalMallocCalls + FMalloc::TotalReallocCalls;
+#else
+	return 0;
+#endif
+}
@@ -0,0 +1,182 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/IndirectArray.h"
+#include "Misc/ScopeLock.h"
+
+/**
+ * Free list of byte buffers. A released buffer keeps its capacity, so once the pool is warm taking one
+ * allocates nothing. Thread safe, buffers past the size limit or past the count limit are dropped.
+ */
+template <typename ElementType>
+class TLobbyBufferPool
+{
+public:
+
+	TLobbyBufferPool(int32 NewMaxBuffers, int32 NewMaxBufferBytes)
+		: MaxBuffers(NewMaxBuffers)
+		, MaxBufferBytes(NewMaxBufferBytes)
+	{
+		Buffers.Reserve(NewMaxBuffers);
+	}
+
+	TLobbyBufferPool(const TLobbyBufferPool&) = delete;
+
+	TLobbyBufferPool& operator=(const TLobbyBufferPool&) = delete;
+
+	/**
+	 * An empty buffer, with the capacity it had when it was released if the pool had one
+	 */
+	TArray<ElementType> Acquire()
+	{
+		FScopeLock Lock(&CriticalSection);
+		if (Buffers.IsEmpty())
+		{
+			++Misses;
+			return TArray<ElementType>();
+		}
+		++Hits;
+		return Buffers.Pop(EAllowShrinking::No);
+	}
+
+	void Release(TArray<ElementType>&& NewBuffer)
+	{
+		if (NewBuffer.Max() == 0 || NewBuffer.GetAllocatedSize() > static_cast<SIZE_T>(MaxBufferBytes))
+		{
+			return;
+		}
+
+		NewBuffer.Reset();
+		FScopeLock Lock(&CriticalSection);
+		if (Buffers.Num() < MaxBuffers)
+		{
+			Buffers.Add(MoveTemp(NewBuffer));
+		}
+	}
+
+	/**
+	 * Acquire calls served from the pool and calls that had to start from an empty buffer
+	 */
+	void GetStats(int64& OutHits, int64& OutMisses) const
+	{
+		FScopeLock Lock(&CriticalSection);
+		OutHits = Hits;
+		OutMisses = Misses;
+	}
+
+	void ResetStats()
+	{
+		FScopeLock Lock(&CriticalSection);
+		Hits = 0;
+		Misses = 0;
+	}
+
+private:
+
+	const int32 MaxBuffers;
+
+	const int32 MaxBufferBytes;
+
+	mutable FCriticalSection CriticalSection;
+
+	TArray<TArray<ElementType>> Buffers;
+
+	int64 Hits = 0;
+
+	int64 Misses = 0;
+};
+
+/**
+ * Received frames, handed from the WebSocket callback to the receive stage and back
+ */
+using FLobbyFramePool = TLobbyBufferPool<uint8>;
+
+/**
+ * Scratch text for one message, one arena per thread. A mark hands out buffers that stay valid until it
+ * ends, then they are handed out again by the next mark: text unescaped or converted while a message is
+ * read or written reuses the same capacity every time instead of going to the heap.
+ *
+ *   FLobbyMessageArena::FMark Mark;
+ *   TArray<UTF8CHAR>& Text = Mark.AcquireText();
+ */
+class LOBBYCLIENT_API FLobbyMessageArena
+{
+public:
+
+	class LOBBYCLIENT_API FMark
+	{
+	public:
+
+		FMark();
+
+		~FMark();
+
+		FMark(const FMark&) = delete;
+
+		FMark& operator=(const FMark&) = delete;
+
+		/**
+		 * An empty buffer, valid until the mark ends
+		 */
+		TArray<UTF8CHAR>& AcquireText();
+
+	private:
+
+		FLobbyMessageArena& Arena;
+
+		const int32 Used;
+	};
+
+	/**
+	 * Buffers that grew past this are freed when their mark ends, a huge message does not stay resident
+	 */
+	static const int32 MAX_RETAINED_BYTES = 64 * 1024;
+
+	/**
+	 * The arena of the calling thread
+	 */
+	static FLobbyMessageArena& Get();
+
+private:
+
+	TArray<UTF8CHAR>& AcquireText();
+
+	void Rewind(int32 NewUsed);
+
+	/**
+	 * Indirect, a buffer handed out must not move when more are added
+	 */
+	TIndirectArray<TArray<UTF8CHAR>> Buffers;
+
+	int32 Used = 0;
+};
+
+/**
+ * Adds the heap allocations made while it lives to a counter. FMalloc only counts its calls in
+ * non-shipping builds and counts them for every thread, so the numbers are a close upper bound.
+ */
+class LOBBYCLIENT_API FLobbyAllocationCounter
+{
+public:
+
+	explicit FLobbyAllocationCounter(int64& InOutAllocations);
+
+	~FLobbyAllocationCounter();
+
+	FLobbyAllocationCounter(const FLobbyAllocationCounter&) = delete;
+
+	FLobbyAllocationCounter& operator=(const FLobbyAllocationCounter&) = delete;
+
+	/**
+	 * Malloc and Realloc calls since the start of the process, 0 in shipping builds
+	 */
+	static uint64 GetTotal();
+
+private:
+
+	int64& Allocations;
+
+	const uint64 TotalBefore;
+};
@@ -0,0 +1,104 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LobbyChatFeed.h"
+#include "LobbyGameInstanceSubsystem.h"
+
+void ULobbyChatFeedView::ShowConversation(ULobbyGameInstanceSubsystem* NewSubsystem, const FString& NewChannelId, const FString& NewPeerPlayerId)
+{
+	ClearConversation();
+	if (NewSubsystem == nullptr)
+	{
+		return;
+	}
+
+	Subsystem = NewSubsystem;
+	ChannelId = NewPeerPlayerId.IsEmpty() ? NewChannelId : FString();
+	PeerPlayerId = NewPeerPlayerId;
+	ChatMessageHandle = NewSubsystem->OnChatMessageNative.AddUObject(this, &ULobbyChatFeedView::OnChatMessage);
+
+	TArray<FLobbyChatMessage> History;
+	NewSubsystem->GetChatMessagesSince(ChannelId, PeerPlayerId, 0, 0, History);
+	for (const FLobbyChatMessage& Message : History)
+	{
+		AddRow(Message);
+	}
+	if (bFollowLatest)
+	{
+		ScrollToBottom();
+	}
+}
+
+void ULobbyChatFeedView::ClearConversation()
+{
+	Unbind();
+	for (UObject* Row : GetListItems())
+	{
+		RetireRow(Row);
+	}
+	ClearListItems();
+	ChannelId.Reset();
+	PeerPlayerId.Reset();
+	LastSequence = 0;
+}
+
+void ULobbyChatFeedView::BeginDestroy()
+{
+	Unbind();
+	Super::BeginDestroy();
+}
+
+void ULobbyChatFeedView::OnChatMessage(const FLobbyChatMessage& NewMessage)
+{
+	if (NewMessage.Sequence <= LastSequence || !NewMessage.ChannelId.Equals(ChannelId, ESearchCase::CaseSensitive)
+		|| !NewMessage.PeerPlayerId.Equals(PeerPlayerId, ESearchCase::CaseSensitive))
+	{
+		return;
+	}
+
+	AddRow(NewMessage);
+	if (bFollowLatest)
+	{
+		ScrollToBottom();
+	}
+}
+
+void ULobbyChatFeedView::AddRow(const FLobbyChatMessage& NewMessage)
+{
+	if (RetiredFrame != GFrameCounter)
+	{
+		SpareRows.Append(RetiredRows);
+		RetiredRows.Reset();
+	}
+
+	if (GetNumItems() >= FMath::Max(MaxRows, 1))
+	{
+		UObject* Oldest = GetItemAt(0);
+		RemoveItem(Oldest);
+		RetireRow(Oldest);
+	}
+
+	ULobbyChatFeedItem* Row = SpareRows.Num() > 0 ? SpareRows.Pop(EAllowShrinking::No).Get() : NewObject<ULobbyChatFeedItem>(this);
+	Row->Message = NewMessage;
+	AddItem(Row);
+	LastSequence = NewMessage.Sequence;
+}
+
+void ULobbyChatFeedView::RetireRow(UObject* NewRow)
+{
+	if (ULobbyChatFeedItem* Row = Cast<ULobbyChatFeedItem>(NewRow))
+	{
+		RetiredRows.Add(Row);
+		RetiredFrame = GFrameCounter;
+	}
+}
+
+void ULobbyChatFeedView::Unbind()
+{
+	if (ULobbyGameInstanceSubsystem* BoundSubsystem = Subsystem.Get())
+	{
+		BoundSubsystem->OnChatMessageNative.Remove(ChatMessageHandle);
+	}
+	ChatMessageHandle.Reset();
+	Subsystem.Reset();
+}
@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ListView.h"
+#include "LobbyTypes.h"
+#include "LobbyChatFeed.generated.h"
+
+class ULobbyGameInstanceSubsystem;
+
+/**
+ * One row of a chat feed, what the entry widget reads in OnListItemObjectSet
+ */
+UCLASS(BlueprintType)
+class LOBBYCLIENT_API ULobbyChatFeedItem : public UObject
+{
+	GENERATED_BODY()
+
+public:
+
+	UPROPERTY(BlueprintReadOnly, Category = "Lobby|Chat")
+	FLobbyChatMessage Message;
+};
+
+/**
+ * List view over one conversation of the subsystem's chat history. Only the rows on screen get an entry
+ * widget, so a long session keeps the same widget count, and the rows themselves are capped by MaxRows
+ * and recycled. The entry widget class implements UserObjectListEntry and casts the item to ULobbyChatFeedItem.
+ */
+UCLASS(meta = (EntryInterface = "/Script/UMG.UserObjectListEntry"))
+class LOBBYCLIENT_API ULobbyChatFeedView : public UListView
+{
+	GENERATED_BODY()
+
+public:
+
+	/**
+	 * Show the history the subsystem still keeps for the channel, or for the peer if NewPeerPlayerId is set,
+	 * then follow the new messages
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Lobby|Chat")
+	void ShowConversation(ULobbyGameInstanceSubsystem* NewSubsystem, const FString& NewChannelId, const FString& NewPeerPlayerId);
+
+	UFUNCTION(BlueprintCallable, Category = "Lobby|Chat")
+	void ClearConversation();
+
+	/**
+	 * Rows kept in the list, the oldest one is reused for the next message
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Lobby|Chat", Meta = (ClampMin = "1"))
+	int32 MaxRows = 500;
+
+	/**
+	 * Scroll to every new message
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Lobby|Chat")
+	bool bFollowLatest = true;
+
+	virtual void BeginDestroy() override;
+
+private:
+
+	void OnChatMessage(const FLobbyChatMessage& NewMessage);
+
+	void AddRow(const FLobbyChatMessage& NewMessage);
+
+	/**
+	 * Rows leave the list here and are only reused on a later frame, once the list no longer maps an entry widget to them
+	 */
+	void RetireRow(UObject* NewRow);
+
+	void Unbind();
+
+	TWeakObjectPtr<ULobbyGameInstanceSubsystem> Subsystem;
+
+	FString ChannelId;
+
+	FString PeerPlayerId;
+
+	int64 LastSequence = 0;
+
+	FDelegateHandle ChatMessageHandle;
+
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<ULobbyChatFeedItem>> RetiredRows;
+
+	uint64 RetiredFrame = 0;
+
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<ULobbyChatFeedItem>> SpareRows;
+};
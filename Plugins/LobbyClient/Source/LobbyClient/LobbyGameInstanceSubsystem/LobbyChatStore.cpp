@@ -0,0 +1,226 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LobbyChatStore.h"
+
+void FLobbyChatStore::SetConfig(const FLobbyChatConfig& NewConfig)
+{
+	const int32 Capacity = FMath::Max(NewConfig.MessagesPerConversation, 1);
+	if (Capacity != FMath::Max(Config.MessagesPerConversation, 1))
+	{
+		for (TPair<FString, FConversation>& Pair : Conversations)
+		{
+			Trim(Pair.Value, Capacity);
+		}
+	}
+
+	// The quietest conversations go first
+	const int32 MaxConversations = FMath::Max(NewConfig.MaxConversations, 1);
+	if (Conversations.Num() > MaxConversations)
+	{
+		Conversations.ValueSort([](const FConversation& A, const FConversation& B)
+		{
+			return A.LastUsed > B.LastUsed;
+		});
+		int32 Index = 0;
+		for (auto It = Conversations.CreateIterator(); It; ++It)
+		{
+			if (Index++ >= MaxConversations)
+			{
+				Release(It.Value());
+				It.RemoveCurrent();
+			}
+		}
+	}
+	Config = NewConfig;
+}
+
+FLobbyChatMessage FLobbyChatStore::Add(const FString& NewChannelId, const FString& NewPeerPlayerId, const FString& NewSenderPlayerId, FStringView NewMessage, const FDateTime& NewReceivedTime)
+{
+	FConversation& Conversation = FindOrAdd(NewChannelId, NewPeerPlayerId);
+	Conversation.LastUsed = ++UseCounter;
+
+	FEntry* Entry = nullptr;
+	if (Conversation.Ring.Num() < FMath::Max(Config.MessagesPerConversation, 1))
+	{
+		Entry = &Conversation.Ring.AddDefaulted_GetRef();
+	}
+	else
+	{
+		// Full, the oldest message is overwritten and its text buffer reused
+		Entry = &Conversation.Ring[Conversation.Head];
+		ReleaseSender(Entry->Sender);
+		Conversation.Head = (Conversation.Head + 1) % Conversation.Ring.Num();
+	}
+
+	Entry->Sender = InternSender(NewSenderPlayerId);
+	Entry->ReceivedTime = NewReceivedTime;
+	Entry->Message.Reset();
+	const FStringView Kept = NewMessage.Left(FMath::Max(Config.MaxMessageChars, 1));
+	Entry->Message.Append(Kept.GetData(), Kept.Len());
+	return MakeMessage(Conversation, *Entry, ++Conversation.LastSequence);
+}
+
+int64 FLobbyChatStore::GetSince(const FString& NewChannelId, const FString& NewPeerPlayerId, int64 NewAfterSequence, int32 NewMaxMessages, TArray<FLobbyChatMessage>& OutMessages) const
+{
+	const FConversation* Conversation = Find(NewChannelId, NewPeerPlayerId);
+	if (Conversation == nullptr)
+	{
+		return 0;
+	}
+
+	// The kept messages are numbered without gaps, the first one wanted is found by subtraction
+	const int32 Num = Conversation->Ring.Num();
+	const int64 OldestSequence = Conversation->LastSequence - Num + 1;
+	const int32 Start = static_cast<int32>(FMath::Clamp<int64>(NewAfterSequence - OldestSequence + 1, 0, Num));
+	const int32 End = NewMaxMessages > 0 ? FMath::Min(Num, Start + NewMaxMessages) : Num;
+	OutMessages.Reserve(OutMessages.Num() + End - Start);
+	for (int32 Index = Start; Index < End; ++Index)
+	{
+		OutMessages.Add(MakeMessage(*Conversation, Conversation->Get(Index), OldestSequence + Index));
+	}
+	return Conversation->LastSequence;
+}
+
+int64 FLobbyChatStore::GetOldestSequence(const FString& NewChannelId, const FString& NewPeerPlayerId) const
+{
+	const FConversation* Conversation = Find(NewChannelId, NewPeerPlayerId);
+	if (Conversation == nullptr || Conversation->Ring.IsEmpty())
+	{
+		return 0;
+	}
+	return Conversation->LastSequence - Conversation->Ring.Num() + 1;
+}
+
+void FLobbyChatStore::Reset()
+{
+	Conversations.Empty();
+	UseCounter = 0;
+	Senders.Empty();
+	SenderReferences.Empty();
+	FreeSenders.Empty();
+	SenderIndices.Empty();
+}
+
+FString FLobbyChatStore::MakeKey(const FString& NewChannelId, const FString& NewPeerPlayerId)
+{
+	// Different prefixes, a channel can not share its key with a peer of the same name
+	return NewPeerPlayerId.IsEmpty() ? TEXT("#") + NewChannelId : TEXT("@") + NewPeerPlayerId;
+}
+
+const FLobbyChatStore::FConversation* FLobbyChatStore::Find(const FString& NewChannelId, const FString& NewPeerPlayerId) const
+{
+	return Conversations.Find(MakeKey(NewChannelId, NewPeerPlayerId));
+}
+
+FLobbyChatStore::FConversation& FLobbyChatStore::FindOrAdd(const FString& NewChannelId, const FString& NewPeerPlayerId)
+{
+	FString Key = MakeKey(NewChannelId, NewPeerPlayerId);
+	if (FConversation* Conversation = Conversations.Find(Key))
+	{
+		return *Conversation;
+	}
+
+	if (Conversations.Num() >= FMath::Max(Config.MaxConversations, 1))
+	{
+		FSetElementId QuietestId;
+		uint64 QuietestUse = MAX_uint64;
+		for (auto It = Conversations.CreateConstIterator(); It; ++It)
+		{
+			if (It.Value().LastUsed < QuietestUse)
+			{
+				QuietestUse = It.Value().LastUsed;
+				QuietestId = It.GetId();
+			}
+		}
+		Release(Conversations.Get(QuietestId).Value);
+		Conversations.Remove(QuietestId);
+	}
+
+	FConversation& R_Conversation = Conversations.Add(MoveTemp(Key));
+	R_Conversation.ChannelId = NewPeerPlayerId.IsEmpty() ? NewChannelId : FString();
+	R_Conversation.PeerPlayerId = NewPeerPlayerId;
+	return R_Conversation;
+}
+
+void FLobbyChatStore::Trim(FConversation& InOutConversation, int32 NewCapacity)
+{
+	const int32 Num = InOutConversation.Ring.Num();
+	if (Num <= NewCapacity && InOutConversation.Head == 0)
+	{
+		return;
+	}
+
+	TArray<FEntry> Kept;
+	Kept.Reserve(FMath::Min(Num, NewCapacity));
+	for (int32 Index = 0; Index < Num; ++Index)
+	{
+		FEntry& Entry = InOutConversation.Ring[(InOutConversation.Head + Index) % Num];
+		if (Index < Num - NewCapacity)
+		{
+			ReleaseSender(Entry.Sender);
+		}
+		else
+		{
+			Kept.Add(MoveTemp(Entry));
+		}
+	}
+	InOutConversation.Ring = MoveTemp(Kept);
+	InOutConversation.Head = 0;
+}
+
+void FLobbyChatStore::Release(FConversation& InOutConversation)
+{
+	for (const FEntry& Entry : InOutConversation.Ring)
+	{
+		ReleaseSender(Entry.Sender);
+	}
+	InOutConversation.Ring.Reset();
+}
+
+int32 FLobbyChatStore::InternSender(const FString& NewSenderPlayerId)
+{
+	if (const int32* Found = SenderIndices.Find(NewSenderPlayerId))
+	{
+		++SenderReferences[*Found];
+		return *Found;
+	}
+
+	int32 R_Sender = INDEX_NONE;
+	if (FreeSenders.Num() > 0)
+	{
+		R_Sender = FreeSenders.Pop(EAllowShrinking::No);
+		Senders[R_Sender] = NewSenderPlayerId;
+		SenderReferences[R_Sender] = 1;
+	}
+	else
+	{
+		R_Sender = Senders.Add(NewSenderPlayerId);
+		SenderReferences.Add(1);
+	}
+	SenderIndices.Add(NewSenderPlayerId, R_Sender);
+	return R_Sender;
+}
+
+void FLobbyChatStore::ReleaseSender(int32 NewSender)
+{
+	if (NewSender == INDEX_NONE || --SenderReferences[NewSender] > 0)
+	{
+		return;
+	}
+	SenderIndices.Remove(Senders[NewSender]);
+	Senders[NewSender].Empty();
+	FreeSenders.Add(NewSender);
+}
+
+FLobbyChatMessage FLobbyChatStore::MakeMessage(const FConversation& NewConversation, const FEntry& NewEntry, int64 NewSequence) const
+{
+	FLobbyChatMessage R_Message;
+	R_Message.Sequence = NewSequence;
+	R_Message.ChannelId = NewConversation.ChannelId;
+	R_Message.PeerPlayerId = NewConversation.PeerPlayerId;
+	R_Message.SenderPlayerId = Senders[NewEntry.Sender];
+	R_Message.Message = NewEntry.Message;
+	R_Message.ReceivedTime = NewEntry.ReceivedTime;
+	return R_Message;
+}
@@ -0,0 +1,125 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LobbyTypes.h"
+
+/**
+ * Chat history with a fixed capacity. Every channel and every direct message peer is a conversation with a
+ * ring of its last messages, numbered one up so a reader asks only for what came after the last one it saw.
+ * Sender ids are interned and counted, one copy per player however many messages they wrote.
+ * Game thread only.
+ */
+class LOBBYCLIENT_API FLobbyChatStore
+{
+public:
+
+	/**
+	 * Conversations over the new capacity keep their newest messages
+	 */
+	void SetConfig(const FLobbyChatConfig& NewConfig);
+
+	/**
+	 * Store one message and return it as it was stored, with its sequence
+	 */
+	FLobbyChatMessage Add(const FString& NewChannelId, const FString& NewPeerPlayerId, const FString& NewSenderPlayerId, FStringView NewMessage, const FDateTime& NewReceivedTime);
+
+	/**
+	 * Append the messages after NewAfterSequence still kept, oldest first and at most NewMaxMessages of them
+	 * if it is above 0. Returns the sequence of the newest message of the conversation, 0 if there is none.
+	 */
+	int64 GetSince(const FString& NewChannelId, const FString& NewPeerPlayerId, int64 NewAfterSequence, int32 NewMaxMessages, TArray<FLobbyChatMessage>& OutMessages) const;
+
+	/**
+	 * Sequence of the oldest message still kept, a reader behind it missed the messages in between
+	 */
+	int64 GetOldestSequence(const FString& NewChannelId, const FString& NewPeerPlayerId) const;
+
+	void Reset();
+
+	int32 NumConversations() const { return Conversations.Num(); }
+
+	int32 NumSenders() const { return SenderIndices.Num(); }
+
+private:
+
+	/**
+	 * Player ids and channel names are compared as they are, TMap would merge ids that only differ in case
+	 */
+	template <typename ValueType>
+	struct TCaseSensitiveKeyFuncs : TDefaultMapKeyFuncs<FString, ValueType, false>
+	{
+		static bool Matches(const FString& A, const FString& B) { return A.Equals(B, ESearchCase::CaseSensitive); }
+
+		static uint32 GetKeyHash(const FString& NewKey) { return FCrc::StrCrc32(*NewKey); }
+	};
+
+	struct FEntry
+	{
+		int32 Sender = INDEX_NONE;
+
+		FDateTime ReceivedTime;
+
+		FString Message;
+	};
+
+	struct FConversation
+	{
+		FString ChannelId;
+
+		FString PeerPlayerId;
+
+		/**
+		 * Grows up to the capacity, then Head is the oldest entry and the next one overwritten
+		 */
+		TArray<FEntry> Ring;
+
+		int32 Head = 0;
+
+		int64 LastSequence = 0;
+
+		/**
+		 * Store wide counter of the last message, the lowest one is dropped when there are too many conversations
+		 */
+		uint64 LastUsed = 0;
+
+		const FEntry& Get(int32 NewIndex) const { return Ring[(Head + NewIndex) % Ring.Num()]; }
+	};
+
+	static FString MakeKey(const FString& NewChannelId, const FString& NewPeerPlayerId);
+
+	const FConversation* Find(const FString& NewChannelId, const FString& NewPeerPlayerId) const;
+
+	FConversation& FindOrAdd(const FString& NewChannelId, const FString& NewPeerPlayerId);
+
+	/**
+	 * Rotate the ring so the oldest entry is first and keep the newest NewCapacity entries
+	 */
+	void Trim(FConversation& InOutConversation, int32 NewCapacity);
+
+	void Release(FConversation& InOutConversation);
+
+	int32 InternSender(const FString& NewSenderPlayerId);
+
+	void ReleaseSender(int32 NewSender);
+
+	FLobbyChatMessage MakeMessage(const FConversation& NewConversation, const FEntry& NewEntry, int64 NewSequence) const;
+
+	FLobbyChatConfig Config;
+
+	TMap<FString, FConversation, FDefaultSetAllocator, TCaseSensitiveKeyFuncs<FConversation>> Conversations;
+
+	uint64 UseCounter = 0;
+
+	/**
+	 * Interned sender ids and the number of kept messages using each, free slots are reused
+	 */
+	TArray<FString> Senders;
+
+	TArray<int32> SenderReferences;
+
+	TArray<int32> FreeSenders;
+
+	TMap<FString, int32, FDefaultSetAllocator, TCaseSensitiveKeyFuncs<int32>> SenderIndices;
+};
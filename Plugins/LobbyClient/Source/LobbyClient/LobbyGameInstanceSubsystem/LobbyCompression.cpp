@@ -0,0 +1,148 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LobbyCompression.h"
+#include "LobbyClient.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "zlib.h"
+THIRD_PARTY_INCLUDES_END
+
+namespace
+{
+	/**
+	 * First guess for the inflated size, JSON usually shrinks to a fifth or less
+	 */
+	constexpr int32 INFLATE_GROWTH_FACTOR = 4;
+
+	constexpr int32 MIN_INFLATE_CHUNK = 4096;
+}
+
+FLobbyDeflater::FLobbyDeflater()
+	: Stream(new z_stream())
+{
+	if (deflateInit(Stream, Level) != Z_OK)
+	{
+		delete Stream;
+		Stream = nullptr;
+	}
+}
+
+FLobbyDeflater::~FLobbyDeflater()
+{
+	if (Stream != nullptr)
+	{
+		deflateEnd(Stream);
+		delete Stream;
+	}
+}
+
+void FLobbyDeflater::SetLevel(int32 NewLevel)
+{
+	NewLevel = FMath::Clamp(NewLevel, 1, 9);
+	bLevelChanged |= NewLevel != Level;
+	Level = NewLevel;
+}
+
+bool FLobbyDeflater::TryCompress(FUtf8StringView NewBody, int32 NewMinBytes)
+{
+	Compressed.Reset();
+	if (Stream == nullptr || NewBody.Len() < FMath::Max(NewMinBytes, 1))
+	{
+		return false;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	if (bLevelChanged)
+	{
+		bLevelChanged = false;
+		deflateParams(Stream, Level, Z_DEFAULT_STRATEGY);
+	}
+	deflateReset(Stream);
+
+	// Sized once from the bound, a body that does not shrink below its own size is sent as it is
+	const int32 Bound = static_cast<int32>(deflateBound(Stream, static_cast<uLong>(NewBody.Len())));
+	Compressed.SetNumUninitialized(FMath::Min(Bound, NewBody.Len()), EAllowShrinking::No);
+	Stream->next_in = reinterpret_cast<Bytef*>(const_cast<UTF8CHAR*>(NewBody.GetData()));
+	Stream->avail_in = static_cast<uInt>(NewBody.Len());
+	Stream->next_out = reinterpret_cast<Bytef*>(Compressed.GetData());
+	Stream->avail_out = static_cast<uInt>(Compressed.Num());
+
+	if (deflate(Stream, Z_FINISH) != Z_STREAM_END)
+	{
+		Compressed.Reset();
+		return false;
+	}
+
+	Compressed.SetNum(static_cast<int32>(Stream->total_out), EAllowShrinking::No);
+	LastRawBytes = NewBody.Len();
+	LastSeconds = FPlatformTime::Seconds() - StartTime;
+	return true;
+}
+
+FLobbyInflater::FLobbyInflater()
+	: Stream(new z_stream())
+{
+	if (inflateInit(Stream) != Z_OK)
+	{
+		delete Stream;
+		Stream = nullptr;
+	}
+}
+
+FLobbyInflater::~FLobbyInflater()
+{
+	if (Stream != nullptr)
+	{
+		inflateEnd(Stream);
+		delete Stream;
+	}
+}
+
+bool FLobbyInflater::Inflate(FUtf8StringView NewBody, int32 NewMaxBytes, TArray<UTF8CHAR>& OutInflated)
+{
+	OutInflated.Reset();
+	if (Stream == nullptr || NewBody.IsEmpty())
+	{
+		return false;
+	}
+
+	inflateReset(Stream);
+	Stream->next_in = reinterpret_cast<Bytef*>(const_cast<UTF8CHAR*>(NewBody.GetData()));
+	Stream->avail_in = static_cast<uInt>(NewBody.Len());
+
+	// A buffer kept from an earlier frame is used as far as it goes before growing
+	NewMaxBytes = FMath::Max(NewMaxBytes, 1);
+	int32 Capacity = FMath::Min(FMath::Max3(NewBody.Len() * INFLATE_GROWTH_FACTOR, MIN_INFLATE_CHUNK, OutInflated.Max()), NewMaxBytes);
+	for (;;)
+	{
+		// Inflate writes into the tail of the output, which only grows when it is full
+		const int32 Written = static_cast<int32>(Stream->total_out);
+		OutInflated.SetNumUninitialized(Capacity, EAllowShrinking::No);
+		Stream->next_out = reinterpret_cast<Bytef*>(OutInflated.GetData() + Written);
+		Stream->avail_out = static_cast<uInt>(Capacity - Written);
+
+		const int Result = inflate(Stream, Z_NO_FLUSH);
+		if (Result == Z_STREAM_END)
+		{
+			break;
+		}
+		// Room left over means the input ended before the stream did
+		if ((Result != Z_OK && Result != Z_BUF_ERROR) || Stream->avail_out != 0)
+		{
+			OutInflated.Reset();
+			return false;
+		}
+		if (Capacity >= NewMaxBytes)
+		{
+			UE_LOG(LogLobbyClient, Warning, TEXT("A compressed frame inflates past %d bytes and is dropped."), NewMaxBytes);
+			OutInflated.Reset();
+			return false;
+		}
+		Capacity = static_cast<int32>(FMath::Min<int64>(static_cast<int64>(Capacity) * 2, NewMaxBytes));
+	}
+
+	OutInflated.SetNum(static_cast<int32>(Stream->total_out), EAllowShrinking::No);
+	// Trailing bytes after the stream mean the sender and receiver disagree about the body
+	return Stream->avail_in == 0;
+}
@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct z_stream_s;
+
+/**
+ * Deflates frame bodies in the zlib format. The stream state is allocated once and reset for every body,
+ * the compressed body stays in the deflater until the next one. Not thread safe.
+ */
+class LOBBYCLIENT_API FLobbyDeflater
+{
+public:
+
+	FLobbyDeflater();
+
+	~FLobbyDeflater();
+
+	FLobbyDeflater(const FLobbyDeflater&) = delete;
+	FLobbyDeflater& operator=(const FLobbyDeflater&) = delete;
+
+	/**
+	 * Compression level from 1 (fastest) to 9 (smallest), applied to the next body
+	 */
+	void SetLevel(int32 NewLevel);
+
+	/**
+	 * Deflate NewBody if it is at least NewMinBytes long. Returns false and keeps nothing if it does not get smaller.
+	 */
+	bool TryCompress(FUtf8StringView NewBody, int32 NewMinBytes);
+
+	FUtf8StringView GetCompressed() const { return FUtf8StringView(Compressed.GetData(), Compressed.Num()); }
+
+	/**
+	 * Size before compression and time spent in the last successful TryCompress
+	 */
+	int32 GetLastRawBytes() const { return LastRawBytes; }
+
+	double GetLastSeconds() const { return LastSeconds; }
+
+private:
+
+	z_stream_s* Stream = nullptr;
+
+	int32 Level = 6;
+
+	bool bLevelChanged = false;
+
+	TArray<UTF8CHAR> Compressed;
+
+	int32 LastRawBytes = 0;
+
+	double LastSeconds = 0.0;
+};
+
+/**
+ * Inflates zlib frame bodies chunk by chunk straight into a reused output buffer, so a body is expanded
+ * once and never copied. The stream state is allocated once and reset for every body. Not thread safe.
+ */
+class LOBBYCLIENT_API FLobbyInflater
+{
+public:
+
+	FLobbyInflater();
+
+	~FLobbyInflater();
+
+	FLobbyInflater(const FLobbyInflater&) = delete;
+	FLobbyInflater& operator=(const FLobbyInflater&) = delete;
+
+	/**
+	 * Replace OutInflated with the inflated NewBody. Fails on a corrupt stream or once the output passes NewMaxBytes.
+	 */
+	bool Inflate(FUtf8StringView NewBody, int32 NewMaxBytes, TArray<UTF8CHAR>& OutInflated);
+
+private:
+
+	z_stream_s* Stream = nullptr;
+};
@@ -0,0 +1,133 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IWebSocket.h"
+#include "LobbyTypes.h"
+#include "LobbySendQueue.h"
+#include "LobbyOutboundScheduler.h"
+#include "LobbyBufferPool.h"
+
+/**
+ * A write that went out on a connection and is kept until it is answered
+ */
+struct FLobbyRetainedEnvelope
+{
+	FString RequestId;
+	TArray<UTF8CHAR> Envelope;
+	bool bBson = false;
+};
+
+/**
+ * One WebSocket to the lobby server and everything waiting to go out on it.
+ * The subsystem keeps one per channel, or several for a database pool. Signing, request tracking and
+ * the receive stage are shared, so a response is matched the same way whatever connection it comes back on.
+ */
+struct FLobbyConnection
+{
+	FLobbyConnection(int32 NewId, ELobbyChannel NewChannel)
+		: Id(NewId)
+		, Channel(NewChannel)
+		, FramePool(MakeShared<FLobbyFramePool, ESPMode::ThreadSafe>(8, 1024 * 1024))
+		, EnvelopePool(64, 64 * 1024)
+	{
+	}
+
+	/**
+	 * Bound to the WebSocket events, unique for the lifetime of the subsystem
+	 */
+	const int32 Id;
+
+	const ELobbyChannel Channel;
+
+	FString URL;
+
+	TSharedPtr<IWebSocket> WebSocket;
+
+	/**
+	 * Collects the fragments of the message being received, taken from FramePool
+	 */
+	TArray<uint8> ReceiveBuffer;
+
+	/**
+	 * Frame buffers come back here from the receive stage once processed, shared with the tasks in flight
+	 */
+	TSharedRef<FLobbyFramePool, ESPMode::ThreadSafe> FramePool;
+
+	ELobbyConnectionState State = ELobbyConnectionState::DISCONNECTED;
+
+	/**
+	 * Set after the first connection, the player is registered again on every later one
+	 */
+	bool bHasConnected = false;
+
+	int32 ReconnectAttempt = 0;
+
+	double NextReconnectTime = 0.0;
+
+	/**
+	 * Set once the server sent a compressed frame on this WebSocket
+	 */
+	bool bPeerCompresses = false;
+
+	/**
+	 * Requests waiting for the next batch frame
+	 */
+	FLobbySendQueue SendQueue;
+
+	/**
+	 * Framing the queued envelopes were written for
+	 */
+	bool bSendQueueNested = false;
+
+	/**
+	 * Requests held back by the budget, sent by priority on the next ticks
+	 */
+	FLobbyOutboundScheduler OutboundScheduler;
+
+	/**
+	 * Bytes handed to the WebSocket since the tick started
+	 */
+	int32 TickBytesSent = 0;
+
+	/**
+	 * Requests made while not connected, replayed in order once connected
+	 */
+	FLobbySendQueue OfflineQueue;
+
+	/**
+	 * Writes sent but not answered yet, replayed with their idempotency keys if the connection drops
+	 */
+	TArray<FLobbyRetainedEnvelope> UnacknowledgedEnvelopes;
+
+	/**
+	 * Buffers of answered writes, reused for the next retained envelope
+	 */
+	TLobbyBufferPool<UTF8CHAR> EnvelopePool;
+
+	/**
+	 * Drop the retained writes, their buffers go back to the pool
+	 */
+	void ResetUnacknowledged()
+	{
+		for (FLobbyRetainedEnvelope& Retained : UnacknowledgedEnvelopes)
+		{
+			EnvelopePool.Release(MoveTemp(Retained.Envelope));
+		}
+		UnacknowledgedEnvelopes.Reset();
+	}
+
+	bool IsConnected() const
+	{
+		return State == ELobbyConnectionState::CONNECTED && WebSocket.IsValid();
+	}
+
+	/**
+	 * Bytes waiting on this connection, used to pick the least busy one of a pool
+	 */
+	int32 GetPendingBytes() const
+	{
+		return SendQueue.NumBytes() + OutboundScheduler.GetQueuedBytes() + OfflineQueue.NumBytes();
+	}
+};
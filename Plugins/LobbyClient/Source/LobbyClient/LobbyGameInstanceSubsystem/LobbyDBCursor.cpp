@@ -0,0 +1,160 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LobbyDBCursor.h"
+#include "LobbyClient.h"
+#include "LobbyGameInstanceSubsystem.h"
+#include "LobbyJsonView.h"
+
+void ULobbyDBCursor::Open(ULobbyGameInstanceSubsystem* NewSubsystem, const FMongoDBData& NewQuery, int32 NewBatchSize, float NewTimeoutSeconds)
+{
+	check(NewSubsystem);
+	Subsystem = NewSubsystem;
+	Query = NewQuery;
+	BatchSize = FMath::Max(NewBatchSize, 1);
+	TimeoutSeconds = NewTimeoutSeconds;
+	NextBatchIndex = 0;
+	bOpen = true;
+	bHasMore = true;
+	bBatchPending = true;
+
+	if (Query.DbAction != EMongoDBActionType::FIND && Query.DbAction != EMongoDBActionType::FIND_WITH_OPTIONS && Query.DbAction != EMongoDBActionType::AGGREGATE)
+	{
+		UE_LOG(LogLobbyClient, Warning, TEXT("Function OpenDBCursor: Only FIND, FIND_WITH_OPTIONS and AGGREGATE return cursors."));
+	}
+
+	FMongoDBData CursorQuery = Query;
+	CursorQuery.BatchSize = BatchSize;
+	CursorQuery.CursorId.Reset();
+	NewSubsystem->SendDBRequest(CursorQuery, FOnLobbyResponseNative::CreateUObject(this, &ULobbyDBCursor::OnBatchResponse), TimeoutSeconds);
+}
+
+bool ULobbyDBCursor::RequestNextBatch()
+{
+	ULobbyGameInstanceSubsystem* LobbySubsystem = Subsystem.Get();
+	if (!bOpen || !bHasMore || bBatchPending || LobbySubsystem == nullptr)
+	{
+		return false;
+	}
+
+	FMongoDBData GetMore;
+	GetMore.SenderPlayerId = Query.SenderPlayerId;
+	GetMore.DbName = Query.DbName;
+	GetMore.CollectionName = Query.CollectionName;
+	GetMore.DbAction = EMongoDBActionType::GET_MORE;
+	GetMore.BatchSize = BatchSize;
+	GetMore.CursorId = CursorId;
+
+	bBatchPending = true;
+	LobbySubsystem->SendDBRequest(GetMore, FOnLobbyResponseNative::CreateUObject(this, &ULobbyDBCursor::OnBatchResponse), TimeoutSeconds);
+	return true;
+}
+
+void ULobbyDBCursor::Cancel()
+{
+	if (!bOpen)
+	{
+		return;
+	}
+
+	// An exhausted cursor is already gone on the server
+	ULobbyGameInstanceSubsystem* LobbySubsystem = Subsystem.Get();
+	if (LobbySubsystem != nullptr && bHasMore && !CursorId.IsEmpty())
+	{
+		FMongoDBData KillCursor;
+		KillCursor.SenderPlayerId = Query.SenderPlayerId;
+		KillCursor.DbName = Query.DbName;
+		KillCursor.CollectionName = Query.CollectionName;
+		KillCursor.DbAction = EMongoDBActionType::KILL_CURSOR;
+		KillCursor.CursorId = CursorId;
+		LobbySubsystem->SendDBRequest(KillCursor);
+	}
+	Close();
+}
+
+void ULobbyDBCursor::OnBatchResponse(const FLobbyResponse& NewResponse)
+{
+	bBatchPending = false;
+	if (!bOpen)
+	{
+		return;
+	}
+
+	FLobbyDBCursorBatch Batch;
+	Batch.BatchIndex = NextBatchIndex++;
+	Batch.Status = NewResponse.Status;
+	Batch.Error = NewResponse.Error;
+	if (Batch.Status == ELobbyRequestStatus::SUCCESS && !ParseBatch(NewResponse.PayLoadData, Batch))
+	{
+		Batch.Status = ELobbyRequestStatus::FAILED;
+		Batch.Error = TEXT("The response is not a cursor batch.");
+	}
+
+	if (Batch.Status == ELobbyRequestStatus::SUCCESS)
+	{
+		if (!Batch.CursorId.IsEmpty())
+		{
+			CursorId = Batch.CursorId;
+		}
+		bHasMore = Batch.bHasMore;
+	}
+	else
+	{
+		bHasMore = false;
+	}
+
+	// Closed before the broadcast, so listeners see the final state
+	if (!bHasMore)
+	{
+		Close();
+	}
+
+	OnBatchNative.Broadcast(this, Batch);
+	OnBatch.Broadcast(this, Batch);
+}
+
+void ULobbyDBCursor::Close()
+{
+	bOpen = false;
+	if (ULobbyGameInstanceSubsystem* LobbySubsystem = Subsystem.Get())
+	{
+		LobbySubsystem->ReleaseDBCursor(this);
+	}
+}
+
+bool ULobbyDBCursor::ParseBatch(const FString& NewPayLoadData, FLobbyDBCursorBatch& OutBatch)
+{
+	const FTCHARToUTF8 PayLoadUtf8(*NewPayLoadData, NewPayLoadData.Len());
+	FLobbyJsonView PayLoadView;
+	if (!PayLoadView.Parse(FUtf8StringView(reinterpret_cast<const UTF8CHAR*>(PayLoadUtf8.Get()), PayLoadUtf8.Length())))
+	{
+		return false;
+	}
+
+	const FLobbyJsonView::FValue PayLoad = PayLoadView.GetRoot();
+	const FLobbyJsonView::FValue Documents = PayLoad.Find("batch");
+	if (!Documents.IsArray())
+	{
+		return false;
+	}
+
+	PayLoad.Find("cursorId").TryGetString(OutBatch.CursorId);
+	PayLoad.Find("hasMore").TryGetBool(OutBatch.bHasMore);
+
+	// Documents are handed on as the text they arrived as
+	OutBatch.Documents.Reserve(Documents.Num());
+	Documents.ForEachElement([&OutBatch](const FLobbyJsonView::FValue& Document)
+	{
+		FString& DocumentJson = OutBatch.Documents.AddDefaulted_GetRef();
+		if (Document.IsObject() || Document.IsArray())
+		{
+			const FUtf8StringView DocumentText = Document.GetText();
+			DocumentJson = FString(DocumentText.Len(), DocumentText.GetData());
+		}
+		else
+		{
+			Document.TryGetString(DocumentJson);
+		}
+	});
+	return true;
+}
@@ -0,0 +1,124 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "LobbyTypes.h"
+#include "LobbyDBCursor.generated.h"
+
+class ULobbyGameInstanceSubsystem;
+
+/**
+ * One page of a cursor result, the payLoadData {"cursorId","batch","hasMore"} of a cursor response
+ */
+USTRUCT(BlueprintType, Blueprintable)
+struct FLobbyDBCursorBatch
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "CursorId"))
+	FString CursorId = "";
+
+	/**
+	*	0 for the batch the query returned, then one up for every GET_MORE
+	*/
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "BatchIndex"))
+	int32 BatchIndex = 0;
+
+	/**
+	*	The documents of this batch as JSON text
+	*/
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "Documents"))
+	TArray<FString> Documents;
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "HasMore"))
+	bool bHasMore = false;
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "Status"))
+	ELobbyRequestStatus Status = ELobbyRequestStatus::SUCCESS;
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "Error"))
+	FString Error = "";
+};
+
+class ULobbyDBCursor;
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnLobbyDBCursorBatchNative, ULobbyDBCursor* /*Cursor*/, const FLobbyDBCursorBatch& /*Batch*/);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnLobbyDBCursorBatch, ULobbyDBCursor*, Cursor, const FLobbyDBCursorBatch&, Batch);
+
+/**
+ * A server side cursor over a FIND, FIND_WITH_OPTIONS or AGGREGATE result. Every batch is broadcast as it
+ * arrives, the next one is only fetched when RequestNextBatch is called.
+ * Open it with ULobbyGameInstanceSubsystem::OpenDBCursor, the subsystem keeps it alive until it is closed.
+ */
+UCLASS(BlueprintType)
+class LOBBYCLIENT_API ULobbyDBCursor : public UObject
+{
+	GENERATED_BODY()
+
+public:
+
+	UPROPERTY(BlueprintAssignable)
+	FOnLobbyDBCursorBatch OnBatch;
+
+	FOnLobbyDBCursorBatchNative OnBatchNative;
+
+	/**
+	 * Ask for the next batch, false if the cursor is closed, exhausted or a batch is still on its way
+	 */
+	UFUNCTION(BlueprintCallable)
+	bool RequestNextBatch();
+
+	/**
+	 * Close the cursor and tell the server to drop it. A batch still on its way is ignored.
+	 */
+	UFUNCTION(BlueprintCallable)
+	void Cancel();
+
+	UFUNCTION(BlueprintPure)
+	bool IsOpen() const { return bOpen; }
+
+	UFUNCTION(BlueprintPure)
+	bool HasMore() const { return bHasMore; }
+
+	UFUNCTION(BlueprintPure)
+	bool IsBatchPending() const { return bBatchPending; }
+
+	UFUNCTION(BlueprintPure)
+	FString GetCursorId() const { return CursorId; }
+
+	/**
+	 * Send the query, called by the subsystem
+	 */
+	void Open(ULobbyGameInstanceSubsystem* NewSubsystem, const FMongoDBData& NewQuery, int32 NewBatchSize, float NewTimeoutSeconds);
+
+	static bool ParseBatch(const FString& NewPayLoadData, FLobbyDBCursorBatch& OutBatch);
+
+private:
+
+	void OnBatchResponse(const FLobbyResponse& NewResponse);
+
+	void Close();
+
+	TWeakObjectPtr<ULobbyGameInstanceSubsystem> Subsystem;
+
+	/**
+	 * Sender, database and collection for the follow-up requests
+	 */
+	FMongoDBData Query;
+
+	FString CursorId;
+
+	int32 BatchSize = 0;
+
+	int32 NextBatchIndex = 0;
+
+	float TimeoutSeconds = -1.f;
+
+	bool bOpen = false;
+
+	bool bHasMore = false;
+
+	bool bBatchPending = false;
+};
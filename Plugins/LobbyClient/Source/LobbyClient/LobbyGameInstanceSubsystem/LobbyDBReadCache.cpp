@@ -0,0 +1,317 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LobbyDBReadCache.h"
+#include "Hash/xxhash.h"
+
+namespace
+{
+	/**
+	 * Append NewJson without the whitespace outside of its strings
+	 */
+	void AppendNormalizedJson(FString& OutKey, const FString& NewJson)
+	{
+		bool bInString = false;
+		bool bEscaped = false;
+		for (const TCHAR Char : NewJson)
+		{
+			if (bInString)
+			{
+				if (bEscaped)
+				{
+					bEscaped = false;
+				}
+				else if (Char == TEXT('\\'))
+				{
+					bEscaped = true;
+				}
+				else if (Char == TEXT('"'))
+				{
+					bInString = false;
+				}
+			}
+			else if (FChar::IsWhitespace(Char))
+			{
+				continue;
+			}
+			else
+			{
+				bInString = Char == TEXT('"');
+			}
+			OutKey.AppendChar(Char);
+		}
+	}
+
+	const TCHAR KeySeparator = TEXT('\x1F');
+}
+
+bool FLobbyDBReadCache::IsCacheableRead(const FMongoDBData& NewMongoDBData)
+{
+	switch (NewMongoDBData.DbAction)
+	{
+	case EMongoDBActionType::FIND:
+	case EMongoDBActionType::FIND_WITH_OPTIONS:
+		// Cursor batches depend on the server cursor state
+		return NewMongoDBData.BatchSize <= 0;
+
+	case EMongoDBActionType::FIND_ONE:
+	case EMongoDBActionType::FIND_ONE_WITH_OPTIONS:
+	case EMongoDBActionType::COUNT_DOCUMENTS:
+	case EMongoDBActionType::GET_ESTIMATED_DOCUMENT_COUNT:
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+bool FLobbyDBReadCache::IsWrite(EMongoDBActionType NewDbAction)
+{
+	switch (NewDbAction)
+	{
+	case EMongoDBActionType::INSERT_ONE:
+	case EMongoDBActionType::INSERT_MANY:
+	case EMongoDBActionType::UPDATE_ONE:
+	case EMongoDBActionType::UPDATE_ONE_WITH_OPTIONS:
+	case EMongoDBActionType::UPDATE_MANY:
+	case EMongoDBActionType::UPDATE_MANY_WITH_OPTIONS:
+	case EMongoDBActionType::REPLACE_ONE:
+	case EMongoDBActionType::DELETE_ONE:
+	case EMongoDBActionType::DELETE_MANY:
+	case EMongoDBActionType::FIND_ONE_AND_DELETE:
+	case EMongoDBActionType::FIND_ONE_AND_REPLACE:
+	case EMongoDBActionType::FIND_ONE_AND_UPDATE:
+	case EMongoDBActionType::DROP_COLLECTION:
+	case EMongoDBActionType::RENAME_COLLECTION:
+	case EMongoDBActionType::BULK_WRITE:
+	case EMongoDBActionType::RUN_COMMAND:
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+FString FLobbyDBReadCache::MakeKey(const FMongoDBData& NewMongoDBData)
+{
+	FString R_Key;
+	R_Key.Reserve(NewMongoDBData.DbName.Len() + NewMongoDBData.CollectionName.Len() + NewMongoDBData.Filter.Len() + NewMongoDBData.Options.Len() + 8);
+	R_Key.Append(NewMongoDBData.DbName);
+	R_Key.AppendChar(KeySeparator);
+	R_Key.Append(NewMongoDBData.CollectionName);
+	R_Key.AppendChar(KeySeparator);
+	R_Key.AppendInt(static_cast<int32>(NewMongoDBData.DbAction));
+	R_Key.AppendChar(KeySeparator);
+	AppendNormalizedJson(R_Key, NewMongoDBData.Filter);
+	R_Key.AppendChar(KeySeparator);
+	AppendNormalizedJson(R_Key, NewMongoDBData.Options);
+	// Documents built as BSON replace the text, their bytes are compared as they are
+	if (!NewMongoDBData.FilterBson.IsEmpty() || !NewMongoDBData.OptionsBson.IsEmpty())
+	{
+		R_Key.AppendChar(KeySeparator);
+		R_Key.Append(BytesToHex(reinterpret_cast<const uint8*>(NewMongoDBData.FilterBson.GetData()), NewMongoDBData.FilterBson.Num()));
+		R_Key.AppendChar(KeySeparator);
+		R_Key.Append(BytesToHex(reinterpret_cast<const uint8*>(NewMongoDBData.OptionsBson.GetData()), NewMongoDBData.OptionsBson.Num()));
+	}
+	return R_Key;
+}
+
+FString FLobbyDBReadCache::MakeCollectionKey(const FMongoDBData& NewMongoDBData)
+{
+	FString R_CollectionKey = NewMongoDBData.DbName;
+	R_CollectionKey.AppendChar(KeySeparator);
+	R_CollectionKey.Append(NewMongoDBData.CollectionName);
+	return R_CollectionKey;
+}
+
+bool FLobbyDBReadCache::Find(const FString& NewKey, double NewNow, FString& OutPayLoadData)
+{
+	const int32* Slot = SlotByHash.Find(HashKey(NewKey));
+	if (Slot == nullptr || !Entries[*Slot].Key.Equals(NewKey, ESearchCase::CaseSensitive))
+	{
+		++Stats.Misses;
+		return false;
+	}
+
+	const int32 FoundSlot = *Slot;
+	if (IsStale(Entries[FoundSlot], NewNow))
+	{
+		Remove(FoundSlot);
+		++Stats.Misses;
+		return false;
+	}
+
+	// Move to the front of the recency list
+	Unlink(FoundSlot);
+	Link(FoundSlot);
+	OutPayLoadData = Entries[FoundSlot].PayLoadData;
+	++Stats.Hits;
+	return true;
+}
+
+void FLobbyDBReadCache::Store(const FString& NewKey, const FString& NewCollectionKey, uint64 NewStamp, const FString& NewPayLoadData, double NewExpireTime)
+{
+	if (NewStamp <= FMath::Max(AllInvalidatedAt, InvalidatedAt.FindRef(NewCollectionKey)))
+	{
+		// A write to the collection went out after this read, the answer may be old
+		return;
+	}
+
+	const uint64 Hash = HashKey(NewKey);
+	if (const int32* Existing = SlotByHash.Find(Hash))
+	{
+		Remove(*Existing);
+	}
+
+	const int32 Bytes = (NewKey.Len() + NewCollectionKey.Len() + NewPayLoadData.Len()) * sizeof(TCHAR) + sizeof(FEntry);
+	if (Bytes > MaxBytes)
+	{
+		return;
+	}
+
+	int32 Slot = FirstFree;
+	if (Slot != INDEX_NONE)
+	{
+		FirstFree = Entries[Slot].Next;
+	}
+	else
+	{
+		Slot = Entries.AddDefaulted();
+	}
+
+	FEntry& Entry = Entries[Slot];
+	Entry.Key = NewKey;
+	Entry.CollectionKey = NewCollectionKey;
+	Entry.PayLoadData = NewPayLoadData;
+	Entry.Hash = Hash;
+	Entry.Stamp = NewStamp;
+	Entry.ExpireTime = NewExpireTime;
+	Entry.Bytes = Bytes;
+	SlotByHash.Add(Hash, Slot);
+	Link(Slot);
+	TotalBytes += Bytes;
+
+	EvictToFit();
+}
+
+void FLobbyDBReadCache::Invalidate(const FMongoDBData& NewMongoDBData)
+{
+	++Stats.Invalidations;
+	// Renames and commands can touch collections the request does not name
+	if (NewMongoDBData.DbAction == EMongoDBActionType::RENAME_COLLECTION || NewMongoDBData.DbAction == EMongoDBActionType::RUN_COMMAND)
+	{
+		AllInvalidatedAt = Stamp++;
+		return;
+	}
+	InvalidatedAt.Add(MakeCollectionKey(NewMongoDBData), Stamp++);
+}
+
+void FLobbyDBReadCache::InvalidateAll()
+{
+	++Stats.Invalidations;
+	AllInvalidatedAt = Stamp++;
+}
+
+void FLobbyDBReadCache::SetMaxBytes(int32 NewMaxBytes)
+{
+	MaxBytes = FMath::Max(NewMaxBytes, 0);
+	EvictToFit();
+}
+
+void FLobbyDBReadCache::Empty()
+{
+	Entries.Reset();
+	SlotByHash.Reset();
+	InvalidatedAt.Reset();
+	AllInvalidatedAt = Stamp++;
+	Head = INDEX_NONE;
+	Tail = INDEX_NONE;
+	FirstFree = INDEX_NONE;
+	TotalBytes = 0;
+}
+
+void FLobbyDBReadCache::ResetStats()
+{
+	Stats = FLobbyDBCacheStats();
+}
+
+FLobbyDBCacheStats FLobbyDBReadCache::GetStats() const
+{
+	FLobbyDBCacheStats R_Stats = Stats;
+	R_Stats.Entries = SlotByHash.Num();
+	R_Stats.Bytes = TotalBytes;
+	return R_Stats;
+}
+
+bool FLobbyDBReadCache::IsStale(const FEntry& NewEntry, double NewNow) const
+{
+	return NewNow >= NewEntry.ExpireTime
+		|| NewEntry.Stamp <= FMath::Max(AllInvalidatedAt, InvalidatedAt.FindRef(NewEntry.CollectionKey));
+}
+
+void FLobbyDBReadCache::Link(int32 NewSlot)
+{
+	FEntry& Entry = Entries[NewSlot];
+	Entry.Prev = INDEX_NONE;
+	Entry.Next = Head;
+	if (Head != INDEX_NONE)
+	{
+		Entries[Head].Prev = NewSlot;
+	}
+	Head = NewSlot;
+	if (Tail == INDEX_NONE)
+	{
+		Tail = NewSlot;
+	}
+}
+
+void FLobbyDBReadCache::Unlink(int32 NewSlot)
+{
+	FEntry& Entry = Entries[NewSlot];
+	if (Entry.Prev != INDEX_NONE)
+	{
+		Entries[Entry.Prev].Next = Entry.Next;
+	}
+	else
+	{
+		Head = Entry.Next;
+	}
+	if (Entry.Next != INDEX_NONE)
+	{
+		Entries[Entry.Next].Prev = Entry.Prev;
+	}
+	else
+	{
+		Tail = Entry.Prev;
+	}
+	Entry.Prev = INDEX_NONE;
+	Entry.Next = INDEX_NONE;
+}
+
+void FLobbyDBReadCache::Remove(int32 NewSlot)
+{
+	Unlink(NewSlot);
+	FEntry& Entry = Entries[NewSlot];
+	SlotByHash.Remove(Entry.Hash);
+	TotalBytes -= Entry.Bytes;
+	Entry.Key.Empty();
+	Entry.CollectionKey.Empty();
+	Entry.PayLoadData.Empty();
+	Entry.Bytes = 0;
+	Entry.Next = FirstFree;
+	FirstFree = NewSlot;
+}
+
+void FLobbyDBReadCache::EvictToFit()
+{
+	while (TotalBytes > MaxBytes && Tail != INDEX_NONE)
+	{
+		Remove(Tail);
+		++Stats.Evictions;
+	}
+}
+
+uint64 FLobbyDBReadCache::HashKey(const FString& NewKey)
+{
+	return FXxHash64::HashBuffer(*NewKey, NewKey.Len() * sizeof(TCHAR)).Hash;
+}
@@ -0,0 +1,126 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LobbyTypes.h"
+
+/**
+ * LRU cache of database read responses keyed by a hash of the normalized read.
+ * Writes invalidate a collection by bumping its stamp: an entry, or a read still on its way,
+ * is only valid if it was stamped after the last invalidation of its collection.
+ */
+class LOBBYCLIENT_API FLobbyDBReadCache
+{
+public:
+
+	/**
+	 * Reads whose answer only depends on DbName, CollectionName, DbAction, Filter and Options
+	 */
+	static bool IsCacheableRead(const FMongoDBData& NewMongoDBData);
+
+	/**
+	 * Actions that change the collection they name, or that could change anything
+	 */
+	static bool IsWrite(EMongoDBActionType NewDbAction);
+
+	/**
+	 * The normalized read, whitespace outside JSON strings in Filter and Options does not change the key
+	 */
+	static FString MakeKey(const FMongoDBData& NewMongoDBData);
+
+	static FString MakeCollectionKey(const FMongoDBData& NewMongoDBData);
+
+	/**
+	 * Counts a hit or a miss. Expired and invalidated entries are dropped on the way.
+	 */
+	bool Find(const FString& NewKey, double NewNow, FString& OutPayLoadData);
+
+	/**
+	 * Stamp for a read sent now, hand it back to Store with the response
+	 */
+	uint64 GetStamp() const { return Stamp; }
+
+	/**
+	 * Keep a response unless its collection was invalidated after NewStamp
+	 */
+	void Store(const FString& NewKey, const FString& NewCollectionKey, uint64 NewStamp, const FString& NewPayLoadData, double NewExpireTime);
+
+	/**
+	 * Invalidate the collection NewMongoDBData writes to, every collection for writes that are not limited to one
+	 */
+	void Invalidate(const FMongoDBData& NewMongoDBData);
+
+	void InvalidateAll();
+
+	void SetMaxBytes(int32 NewMaxBytes);
+
+	/**
+	 * Drop every entry, the counters are kept
+	 */
+	void Empty();
+
+	void ResetStats();
+
+	FLobbyDBCacheStats GetStats() const;
+
+private:
+
+	struct FEntry
+	{
+		FString Key;
+		FString CollectionKey;
+		FString PayLoadData;
+		uint64 Hash = 0;
+		uint64 Stamp = 0;
+		double ExpireTime = 0.0;
+		int32 Bytes = 0;
+		/**
+		 * Neighbours in the recency list, or the next free slot
+		 */
+		int32 Prev = INDEX_NONE;
+		int32 Next = INDEX_NONE;
+	};
+
+	bool IsStale(const FEntry& NewEntry, double NewNow) const;
+
+	void Link(int32 NewSlot);
+
+	void Unlink(int32 NewSlot);
+
+	void Remove(int32 NewSlot);
+
+	void EvictToFit();
+
+	static uint64 HashKey(const FString& NewKey);
+
+	TArray<FEntry> Entries;
+
+	/**
+	 * Entries are compared by their full key as well, FString keys in TMap would ignore case
+	 */
+	TMap<uint64, int32> SlotByHash;
+
+	/**
+	 * Stamp of the last invalidation per collection
+	 */
+	TMap<FString, uint64> InvalidatedAt;
+
+	uint64 AllInvalidatedAt = 0;
+
+	uint64 Stamp = 1;
+
+	/**
+	 * Most and least recently used entries
+	 */
+	int32 Head = INDEX_NONE;
+	int32 Tail = INDEX_NONE;
+
+	int32 FirstFree = INDEX_NONE;
+
+	int32 TotalBytes = 0;
+
+	int32 MaxBytes = 1024 * 1024;
+
+	FLobbyDBCacheStats Stats;
+};
@@ -0,0 +1,158 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LobbyTypes.h"
+
+/**
+ * The authored enumerator names the server reads and writes, built at compile time.
+ * UEnum gives the same names only after a lookup and a FString copy per call.
+ * The order has to follow the enum declarations in LobbyTypes.h, FLobbyBenchmark::VerifySerializers checks it against reflection.
+ */
+namespace NGG_LOBBY_ENUM_NAMES
+{
+	template <int32 Length>
+	constexpr FAnsiStringView Name(const ANSICHAR (&NewName)[Length])
+	{
+		return FAnsiStringView(NewName, Length - 1);
+	}
+
+	constexpr FAnsiStringView ACTION_TYPES[] =
+	{
+		 Name("NONE")
+		,Name("DATABASE")
+		,Name("TEXT_CHAT")
+		,Name("FIND_PLAYER")
+		,Name("REGISTER_PLAYER_INTO_LOBBY")
+		,Name("REQUEST_STATUS")
+		,Name("RESYNC")
+	};
+	static_assert(UE_ARRAY_COUNT(ACTION_TYPES) == static_cast<int32>(ELobbyActionType::RESYNC) + 1, "ELobbyActionType changed, update ACTION_TYPES");
+
+	constexpr FAnsiStringView DB_ACTION_TYPES[] =
+	{
+		 Name("NONE")
+		,Name("AGGREGATE")
+		,Name("DROP_COLLECTION")
+		,Name("CREATE_COLLECTION")
+		,Name("FIND")
+		,Name("FIND_WITH_OPTIONS")
+		,Name("FIND_ONE")
+		,Name("FIND_ONE_WITH_OPTIONS")
+		,Name("INSERT_ONE")
+		,Name("INSERT_MANY")
+		,Name("LIST_DATABASES")
+		,Name("LIST_COLLECTION_NAMES")
+		,Name("LIST_INDEXES")
+		,Name("CREATE_INDEX")
+		,Name("DELETE_ONE")
+		,Name("DELETE_MANY")
+		,Name("GET_ESTIMATED_DOCUMENT_COUNT")
+		,Name("COUNT_DOCUMENTS")
+		,Name("RENAME_COLLECTION")
+		,Name("RUN_COMMAND")
+		,Name("REPLACE_ONE")
+		,Name("UPDATE_ONE")
+		,Name("UPDATE_ONE_WITH_OPTIONS")
+		,Name("UPDATE_MANY")
+		,Name("UPDATE_MANY_WITH_OPTIONS")
+		,Name("FIND_ONE_AND_DELETE")
+		,Name("FIND_ONE_AND_REPLACE")
+		,Name("FIND_ONE_AND_UPDATE")
+		,Name("BULK_WRITE")
+		,Name("GET_MORE")
+		,Name("KILL_CURSOR")
+	};
+	static_assert(UE_ARRAY_COUNT(DB_ACTION_TYPES) == static_cast<int32>(EMongoDBActionType::KILL_CURSOR) + 1, "EMongoDBActionType changed, update DB_ACTION_TYPES");
+
+	constexpr FAnsiStringView BULK_OPERATION_TYPES[] =
+	{
+		 Name("INSERT_ONE")
+		,Name("UPDATE_ONE")
+		,Name("UPDATE_MANY")
+		,Name("REPLACE_ONE")
+		,Name("DELETE_ONE")
+		,Name("DELETE_MANY")
+	};
+	static_assert(UE_ARRAY_COUNT(BULK_OPERATION_TYPES) == static_cast<int32>(EMongoDBBulkOperationType::DELETE_MANY) + 1, "EMongoDBBulkOperationType changed, update BULK_OPERATION_TYPES");
+
+	constexpr FAnsiStringView SYNC_STREAMS[] =
+	{
+		 Name("NONE")
+		,Name("CHAT")
+		,Name("LOBBY")
+		,Name("SUBSCRIPTIONS")
+	};
+	static_assert(UE_ARRAY_COUNT(SYNC_STREAMS) == static_cast<int32>(ELobbySyncStream::SUBSCRIPTIONS) + 1, "ELobbySyncStream changed, update SYNC_STREAMS");
+};
+
+/**
+ * Enum to name and back through the tables above, without touching UEnum
+ */
+class FLobbyEnumNames
+{
+public:
+
+	static TConstArrayView<FAnsiStringView> GetTable(ELobbyActionType) { return MakeArrayView(NGG_LOBBY_ENUM_NAMES::ACTION_TYPES); }
+
+	static TConstArrayView<FAnsiStringView> GetTable(EMongoDBActionType) { return MakeArrayView(NGG_LOBBY_ENUM_NAMES::DB_ACTION_TYPES); }
+
+	static TConstArrayView<FAnsiStringView> GetTable(EMongoDBBulkOperationType) { return MakeArrayView(NGG_LOBBY_ENUM_NAMES::BULK_OPERATION_TYPES); }
+
+	static TConstArrayView<FAnsiStringView> GetTable(ELobbySyncStream) { return MakeArrayView(NGG_LOBBY_ENUM_NAMES::SYNC_STREAMS); }
+
+	/**
+	 * The names are ASCII, so they go to the UTF-8 writers as they are. Empty for a value outside the enum, like UEnum.
+	 */
+	template <typename EnumType>
+	static FUtf8StringView ToName(EnumType NewValue)
+	{
+		const TConstArrayView<FAnsiStringView> Table = GetTable(NewValue);
+		const int32 Index = static_cast<int32>(NewValue);
+		if (!Table.IsValidIndex(Index))
+		{
+			return FUtf8StringView();
+		}
+		return FUtf8StringView(reinterpret_cast<const UTF8CHAR*>(Table[Index].GetData()), Table[Index].Len());
+	}
+
+	/**
+	 * Case insensitive like the FName lookup of UEnum::GetValueByNameString
+	 */
+	template <typename EnumType, typename CharType>
+	static bool FromName(TStringView<CharType> NewName, EnumType& OutValue)
+	{
+		const TConstArrayView<FAnsiStringView> Table = GetTable(EnumType());
+		for (int32 Index = 0; Index < Table.Num(); ++Index)
+		{
+			if (Equals(Table[Index], NewName))
+			{
+				OutValue = static_cast<EnumType>(Index);
+				return true;
+			}
+		}
+		return false;
+	}
+
+private:
+
+	template <typename CharType>
+	static bool Equals(FAnsiStringView NewTableName, TStringView<CharType> NewName)
+	{
+		if (NewTableName.Len() != NewName.Len())
+		{
+			return false;
+		}
+		for (int32 i = 0; i < NewName.Len(); ++i)
+		{
+			const uint32 Char = static_cast<uint32>(NewName[i]);
+			const uint32 Upper = (Char >= 'a' && Char <= 'z') ? Char - ('a' - 'A') : Char;
+			if (Upper != static_cast<uint32>(NewTableName[i]))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+};
@@ -0,0 +1,303 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LobbyEnvelope.h"
+#include "LobbyFrame.h"
+#include "LobbySigner.h"
+#include "LobbyCompression.h"
+#include "LobbyEnumNames.h"
+#include "LobbyBufferPool.h"
+#include "LobbyJsonView.h"
+
+namespace
+{
+	/**
+	 * True if NewText is one valid JSON object or array, so it can be written into the envelope as it is
+	 */
+	bool IsJsonDocument(FStringView NewText)
+	{
+		FLobbyMessageArena::FMark Mark;
+		TArray<UTF8CHAR>& Text = Mark.AcquireText();
+		const int32 Length = FPlatformString::ConvertedLength<UTF8CHAR>(NewText.GetData(), NewText.Len());
+		Text.SetNumUninitialized(Length);
+		FPlatformString::Convert(Text.GetData(), Length, NewText.GetData(), NewText.Len());
+
+		// Kept per thread so a warm tape validates without allocating
+		static thread_local FLobbyJsonView View;
+		if (!View.Parse(FUtf8StringView(Text.GetData(), Text.Num())))
+		{
+			return false;
+		}
+		const FLobbyJsonView::FValue Root = View.GetRoot();
+		return Root.IsObject() || Root.IsArray();
+	}
+
+	void WriteDocumentText(FLobbyJsonWriter& NewWriter, const FString& NewJson, const TArray<UTF8CHAR>& NewBson)
+	{
+		if (NewBson.IsEmpty())
+		{
+			NewWriter.WriteString(NewJson);
+			return;
+		}
+
+		// JSON servers get the built document as the text they expect
+		FLobbyMessageArena::FMark Mark;
+		TArray<UTF8CHAR>& Text = Mark.AcquireText();
+		{
+			FLobbyJsonWriter TextWriter(Text);
+			FLobbyBsonView(FUtf8StringView(NewBson.GetData(), NewBson.Num())).WriteJson(TextWriter);
+		}
+		NewWriter.WriteString(FUtf8StringView(Text.GetData(), Text.Num()));
+	}
+
+	void WriteDocument(FLobbyBsonWriter& NewWriter, FAnsiStringView NewKey, const FString& NewJson, const TArray<UTF8CHAR>& NewBson = TArray<UTF8CHAR>())
+	{
+		NewWriter.WriteKey(NewKey);
+		if (!NewBson.IsEmpty())
+		{
+			NewWriter.WriteDocument(FUtf8StringView(NewBson.GetData(), NewBson.Num()));
+		}
+		else if (NewJson.IsEmpty())
+		{
+			NewWriter.WriteNull();
+		}
+		else if (!NewWriter.WriteJson(NewJson))
+		{
+			// Not JSON, it goes as the text it is
+			NewWriter.WriteString(NewJson);
+		}
+	}
+}
+
+void FLobbyEnvelope::WriteEnvelope(FLobbyJsonWriter& NewWriter, ELobbyActionType NewAction, FStringView NewClientID, FStringView NewRequestId, bool bNewNestedPayload, FWritePayload NewWritePayload, FStringView NewIdempotencyKey)
+{
+	NewWriter.BeginObject();
+	NewWriter.WriteKey("clientID");
+	NewWriter.WriteString(NewClientID);
+	NewWriter.WriteKey("action");
+	NewWriter.WriteString(FLobbyEnumNames::ToName(NewAction));
+	NewWriter.WriteKey("payLoadData");
+	if (bNewNestedPayload)
+	{
+		NewWritePayload(NewWriter);
+	}
+	else
+	{
+		NewWriter.BeginEmbeddedString();
+		NewWritePayload(NewWriter);
+		NewWriter.EndEmbeddedString();
+	}
+	NewWriter.WriteKey("requestId");
+	NewWriter.WriteString(NewRequestId);
+	if (!NewIdempotencyKey.IsEmpty())
+	{
+		NewWriter.WriteKey("idempotencyKey");
+		NewWriter.WriteString(NewIdempotencyKey);
+	}
+	NewWriter.EndObject();
+}
+
+void FLobbyEnvelope::WriteChatPayload(FLobbyJsonWriter& NewWriter, const FChatData& NewChatData)
+{
+	NewWriter.BeginObject();
+	NewWriter.WriteKey("senderPlayerId");
+	NewWriter.WriteString(NewChatData.SenderPlayerId);
+	NewWriter.WriteKey("message");
+	NewWriter.WriteString(NewChatData.Message);
+	NewWriter.WriteKey("recipientPlayerId");
+	NewWriter.WriteString(NewChatData.RecipientPlayerId);
+	NewWriter.EndObject();
+}
+
+void FLobbyEnvelope::WriteDBPayload(FLobbyJsonWriter& NewWriter, const FMongoDBData& NewMongoDBData)
+{
+	NewWriter.BeginObject();
+	NewWriter.WriteKey("senderPlayerId");
+	NewWriter.WriteString(NewMongoDBData.SenderPlayerId);
+	NewWriter.WriteKey("dbName");
+	NewWriter.WriteString(NewMongoDBData.DbName);
+	NewWriter.WriteKey("collectionName");
+	NewWriter.WriteString(NewMongoDBData.CollectionName);
+	NewWriter.WriteKey("dbAction");
+	NewWriter.WriteString(FLobbyEnumNames::ToName(NewMongoDBData.DbAction));
+	NewWriter.WriteKey("data");
+	WriteDocumentText(NewWriter, NewMongoDBData.Data, NewMongoDBData.DataBson);
+	NewWriter.WriteKey("filter");
+	WriteDocumentText(NewWriter, NewMongoDBData.Filter, NewMongoDBData.FilterBson);
+	NewWriter.WriteKey("options");
+	WriteDocumentText(NewWriter, NewMongoDBData.Options, NewMongoDBData.OptionsBson);
+	// Only cursor requests carry these, everything else stays as it was
+	if (NewMongoDBData.BatchSize > 0)
+	{
+		NewWriter.WriteKey("batchSize");
+		NewWriter.WriteInt(NewMongoDBData.BatchSize);
+	}
+	if (!NewMongoDBData.CursorId.IsEmpty())
+	{
+		NewWriter.WriteKey("cursorId");
+		NewWriter.WriteString(NewMongoDBData.CursorId);
+	}
+	NewWriter.EndObject();
+}
+
+void FLobbyEnvelope::WriteDBBulkPayload(FLobbyJsonWriter& NewWriter, const FMongoDBBulkData& NewMongoDBBulkData)
+{
+	NewWriter.BeginObject();
+	NewWriter.WriteKey("senderPlayerId");
+	NewWriter.WriteString(NewMongoDBBulkData.SenderPlayerId);
+	NewWriter.WriteKey("dbName");
+	NewWriter.WriteString(NewMongoDBBulkData.DbName);
+	NewWriter.WriteKey("collectionName");
+	NewWriter.WriteString(NewMongoDBBulkData.CollectionName);
+	NewWriter.WriteKey("dbAction");
+	NewWriter.WriteString(FLobbyEnumNames::ToName(EMongoDBActionType::BULK_WRITE));
+	NewWriter.WriteKey("ordered");
+	NewWriter.WriteBool(NewMongoDBBulkData.bOrdered);
+	NewWriter.WriteKey("operations");
+	NewWriter.BeginArray();
+	for (const FMongoDBBulkOperation& Operation : NewMongoDBBulkData.Operations)
+	{
+		NewWriter.BeginObject();
+		NewWriter.WriteKey("operationType");
+		NewWriter.WriteString(FLobbyEnumNames::ToName(Operation.OperationType));
+		NewWriter.WriteKey("document");
+		NewWriter.WriteString(Operation.Document);
+		NewWriter.WriteKey("filter");
+		NewWriter.WriteString(Operation.Filter);
+		NewWriter.WriteKey("upsert");
+		NewWriter.WriteBool(Operation.bUpsert);
+		NewWriter.EndObject();
+	}
+	NewWriter.EndArray();
+	NewWriter.EndObject();
+}
+
+void FLobbyEnvelope::WriteTextPayload(FLobbyJsonWriter& NewWriter, FStringView NewPayLoadData, bool bNewNestedPayload)
+{
+	if (!bNewNestedPayload)
+	{
+		// Inside the embedded string the text is escaped by the writer
+		NewWriter.WriteRawValue(NewPayLoadData);
+		return;
+	}
+
+	// Only a valid document goes in raw, anything else would corrupt the envelope and goes as the text it is
+	const FStringView Trimmed = NewPayLoadData.TrimStart();
+	if (!Trimmed.IsEmpty() && (Trimmed[0] == TEXT('{') || Trimmed[0] == TEXT('[')) && IsJsonDocument(Trimmed))
+	{
+		NewWriter.WriteRawValue(Trimmed);
+	}
+	else
+	{
+		NewWriter.WriteString(NewPayLoadData);
+	}
+}
+
+void FLobbyEnvelope::WriteEnvelope(FLobbyBsonWriter& NewWriter, ELobbyActionType NewAction, FStringView NewClientID, FStringView NewRequestId, FWriteBsonPayload NewWritePayload, FStringView NewIdempotencyKey)
+{
+	NewWriter.BeginObject();
+	NewWriter.WriteKey("clientID");
+	NewWriter.WriteString(NewClientID);
+	NewWriter.WriteKey("action");
+	NewWriter.WriteString(FLobbyEnumNames::ToName(NewAction));
+	NewWriter.WriteKey("payLoadData");
+	NewWritePayload(NewWriter);
+	NewWriter.WriteKey("requestId");
+	NewWriter.WriteString(NewRequestId);
+	if (!NewIdempotencyKey.IsEmpty())
+	{
+		NewWriter.WriteKey("idempotencyKey");
+		NewWriter.WriteString(NewIdempotencyKey);
+	}
+	NewWriter.EndObject();
+}
+
+void FLobbyEnvelope::WriteDBPayload(FLobbyBsonWriter& NewWriter, const FMongoDBData& NewMongoDBData)
+{
+	NewWriter.BeginObject();
+	NewWriter.WriteKey("senderPlayerId");
+	NewWriter.WriteString(NewMongoDBData.SenderPlayerId);
+	NewWriter.WriteKey("dbName");
+	NewWriter.WriteString(NewMongoDBData.DbName);
+	NewWriter.WriteKey("collectionName");
+	NewWriter.WriteString(NewMongoDBData.CollectionName);
+	NewWriter.WriteKey("dbAction");
+	NewWriter.WriteString(FLobbyEnumNames::ToName(NewMongoDBData.DbAction));
+	WriteDocument(NewWriter, "data", NewMongoDBData.Data, NewMongoDBData.DataBson);
+	WriteDocument(NewWriter, "filter", NewMongoDBData.Filter, NewMongoDBData.FilterBson);
+	WriteDocument(NewWriter, "options", NewMongoDBData.Options, NewMongoDBData.OptionsBson);
+	if (NewMongoDBData.BatchSize > 0)
+	{
+		NewWriter.WriteKey("batchSize");
+		NewWriter.WriteInt(NewMongoDBData.BatchSize);
+	}
+	if (!NewMongoDBData.CursorId.IsEmpty())
+	{
+		NewWriter.WriteKey("cursorId");
+		NewWriter.WriteString(NewMongoDBData.CursorId);
+	}
+	NewWriter.EndObject();
+}
+
+void FLobbyEnvelope::WriteDBBulkPayload(FLobbyBsonWriter& NewWriter, const FMongoDBBulkData& NewMongoDBBulkData)
+{
+	NewWriter.BeginObject();
+	NewWriter.WriteKey("senderPlayerId");
+	NewWriter.WriteString(NewMongoDBBulkData.SenderPlayerId);
+	NewWriter.WriteKey("dbName");
+	NewWriter.WriteString(NewMongoDBBulkData.DbName);
+	NewWriter.WriteKey("collectionName");
+	NewWriter.WriteString(NewMongoDBBulkData.CollectionName);
+	NewWriter.WriteKey("dbAction");
+	NewWriter.WriteString(FLobbyEnumNames::ToName(EMongoDBActionType::BULK_WRITE));
+	NewWriter.WriteKey("ordered");
+	NewWriter.WriteBool(NewMongoDBBulkData.bOrdered);
+	NewWriter.WriteKey("operations");
+	NewWriter.BeginArray();
+	for (const FMongoDBBulkOperation& Operation : NewMongoDBBulkData.Operations)
+	{
+		NewWriter.BeginObject();
+		NewWriter.WriteKey("operationType");
+		NewWriter.WriteString(FLobbyEnumNames::ToName(Operation.OperationType));
+		WriteDocument(NewWriter, "document", Operation.Document);
+		WriteDocument(NewWriter, "filter", Operation.Filter);
+		NewWriter.WriteKey("upsert");
+		NewWriter.WriteBool(Operation.bUpsert);
+		NewWriter.EndObject();
+	}
+	NewWriter.EndArray();
+	NewWriter.EndObject();
+}
+
+bool FLobbyEnvelope::CookFrame(TArray<UTF8CHAR>& NewFrame, FLobbySigner& NewSigner, bool bNewLengthPrefixed, int64 NewTimestamp, FWritePayload NewWriteBody, FLobbyDeflater* NewDeflater, int32 NewMinCompressBytes, bool bNewBsonBody)
+{
+	// The legacy layout finds the body by its braces, BSON has none
+	if (!NewSigner.HasKey() || (bNewBsonBody && !bNewLengthPrefixed))
+	{
+		return false;
+	}
+
+	FLobbyFrameWriter FrameWriter(NewFrame, bNewLengthPrefixed);
+	const ANSICHAR BsonFlag[] = { NGG_LOBBY_PROTOCOL_V2::FLAG_BSON_LETTER };
+	FrameWriter.BeginBody(NewSigner.GetClientIdUtf8(), NewTimestamp, bNewBsonBody ? FAnsiStringView(BsonFlag, 1) : FAnsiStringView());
+	{
+		FLobbyJsonWriter JsonWriter(NewFrame);
+		NewWriteBody(JsonWriter);
+	}
+	const FUtf8StringView Body = FrameWriter.EndBody();
+
+	// The body is signed where it lies, the signature goes on a stack buffer before the frame can grow
+	UTF8CHAR Signature[FLobbySigner::SIGNATURE_LENGTH];
+	if (!NewSigner.Sign(NewTimestamp, Body, Signature))
+	{
+		return false;
+	}
+
+	// Signed before compression, the receiver verifies the body it inflated
+	if (NewDeflater != nullptr && bNewLengthPrefixed && NewDeflater->TryCompress(Body, NewMinCompressBytes))
+	{
+		FrameWriter.ReplaceBody(NewDeflater->GetCompressed(), NGG_LOBBY_PROTOCOL_V2::FLAG_DEFLATE_LETTER);
+	}
+	FrameWriter.WriteSignature(FUtf8StringView(Signature, FLobbySigner::SIGNATURE_LENGTH));
+	return true;
+}
@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LobbyTypes.h"
+#include "LobbyJsonWriter.h"
+#include "LobbyBson.h"
+
+class FLobbySigner;
+class FLobbyDeflater;
+
+/**
+ * Writes FNGGLobbyData envelopes and their payloads with FLobbyJsonWriter and turns them into
+ * signed frames. Field names and order follow FJsonObjectConverter for the same structs.
+ */
+struct LOBBYCLIENT_API FLobbyEnvelope
+{
+	using FWritePayload = TFunctionRef<void(FLobbyJsonWriter&)>;
+
+	using FWriteBsonPayload = TFunctionRef<void(FLobbyBsonWriter&)>;
+
+	/**
+	 * Write {"clientID","action","payLoadData","requestId"}. The payload is nested as a JSON value
+	 * if bNewNestedPayload is set, otherwise it is written as an escaped string for legacy servers.
+	 * Writes that may be replayed after a reconnect add "idempotencyKey", the server applies a key once.
+	 */
+	static void WriteEnvelope(FLobbyJsonWriter& NewWriter, ELobbyActionType NewAction, FStringView NewClientID, FStringView NewRequestId, bool bNewNestedPayload, FWritePayload NewWritePayload, FStringView NewIdempotencyKey = FStringView());
+
+	static void WriteChatPayload(FLobbyJsonWriter& NewWriter, const FChatData& NewChatData);
+
+	static void WriteDBPayload(FLobbyJsonWriter& NewWriter, const FMongoDBData& NewMongoDBData);
+
+	/**
+	 * Write a BULK_WRITE payload, the operations keep the order they were added in
+	 */
+	static void WriteDBBulkPayload(FLobbyJsonWriter& NewWriter, const FMongoDBBulkData& NewMongoDBBulkData);
+
+	/**
+	 * Payloads given as text. Nested mode keeps valid JSON objects and arrays as they are and writes anything else as a string.
+	 */
+	static void WriteTextPayload(FLobbyJsonWriter& NewWriter, FStringView NewPayLoadData, bool bNewNestedPayload);
+
+	/**
+	 * The same envelope as a BSON document, the payload is always nested
+	 */
+	static void WriteEnvelope(FLobbyBsonWriter& NewWriter, ELobbyActionType NewAction, FStringView NewClientID, FStringView NewRequestId, FWriteBsonPayload NewWritePayload, FStringView NewIdempotencyKey = FStringView());
+
+	/**
+	 * Data, Filter and Options become embedded documents, JSON text is converted without being escaped into a string
+	 */
+	static void WriteDBPayload(FLobbyBsonWriter& NewWriter, const FMongoDBData& NewMongoDBData);
+
+	static void WriteDBBulkPayload(FLobbyBsonWriter& NewWriter, const FMongoDBBulkData& NewMongoDBBulkData);
+
+	/**
+	 * Write the frame for one body into NewFrame, sign the body where it lies and append the signature.
+	 * With a deflater, length-prefixed bodies of at least NewMinCompressBytes are sent deflated if that makes them smaller.
+	 * A BSON body is copied in with WriteRawValue and needs the length-prefixed layout.
+	 */
+	static bool CookFrame(TArray<UTF8CHAR>& NewFrame, FLobbySigner& NewSigner, bool bNewLengthPrefixed, int64 NewTimestamp, FWritePayload NewWriteBody, FLobbyDeflater* NewDeflater = nullptr, int32 NewMinCompressBytes = 0, bool bNewBsonBody = false);
+};
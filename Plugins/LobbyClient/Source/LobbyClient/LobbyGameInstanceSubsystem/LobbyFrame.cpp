@@ -0,0 +1,321 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LobbyFrame.h"
+
+namespace
+{
+	bool ReadSection(FUtf8StringView NewFrame, int32& InOutCursor, FUtf8StringView& OutSection)
+	{
+		const UTF8CHAR* Data = NewFrame.GetData();
+		const int32 FrameLength = NewFrame.Len();
+
+		int64 SectionLength = 0;
+		int32 DigitCount = 0;
+		while (InOutCursor < FrameLength && Data[InOutCursor] >= '0' && Data[InOutCursor] <= '9')
+		{
+			if (++DigitCount > NGG_LOBBY_PROTOCOL_V2::MAX_SECTION_LENGTH_DIGITS)
+			{
+				return false;
+			}
+			SectionLength = SectionLength * 10 + (Data[InOutCursor] - '0');
+			++InOutCursor;
+		}
+
+		if (DigitCount == 0 || InOutCursor >= FrameLength || Data[InOutCursor] != NGG_LOBBY_PROTOCOL_V2::SECTION_DELIMITER)
+		{
+			return false;
+		}
+		++InOutCursor;
+
+		if (SectionLength > FrameLength - InOutCursor)
+		{
+			return false;
+		}
+
+		OutSection = FUtf8StringView(Data + InOutCursor, static_cast<int32>(SectionLength));
+		InOutCursor += static_cast<int32>(SectionLength);
+		return true;
+	}
+}
+
+bool FLobbyFrameParser::Parse(FUtf8StringView NewFrame, FLobbyFrameView& OutFrameView)
+{
+	// A legacy client id may start with the magic too, such a frame only fails the length-prefixed layout
+	if (IsLengthPrefixed(NewFrame) && ParseLengthPrefixed(NewFrame, OutFrameView))
+	{
+		return true;
+	}
+	return ParseLegacy(NewFrame, OutFrameView);
+}
+
+bool FLobbyFrameParser::IsLengthPrefixed(FUtf8StringView NewFrame)
+{
+	return NewFrame.Len() > NGG_LOBBY_PROTOCOL_V2::MAGIC_LENGTH
+		&& FMemory::Memcmp(NewFrame.GetData(), NGG_LOBBY_PROTOCOL_V2::MAGIC, NGG_LOBBY_PROTOCOL_V2::MAGIC_LENGTH) == 0;
+}
+
+bool FLobbyFrameParser::ParseLengthPrefixed(FUtf8StringView NewFrame, FLobbyFrameView& OutFrameView)
+{
+	OutFrameView = FLobbyFrameView{};
+	if (!IsLengthPrefixed(NewFrame))
+	{
+		return false;
+	}
+
+	int32 Cursor = NGG_LOBBY_PROTOCOL_V2::MAGIC_LENGTH;
+	uint8 Flags = NGG_LOBBY_PROTOCOL_V2::FRAME_FLAG_NONE;
+	for (; Cursor < NewFrame.Len() && NewFrame[Cursor] != NGG_LOBBY_PROTOCOL_V2::SECTION_DELIMITER; ++Cursor)
+	{
+		uint8 Flag = NGG_LOBBY_PROTOCOL_V2::FRAME_FLAG_NONE;
+		switch (static_cast<ANSICHAR>(NewFrame[Cursor]))
+		{
+		case NGG_LOBBY_PROTOCOL_V2::FLAG_DEFLATE_LETTER: Flag = NGG_LOBBY_PROTOCOL_V2::FRAME_FLAG_DEFLATE; break;
+		case NGG_LOBBY_PROTOCOL_V2::FLAG_BSON_LETTER:    Flag = NGG_LOBBY_PROTOCOL_V2::FRAME_FLAG_BSON; break;
+		default: break;
+		}
+
+		// Unknown or repeated flags could change how the body is read, such frames are refused
+		if (Flag == NGG_LOBBY_PROTOCOL_V2::FRAME_FLAG_NONE || (Flags & Flag) != 0)
+		{
+			return false;
+		}
+		Flags |= Flag;
+	}
+	if (Cursor >= NewFrame.Len())
+	{
+		return false;
+	}
+	++Cursor;
+
+	for (FUtf8StringView& Part : OutFrameView.Parts)
+	{
+		if (!ReadSection(NewFrame, Cursor, Part))
+		{
+			return false;
+		}
+	}
+
+	// Trailing bytes mean the sender and receiver disagree about the layout
+	if (Cursor != NewFrame.Len())
+	{
+		return false;
+	}
+
+	OutFrameView.Version = 2;
+	OutFrameView.Flags = Flags;
+	return true;
+}
+
+bool FLobbyFrameParser::ParseLegacy(FUtf8StringView NewFrame, FLobbyFrameView& OutFrameView)
+{
+	OutFrameView = FLobbyFrameView{};
+
+	const UTF8CHAR* Data = NewFrame.GetData();
+	const int32 FrameLength = NewFrame.Len();
+	if (FrameLength <= NGG_LOBBY_PROTOCOL::CLIENT_ID_LENGTH)
+	{
+		return false;
+	}
+
+	// The body is one envelope object or, for a batch, an array of them
+	int32 JsonStartIndex = INDEX_NONE;
+	for (int32 i = NGG_LOBBY_PROTOCOL::CLIENT_ID_LENGTH; i < FrameLength; ++i)
+	{
+		if (Data[i] == '{' || Data[i] == '[') { JsonStartIndex = i; break; }
+	}
+	if (JsonStartIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	// Find the matching closing brace or bracket, skipping over string contents
+	int32 BraceCount = 0, JsonEndIndex = INDEX_NONE;
+	bool bInString = false, bEscaped = false;
+	for (int32 i = JsonStartIndex; i < FrameLength; ++i)
+	{
+		const UTF8CHAR Char = Data[i];
+		if (bInString)
+		{
+			if (bEscaped)
+			{
+				bEscaped = false;
+			}
+			else if (Char == '\\')
+			{
+				bEscaped = true;
+			}
+			else if (Char == '"')
+			{
+				bInString = false;
+			}
+			continue;
+		}
+
+		if (Char == '"')
+		{
+			bInString = true;
+		}
+		else if (Char == '{' || Char == '[')
+		{
+			++BraceCount;
+		}
+		else if ((Char == '}' || Char == ']') && --BraceCount == 0)
+		{
+			JsonEndIndex = i;
+			break;
+		}
+	}
+	if (JsonEndIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	OutFrameView.Parts[NGG_LOBBY_PROTOCOL::CLIENT_ID] = NewFrame.Left(NGG_LOBBY_PROTOCOL::CLIENT_ID_LENGTH);
+	OutFrameView.Parts[NGG_LOBBY_PROTOCOL::TIMESTAMP] = NewFrame.Mid(NGG_LOBBY_PROTOCOL::CLIENT_ID_LENGTH, JsonStartIndex - NGG_LOBBY_PROTOCOL::CLIENT_ID_LENGTH);
+	OutFrameView.Parts[NGG_LOBBY_PROTOCOL::JSON] = NewFrame.Mid(JsonStartIndex, (JsonEndIndex - JsonStartIndex) + 1);
+	OutFrameView.Parts[NGG_LOBBY_PROTOCOL::SIGNATURE] = NewFrame.Mid(JsonEndIndex + 1);
+	OutFrameView.Version = 1;
+	return true;
+}
+
+bool FLobbyFrameParser::ParseTimestamp(FUtf8StringView NewTimestamp, int64& OutTimestamp)
+{
+	// 18 digits always fit into int64
+	if (NewTimestamp.IsEmpty() || NewTimestamp.Len() > 18)
+	{
+		return false;
+	}
+
+	int64 Timestamp = 0;
+	for (const UTF8CHAR Char : NewTimestamp)
+	{
+		if (Char < '0' || Char > '9')
+		{
+			return false;
+		}
+		Timestamp = Timestamp * 10 + (Char - '0');
+	}
+	OutTimestamp = Timestamp;
+	return true;
+}
+
+FLobbyFrameWriter::FLobbyFrameWriter(TArray<UTF8CHAR>& NewBuffer, bool bNewLengthPrefixed)
+	: Buffer(NewBuffer)
+	, bLengthPrefixed(bNewLengthPrefixed)
+{
+}
+
+void FLobbyFrameWriter::BeginBody(FUtf8StringView NewClientId, int64 NewTimestamp, FAnsiStringView NewFlagLetters)
+{
+	// Keep the allocation of the previous frame
+	Buffer.Reset();
+
+	UTF8CHAR TimestampDigits[24];
+	const int32 TimestampLength = FormatTimestamp(NewTimestamp, TimestampDigits);
+
+	if (bLengthPrefixed)
+	{
+		Buffer.Append(reinterpret_cast<const UTF8CHAR*>(NGG_LOBBY_PROTOCOL_V2::MAGIC), NGG_LOBBY_PROTOCOL_V2::MAGIC_LENGTH);
+		Buffer.Append(reinterpret_cast<const UTF8CHAR*>(NewFlagLetters.GetData()), NewFlagLetters.Len());
+		Buffer.Add(UTF8CHAR(NGG_LOBBY_PROTOCOL_V2::SECTION_DELIMITER));
+		WriteSection(NewClientId);
+		WriteSection(FUtf8StringView(TimestampDigits, TimestampLength));
+
+		BodyLengthOffset = Buffer.Num();
+		Buffer.AddUninitialized(BODY_LENGTH_DIGITS);
+		Buffer.Add(UTF8CHAR(NGG_LOBBY_PROTOCOL_V2::SECTION_DELIMITER));
+	}
+	else
+	{
+		Buffer.Append(NewClientId.GetData(), NewClientId.Len());
+		Buffer.Append(TimestampDigits, TimestampLength);
+	}
+	BodyStart = Buffer.Num();
+}
+
+FUtf8StringView FLobbyFrameWriter::EndBody()
+{
+	check(BodyStart != INDEX_NONE);
+	const int32 BodyLength = Buffer.Num() - BodyStart;
+
+	if (bLengthPrefixed)
+	{
+		int32 Remaining = BodyLength;
+		for (int32 i = BODY_LENGTH_DIGITS - 1; i >= 0; --i)
+		{
+			Buffer[BodyLengthOffset + i] = static_cast<UTF8CHAR>('0' + Remaining % 10);
+			Remaining /= 10;
+		}
+	}
+	return FUtf8StringView(Buffer.GetData() + BodyStart, BodyLength);
+}
+
+void FLobbyFrameWriter::ReplaceBody(FUtf8StringView NewBody, ANSICHAR NewFlagLetter)
+{
+	check(bLengthPrefixed && BodyStart != INDEX_NONE);
+	Buffer.SetNum(BodyStart, EAllowShrinking::No);
+	Buffer.Append(NewBody.GetData(), NewBody.Len());
+
+	// The flag goes right after the magic, everything behind it moves by one
+	Buffer.Insert(UTF8CHAR(NewFlagLetter), NGG_LOBBY_PROTOCOL_V2::MAGIC_LENGTH);
+	++BodyLengthOffset;
+	++BodyStart;
+	EndBody();
+}
+
+void FLobbyFrameWriter::WriteSignature(FUtf8StringView NewSignature)
+{
+	if (bLengthPrefixed)
+	{
+		WriteSection(NewSignature);
+	}
+	else
+	{
+		Buffer.Append(NewSignature.GetData(), NewSignature.Len());
+	}
+}
+
+void FLobbyFrameWriter::WriteSection(FUtf8StringView NewSection)
+{
+	WriteLength(NewSection.Len());
+	Buffer.Add(UTF8CHAR(NGG_LOBBY_PROTOCOL_V2::SECTION_DELIMITER));
+	Buffer.Append(NewSection.GetData(), NewSection.Len());
+}
+
+void FLobbyFrameWriter::WriteLength(int32 NewLength)
+{
+	UTF8CHAR Digits[24];
+	const int32 DigitCount = FormatTimestamp(NewLength, Digits);
+	Buffer.Append(Digits, DigitCount);
+}
+
+int32 FLobbyFrameWriter::FormatTimestamp(int64 NewTimestamp, UTF8CHAR (&OutDigits)[24])
+{
+	ANSICHAR Reversed[24];
+	int32 Count = 0;
+	uint64 Magnitude = NewTimestamp < 0 ? 0ull - static_cast<uint64>(NewTimestamp) : static_cast<uint64>(NewTimestamp);
+	do
+	{
+		Reversed[Count++] = static_cast<ANSICHAR>('0' + Magnitude % 10);
+		Magnitude /= 10;
+	}
+	while (Magnitude != 0);
+
+	int32 R_Length = 0;
+	if (NewTimestamp < 0)
+	{
+		OutDigits[R_Length++] = UTF8CHAR('-');
+	}
+	while (Count > 0)
+	{
+		OutDigits[R_Length++] = static_cast<UTF8CHAR>(Reversed[--Count]);
+	}
+	return R_Length;
+}
+
+int64 FLobbyFrameWriter::GetCurrentTimestamp()
+{
+	const FDateTime CurrentDateTime = FDateTime::UtcNow();
+	return CurrentDateTime.ToUnixTimestamp() * 1000 + CurrentDateTime.GetMillisecond();
+}
@@ -0,0 +1,173 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Legacy layout: ClientId(32) + Timestamp + {JSON body} + Signature, boundaries found by scanning.
+ * A batch body is a JSON array of envelopes: ClientId(32) + Timestamp + [{..},{..}] + Signature.
+ */
+namespace NGG_LOBBY_PROTOCOL
+{
+	enum PRATACOL
+	{
+		  CLIENT_ID = 0x0
+		, TIMESTAMP = 0x1
+		, JSON      = 0x2
+		, SIGNATURE = 0x3
+	};
+	const int32 PART_PRATACOL_COUNT = 4;
+
+	const int32 CLIENT_ID_LENGTH = 32;
+};
+
+/**
+ * Length-prefixed layout: "NGG2:" followed by the four sections of the legacy layout,
+ * each written as <decimal byte length>:<bytes>. Example: NGG2:32:<id>13:<ts>2:{}64:<sig>
+ */
+namespace NGG_LOBBY_PROTOCOL_V2
+{
+	const ANSICHAR MAGIC[] = "NGG2";
+	const int32 MAGIC_LENGTH = 4;
+	const ANSICHAR SECTION_DELIMITER = ':';
+
+	/**
+	 * Up to 10 digits keeps every section length inside int32 range checks
+	 */
+	const int32 MAX_SECTION_LENGTH_DIGITS = 10;
+
+	/**
+	 * Flag letters may follow the magic, "NGG2z:" carries a deflated body.
+	 * The signature always covers the body before compression.
+	 */
+	const ANSICHAR FLAG_DEFLATE_LETTER = 'z';
+
+	/**
+	 * "NGG2b:" carries one envelope as a BSON document instead of JSON
+	 */
+	const ANSICHAR FLAG_BSON_LETTER = 'b';
+
+	enum EFrameFlags : uint8
+	{
+		  FRAME_FLAG_NONE    = 0
+		, FRAME_FLAG_DEFLATE = 1 << 0
+		, FRAME_FLAG_BSON    = 1 << 1
+	};
+};
+
+/**
+ * Non-owning view of one received frame. Every part points into the receive buffer,
+ * so the view is only valid until that buffer is reused.
+ */
+struct FLobbyFrameView
+{
+	FUtf8StringView Parts[NGG_LOBBY_PROTOCOL::PART_PRATACOL_COUNT];
+
+	/**
+	 * The framing version the frame was parsed with, 0 if the frame is not valid
+	 */
+	uint8 Version = 0;
+
+	/**
+	 * NGG_LOBBY_PROTOCOL_V2::EFrameFlags, always 0 for the legacy layout
+	 */
+	uint8 Flags = NGG_LOBBY_PROTOCOL_V2::FRAME_FLAG_NONE;
+
+	bool IsValid() const { return Version != 0; }
+
+	const FUtf8StringView& operator[](NGG_LOBBY_PROTOCOL::PRATACOL NewPart) const { return Parts[NewPart]; }
+};
+
+/**
+ * Splits received frames into their protocol parts without copying.
+ */
+struct LOBBYCLIENT_API FLobbyFrameParser
+{
+	/**
+	 * Detect the framing version from the frame prefix and parse it. A frame that starts with the
+	 * magic but is not length-prefixed is parsed with the legacy layout, its client id may start with "NGG2".
+	 */
+	static bool Parse(FUtf8StringView NewFrame, FLobbyFrameView& OutFrameView);
+
+	/**
+	 * Parse the length-prefixed layout. Fails on any section that does not fit the frame.
+	 */
+	static bool ParseLengthPrefixed(FUtf8StringView NewFrame, FLobbyFrameView& OutFrameView);
+
+	/**
+	 * Parse the legacy layout. Braces and brackets inside JSON strings do not count towards the body nesting,
+	 * a mismatched pair is left for the JSON parser to refuse.
+	 */
+	static bool ParseLegacy(FUtf8StringView NewFrame, FLobbyFrameView& OutFrameView);
+
+	/**
+	 * True if the frame starts with the magic, which a legacy client id can do as well.
+	 * FLobbyFrameView::Version tells which layout a parsed frame had.
+	 */
+	static bool IsLengthPrefixed(FUtf8StringView NewFrame);
+
+	/**
+	 * Decimal digits only, no sign and no whitespace
+	 */
+	static bool ParseTimestamp(FUtf8StringView NewTimestamp, int64& OutTimestamp);
+};
+
+/**
+ * Writes one outgoing frame into a reusable UTF-8 buffer. The body is written in place between
+ * BeginBody and EndBody, the length-prefixed layout reserves a fixed width for the body length
+ * and patches it afterwards, so the body is never copied.
+ */
+class LOBBYCLIENT_API FLobbyFrameWriter
+{
+public:
+
+	/**
+	 * Width of the zero padded body length written by the length-prefixed layout
+	 */
+	static constexpr int32 BODY_LENGTH_DIGITS = NGG_LOBBY_PROTOCOL_V2::MAX_SECTION_LENGTH_DIGITS;
+
+	FLobbyFrameWriter(TArray<UTF8CHAR>& NewBuffer, bool bNewLengthPrefixed);
+
+	/**
+	 * Reset the buffer and write everything that precedes the body. Flag letters only go into the length-prefixed layout.
+	 */
+	void BeginBody(FUtf8StringView NewClientId, int64 NewTimestamp, FAnsiStringView NewFlagLetters = FAnsiStringView());
+
+	/**
+	 * Close the body section. The returned view is valid until the buffer grows again.
+	 */
+	FUtf8StringView EndBody();
+
+	/**
+	 * Swap the body written since BeginBody for NewBody and mark the frame with NewFlagLetter.
+	 * Only for the length-prefixed layout, call it between EndBody and WriteSignature.
+	 */
+	void ReplaceBody(FUtf8StringView NewBody, ANSICHAR NewFlagLetter);
+
+	void WriteSignature(FUtf8StringView NewSignature);
+
+	/**
+	 * Decimal form of NewTimestamp as it is signed and framed, returns the written length
+	 */
+	static int32 FormatTimestamp(int64 NewTimestamp, UTF8CHAR (&OutDigits)[24]);
+
+	/**
+	 * Milliseconds since the Unix epoch in UTC, the clock every frame is stamped and checked with
+	 */
+	static int64 GetCurrentTimestamp();
+
+private:
+
+	void WriteSection(FUtf8StringView NewSection);
+
+	void WriteLength(int32 NewLength);
+
+	TArray<UTF8CHAR>& Buffer;
+
+	bool bLengthPrefixed;
+
+	int32 BodyLengthOffset = INDEX_NONE;
+
+	int32 BodyStart = INDEX_NONE;
+};
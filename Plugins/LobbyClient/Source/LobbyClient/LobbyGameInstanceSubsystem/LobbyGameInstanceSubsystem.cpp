@@ -2,15 +2,14 @@
 
 
 #include "LobbyGameInstanceSubsystem.h"
+#include "LobbyDBCursor.h"
+#include "LobbyEnumNames.h"
+#include "LobbyStats.h"
+#include "LobbyClient.h"
 #include "WebSocketsModule.h"
 #include <JsonObjectConverter.h>
-
-namespace OpenSSLWrapper
-{
-	#include "openssl/hmac.h"
-	#include "openssl/evp.h"
-	#include "Misc/Guid.h"
-}
+#include "Misc/Guid.h"
+#include "Hash/xxhash.h"
 
 
 ULobbyGameInstanceSubsystem::ULobbyGameInstanceSubsystem()
@@ -18,125 +17,379 @@ ULobbyGameInstanceSubsystem::ULobbyGameInstanceSubsystem()
 {
 	// Initialize the WebSocket module
 	FModuleManager::Get().LoadModuleChecked<FWebSocketsModule>("WebSockets");	
+	// The primary connection always exists, requests made before connecting wait or fail there
+	Connections.Add(MakeUnique<FLobbyConnection>(NextConnectionId++, ELobbyChannel::PRIMARY));
 }
 
 ULobbyGameInstanceSubsystem::~ULobbyGameInstanceSubsystem()
 {
-	if(WebSocket.IsValid())
+	for (const TUniquePtr<FLobbyConnection>& Connection : Connections)
+	{
+		if (Connection->WebSocket.IsValid())
+		{
+			Connection->WebSocket->Close();
+		}
+	}
+}
+
+void ULobbyGameInstanceSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	ReceiveStage = MakeShared<FLobbyReceiveStage, ESPMode::ThreadSafe>();
+	EnsureSigner();
+	TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ULobbyGameInstanceSubsystem::Tick));
+}
+
+void ULobbyGameInstanceSubsystem::Deinitialize()
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+	TickHandle.Reset();
+	bWantConnection = false;
+	FlushSendQueue();
+	// Nobody will answer these anymore, futures must not be left unset
+	RequestTracker.FailAll(ELobbyRequestStatus::CANCELLED, TEXT("The lobby subsystem was shut down."), FPlatformTime::Seconds());
+	OpenCursors.Reset();
+	LocalResponses.Reset();
+	InFlightReads.Reset();
+	ChatStore.Reset();
+	for (const TUniquePtr<FLobbyConnection>& Connection : Connections)
 	{
-		WebSocket->Close();
+		Connection->OfflineQueue.Reset();
+		Connection->OutboundScheduler.Reset();
+		Connection->ResetUnacknowledged();
+		ReleaseWebSocket(*Connection);
 	}
+	// Blocks until the frames still on the receive pipe are processed, nothing runs on it afterwards
+	ReceiveStage.Reset();
+	Super::Deinitialize();
 }
 
-FString ULobbyGameInstanceSubsystem::GenerateSignature(const FString& NewClientSecret, const FString& NewRequestBodyString, const FString& NewClientId, int64 NewTimestamp) const
+bool ULobbyGameInstanceSubsystem::Tick(float NewDeltaTime)
 {
-	// Use FString instead of std::string
-	FString SecretStr = NewClientSecret;
-	FString Body = NewRequestBodyString;
+	// Indexed loops, callbacks of failed requests may send and touch the connections
+	const double Now = FPlatformTime::Seconds();
+	for (int32 Index = 0; Index < Connections.Num(); ++Index)
+	{
+		FLobbyConnection& Connection = *Connections[Index];
+		Connection.TickBytesSent = 0;
+		if (Connection.State == ELobbyConnectionState::WAITING_TO_RECONNECT && Now >= Connection.NextReconnectTime)
+		{
+			OpenWebSocket(Connection);
+		}
+	}
 
-	FString MessageStr = NewClientId + FString::Printf(TEXT("%lld"), NewTimestamp) + Body;
-	if (bDebug)
+	DispatchReceivedMessages();
+	for (int32 Index = 0; Index < Connections.Num(); ++Index)
 	{
-		UE_LOG(LogTemp, Log, TEXT("----------------- Message ----------------------"));
-		UE_LOG(LogTemp, Log, TEXT("%s"), *MessageStr);
-		UE_LOG(LogTemp, Log, TEXT("----------------- Message ----------------------"));
+		FLobbyConnection& Connection = *Connections[Index];
+		if (Connection.UnacknowledgedEnvelopes.Num() > 0)
+		{
+			// Answered, failed and timed out writes are no longer tracked and need no replay
+			Connection.UnacknowledgedEnvelopes.RemoveAllSwap([this, &Connection](FLobbyRetainedEnvelope& NewRetained)
+			{
+				if (RequestTracker.Contains(NewRetained.RequestId))
+				{
+					return false;
+				}
+				Connection.EnvelopePool.Release(MoveTemp(NewRetained.Envelope));
+				return true;
+			}, EAllowShrinking::No);
+		}
+		PumpOutbound(Connection);
+		FlushConnectionSendQueue(Connection);
 	}
+	RequestTracker.ExpireTimedOut(FPlatformTime::Seconds());
+	return true;
+}
 
-	// HMAC-SHA256 computation
-	unsigned char Result[64];
-	unsigned int ResultLength;
+void ULobbyGameInstanceSubsystem::DispatchReceivedMessages()
+{
+	if (LocalResponses.Num() > 0)
+	{
+		// Callbacks may add more, those wait for the next tick
+		TArray<FLobbyResponse> Responses = MoveTemp(LocalResponses);
+		LocalResponses.Reset();
+		const double Now = FPlatformTime::Seconds();
+		for (FLobbyResponse& Response : Responses)
+		{
+			RequestTracker.Complete(Response, Now);
+			OnLobbyMessage.Broadcast(Response);
+		}
+	}
 
-	// Convert FString to UTF-8 encoded char* for HMAC computation
-	FTCHARToUTF8 SecretUtf8(*SecretStr);
-	FTCHARToUTF8 MessageUtf8(*MessageStr);
+	if (!ReceiveStage.IsValid())
+	{
+		return;
+	}
 
-	OpenSSLWrapper::HMAC(OpenSSLWrapper::EVP_sha256(), SecretUtf8.Get(), SecretUtf8.Length(),
-		reinterpret_cast<const unsigned char*>(MessageUtf8.Get()), MessageUtf8.Length(),
-		Result, &ResultLength);
+	// At least one message per tick, then only as many as fit into the budget
+	const double StartTime = FPlatformTime::Seconds();
+	const double EndTime = StartTime + FMath::Max(ReceiveBudgetMilliseconds, 0.f) / 1000.0;
+	FLobbyInboundMessage Message;
+	for (double Now = StartTime; ReceiveStage->Dequeue(Message); Now = FPlatformTime::Seconds())
+	{
+		OnMessageReceived(Message, Now);
+		if (FPlatformTime::Seconds() >= EndTime)
+		{
+			break;
+		}
+	}
+}
 
-	// Convert result to hex string
-	FString Signature = BytesToHex(Result, ResultLength);
-	if (bDebug)
+bool ULobbyGameInstanceSubsystem::EnsureSigner()
+{
+	if (!Signer.IsKeyedFor(JWTConfig.ClientSecret, JWTConfig.ClientId))
 	{
-		UE_LOG(LogTemp, Log, TEXT("Signature : %s"), *Signature);
+		Signer.SetKey(JWTConfig.ClientSecret, JWTConfig.ClientId);
+		if (ReceiveStage.IsValid())
+		{
+			ReceiveStage->SetKey(JWTConfig.ClientSecret, JWTConfig.ClientId);
+		}
 	}
-	return Signature.ToLower();
+	return Signer.HasKey();
+}
+
+void ULobbyGameInstanceSubsystem::SetJWTConfig(const FJWTConfig& NewJWTConfig)
+{
+	JWTConfig = NewJWTConfig;
+	EnsureSigner();
 }
 
-FString ULobbyGameInstanceSubsystem::MakeSendData(const FString& NewRequestBodyString, const FString& NewClientId, int64 NewTimestamp, const FString& NewSignature) const
+void ULobbyGameInstanceSubsystem::OnConnected(int32 NewConnectionId)
 {
-	FString Body = NewRequestBodyString;
-	// Concatenate ClientID, Timestamp, and Body
-	FString MessageStr = NewClientId + FString::Printf(TEXT("%lld"), NewTimestamp) + Body + NewSignature;
-	// Debug output
-	if (bDebug)
+	FLobbyConnection* Connection = FindConnection(NewConnectionId);
+	if (Connection == nullptr)
+	{
+		return;
+	}
+
+	UE_LOG(LogLobbyClient, Log, TEXT("WebSocket connected! Channel: %s"), *UEnum::GetValueAsString(Connection->Channel));
+	const bool bReconnected = Connection->bHasConnected;
+	Connection->bHasConnected = true;
+	Connection->ReconnectAttempt = 0;
+
+	// Registration and the replay go out before anyone listening to the state change can send
+	Connection->State = ELobbyConnectionState::CONNECTED;
+	if (Connection->Channel == ELobbyChannel::PRIMARY && bReconnected && !RegisteredPlayerId.IsEmpty())
+	{
+		RegisterPlayerIntoLobby(RegisteredPlayerId);
+		// The answer of a resync sent on the lost connection will not come
+		ResyncRequestId.Reset();
+		if (ResyncConfig.bEnabled)
+		{
+			RequestResync();
+		}
+	}
+	ReplayOfflineQueue(*Connection);
+	if (Connection->Channel == ELobbyChannel::PRIMARY)
 	{
-		UE_LOG(LogTemp, Log, TEXT("----------------- Message ----------------------"));
-		UE_LOG(LogTemp, Log, TEXT("%s"), *MessageStr);
-		UE_LOG(LogTemp, Log, TEXT("----------------- Message ----------------------"));
+		OnConnectionStateChanged.Broadcast(Connection->State);
 	}
-	return MessageStr;
 }
 
-void ULobbyGameInstanceSubsystem::OnConnected()
+void ULobbyGameInstanceSubsystem::OnConnectionError(const FString& NewError, int32 NewConnectionId)
 {
-	UE_LOG(LogTemp, Log, TEXT("WebSocket connected!"));
+	UE_LOG(LogLobbyClient, Error, TEXT("WebSocket connection error: %s"), *NewError);	
+	if (FLobbyConnection* Connection = FindConnection(NewConnectionId))
+	{
+		HandleConnectionLost(*Connection);
+	}
 }
 
-void ULobbyGameInstanceSubsystem::OnConnectionError(const FString& NewError)
+void ULobbyGameInstanceSubsystem::OnRawMessageReceived(const void* NewData, SIZE_T NewSize, SIZE_T NewBytesRemaining, int32 NewConnectionId)
 {
-	UE_LOG(LogTemp, Error, TEXT("WebSocket connection error: %s"), *NewError);	
+	FLobbyConnection* Connection = FindConnection(NewConnectionId);
+	if (Connection == nullptr)
+	{
+		return;
+	}
+
+	Connection->ReceiveBuffer.Append(static_cast<const uint8*>(NewData), static_cast<int32>(NewSize));
+	INC_DWORD_STAT_BY(STAT_LobbyBytesReceived, NewSize);
+	CSV_CUSTOM_STAT(Lobby, BytesReceived, static_cast<int32>(NewSize), ECsvCustomStatOp::Accumulate);
+	if (NewBytesRemaining == 0 && ReceiveStage.IsValid())
+	{
+		// Parsing and signature checks run on the receive pipe, the frame moves there with them
+		EnsureSigner();
+		ReceiveStage->Enqueue(MoveTemp(Connection->ReceiveBuffer), bDebug, NewConnectionId, Connection->FramePool);
+		Connection->ReceiveBuffer = Connection->FramePool->Acquire();
+	}
 }
 
-void ULobbyGameInstanceSubsystem::OnMessageReceived(const FString& NewMessage)
+void ULobbyGameInstanceSubsystem::OnMessageReceived(FLobbyInboundMessage& NewMessage, double NewNow)
 {
-	TArray<FString> ReceivedData =  ParsReceivedData(NewMessage);
-	if (bool IsValidProtocol = CheckClientDataIsValid(ReceivedData); IsValidProtocol)
+	SCOPE_CYCLE_COUNTER(STAT_LobbyMessageReceived);
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Lobby_OnMessageReceived, LobbyChannel);
+	INC_DWORD_STAT(STAT_LobbyMessagesReceived);
+	CSV_CUSTOM_STAT(Lobby, MessagesReceived, 1, ECsvCustomStatOp::Accumulate);
+	switch (NewMessage.Result)
 	{
-		if (bDebug)
+	case ELobbyInboundResult::VALID:
+		if (NewMessage.CompressedBytes > 0)
+		{
+			InboundCompressionStats.FindOrAdd(NewMessage.Response.Action).Add(NewMessage.InflatedBytes, NewMessage.CompressedBytes, NewMessage.InflateSeconds);
+			if (FLobbyConnection* Connection = FindConnection(NewMessage.ConnectionId))
+			{
+				Connection->bPeerCompresses = true;
+			}
+		}
+		if (NewMessage.Response.Stream != ELobbySyncStream::NONE && !ObserveSequence(NewMessage.Response))
+		{
+			break;
+		}
+		// Pushed messages have no waiting request, they only go to the broadcast
+		RequestTracker.Complete(NewMessage.Response, NewNow);
+		if (NewMessage.Response.Action == ELobbyActionType::TEXT_CHAT && NewMessage.Response.RequestId.IsEmpty())
+		{
+			StoreChatMessage(NewMessage.Response);
+		}
+		OnLobbyMessage.Broadcast(NewMessage.Response);
+		break;
+
+	case ELobbyInboundResult::INVALID_FRAME:
+		if (FLobbyConnection* Connection = FindConnection(NewMessage.ConnectionId); Connection != nullptr && Connection->WebSocket.IsValid())
 		{
-			UE_LOG(LogTemp, Log, TEXT("Valid Data, WebSocket message received: %s"), *NewMessage);	
+			// Disconnect the client because the data protocol is invalid.
+			Connection->WebSocket->Close();
 		}
-		
+		break;
+
+	case ELobbyInboundResult::INVALID_BODY:
+		UE_LOG(LogLobbyClient, Warning, TEXT("The message body is not a lobby JSON object."));
+		break;
+
+	default:
+		break;
 	}
-	else
+}
+
+void ULobbyGameInstanceSubsystem::StoreChatMessage(const FLobbyResponse& NewResponse)
+{
+	if (!ChatConfig.bEnabled)
+	{
+		return;
+	}
+
+	const FTCHARToUTF8 PayLoadUtf8(*NewResponse.PayLoadData, NewResponse.PayLoadData.Len());
+	if (!ChatPayLoadView.Parse(FUtf8StringView(reinterpret_cast<const UTF8CHAR*>(PayLoadUtf8.Get()), PayLoadUtf8.Length())))
+	{
+		return;
+	}
+
+	const FLobbyJsonView::FValue PayLoad = ChatPayLoadView.GetRoot();
+	FString SenderPlayerId;
+	FString Message;
+	FString RecipientPlayerId;
+	FString ChannelId;
+	if (!PayLoad.Find("message").TryGetString(Message) || Message.IsEmpty())
+	{
+		return;
+	}
+	PayLoad.Find("senderPlayerId").TryGetString(SenderPlayerId);
+	PayLoad.Find("recipientPlayerId").TryGetString(RecipientPlayerId);
+	PayLoad.Find("channelId").TryGetString(ChannelId);
+
+	// A direct message belongs to the other player, whichever of the two sent it
+	FString PeerPlayerId;
+	if (!RecipientPlayerId.IsEmpty())
 	{
-		UE_LOG(LogTemp, Error, TEXT("The data is not valid please check it, data : %s"), *NewMessage);	
+		PeerPlayerId = SenderPlayerId.Equals(RegisteredPlayerId, ESearchCase::CaseSensitive) ? RecipientPlayerId : SenderPlayerId;
 	}
 
+	ChatStore.SetConfig(ChatConfig);
+	const FLobbyChatMessage Stored = ChatStore.Add(ChannelId, PeerPlayerId, SenderPlayerId, Message, FDateTime::UtcNow());
+	OnChatMessageNative.Broadcast(Stored);
+	OnChatMessage.Broadcast(Stored);
 }
 
-void ULobbyGameInstanceSubsystem::OnClosed(int32 NewStatusCode, const FString& NewReason, bool NewWasClean)
+bool ULobbyGameInstanceSubsystem::ObserveSequence(const FLobbyResponse& NewResponse)
 {
-	UE_LOG(LogTemp, Log, TEXT("WebSocket closed: %s"), *NewReason);	
+	++SyncStats.SequencedMessages;
+	switch (SyncTracker.Observe(NewResponse.Stream, NewResponse.Sequence))
+	{
+	case FLobbySyncTracker::EObserveResult::DUPLICATE:
+		++SyncStats.DuplicateMessages;
+		return false;
+
+	case FLobbySyncTracker::EObserveResult::AHEAD:
+		++SyncStats.Gaps;
+		if (ResyncConfig.bEnabled)
+		{
+			RequestResync();
+		}
+		return true;
+
+	default:
+		return true;
+	}
 }
 
-TArray<FString> ULobbyGameInstanceSubsystem::ParsReceivedData(const FString& NewReceivedData) const
+void ULobbyGameInstanceSubsystem::HandleResyncResponse(const FLobbyResponse& NewResponse, TConstArrayView<int64> NewFromSequences)
 {
-	TArray<FString> R_ParsedData{};
-	R_ParsedData.Add(NewReceivedData.Left(32));  // Client ID
-
-	int32 JsonStartIndex, BraceCount = 0, JsonEndIndex = -1;
-	if (!NewReceivedData.FindChar('{', JsonStartIndex))
+	if (NewResponse.Status != ELobbyRequestStatus::SUCCESS)
 	{
-		return R_ParsedData;
+		UE_LOG(LogLobbyClient, Warning, TEXT("Resync failed: %s"), *NewResponse.Error);
+		return;
 	}
 
-	// Find the matching closing brace
-	for (int32 i = JsonStartIndex; i < NewReceivedData.Len(); ++i)
+	const FTCHARToUTF8 PayLoadUtf8(*NewResponse.PayLoadData, NewResponse.PayLoadData.Len());
+	FLobbyJsonView PayLoadView;
+	if (!PayLoadView.Parse(FUtf8StringView(reinterpret_cast<const UTF8CHAR*>(PayLoadUtf8.Get()), PayLoadUtf8.Length())))
 	{
-		BraceCount += (NewReceivedData[i] == '{') ? 1 : (NewReceivedData[i] == '}') ? -1 : 0;
-		if (BraceCount == 0) { JsonEndIndex = i; break; }
+		UE_LOG(LogLobbyClient, Warning, TEXT("The resync answer is not a JSON object."));
+		return;
 	}
-	if (JsonEndIndex == -1)
+
+	TArray<FLobbyResyncResult, TInlineAllocator<4>> Results;
+	PayLoadView.GetRoot().Find("streams").ForEachMember([this, NewFromSequences, &Results](const FLobbyJsonView::FValue& NewKey, const FLobbyJsonView::FValue& NewValue)
+	{
+		FLobbyResyncResult Result;
+		if (!FLobbyEnumNames::FromName(FStringView(NewKey.AsString()), Result.Stream) || Result.Stream == ELobbySyncStream::NONE
+			|| !NewFromSequences.IsValidIndex(static_cast<int32>(Result.Stream)))
+		{
+			return;
+		}
+		Result.FromSequence = NewFromSequences[static_cast<int32>(Result.Stream)];
+		NewValue.Find("sequence").TryGetNumber(Result.ToSequence);
+
+		const FLobbyJsonView::FValue Snapshot = NewValue.Find("snapshot");
+		if (Snapshot.IsObject() || Snapshot.IsArray())
+		{
+			const FUtf8StringView SnapshotText = Snapshot.GetText();
+			Result.bSnapshot = true;
+			Result.SnapshotPayLoad = FString(SnapshotText.Len(), SnapshotText.GetData());
+			++SyncStats.SnapshotResyncs;
+		}
+		else
+		{
+			++SyncStats.DeltaResyncs;
+		}
+
+		// The missed messages came before the answer, a hole left now will not be filled
+		if (Result.bSnapshot || SyncTracker.GetAcknowledged(Result.Stream) < Result.ToSequence)
+		{
+			if (!Result.bSnapshot)
+			{
+				UE_LOG(LogLobbyClient, Warning, TEXT("Resync of %s stopped at %lld, the server is at %lld."), *UEnum::GetValueAsString(Result.Stream), SyncTracker.GetAcknowledged(Result.Stream), Result.ToSequence);
+			}
+			SyncTracker.Rebase(Result.Stream, Result.ToSequence);
+		}
+		Results.Add(MoveTemp(Result));
+	});
+
+	for (const FLobbyResyncResult& Result : Results)
 	{
-		return R_ParsedData;
+		OnResync.Broadcast(Result);
 	}
+}
 
-	R_ParsedData.Add(NewReceivedData.Mid(32, JsonStartIndex - 32));  // Timestamp
-	R_ParsedData.Add(NewReceivedData.Mid(JsonStartIndex, (JsonEndIndex - JsonStartIndex) + 1));  // JSON body
-	R_ParsedData.Add(NewReceivedData.Mid(JsonEndIndex + 1));  // Signature
-	return R_ParsedData;
+void ULobbyGameInstanceSubsystem::OnClosed(int32 NewStatusCode, const FString& NewReason, bool NewWasClean, int32 NewConnectionId)
+{
+	UE_LOG(LogLobbyClient, Log, TEXT("WebSocket closed: %s"), *NewReason);	
+	if (FLobbyConnection* Connection = FindConnection(NewConnectionId))
+	{
+		HandleConnectionLost(*Connection);
+	}
 }
 
 FString ULobbyGameInstanceSubsystem::GetClientSecret() const
@@ -149,291 +402,1144 @@ FString ULobbyGameInstanceSubsystem::GetClientId() const
 	return JWTConfig.ClientId;
 }
 
-void ULobbyGameInstanceSubsystem::CookingDataAndSendToClient(const FString& NewData)
+bool ULobbyGameInstanceSubsystem::CookingDataAndSendToClient(FLobbyConnection& NewConnection, FLobbyEnvelope::FWritePayload NewWriteBody, ELobbyActionType NewAction, bool bNewBsonBody)
 {
-	if (WebSocket.IsValid())
+	SCOPE_CYCLE_COUNTER(STAT_LobbyCookAndSend);
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Lobby_CookingDataAndSendToClient, LobbyChannel);
+	if (NewConnection.IsConnected())
 	{
-		FString ClientId = GetClientId();
-		FString ClientSecret = GetClientSecret();
-		int64 Timestamp = GetTimestamp();
+		if (!EnsureSigner())
+		{
+			UE_LOG(LogLobbyClient, Error, TEXT("The signer could not be keyed, please check JWTConfig."));
+			return false;
+		}
+
+		const bool bLengthPrefixed = FramingMode == ELobbyFramingMode::LENGTH_PREFIXED;
+		// Legacy framing has no room for the flag, and a server that never compressed may not inflate either
+		const bool bCompress = CompressionConfig.bEnabled && bLengthPrefixed && (NewConnection.bPeerCompresses || !CompressionConfig.bWaitForServer);
+		if (bCompress)
+		{
+			Deflater.SetLevel(CompressionConfig.Level);
+		}
+		if (!FLobbyEnvelope::CookFrame(SendBuffer, Signer, bLengthPrefixed, GetTimestamp(), NewWriteBody, bCompress ? &Deflater : nullptr, CompressionConfig.MinBytes, bNewBsonBody))
+		{
+			UE_LOG(LogLobbyClient, Error, TEXT("Function CookingDataAndSendToClient: The message could not be signed."));
+			return false;
+		}
+
+		if (bCompress && !Deflater.GetCompressed().IsEmpty())
+		{
+			OutboundCompressionStats.FindOrAdd(NewAction).Add(Deflater.GetLastRawBytes(), Deflater.GetCompressed().Len(), Deflater.GetLastSeconds());
+		}
+
+		if (bDebug && !bNewBsonBody)
+		{
+			UE_LOG(LogLobbyClient, Log, TEXT("----------------- Message ----------------------"));
+			UE_LOG(LogLobbyClient, Log, TEXT("%s"), *FString(SendBuffer.Num(), SendBuffer.GetData()));
+			UE_LOG(LogLobbyClient, Log, TEXT("----------------- Message ----------------------"));
+		}
 
-		FString DataWithoutSignature = MakeSendData(NewData, ClientId, Timestamp);
-		FString Signature = GenerateSignature(ClientSecret, NewData, ClientId, Timestamp);
-		FString CookedData = MakeSendData(NewData, ClientId, Timestamp, Signature);
-		WebSocket->Send(CookedData);
+		// The frame is already UTF-8, legacy servers expect text frames
+		NewConnection.WebSocket->Send(SendBuffer.GetData(), SendBuffer.Num(), bLengthPrefixed);
+		NewConnection.TickBytesSent += SendBuffer.Num();
+		INC_DWORD_STAT(STAT_LobbyMessagesSent);
+		INC_DWORD_STAT_BY(STAT_LobbyBytesSent, SendBuffer.Num());
+		CSV_CUSTOM_STAT(Lobby, MessagesSent, 1, ECsvCustomStatOp::Accumulate);
+		CSV_CUSTOM_STAT(Lobby, BytesSent, SendBuffer.Num(), ECsvCustomStatOp::Accumulate);
+		return true;
 	}
-	else
+
+	UE_LOG(LogLobbyClient, Warning, TEXT("Function CookingDataAndSendToClient: The Client is nullptr."));
+	return false;
+}
+
+int64 ULobbyGameInstanceSubsystem::GetTimestamp() const
+{
+	// The receive stage checks frame timestamps against the same clock
+	return FLobbyFrameWriter::GetCurrentTimestamp();
+}
+
+FString ULobbyGameInstanceSubsystem::GenerateRequestUniqueId() const
+{
+	// Generate a new GUID
+	FGuid UniqueId = FGuid::NewGuid();
+	// Convert the GUID to a string and return it
+	FString R_RequestId = UniqueId.ToString(EGuidFormats::DigitsWithHyphens);
+	return R_RequestId;
+}
+
+
+void ULobbyGameInstanceSubsystem::ConnectToLobbyServer(const FString& NewURL)
+{
+	ServerURL = NewURL;
+	bWantConnection = true;
+	UpdateConnections();
+	for (int32 Index = 0; Index < Connections.Num(); ++Index)
+	{
+		FLobbyConnection& Connection = *Connections[Index];
+		Connection.URL = Connection.Channel == ELobbyChannel::DATABASE && !ChannelConfig.DatabaseURL.IsEmpty() ? ChannelConfig.DatabaseURL : ServerURL;
+		Connection.ReconnectAttempt = 0;
+		OpenWebSocket(Connection);
+	}
+}
+
+void ULobbyGameInstanceSubsystem::DisconnectFromLobbyServer()
+{
+	bWantConnection = false;
+	RegisteredPlayerId.Reset();
+	SyncTracker.Reset();
+	ResyncRequestId.Reset();
+	for (int32 Index = 0; Index < Connections.Num(); ++Index)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("Function CookingDataAndSendToClient: The Client is nullptr."));
+		CloseConnection(*Connections[Index], ELobbyRequestStatus::CANCELLED, TEXT("Disconnected from the lobby server."));
 	}
 }
 
-bool ULobbyGameInstanceSubsystem::CheckClientDataIsValid(const TArray<FString>& NewClientDataStringArray)
+ELobbyConnectionState ULobbyGameInstanceSubsystem::GetConnectionState() const
 {
-	bool bStatus = false;
+	return Connections[0]->State;
+}
 
-	if (WebSocket.IsValid())
+ELobbyConnectionState ULobbyGameInstanceSubsystem::GetChannelConnectionState(ELobbyChannel NewChannel) const
+{
+	// Without connections of its own the channel shares the primary one
+	ELobbyConnectionState R_State = Connections[0]->State;
+	bool bFound = false;
+	for (const TUniquePtr<FLobbyConnection>& Connection : Connections)
 	{
-		int32 SplitedDataCount = NewClientDataStringArray.Num();
-		if (NGG_LOBBY_PROTOCOL::PART_PRATACOL_COUNT == SplitedDataCount)
+		if (Connection->Channel != NewChannel)
 		{
-			FString ClientSignature = NewClientDataStringArray[NGG_LOBBY_PROTOCOL::SIGNATURE];
-			bStatus = IsValidSignature(NewClientDataStringArray, ClientSignature);
+			continue;
 		}
-		else
+		if (Connection->State == ELobbyConnectionState::CONNECTED)
 		{
-			// Disconnect the client because the data protocol is invalid.
-			WebSocket->Close();
+			return ELobbyConnectionState::CONNECTED;
+		}
+		if (!bFound)
+		{
+			R_State = Connection->State;
+			bFound = true;
 		}
 	}
-
-	return bStatus;
+	return R_State;
 }
 
-int64 ULobbyGameInstanceSubsystem::GetTimestamp() const
+void ULobbyGameInstanceSubsystem::SimulateConnectionLost()
 {
-	FDateTime CurrentDateTime = FDateTime::UtcNow();
-    int64 Timestamp = CurrentDateTime.ToUnixTimestamp() * 1000 + CurrentDateTime.GetMillisecond();
-    return Timestamp;	
+	// Indexed, a lost connection may fail requests whose callbacks send again
+	for (int32 Index = 0; Index < Connections.Num(); ++Index)
+	{
+		if (Connections[Index]->State == ELobbyConnectionState::CONNECTED)
+		{
+			OnClosed(1006, TEXT("Simulated connection loss"), false, Connections[Index]->Id);
+		}
+	}
 }
 
-TSharedRef<FJsonObject> ULobbyGameInstanceSubsystem::ConvertStringMapToJson(
-	const TMap<FString, FString>& InputMap) const
+int32 ULobbyGameInstanceSubsystem::GetOfflineQueueLength() const
 {
-	TSharedRef<FJsonObject> JsonObject = MakeShared<FJsonObject>();
-	for (const auto& Pair : InputMap)
+	int32 R_Length = 0;
+	for (const TUniquePtr<FLobbyConnection>& Connection : Connections)
 	{
-		JsonObject->SetStringField(Pair.Key, Pair.Value);
+		R_Length += Connection->OfflineQueue.Num();
 	}
-	return JsonObject;
+	return R_Length;
 }
 
-TSharedRef<FJsonObject> ULobbyGameInstanceSubsystem::ConvertIntMapToJson(const TMap<FString, int32>& InputMap) const
+int32 ULobbyGameInstanceSubsystem::GetOutboundQueuedBytes() const
 {
-	TSharedRef<FJsonObject> JsonObject = MakeShared<FJsonObject>();
-	for (const auto& Pair : InputMap)
+	int32 R_Bytes = 0;
+	for (const TUniquePtr<FLobbyConnection>& Connection : Connections)
 	{
-		JsonObject->SetNumberField(Pair.Key, static_cast<double>(Pair.Value));
+		R_Bytes += Connection->OutboundScheduler.GetQueuedBytes();
 	}
-	return JsonObject;
+	return R_Bytes;
 }
 
-TSharedRef<FJsonObject> ULobbyGameInstanceSubsystem::ConvertFloatMapToJson(const TMap<FString, float>& InputMap) const
+bool ULobbyGameInstanceSubsystem::IsOutboundBackpressured(ELobbySendPriority NewPriority) const
 {
-	TSharedRef<FJsonObject> JsonObject = MakeShared<FJsonObject>();
-	for (const auto& Pair : InputMap)
+	for (const TUniquePtr<FLobbyConnection>& Connection : Connections)
 	{
-		JsonObject->SetNumberField(Pair.Key, static_cast<double>(Pair.Value));
+		if (!Connection->OutboundScheduler.CanAdmit(OutboundConfig, NewPriority, 1))
+		{
+			return true;
+		}
 	}
-	return JsonObject;
+	return false;
 }
 
-TSharedRef<FJsonObject> ULobbyGameInstanceSubsystem::ConvertBoolMapToJson(const TMap<FString, bool>& InputMap) const
+void ULobbyGameInstanceSubsystem::UpdateConnections()
 {
-	TSharedRef<FJsonObject> JsonObject = MakeShared<FJsonObject>();
-	for (const auto& Pair : InputMap)
+	// Connections[0] is the primary connection, the database pool follows it
+	const int32 DatabaseConnections = ChannelConfig.bEnabled ? FMath::Clamp(ChannelConfig.DatabaseConnections, 1, 8) : 0;
+	while (Connections.Num() > DatabaseConnections + 1)
 	{
-		JsonObject->SetBoolField(Pair.Key, Pair.Value);
+		// Taken out first, so the callbacks of its failed requests can only reach the connections that stay
+		TUniquePtr<FLobbyConnection> Removed = Connections.Pop();
+		CloseConnection(*Removed, ELobbyRequestStatus::CANCELLED, TEXT("The channel was closed."));
+	}
+	while (Connections.Num() < DatabaseConnections + 1)
+	{
+		Connections.Add(MakeUnique<FLobbyConnection>(NextConnectionId++, ELobbyChannel::DATABASE));
 	}
-	return JsonObject;
 }
 
-TSharedRef<FJsonObject> ULobbyGameInstanceSubsystem::ConvertJsonValueStructMapToJson(
-	const TMap<FString, FJsonValueStruct>& InputMap) const
+FLobbyConnection* ULobbyGameInstanceSubsystem::FindConnection(int32 NewConnectionId) const
 {
-	TSharedRef<FJsonObject> JsonObject = MakeShared<FJsonObject>();
-	for (const auto& Pair : InputMap)
+	for (const TUniquePtr<FLobbyConnection>& Connection : Connections)
 	{
-		if (Pair.Value.IsBool())
-		{
-			JsonObject->SetBoolField(Pair.Key, Pair.Value.ToBool());
-		}
-		else if (Pair.Value.IsNumber())
+		if (Connection->Id == NewConnectionId)
 		{
-			JsonObject->SetNumberField(Pair.Key, static_cast<double>(Pair.Value.ToFloat()));
+			return Connection.Get();
 		}
-		else if (Pair.Value.IsString())
+	}
+	return nullptr;
+}
+
+ELobbyChannel ULobbyGameInstanceSubsystem::GetChannel(ELobbyActionType NewAction) const
+{
+	if (!ChannelConfig.bEnabled)
+	{
+		return ELobbyChannel::PRIMARY;
+	}
+	if (const ELobbyChannel* Channel = ChannelConfig.ActionChannels.Find(NewAction))
+	{
+		return *Channel;
+	}
+	return NewAction == ELobbyActionType::DATABASE ? ELobbyChannel::DATABASE : ELobbyChannel::PRIMARY;
+}
+
+FLobbyConnection& ULobbyGameInstanceSubsystem::GetConnectionFor(ELobbyActionType NewAction)
+{
+	const ELobbyChannel Channel = GetChannel(NewAction);
+	if (Channel == ELobbyChannel::PRIMARY)
+	{
+		return *Connections[0];
+	}
+
+	// A connected one first, then the one with the least waiting, ties take turns
+	FLobbyConnection* R_Connection = nullptr;
+	const int32 NumConnections = Connections.Num();
+	for (int32 Step = 0; Step < NumConnections; ++Step)
+	{
+		FLobbyConnection* Connection = Connections[(NextPoolIndex + Step) % NumConnections].Get();
+		if (Connection->Channel != Channel)
 		{
-			JsonObject->SetStringField(Pair.Key, Pair.Value.ToString());
+			continue;
 		}
-		else if (Pair.Value.IsArray())
+		if (R_Connection == nullptr
+			|| (Connection->IsConnected() && !R_Connection->IsConnected())
+			|| (Connection->IsConnected() == R_Connection->IsConnected() && Connection->GetPendingBytes() < R_Connection->GetPendingBytes()))
 		{
-			JsonObject->SetArrayField(Pair.Key, Pair.Value.ToArray());
+			R_Connection = Connection;
 		}
-		else if (Pair.Value.IsObject())
+	}
+	NextPoolIndex = (NextPoolIndex + 1) % NumConnections;
+
+	// The channel has no connection until the next ConnectToLobbyServer
+	return R_Connection != nullptr ? *R_Connection : *Connections[0];
+}
+
+void ULobbyGameInstanceSubsystem::OpenWebSocket(FLobbyConnection& NewConnection)
+{
+	ReleaseWebSocket(NewConnection);
+	SetConnectionState(NewConnection, ELobbyConnectionState::CONNECTING);
+
+	NewConnection.bPeerCompresses = false;
+	TMap<FString, FString> UpgradeHeaders;
+	if (CompressionConfig.bEnabled)
+	{
+		// Tells the server it may deflate what it sends, the answer is a compressed frame
+		UpgradeHeaders.Add(TEXT("NGG-Compression"), TEXT("deflate"));
+		ReceiveStage->SetMaxInflatedBytes(CompressionConfig.MaxInflatedBytes);
+	}
+	ReceiveStage->SetGateConfig(InboundGateConfig);
+	NewConnection.WebSocket = FWebSocketsModule::Get().CreateWebSocket(NewConnection.URL, "wss", UpgradeHeaders);
+	if(NewConnection.WebSocket.IsValid())
+	{
+		// Bound by id, the connection may be gone by the time an event arrives
+		IWebSocket& WebSocket = *NewConnection.WebSocket;
+		WebSocket.OnConnected().AddUObject(this, &ULobbyGameInstanceSubsystem::OnConnected, NewConnection.Id);
+		WebSocket.OnConnectionError().AddUObject(this, &ULobbyGameInstanceSubsystem::OnConnectionError, NewConnection.Id);
+		WebSocket.OnRawMessage().AddUObject(this, &ULobbyGameInstanceSubsystem::OnRawMessageReceived, NewConnection.Id);
+		WebSocket.OnClosed().AddUObject(this, &ULobbyGameInstanceSubsystem::OnClosed, NewConnection.Id);
+		WebSocket.Connect();
+	}
+	else
+	{
+		UE_LOG(LogLobbyClient, Error, TEXT("The WebSocket is nullptr. Please check WebSocket pointer"));
+		HandleConnectionLost(NewConnection);
+	}
+}
+
+void ULobbyGameInstanceSubsystem::ReleaseWebSocket(FLobbyConnection& NewConnection)
+{
+	if (NewConnection.WebSocket.IsValid())
+	{
+		// Unbound first, closing on purpose is not a lost connection
+		IWebSocket& WebSocket = *NewConnection.WebSocket;
+		WebSocket.OnConnected().RemoveAll(this);
+		WebSocket.OnConnectionError().RemoveAll(this);
+		WebSocket.OnRawMessage().RemoveAll(this);
+		WebSocket.OnClosed().RemoveAll(this);
+		if (WebSocket.IsConnected())
 		{
-			JsonObject->SetObjectField(Pair.Key, Pair.Value.ToObject());
+			WebSocket.Close();
 		}
+		NewConnection.WebSocket.Reset();
 	}
-	return JsonObject;
+	NewConnection.ReceiveBuffer.Reset();
 }
 
-template <typename ValueType>
-FString ULobbyGameInstanceSubsystem::ConvertTMapToJson(const TMap<FString, ValueType>& InputMap) const
+void ULobbyGameInstanceSubsystem::CloseConnection(FLobbyConnection& NewConnection, ELobbyRequestStatus NewStatus, const FString& NewError)
 {
-    TSharedRef<FJsonObject> JsonObject = MakeShared<FJsonObject>();
+	ReleaseWebSocket(NewConnection);
+	NewConnection.ResetUnacknowledged();
+	SetConnectionState(NewConnection, ELobbyConnectionState::DISCONNECTED);
+	FailOfflineQueue(NewConnection, NewStatus, NewError);
+	FailOutbound(NewConnection, NewStatus, NewError);
+	// The batch can not go out anymore, its requests fail with it
+	FlushConnectionSendQueue(NewConnection);
+}
+
+void ULobbyGameInstanceSubsystem::HandleConnectionLost(FLobbyConnection& NewConnection)
+{
+	// The error and the close of one connection both end up here
+	if (NewConnection.State == ELobbyConnectionState::WAITING_TO_RECONNECT || NewConnection.State == ELobbyConnectionState::DISCONNECTED)
+	{
+		return;
+	}
 
-    for (const auto& Pair : InputMap)
-    {
-        if constexpr (std::is_same_v<ValueType, FString>)
-        {
-            JsonObject->SetStringField(Pair.Key, Pair.Value);
-        }
-        else if constexpr (std::is_same_v<ValueType, int32>)
-        {
-            JsonObject->SetNumberField(Pair.Key, static_cast<double>(Pair.Value));
-        }
-        else if constexpr (std::is_same_v<ValueType, float>)
-        {
-            JsonObject->SetNumberField(Pair.Key, static_cast<double>(Pair.Value));
-        }
-        else if constexpr (std::is_same_v<ValueType, bool>)
-        {
-            JsonObject->SetBoolField(Pair.Key, Pair.Value);
-        }
-        else if constexpr (std::is_same_v<ValueType, TMap<FString, FString>>)
-        {
-            JsonObject->SetObjectField(Pair.Key, ConvertStringMapToJson(Pair.Value));
-        }
-        else if constexpr (std::is_same_v<ValueType, TMap<FString, int32>>)
-        {
-            JsonObject->SetObjectField(Pair.Key, ConvertIntMapToJson(Pair.Value));
-        }
-        else if constexpr (std::is_same_v<ValueType, TMap<FString, float>>)
-        {
-            JsonObject->SetObjectField(Pair.Key, ConvertFloatMapToJson(Pair.Value));
-        }
-        else if constexpr (std::is_same_v<ValueType, TMap<FString, bool>>)
-        {
-            JsonObject->SetObjectField(Pair.Key, ConvertBoolMapToJson(Pair.Value));
-        }
-        else if constexpr (std::is_same_v<ValueType, TMap<FString, FJsonValueStruct>>)
-        {
-            JsonObject->SetObjectField(Pair.Key, ConvertJsonValueStructMapToJson(Pair.Value));
-        }
-        else
-        {
-            static_assert(std::is_same_v<ValueType, void>, "Unsupported value type in TMap.");
-        }
-    }
+	const bool bReconnect = bWantConnection && ReconnectConfig.bEnabled
+		&& (ReconnectConfig.MaxAttempts <= 0 || NewConnection.ReconnectAttempt < ReconnectConfig.MaxAttempts);
+	if (!bReconnect)
+	{
+		NewConnection.ResetUnacknowledged();
+		SetConnectionState(NewConnection, ELobbyConnectionState::DISCONNECTED);
+		FailOfflineQueue(NewConnection, ELobbyRequestStatus::FAILED, TEXT("Not connected to the lobby server."));
+		FailOutbound(NewConnection, ELobbyRequestStatus::FAILED, TEXT("Not connected to the lobby server."));
+		return;
+	}
 
-    FString OutputString;
-    TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&OutputString);
-    if (FJsonSerializer::Serialize(JsonObject, Writer))
-    {
-        return OutputString;
-    }
+	NewConnection.NextReconnectTime = FPlatformTime::Seconds() + GetReconnectDelaySeconds(NewConnection.ReconnectAttempt++);
+	UE_LOG(LogLobbyClient, Log, TEXT("Reconnecting to the lobby server in %.2f seconds, attempt %d."), NewConnection.NextReconnectTime - FPlatformTime::Seconds(), NewConnection.ReconnectAttempt);
 
-    return FString("");
+	// Requests still in the priority lanes never went out, they stay there until the connection is back.
+	// Unanswered writes may or may not have been applied, their idempotency keys make sending them again safe
+	TArray<FLobbyRetainedEnvelope> Unacknowledged = MoveTemp(NewConnection.UnacknowledgedEnvelopes);
+	NewConnection.UnacknowledgedEnvelopes.Reset();
+	SetConnectionState(NewConnection, ELobbyConnectionState::WAITING_TO_RECONNECT);
+	const double Now = FPlatformTime::Seconds();
+	for (FLobbyRetainedEnvelope& Retained : Unacknowledged)
+	{
+		if (RequestTracker.Contains(Retained.RequestId) && !QueueOffline(NewConnection, Retained.RequestId, FUtf8StringView(Retained.Envelope.GetData(), Retained.Envelope.Num()), true, Retained.bBson))
+		{
+			RequestTracker.Fail(Retained.RequestId, ELobbyRequestStatus::FAILED, TEXT("The offline queue is full."), Now);
+		}
+		NewConnection.EnvelopePool.Release(MoveTemp(Retained.Envelope));
+	}
 }
 
-FString ULobbyGameInstanceSubsystem::GenerateRequestUniqueId() const
+void ULobbyGameInstanceSubsystem::SetConnectionState(FLobbyConnection& NewConnection, ELobbyConnectionState NewState)
 {
-	// Generate a new GUID
-	FGuid UniqueId = FGuid::NewGuid();
-	// Convert the GUID to a string and return it
-	FString R_RequestId = UniqueId.ToString(EGuidFormats::DigitsWithHyphens);
-	return R_RequestId;
+	if (NewConnection.State != NewState)
+	{
+		NewConnection.State = NewState;
+		if (NewConnection.Channel == ELobbyChannel::PRIMARY)
+		{
+			OnConnectionStateChanged.Broadcast(NewState);
+		}
+	}
 }
 
+float ULobbyGameInstanceSubsystem::GetReconnectDelaySeconds(int32 NewAttempt) const
+{
+	const float Exponent = static_cast<float>(FMath::Min(NewAttempt, 30));
+	const float Bound = FMath::Min(ReconnectConfig.MaxDelaySeconds, ReconnectConfig.InitialDelaySeconds * FMath::Pow(FMath::Max(ReconnectConfig.Multiplier, 1.f), Exponent));
+	// A server restart drops every client at once, a uniform draw spreads them over the whole window
+	return FMath::FRandRange(0.f, FMath::Max(Bound, 0.f));
+}
 
-bool ULobbyGameInstanceSubsystem::IsValidSignature(const TArray<FString>& NewReceivedData, const FString& NewReceivedSignature) const
+bool ULobbyGameInstanceSubsystem::QueueOffline(FLobbyConnection& NewConnection, const FString& NewRequestId, FUtf8StringView NewEnvelope, bool bNewRetain, bool bNewBson)
 {
-	const int DataCount = NewReceivedData.Num();
-	if (NGG_LOBBY_PROTOCOL::PART_PRATACOL_COUNT == DataCount)
+	if (NewConnection.State == ELobbyConnectionState::DISCONNECTED)
 	{
-		FString ServerSideClientID = GetClientId();
-		FString ServerSideClientSecret = GetClientSecret();
+		return false;
+	}
 
-		int64 Timestamp = FCString::Atoi64(*NewReceivedData[NGG_LOBBY_PROTOCOL::TIMESTAMP]);
-		FString Body = NewReceivedData[NGG_LOBBY_PROTOCOL::JSON];
+	FLobbySendQueue& OfflineQueue = NewConnection.OfflineQueue;
+	if (OfflineQueue.Num() >= ReconnectConfig.OfflineQueueMaxMessages
+		|| OfflineQueue.NumBytes() + NewEnvelope.Len() > ReconnectConfig.OfflineQueueMaxBytes)
+	{
+		UE_LOG(LogLobbyClient, Warning, TEXT("The offline queue is full, request %s is dropped."), *NewRequestId);
+		return false;
+	}
 
-		FString ServerSideSignature = GenerateSignature(ServerSideClientSecret, Body, ServerSideClientID, Timestamp);
+	OfflineQueue.Enqueue(NewRequestId, FPlatformTime::Seconds(), NewEnvelope, bNewBson, bNewRetain);
+	return true;
+}
 
-		FString ServerSideSignatureLower = ServerSideSignature.ToLower();
-		FString ClientSignatureLower = NewReceivedSignature.ToLower();
+void ULobbyGameInstanceSubsystem::ReplayOfflineQueue(FLobbyConnection& NewConnection)
+{
+	if (NewConnection.OfflineQueue.IsEmpty())
+	{
+		return;
+	}
 
-		if (ClientSignatureLower == ServerSideSignatureLower)
+	FLobbySendQueue Replay = MoveTemp(NewConnection.OfflineQueue);
+	NewConnection.OfflineQueue.Reset();
+	const double Now = FPlatformTime::Seconds();
+	const TArray<FString>& RequestIds = Replay.GetRequestIds();
+	for (int32 Index = 0; Index < RequestIds.Num(); ++Index)
+	{
+		// Requests that timed out meanwhile were already reported as failed.
+		// They went out before anything in the lanes, so they skip ahead of them.
+		// Only the idempotent ones are kept again, the others must never be sent twice.
+		if (RequestTracker.Contains(RequestIds[Index]))
 		{
-			return true;
+			TransmitEnvelope(NewConnection, RequestIds[Index], Replay.GetEnvelope(Index), Replay.IsRetained(Index), Now, Replay.IsBson(Index));
 		}
 	}
-	else
+	FlushConnectionSendQueue(NewConnection);
+}
+
+void ULobbyGameInstanceSubsystem::FailOutbound(FLobbyConnection& NewConnection, ELobbyRequestStatus NewStatus, const FString& NewError)
+{
+	const TArray<FString> FailedRequestIds = NewConnection.OutboundScheduler.Reset();
+	const double Now = FPlatformTime::Seconds();
+	for (const FString& RequestId : FailedRequestIds)
 	{
-		// TODO: Disconnect the client if the received data is not valid.
-		UE_LOG(LogTemp, Warning, TEXT("The ReceivedData is not valid. Please check."));
+		RequestTracker.Fail(RequestId, NewStatus, NewError, Now);
 	}
-	return false;
+	UpdateOutboundBackpressure();
 }
 
-
-void ULobbyGameInstanceSubsystem::ConnectToLobbyServer(const FString& NewURL)
+void ULobbyGameInstanceSubsystem::PumpOutbound(FLobbyConnection& NewConnection)
 {
-	WebSocket = FWebSocketsModule::Get().CreateWebSocket(NewURL, "wss");
-	if(WebSocket.IsValid())
+	if (NewConnection.OutboundScheduler.IsEmpty() || !NewConnection.IsConnected() || NewConnection.TickBytesSent >= OutboundConfig.MaxBytesPerTick)
 	{
-		WebSocket->OnConnected().AddUObject(this, &ULobbyGameInstanceSubsystem::OnConnected);
-		WebSocket->OnConnectionError().AddUObject(this, &ULobbyGameInstanceSubsystem::OnConnectionError);
-		WebSocket->OnMessage().AddUObject(this, &ULobbyGameInstanceSubsystem::OnMessageReceived);
-		WebSocket->OnClosed().AddUObject(this, &ULobbyGameInstanceSubsystem::OnClosed);
-		WebSocket->Connect();
+		return;
 	}
-	else
+
+	// Taken out of the lanes first, callbacks of failed sends may queue new requests
+	FLobbySendQueue Drained;
+	NewConnection.OutboundScheduler.Drain(OutboundConfig, OutboundConfig.MaxBytesPerTick - NewConnection.TickBytesSent, Drained);
+	const double Now = FPlatformTime::Seconds();
+	const TArray<FString>& RequestIds = Drained.GetRequestIds();
+	for (int32 Index = 0; Index < RequestIds.Num(); ++Index)
 	{
-		UE_LOG(LogTemp, Error, TEXT("The WebSocket is nullptr. Please check WebSocket pointer"));
+		// Requests that timed out while waiting were already reported as failed
+		if (RequestTracker.Contains(RequestIds[Index]))
+		{
+			TransmitEnvelope(NewConnection, RequestIds[Index], Drained.GetEnvelope(Index), Drained.IsRetained(Index), Now, Drained.IsBson(Index));
+		}
 	}
+	UpdateOutboundBackpressure();
+}
 
-
-	
+void ULobbyGameInstanceSubsystem::UpdateOutboundBackpressure()
+{
+	const bool bBackpressured = IsOutboundBackpressured(ELobbySendPriority::BULK);
+	if (bBackpressured != bOutboundBackpressured)
+	{
+		bOutboundBackpressured = bBackpressured;
+		OnOutboundBackpressure.Broadcast(bBackpressured);
+	}
 }
 
+bool ULobbyGameInstanceSubsystem::CanSendDirectly(const FLobbyConnection& NewConnection, ELobbySendPriority NewPriority) const
+{
+	return NewConnection.TickBytesSent < OutboundConfig.MaxBytesPerTick && NewConnection.OutboundScheduler.IsClearFor(NewPriority);
+}
 
-FString ULobbyGameInstanceSubsystem::SendData(const FNGGLobbyData& NewNGGLobbyData)
+void ULobbyGameInstanceSubsystem::FailOfflineQueue(FLobbyConnection& NewConnection, ELobbyRequestStatus NewStatus, const FString& NewError)
 {
-	if (WebSocket.IsValid())
+	const TArray<FString> FailedRequestIds = NewConnection.OfflineQueue.GetRequestIds();
+	NewConnection.OfflineQueue.Reset();
+	const double Now = FPlatformTime::Seconds();
+	for (const FString& RequestId : FailedRequestIds)
 	{
-		FString JsonString{};
-		FJsonObjectConverter::UStructToJsonObjectString<FNGGLobbyData>(NewNGGLobbyData, JsonString);
-		UE_LOG(LogTemp, Log, TEXT("NewStringData = %s"), *JsonString);
-		CookingDataAndSendToClient(JsonString);
+		RequestTracker.Fail(RequestId, NewStatus, NewError, Now);
 	}
-	return NewNGGLobbyData.requestId;
+}
+
+
+FString ULobbyGameInstanceSubsystem::SendData(const FNGGLobbyData& NewNGGLobbyData)
+{
+	return SendData(NewNGGLobbyData, FOnLobbyResponseNative(), -1.f);
 }
 
 FString ULobbyGameInstanceSubsystem::SendChatMessage(const FChatData& NewChatData)
 {
-	FString JsonString{};
-	FJsonObjectConverter::UStructToJsonObjectString<FChatData>(NewChatData, JsonString);
-	FNGGLobbyData LobbyData{};
-	LobbyData.Action = ELobbyActionType::TEXT_CHAT;
-	LobbyData.ClientID = NewChatData.SenderPlayerId;
-	LobbyData.PayLoadData = JsonString;
-	LobbyData.requestId = GenerateRequestUniqueId();
-	FString R_RequestId = SendData(LobbyData);
-	return R_RequestId;
+	return SendChatMessage(NewChatData, FOnLobbyResponseNative(), -1.f);
 }
 
 FString ULobbyGameInstanceSubsystem::SendDBRequest(const FMongoDBData& NewMongoDBdata)
 {
-	FString JsonString{};
-	FJsonObjectConverter::UStructToJsonObjectString<FMongoDBData>(NewMongoDBdata, JsonString);
-	FNGGLobbyData LobbyData{};
-	LobbyData.Action = ELobbyActionType::DATABASE;
-	LobbyData.ClientID = NewMongoDBdata.SenderPlayerId;
-	LobbyData.PayLoadData = JsonString;
-	LobbyData.requestId = GenerateRequestUniqueId();
-	FString R_RequestId = SendData(LobbyData);
-	return R_RequestId;
+	return SendDBRequest(NewMongoDBdata, FOnLobbyResponseNative(), -1.f);
+}
+
+FString ULobbyGameInstanceSubsystem::SendDBBulkRequest(const FMongoDBBulkData& NewMongoDBBulkData)
+{
+	return SendDBBulkRequest(NewMongoDBBulkData, FOnLobbyResponseNative(), -1.f);
 }
 
 FString ULobbyGameInstanceSubsystem::RegisterPlayerIntoLobby(const FString& NewPlayerId)
 {
-	FNGGLobbyData LobbyData{};
-	LobbyData.Action = ELobbyActionType::REGISTER_PLAYER_INTO_LOBBY;
-	LobbyData.ClientID = NewPlayerId;
-	LobbyData.PayLoadData = "";
-	LobbyData.requestId = GenerateRequestUniqueId();
-	FString R_RequestId =  SendData(LobbyData);
-	return R_RequestId;
+	return RegisterPlayerIntoLobby(NewPlayerId, FOnLobbyResponseNative(), -1.f);
 }
 
+FString ULobbyGameInstanceSubsystem::SendData(const FNGGLobbyData& NewNGGLobbyData, FOnLobbyResponseNative NewOnResponse, float NewTimeoutSeconds)
+{
+	// Without a request id the response could not be matched
+	const FString RequestId = NewNGGLobbyData.requestId.IsEmpty() ? GenerateRequestUniqueId() : NewNGGLobbyData.requestId;
+	if (NewNGGLobbyData.Action == ELobbyActionType::FIND_PLAYER)
+	{
+		const FString Key = FString::Printf(TEXT("%d\x1F%s\x1F%s"), static_cast<int32>(NewNGGLobbyData.Action), *NewNGGLobbyData.ClientID, *NewNGGLobbyData.PayLoadData);
+		if (CoalesceRead(Key, RequestId, NewNGGLobbyData.Action, NewOnResponse, NewTimeoutSeconds))
+		{
+			return RequestId;
+		}
+	}
+
+	const bool bNestedPayload = IsPayloadNested();
+	return SendLobbyRequest(NewNGGLobbyData.Action, NewNGGLobbyData.ClientID, RequestId, [&NewNGGLobbyData, bNestedPayload](FLobbyJsonWriter& NewWriter)
+	{
+		FLobbyEnvelope::WriteTextPayload(NewWriter, NewNGGLobbyData.PayLoadData, bNestedPayload);
+	}, MoveTemp(NewOnResponse), NewTimeoutSeconds, FLobbyOutboundScheduler::GetPriority(OutboundConfig, NewNGGLobbyData.Action));
+}
+
+FString ULobbyGameInstanceSubsystem::SendChatMessage(const FChatData& NewChatData, FOnLobbyResponseNative NewOnResponse, float NewTimeoutSeconds)
+{
+	return SendLobbyRequest(ELobbyActionType::TEXT_CHAT, NewChatData.SenderPlayerId, GenerateRequestUniqueId(), [&NewChatData](FLobbyJsonWriter& NewWriter)
+	{
+		FLobbyEnvelope::WriteChatPayload(NewWriter, NewChatData);
+	}, MoveTemp(NewOnResponse), NewTimeoutSeconds, FLobbyOutboundScheduler::GetPriority(OutboundConfig, ELobbyActionType::TEXT_CHAT), true);
+}
+
+FString ULobbyGameInstanceSubsystem::SendDBRequest(const FMongoDBData& NewMongoDBdata, FOnLobbyResponseNative NewOnResponse, float NewTimeoutSeconds)
+{
+	const FString RequestId = GenerateRequestUniqueId();
+	const bool bCacheableRead = FLobbyDBReadCache::IsCacheableRead(NewMongoDBdata);
+	// Normalizing the documents is the expensive part, the cache and the coalescing share one key
+	const FString ReadKey = bCacheableRead ? FLobbyDBReadCache::MakeKey(NewMongoDBdata) : FString();
+	if (DBCacheConfig.bEnabled)
+	{
+		if (FLobbyDBReadCache::IsWrite(NewMongoDBdata.DbAction))
+		{
+			DBReadCache.Invalidate(NewMongoDBdata);
+		}
+		else if (const float TTLSeconds = GetDBCacheTTLSeconds(NewMongoDBdata.CollectionName); TTLSeconds > 0.f && bCacheableRead)
+		{
+			FString Key = ReadKey;
+			FString PayLoadData;
+			if (DBReadCache.Find(Key, FPlatformTime::Seconds(), PayLoadData))
+			{
+				AnswerLocally(RequestId, PayLoadData, MoveTemp(NewOnResponse), NewTimeoutSeconds);
+				return RequestId;
+			}
+
+			// Keep the answer on the way back, unless a write to the collection went out meanwhile
+			NewOnResponse = FOnLobbyResponseNative::CreateWeakLambda(this, [this, Key = MoveTemp(Key), CollectionKey = FLobbyDBReadCache::MakeCollectionKey(NewMongoDBdata),
+				Stamp = DBReadCache.GetStamp(), TTLSeconds, OnResponse = MoveTemp(NewOnResponse)](const FLobbyResponse& NewResponse)
+			{
+				if (NewResponse.Status == ELobbyRequestStatus::SUCCESS && DBCacheConfig.bEnabled)
+				{
+					DBReadCache.SetMaxBytes(DBCacheConfig.MaxBytes);
+					DBReadCache.Store(Key, CollectionKey, Stamp, NewResponse.PayLoadData, FPlatformTime::Seconds() + TTLSeconds);
+				}
+				OnResponse.ExecuteIfBound(NewResponse);
+			});
+		}
+	}
+
+	// The sender is part of the key, the server may answer differently per player
+	if (bCacheableRead && CoalesceRead(FString::Printf(TEXT("%s\x1F%s"), *NewMongoDBdata.SenderPlayerId, *ReadKey), RequestId, ELobbyActionType::DATABASE, NewOnResponse, NewTimeoutSeconds, NewMongoDBdata.DbAction))
+	{
+		return RequestId;
+	}
+
+	const ELobbySendPriority Priority = FLobbyOutboundScheduler::GetPriority(OutboundConfig, ELobbyActionType::DATABASE, NewMongoDBdata.DbAction);
+	if (IsDBPayloadBson())
+	{
+		SendLobbyBsonRequest(ELobbyActionType::DATABASE, NewMongoDBdata.SenderPlayerId, RequestId, [&NewMongoDBdata](FLobbyBsonWriter& NewWriter)
+		{
+			FLobbyEnvelope::WriteDBPayload(NewWriter, NewMongoDBdata);
+		}, MoveTemp(NewOnResponse), NewTimeoutSeconds, Priority, FLobbyDBReadCache::IsWrite(NewMongoDBdata.DbAction), NewMongoDBdata.DbAction);
+	}
+	else
+	{
+		SendLobbyRequest(ELobbyActionType::DATABASE, NewMongoDBdata.SenderPlayerId, RequestId, [&NewMongoDBdata](FLobbyJsonWriter& NewWriter)
+		{
+			FLobbyEnvelope::WriteDBPayload(NewWriter, NewMongoDBdata);
+		}, MoveTemp(NewOnResponse), NewTimeoutSeconds, Priority, FLobbyDBReadCache::IsWrite(NewMongoDBdata.DbAction), NewMongoDBdata.DbAction);
+	}
+	return RequestId;
+}
+
+FString ULobbyGameInstanceSubsystem::SendDBBulkRequest(const FMongoDBBulkData& NewMongoDBBulkData, FOnLobbyResponseNative NewOnResponse, float NewTimeoutSeconds)
+{
+	const FString RequestId = GenerateRequestUniqueId();
+	if (NewMongoDBBulkData.Operations.IsEmpty())
+	{
+		// The server would reject it anyway, it fails here without a round trip
+		UE_LOG(LogLobbyClient, Warning, TEXT("Function SendDBBulkRequest: The bulk request has no operations."));
+		FailWithoutSending(RequestId, ELobbyActionType::DATABASE, TEXT("The bulk request has no operations."), NewOnResponse);
+		return RequestId;
+	}
+
+	if (DBCacheConfig.bEnabled)
+	{
+		FMongoDBData BulkWrite;
+		BulkWrite.DbName = NewMongoDBBulkData.DbName;
+		BulkWrite.CollectionName = NewMongoDBBulkData.CollectionName;
+		BulkWrite.DbAction = EMongoDBActionType::BULK_WRITE;
+		DBReadCache.Invalidate(BulkWrite);
+	}
+
+	const ELobbySendPriority Priority = FLobbyOutboundScheduler::GetPriority(OutboundConfig, ELobbyActionType::DATABASE, EMongoDBActionType::BULK_WRITE);
+	if (IsDBPayloadBson())
+	{
+		SendLobbyBsonRequest(ELobbyActionType::DATABASE, NewMongoDBBulkData.SenderPlayerId, RequestId, [&NewMongoDBBulkData](FLobbyBsonWriter& NewWriter)
+		{
+			FLobbyEnvelope::WriteDBBulkPayload(NewWriter, NewMongoDBBulkData);
+		}, MoveTemp(NewOnResponse), NewTimeoutSeconds, Priority, true, EMongoDBActionType::BULK_WRITE);
+	}
+	else
+	{
+		SendLobbyRequest(ELobbyActionType::DATABASE, NewMongoDBBulkData.SenderPlayerId, RequestId, [&NewMongoDBBulkData](FLobbyJsonWriter& NewWriter)
+		{
+			FLobbyEnvelope::WriteDBBulkPayload(NewWriter, NewMongoDBBulkData);
+		}, MoveTemp(NewOnResponse), NewTimeoutSeconds, Priority, true, EMongoDBActionType::BULK_WRITE);
+	}
+	return RequestId;
+}
+
+FString ULobbyGameInstanceSubsystem::RegisterPlayerIntoLobby(const FString& NewPlayerId, FOnLobbyResponseNative NewOnResponse, float NewTimeoutSeconds)
+{
+	// Registered again automatically after a reconnect
+	if (!NewPlayerId.Equals(RegisteredPlayerId, ESearchCase::CaseSensitive))
+	{
+		// Another player's streams start over
+		SyncTracker.Reset();
+		ResyncRequestId.Reset();
+	}
+	RegisteredPlayerId = NewPlayerId;
+	const bool bNestedPayload = IsPayloadNested();
+	return SendLobbyRequest(ELobbyActionType::REGISTER_PLAYER_INTO_LOBBY, NewPlayerId, GenerateRequestUniqueId(), [bNestedPayload](FLobbyJsonWriter& NewWriter)
+	{
+		FLobbyEnvelope::WriteTextPayload(NewWriter, FStringView(), bNestedPayload);
+	}, MoveTemp(NewOnResponse), NewTimeoutSeconds, FLobbyOutboundScheduler::GetPriority(OutboundConfig, ELobbyActionType::REGISTER_PLAYER_INTO_LOBBY));
+}
+
+ULobbyDBCursor* ULobbyGameInstanceSubsystem::OpenDBCursor(const FMongoDBData& NewQuery, int32 NewBatchSize, float NewTimeoutSeconds)
+{
+	ULobbyDBCursor* R_Cursor = NewObject<ULobbyDBCursor>(this);
+	OpenCursors.Add(R_Cursor);
+	R_Cursor->Open(this, NewQuery, NewBatchSize, NewTimeoutSeconds);
+	return R_Cursor;
+}
+
+void ULobbyGameInstanceSubsystem::ReleaseDBCursor(ULobbyDBCursor* NewCursor)
+{
+	OpenCursors.RemoveSingleSwap(NewCursor, EAllowShrinking::No);
+}
+
+FString ULobbyGameInstanceSubsystem::SendLobbyRequest(ELobbyActionType NewAction, const FString& NewClientID, const FString& NewRequestId, FLobbyEnvelope::FWritePayload NewWritePayload, FOnLobbyResponseNative NewOnResponse, float NewTimeoutSeconds, ELobbySendPriority NewPriority, bool bNewIdempotent, EMongoDBActionType NewDbAction)
+{
+	++AllocationStats.SentMessages;
+	FLobbyAllocationCounter AllocationCounter(AllocationStats.SendAllocations);
+	const double Now = FPlatformTime::Seconds();
+	const float TimeoutSeconds = NewTimeoutSeconds < 0.f ? DefaultRequestTimeoutSeconds : NewTimeoutSeconds;
+	if (!RequestTracker.Add(NewRequestId, NewAction, Now, TimeoutSeconds, MoveTemp(NewOnResponse), NewDbAction))
+	{
+		FailUntracked(NewRequestId, NewAction, NewOnResponse);
+		return NewRequestId;
+	}
+
+	const bool bNestedPayload = IsPayloadNested();
+	const bool bRetain = bNewIdempotent && ReconnectConfig.bEnabled;
+	auto WriteEnvelope = [&](FLobbyJsonWriter& NewWriter)
+	{
+		// The request id is unique per call, so it doubles as the idempotency key
+		FLobbyEnvelope::WriteEnvelope(NewWriter, NewAction, NewClientID, NewRequestId, bNestedPayload, NewWritePayload, bNewIdempotent ? FStringView(NewRequestId) : FStringView());
+	};
+
+	FLobbyConnection& Connection = GetConnectionFor(NewAction);
+	if (Connection.IsConnected() && !bRetain && CanSendDirectly(Connection, NewPriority))
+	{
+		// Nothing has to be kept or wait, the envelope is written straight into the frame
+		if (SendBatchConfig.bEnabled)
+		{
+			EnqueueLobbyRequest(Connection, NewRequestId, Now, WriteEnvelope);
+		}
+		else if (!CookingDataAndSendToClient(Connection, WriteEnvelope, NewAction))
+		{
+			RequestTracker.Fail(NewRequestId, ELobbyRequestStatus::FAILED, TEXT("Not connected to the lobby server."), Now);
+		}
+		return NewRequestId;
+	}
+
+	EnvelopeBuffer.Reset();
+	{
+		FLobbyJsonWriter Writer(EnvelopeBuffer);
+		WriteEnvelope(Writer);
+	}
+	SendEnvelope(Connection, NewRequestId, FUtf8StringView(EnvelopeBuffer.GetData(), EnvelopeBuffer.Num()), bRetain, NewPriority);
+	return NewRequestId;
+}
+
+FString ULobbyGameInstanceSubsystem::SendLobbyBsonRequest(ELobbyActionType NewAction, const FString& NewClientID, const FString& NewRequestId, FLobbyEnvelope::FWriteBsonPayload NewWritePayload, FOnLobbyResponseNative NewOnResponse, float NewTimeoutSeconds, ELobbySendPriority NewPriority, bool bNewIdempotent, EMongoDBActionType NewDbAction)
+{
+	++AllocationStats.SentMessages;
+	FLobbyAllocationCounter AllocationCounter(AllocationStats.SendAllocations);
+	const double Now = FPlatformTime::Seconds();
+	const float TimeoutSeconds = NewTimeoutSeconds < 0.f ? DefaultRequestTimeoutSeconds : NewTimeoutSeconds;
+	if (!RequestTracker.Add(NewRequestId, NewAction, Now, TimeoutSeconds, MoveTemp(NewOnResponse), NewDbAction))
+	{
+		FailUntracked(NewRequestId, NewAction, NewOnResponse);
+		return NewRequestId;
+	}
+
+	EnvelopeBuffer.Reset();
+	{
+		FLobbyBsonWriter Writer(EnvelopeBuffer);
+		FLobbyEnvelope::WriteEnvelope(Writer, NewAction, NewClientID, NewRequestId, NewWritePayload, bNewIdempotent ? FStringView(NewRequestId) : FStringView());
+	}
+	SendEnvelope(GetConnectionFor(NewAction), NewRequestId, FUtf8StringView(EnvelopeBuffer.GetData(), EnvelopeBuffer.Num()), bNewIdempotent && ReconnectConfig.bEnabled, NewPriority, true);
+	return NewRequestId;
+}
+
+void ULobbyGameInstanceSubsystem::SendEnvelope(FLobbyConnection& NewConnection, const FString& NewRequestId, FUtf8StringView NewEnvelope, bool bNewRetain, ELobbySendPriority NewPriority, bool bNewBson)
+{
+	const double Now = FPlatformTime::Seconds();
+	if (!NewConnection.IsConnected() || CanSendDirectly(NewConnection, NewPriority))
+	{
+		TransmitEnvelope(NewConnection, NewRequestId, NewEnvelope, bNewRetain, Now, bNewBson);
+		return;
+	}
+
+	if (!NewConnection.OutboundScheduler.Enqueue(OutboundConfig, NewPriority, NewRequestId, Now, NewEnvelope, bNewRetain, bNewBson))
+	{
+		UE_LOG(LogLobbyClient, Warning, TEXT("The outbound queue is full, request %s is rejected."), *NewRequestId);
+		RequestTracker.Fail(NewRequestId, ELobbyRequestStatus::REJECTED, TEXT("The outbound queue is full."), Now);
+	}
+	UpdateOutboundBackpressure();
+}
+
+void ULobbyGameInstanceSubsystem::TransmitEnvelope(FLobbyConnection& NewConnection, const FString& NewRequestId, FUtf8StringView NewEnvelope, bool bNewRetain, double NewNow, bool bNewBson)
+{
+	if (!NewConnection.IsConnected())
+	{
+		if (!QueueOffline(NewConnection, NewRequestId, NewEnvelope, bNewRetain, bNewBson))
+		{
+			RequestTracker.Fail(NewRequestId, ELobbyRequestStatus::FAILED, TEXT("Not connected to the lobby server."), NewNow);
+		}
+		return;
+	}
+
+	if (bNewRetain)
+	{
+		FLobbyRetainedEnvelope& Retained = NewConnection.UnacknowledgedEnvelopes.AddDefaulted_GetRef();
+		Retained.RequestId = NewRequestId;
+		Retained.Envelope = NewConnection.EnvelopePool.Acquire();
+		Retained.Envelope.Append(NewEnvelope.GetData(), NewEnvelope.Len());
+		Retained.bBson = bNewBson;
+	}
+
+	auto WriteEnvelope = [NewEnvelope](FLobbyJsonWriter& NewWriter)
+	{
+		NewWriter.WriteRawValue(NewEnvelope);
+	};
+	if (bNewBson)
+	{
+		// A BSON body is never part of a batch, the batch in front of it goes out first to keep the order
+		FlushConnectionSendQueue(NewConnection);
+		if (!CookingDataAndSendToClient(NewConnection, WriteEnvelope, RequestTracker.GetAction(NewRequestId), true))
+		{
+			RequestTracker.Fail(NewRequestId, ELobbyRequestStatus::FAILED, TEXT("The BSON request could not be sent, it needs the length-prefixed framing."), NewNow);
+		}
+	}
+	else if (SendBatchConfig.bEnabled)
+	{
+		EnqueueLobbyRequest(NewConnection, NewRequestId, NewNow, WriteEnvelope, bNewRetain);
+	}
+	else if (!CookingDataAndSendToClient(NewConnection, WriteEnvelope, RequestTracker.GetAction(NewRequestId)))
+	{
+		RequestTracker.Fail(NewRequestId, ELobbyRequestStatus::FAILED, TEXT("Not connected to the lobby server."), NewNow);
+	}
+}
+
+void ULobbyGameInstanceSubsystem::EnqueueLobbyRequest(FLobbyConnection& NewConnection, const FString& NewRequestId, double NewNow, FLobbyEnvelope::FWritePayload NewWriteEnvelope, bool bNewRetain)
+{
+	// Envelopes written for the other framing must not end up in the same body
+	FLobbySendQueue& SendQueue = NewConnection.SendQueue;
+	if (!SendQueue.IsEmpty() && NewConnection.bSendQueueNested != IsPayloadNested())
+	{
+		FlushConnectionSendQueue(NewConnection);
+	}
+	NewConnection.bSendQueueNested = IsPayloadNested();
+	SendQueue.Enqueue(NewRequestId, NewNow, NewWriteEnvelope, bNewRetain);
+
+	if (SendQueue.Num() >= SendBatchConfig.MaxMessages
+		|| SendQueue.NumBytes() >= SendBatchConfig.MaxBytes
+		|| (NewNow - SendQueue.GetOldestEnqueueTime()) * 1000.0 >= SendBatchConfig.MaxLatencyMilliseconds)
+	{
+		FlushConnectionSendQueue(NewConnection);
+	}
+}
+
+
+FLobbyDBCacheStats ULobbyGameInstanceSubsystem::GetDBCacheStats() const
+{
+	return DBReadCache.GetStats();
+}
+
+void ULobbyGameInstanceSubsystem::ResetDBCacheStats()
+{
+	DBReadCache.ResetStats();
+}
+
+FLobbyCompressionStats ULobbyGameInstanceSubsystem::GetCompressionStats(ELobbyActionType NewAction, bool bNewOutbound) const
+{
+	const FLobbyCompressionStats* Stats = (bNewOutbound ? OutboundCompressionStats : InboundCompressionStats).Find(NewAction);
+	return Stats ? *Stats : FLobbyCompressionStats();
+}
+
+void ULobbyGameInstanceSubsystem::ResetCompressionStats()
+{
+	OutboundCompressionStats.Reset();
+	InboundCompressionStats.Reset();
+}
+
+FLobbyAllocationStats ULobbyGameInstanceSubsystem::GetAllocationStats() const
+{
+	FLobbyAllocationStats R_Stats = AllocationStats;
+	if (ReceiveStage.IsValid())
+	{
+		ReceiveStage->GetAllocationStats(R_Stats.ReceivedFrames, R_Stats.ReceiveAllocations);
+	}
+	for (const TUniquePtr<FLobbyConnection>& Connection : Connections)
+	{
+		int64 Hits = 0;
+		int64 Misses = 0;
+		Connection->FramePool->GetStats(Hits, Misses);
+		R_Stats.PoolHits += Hits;
+		R_Stats.PoolMisses += Misses;
+		Connection->EnvelopePool.GetStats(Hits, Misses);
+		R_Stats.PoolHits += Hits;
+		R_Stats.PoolMisses += Misses;
+	}
+	R_Stats.AllocationsPerSend = R_Stats.SentMessages > 0 ? static_cast<float>(static_cast<double>(R_Stats.SendAllocations) / R_Stats.SentMessages) : 0.f;
+	R_Stats.AllocationsPerReceive = R_Stats.ReceivedFrames > 0 ? static_cast<float>(static_cast<double>(R_Stats.ReceiveAllocations) / R_Stats.ReceivedFrames) : 0.f;
+	return R_Stats;
+}
+
+FLobbyInboundGateStats ULobbyGameInstanceSubsystem::GetInboundGateStats() const
+{
+	FLobbyInboundGateStats R_Stats;
+	if (ReceiveStage.IsValid())
+	{
+		ReceiveStage->GetGateStats(R_Stats);
+	}
+	return R_Stats;
+}
+
+void ULobbyGameInstanceSubsystem::ResetInboundGateStats()
+{
+	if (ReceiveStage.IsValid())
+	{
+		ReceiveStage->ResetGateStats();
+	}
+}
+
+void ULobbyGameInstanceSubsystem::ResetAllocationStats()
+{
+	AllocationStats = FLobbyAllocationStats();
+	if (ReceiveStage.IsValid())
+	{
+		ReceiveStage->ResetAllocationStats();
+	}
+	for (const TUniquePtr<FLobbyConnection>& Connection : Connections)
+	{
+		Connection->FramePool->ResetStats();
+		Connection->EnvelopePool.ResetStats();
+	}
+}
+
+void ULobbyGameInstanceSubsystem::ClearDBCache()
+{
+	DBReadCache.Empty();
+}
+
+void ULobbyGameInstanceSubsystem::FlushSendQueue()
+{
+	for (int32 Index = 0; Index < Connections.Num(); ++Index)
+	{
+		FlushConnectionSendQueue(*Connections[Index]);
+	}
+}
+
+void ULobbyGameInstanceSubsystem::FlushConnectionSendQueue(FLobbyConnection& NewConnection)
+{
+	FLobbySendQueue& SendQueue = NewConnection.SendQueue;
+	if (SendQueue.IsEmpty())
+	{
+		return;
+	}
+
+	const ELobbyActionType Action = SendQueue.Num() == 1 ? RequestTracker.GetAction(SendQueue.GetRequestIds()[0]) : ELobbyActionType::NONE;
+	const bool bSent = CookingDataAndSendToClient(NewConnection, [&SendQueue](FLobbyJsonWriter& NewWriter)
+	{
+		SendQueue.WriteBody(NewWriter);
+	}, Action);
+
+	if (bSent)
+	{
+		SendQueue.Reset();
+		return;
+	}
+
+	// Callbacks may send again, so the queue is emptied before they run
+	FLobbySendQueue Unsent = MoveTemp(SendQueue);
+	SendQueue.Reset();
+	const bool bConnected = NewConnection.IsConnected();
+	const double Now = FPlatformTime::Seconds();
+	const TArray<FString>& RequestIds = Unsent.GetRequestIds();
+	for (int32 Index = 0; Index < RequestIds.Num(); ++Index)
+	{
+		// Retained envelopes are already among the unacknowledged ones, which the reconnect queues again itself.
+		// A second copy here would be replayed too and go out twice.
+		if (!bConnected && Unsent.IsRetained(Index) && NewConnection.State != ELobbyConnectionState::DISCONNECTED)
+		{
+			continue;
+		}
+
+		// The connection dropped before the batch went out, it waits for the next one
+		if (bConnected || !QueueOffline(NewConnection, RequestIds[Index], Unsent.GetEnvelope(Index), false, Unsent.IsBson(Index)))
+		{
+			RequestTracker.Fail(RequestIds[Index], ELobbyRequestStatus::FAILED, TEXT("Not connected to the lobby server."), Now);
+		}
+	}
+}
+
+void ULobbyGameInstanceSubsystem::AnswerLocally(const FString& NewRequestId, const FString& NewPayLoadData, FOnLobbyResponseNative NewOnResponse, float NewTimeoutSeconds)
+{
+	const float TimeoutSeconds = NewTimeoutSeconds < 0.f ? DefaultRequestTimeoutSeconds : NewTimeoutSeconds;
+	if (!RequestTracker.Add(NewRequestId, ELobbyActionType::DATABASE, FPlatformTime::Seconds(), TimeoutSeconds, MoveTemp(NewOnResponse)))
+	{
+		FailUntracked(NewRequestId, ELobbyActionType::DATABASE, NewOnResponse);
+		return;
+	}
+
+	FLobbyResponse& Response = LocalResponses.AddDefaulted_GetRef();
+	Response.RequestId = NewRequestId;
+	Response.Action = ELobbyActionType::DATABASE;
+	Response.PayLoadData = NewPayLoadData;
+}
+
+void ULobbyGameInstanceSubsystem::FailWithoutSending(const FString& NewRequestId, ELobbyActionType NewAction, const FString& NewError, const FOnLobbyResponseNative& NewOnResponse)
+{
+	FLobbyResponse Response;
+	Response.RequestId = NewRequestId;
+	Response.Action = NewAction;
+	Response.Status = ELobbyRequestStatus::FAILED;
+	Response.Error = NewError;
+	NewOnResponse.ExecuteIfBound(Response);
+}
+
+void ULobbyGameInstanceSubsystem::FailUntracked(const FString& NewRequestId, ELobbyActionType NewAction, const FOnLobbyResponseNative& NewOnResponse)
+{
+	FailWithoutSending(NewRequestId, NewAction, NewRequestId.IsEmpty() ? TEXT("The request id is empty.") : TEXT("A request with the same id is already in flight."), NewOnResponse);
+}
+
+bool ULobbyGameInstanceSubsystem::CoalesceRead(const FString& NewKey, const FString& NewRequestId, ELobbyActionType NewAction, FOnLobbyResponseNative& InOutOnResponse, float NewTimeoutSeconds, EMongoDBActionType NewDbAction)
+{
+	if (!bCoalesceReads)
+	{
+		return false;
+	}
+
+	const uint64 Hash = FXxHash64::HashBuffer(*NewKey, NewKey.Len() * sizeof(TCHAR)).Hash;
+	if (FInFlightRead* InFlightRead = InFlightReads.Find(Hash))
+	{
+		if (!InFlightRead->Key.Equals(NewKey, ESearchCase::CaseSensitive))
+		{
+			// A hash collision, send this one on its own
+			return false;
+		}
+
+		const float TimeoutSeconds = NewTimeoutSeconds < 0.f ? DefaultRequestTimeoutSeconds : NewTimeoutSeconds;
+		if (!RequestTracker.Add(NewRequestId, NewAction, FPlatformTime::Seconds(), TimeoutSeconds, MoveTemp(InOutOnResponse), NewDbAction))
+		{
+			FailUntracked(NewRequestId, NewAction, InOutOnResponse);
+			return true;
+		}
+		InFlightRead->FollowerRequestIds.Add(NewRequestId);
+		++CoalescedRequestCount;
+		return true;
+	}
+
+	InFlightReads.Add(Hash).Key = NewKey;
+	InOutOnResponse = FOnLobbyResponseNative::CreateWeakLambda(this, [this, Hash, OnResponse = MoveTemp(InOutOnResponse)](const FLobbyResponse& NewResponse)
+	{
+		FInFlightRead InFlightRead;
+		if (InFlightReads.RemoveAndCopyValue(Hash, InFlightRead))
+		{
+			const double Now = FPlatformTime::Seconds();
+			for (const FString& FollowerRequestId : InFlightRead.FollowerRequestIds)
+			{
+				// Only a successful answer is shared, a failed, timed out, cancelled or rejected read fails its followers the same way
+				if (NewResponse.Status != ELobbyRequestStatus::SUCCESS)
+				{
+					RequestTracker.Fail(FollowerRequestId, NewResponse.Status, NewResponse.Error, Now);
+					continue;
+				}
+
+				FLobbyResponse FollowerResponse = NewResponse;
+				FollowerResponse.RequestId = FollowerRequestId;
+				if (RequestTracker.Complete(FollowerResponse, Now))
+				{
+					OnLobbyMessage.Broadcast(FollowerResponse);
+				}
+			}
+		}
+		OnResponse.ExecuteIfBound(NewResponse);
+	});
+	return false;
+}
+
+int64 ULobbyGameInstanceSubsystem::GetCoalescedRequestCount() const
+{
+	return CoalescedRequestCount;
+}
+
+float ULobbyGameInstanceSubsystem::GetDBCacheTTLSeconds(const FString& NewCollectionName) const
+{
+	const float* TTLSeconds = DBCacheConfig.CollectionTTLSeconds.Find(NewCollectionName);
+	return TTLSeconds != nullptr ? *TTLSeconds : DBCacheConfig.DefaultTTLSeconds;
+}
+
+bool ULobbyGameInstanceSubsystem::IsPayloadNested() const
+{
+	// Nested payloads are part of the length-prefixed protocol, legacy servers expect a string
+	return FramingMode == ELobbyFramingMode::LENGTH_PREFIXED;
+}
+
+bool ULobbyGameInstanceSubsystem::IsDBPayloadBson() const
+{
+	return DBPayloadEncoding == ELobbyPayloadEncoding::BSON && FramingMode == ELobbyFramingMode::LENGTH_PREFIXED;
+}
+
+FOnLobbyResponseNative ULobbyGameInstanceSubsystem::ToNativeDelegate(const FOnLobbyResponse& NewOnResponse)
+{
+	return FOnLobbyResponseNative::CreateLambda([NewOnResponse](const FLobbyResponse& NewResponse)
+	{
+		NewOnResponse.ExecuteIfBound(NewResponse);
+	});
+}
+
+FString ULobbyGameInstanceSubsystem::SendDataWithResponse(const FNGGLobbyData& NewNGGLobbyData, const FOnLobbyResponse& NewOnResponse, float NewTimeoutSeconds)
+{
+	return SendData(NewNGGLobbyData, ToNativeDelegate(NewOnResponse), NewTimeoutSeconds);
+}
+
+FString ULobbyGameInstanceSubsystem::SendChatMessageWithResponse(const FChatData& NewChatData, const FOnLobbyResponse& NewOnResponse, float NewTimeoutSeconds)
+{
+	return SendChatMessage(NewChatData, ToNativeDelegate(NewOnResponse), NewTimeoutSeconds);
+}
+
+FString ULobbyGameInstanceSubsystem::SendDBRequestWithResponse(const FMongoDBData& NewMongoDBdata, const FOnLobbyResponse& NewOnResponse, float NewTimeoutSeconds)
+{
+	return SendDBRequest(NewMongoDBdata, ToNativeDelegate(NewOnResponse), NewTimeoutSeconds);
+}
+
+FString ULobbyGameInstanceSubsystem::SendDBBulkRequestWithResponse(const FMongoDBBulkData& NewMongoDBBulkData, const FOnLobbyResponse& NewOnResponse, float NewTimeoutSeconds)
+{
+	return SendDBBulkRequest(NewMongoDBBulkData, ToNativeDelegate(NewOnResponse), NewTimeoutSeconds);
+}
+
+FString ULobbyGameInstanceSubsystem::RegisterPlayerIntoLobbyWithResponse(const FString& NewPlayerId, const FOnLobbyResponse& NewOnResponse, float NewTimeoutSeconds)
+{
+	return RegisterPlayerIntoLobby(NewPlayerId, ToNativeDelegate(NewOnResponse), NewTimeoutSeconds);
+}
+
+int32 ULobbyGameInstanceSubsystem::GetInFlightRequestCount() const
+{
+	return RequestTracker.Num();
+}
+
+int64 ULobbyGameInstanceSubsystem::GetChatMessagesSince(const FString& NewChannelId, const FString& NewPeerPlayerId, int64 NewAfterSequence, int32 NewMaxMessages, TArray<FLobbyChatMessage>& OutMessages) const
+{
+	OutMessages.Reset();
+	return ChatStore.GetSince(NewChannelId, NewPeerPlayerId, NewAfterSequence, NewMaxMessages, OutMessages);
+}
+
+int64 ULobbyGameInstanceSubsystem::GetOldestChatSequence(const FString& NewChannelId, const FString& NewPeerPlayerId) const
+{
+	return ChatStore.GetOldestSequence(NewChannelId, NewPeerPlayerId);
+}
+
+void ULobbyGameInstanceSubsystem::ClearChatHistory()
+{
+	ChatStore.Reset();
+}
+
+FString ULobbyGameInstanceSubsystem::RequestResync()
+{
+	if (!ResyncRequestId.IsEmpty() || RegisteredPlayerId.IsEmpty() || !SyncTracker.HasBaseline())
+	{
+		return FString();
+	}
+
+	TArray<int64, TInlineAllocator<4>> FromSequences;
+	for (int32 Index = 0; Index <= static_cast<int32>(ELobbySyncStream::SUBSCRIPTIONS); ++Index)
+	{
+		FromSequences.Add(SyncTracker.GetAcknowledged(static_cast<ELobbySyncStream>(Index)));
+	}
+
+	++SyncStats.ResyncRequests;
+	ResyncRequestId = GenerateRequestUniqueId();
+	const int32 MaxDeltaMessages = ResyncConfig.MaxDeltaMessages;
+	return SendLobbyRequest(ELobbyActionType::RESYNC, RegisteredPlayerId, ResyncRequestId, [this, MaxDeltaMessages](FLobbyJsonWriter& NewWriter)
+	{
+		SyncTracker.WriteResyncPayload(NewWriter, MaxDeltaMessages);
+	}, FOnLobbyResponseNative::CreateWeakLambda(this, [this, FromSequences = MoveTemp(FromSequences)](const FLobbyResponse& NewResponse)
+	{
+		if (NewResponse.RequestId == ResyncRequestId)
+		{
+			ResyncRequestId.Reset();
+		}
+		HandleResyncResponse(NewResponse, FromSequences);
+	}), -1.f, FLobbyOutboundScheduler::GetPriority(OutboundConfig, ELobbyActionType::RESYNC));
+}
+
+int64 ULobbyGameInstanceSubsystem::GetAcknowledgedSequence(ELobbySyncStream NewStream) const
+{
+	return SyncTracker.GetAcknowledged(NewStream);
+}
+
+FLobbySyncStats ULobbyGameInstanceSubsystem::GetSyncStats() const
+{
+	return SyncStats;
+}
+
+void ULobbyGameInstanceSubsystem::ResetSyncStats()
+{
+	SyncStats = FLobbySyncStats();
+}
+
+FLobbyLatencyStats ULobbyGameInstanceSubsystem::GetLatencyStats(ELobbyActionType NewAction) const
+{
+	return RequestTracker.GetLatencyStats(NewAction);
+}
+
+FLobbyLatencyStats ULobbyGameInstanceSubsystem::GetDBLatencyStats(EMongoDBActionType NewDbAction) const
+{
+	return RequestTracker.GetDBLatencyStats(NewDbAction);
+}
+
+void ULobbyGameInstanceSubsystem::ResetLatencyStats()
+{
+	RequestTracker.ResetLatencyStats();
+}
@@ -5,8 +5,25 @@
 #include "IWebSocket.h"
 #include "CoreMinimal.h"
 #include "Subsystems/GameInstanceSubsystem.h"
+#include "Containers/Ticker.h"
+#include "LobbyFrame.h"
+#include "LobbyTypes.h"
+#include "LobbyRequestTracker.h"
+#include "LobbySigner.h"
+#include "LobbyEnvelope.h"
+#include "LobbyReceiveStage.h"
+#include "LobbyCompression.h"
+#include "LobbySendQueue.h"
+#include "LobbyOutboundScheduler.h"
+#include "LobbyConnection.h"
+#include "LobbyDBReadCache.h"
+#include "LobbyChatStore.h"
+#include "LobbyJsonView.h"
+#include "LobbySyncTracker.h"
 #include "LobbyGameInstanceSubsystem.generated.h"
 
+class ULobbyDBCursor;
+
 // TODO need to move this information into Data Asset or ini file
 USTRUCT(Blueprintable)
 struct FJWTConfig
@@ -22,255 +39,255 @@ struct FJWTConfig
 };
 
 
-namespace NGG_LOBBY_PROTOCOL 
+/**
+ * 
+ */
+UCLASS(Blueprintable, Blueprinttype)
+class LOBBYCLIENT_API ULobbyGameInstanceSubsystem : public UGameInstanceSubsystem
 {
-	enum PRATACOL
-	{
-		  CLIENT_ID = 0x0
-		, TIMESTAMP = 0x1
-		, JSON      = 0x2
-		, SIGNATURE = 0x3
-	};
-	const int32 PART_PRATACOL_COUNT = 4;
-};
+	GENERATED_BODY()
 
-UENUM(Blueprintable)
-enum class ELobbyActionType : uint8
-{
-	 NONE						UMETA(DisplayName = "None")
-	,DATABASE					UMETA(DisplayName = "Data Base")
-	,TEXT_CHAT					UMETA(DisplayName = "Text Chat")
-	,FIND_PLAYER				UMETA(DisplayName = "Find Player")
-	,REGISTER_PLAYER_INTO_LOBBY UMETA(DisplayName = "Register Player")
-	,REQUEST_STATUS 			UMETA(DisplayName = "Request Status")
-};
+private:
 
-UENUM(Blueprintable)
-enum class EMongoDBActionType : uint8
-{
-	NONE							UMETA(DisplayName = "None")
-	,AGGREGATE 						UMETA(DisplayName = "Aggregate")
-	,DROP_COLLECTION				UMETA(DisplayName = "Drop Collection")
-	,CREATE_COLLECTION				UMETA(DisplayName = "Create Collection")
-    ,FIND							UMETA(DisplayName = "Find")
-    ,FIND_WITH_OPTIONS				UMETA(DisplayName = "Find With Options")
-    ,FIND_ONE						UMETA(DisplayName = "Find One")
-	,FIND_ONE_WITH_OPTIONS			UMETA(DisplayName = "Find One With Options")
-	,INSERT_ONE						UMETA(DisplayName = "Insert One")
-	,INSERT_MANY					UMETA(DisplayName = "Insert Many")
-	,LIST_DATABASES					UMETA(DisplayName = "List Databases")
-	,LIST_COLLECTION_NAMES			UMETA(DisplayName = "List Collection Names")
-	,LIST_INDEXES					UMETA(DisplayName = "List Indexes")
-	,CREATE_INDEX					UMETA(DisplayName = "Create Index")
-	,DELETE_ONE						UMETA(DisplayName = "Delete One")
-    ,DELETE_MANY					UMETA(DisplayName = "Delete Many")
-    ,GET_ESTIMATED_DOCUMENT_COUNT	UMETA(DisplayName = "Get Estimated Document Count")	
-    ,COUNT_DOCUMENTS 				UMETA(DisplayName = "Count Documents")
-    ,RENAME_COLLECTION              UMETA(DisplayName = "Rename Collection")
-	,RUN_COMMAND					UMETA(DisplayName = "Run Command")
-	,REPLACE_ONE					UMETA(DisplayName = "Replace One")
-	,UPDATE_ONE						UMETA(DisplayName = "Update One")
-	,UPDATE_ONE_WITH_OPTIONS 		UMETA(DisplayName = "Update One With Options")
-	,UPDATE_MANY			 		UMETA(DisplayName = "Update Many")
-	,UPDATE_MANY_WITH_OPTIONS 		UMETA(DisplayName = "Update Many with Options")
-	,FIND_ONE_AND_DELETE 			UMETA(DisplayName = "Find one and delete")
-	,FIND_ONE_AND_REPLACE 			UMETA(DisplayName = "Find one and Replace")
-	,FIND_ONE_AND_UPDATE 			UMETA(DisplayName = "Find one and Update")
-};
+	/**
+	* Connections[0] is the primary one, the database channel's connections follow it while channels are enabled
+	*/
+	TArray<TUniquePtr<FLobbyConnection>> Connections;
 
+	int32 NextConnectionId = 0;
 
-USTRUCT(BlueprintType, Blueprintable)
-struct FNGGLobbyData 
-{
-	GENERATED_BODY()
+	/**
+	* Where the next database request starts looking, so an idle pool takes turns
+	*/
+	int32 NextPoolIndex = 0;
 
 	/**
-	* Client custom ID
+	*	Which actions get connections of their own, applied on the next ConnectToLobbyServer
 	*/
-	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "ClientID"))
-	FString ClientID = "";
+	UPROPERTY(BlueprintReadWrite, meta = (AllowPrivateAccess=true))
+	FLobbyChannelConfig ChannelConfig;
+	
+	/**
+	* bDebug if ture then write log	
+	*/
+	uint8 bDebug : 1;
 
 	/**
-	* The Lobby action type
+	*	JWET Config TODO the JWTConfig must read from DataAsset	
 	*/
-	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "Action"))
-	ELobbyActionType Action = ELobbyActionType::NONE;
+	UPROPERTY(BlueprintReadWrite, meta = (AllowPrivateAccess=true))
+	FJWTConfig JWTConfig;
 
 	/**
-	* 
-	* The PayLoadData can be JSON data
+	*	Keyed HMAC state for JWTConfig, rebuilt only when the config changes
 	*/
-	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "PayLoadData"))
-	FString PayLoadData = "";
+	FLobbySigner Signer;
 
 	/**
-	 *	The Request id  
-	 */
-	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "RequestId"))
-	FString requestId = "";
+	*	Framing used for outgoing messages, received messages are detected by their prefix
+	*/
+	UPROPERTY(BlueprintReadWrite, meta = (AllowPrivateAccess=true))
+	ELobbyFramingMode FramingMode = ELobbyFramingMode::LEGACY;
 
+	/**
+	*	Encoding of database requests, BSON is only used with the length-prefixed framing
+	*/
+	UPROPERTY(BlueprintReadWrite, meta = (AllowPrivateAccess=true))
+	ELobbyPayloadEncoding DBPayloadEncoding = ELobbyPayloadEncoding::JSON;
 
-};
+	/**
+	*	The outgoing frame is written and signed here, reused between messages
+	*/
+	TArray<UTF8CHAR> SendBuffer;
 
-USTRUCT(BlueprintType, Blueprintable)
-struct FChatData
-{
-	GENERATED_BODY()
+	/**
+	*	Outbound batching, requests are sent one frame each while it is disabled
+	*/
+	UPROPERTY(BlueprintReadWrite, meta = (AllowPrivateAccess=true))
+	FLobbySendBatchConfig SendBatchConfig;
 
-	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "SenderPlayerId"))
-	FString SenderPlayerId = "";
+	/**
+	*	Priority lanes and byte budgets for outgoing requests
+	*/
+	UPROPERTY(BlueprintReadWrite, meta = (AllowPrivateAccess=true))
+	FLobbyOutboundConfig OutboundConfig;
 
-	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "Message"))
-	FString Message = "";
+	bool bOutboundBackpressured = false;
 
-	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "RecipientPlayerId"))
-	FString RecipientPlayerId = "";
-};
+	/**
+	*	Deflate large NGG2 frame bodies
+	*/
+	UPROPERTY(BlueprintReadWrite, meta = (AllowPrivateAccess=true))
+	FLobbyCompressionConfig CompressionConfig;
 
-USTRUCT(BlueprintType, Blueprintable)
-struct FMongoDBData
-{
-	GENERATED_BODY()
-	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "SenderPlayerId"))
-	FString SenderPlayerId = "";
-	
-	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "DbName"))
-	FString DbName = "";
+	FLobbyDeflater Deflater;
 
-	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "CollectionName"))
-	FString CollectionName = "";
+	/**
+	*	Per action type, frames carrying several requests are counted under NONE
+	*/
+	TMap<ELobbyActionType, FLobbyCompressionStats> OutboundCompressionStats;
 
-	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "DbAction"))
-	EMongoDBActionType DbAction = EMongoDBActionType::NONE;
+	TMap<ELobbyActionType, FLobbyCompressionStats> InboundCompressionStats;
 
-	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "Data"))
-	FString Data = "";
+	/**
+	*	Send side of the allocation numbers, the receive side and the pools keep their own
+	*/
+	FLobbyAllocationStats AllocationStats;
 
-	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "Filter"))
-	FString Filter = "";
+	/**
+	*	Cheap checks on received frames before their signature, applied on the next connection
+	*/
+	UPROPERTY(BlueprintReadWrite, meta = (AllowPrivateAccess=true))
+	FLobbyInboundGateConfig InboundGateConfig;
 
-	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "Options"))
-	FString Options = "";
-};
+	/**
+	*	Parses and verifies received frames off the game thread
+	*/
+	TSharedPtr<FLobbyReceiveStage, ESPMode::ThreadSafe> ReceiveStage;
 
-USTRUCT(BlueprintType)
-struct FJsonValueStruct
-{
-    GENERATED_BODY()
+	/**
+	*	Game thread time per tick for handling received messages, the rest waits for the next tick
+	*/
+	UPROPERTY(BlueprintReadWrite, meta = (AllowPrivateAccess=true))
+	float ReceiveBudgetMilliseconds = 2.f;
 
-public:
-    // The type of JSON value
-    EJson Type = EJson::None;
-
-    // Stored value
-    TSharedPtr<FJsonValue> JsonValue;
-
-    // Default constructor
-    FJsonValueStruct()
-        : Type(EJson::None), JsonValue(nullptr) {}
-
-    // Initialize with a shared JSON value
-	explicit FJsonValueStruct(TSharedPtr<FJsonValue> InValue)
-	: Type(InValue.IsValid() ? InValue->Type : EJson::None), JsonValue(InValue) {}
-    // Factory methods to create JSON values
-    static FJsonValueStruct FromBool(bool Value)
-    {
-        return FJsonValueStruct(MakeShared<FJsonValueBoolean>(Value));
-    }
-
-    static FJsonValueStruct FromInt(int32 Value)
-    {
-        return FJsonValueStruct(MakeShared<FJsonValueNumber>(static_cast<double>(Value)));
-    }
-
-    static FJsonValueStruct FromFloat(float Value)
-    {
-        return FJsonValueStruct(MakeShared<FJsonValueNumber>(static_cast<double>(Value)));
-    }
-
-    static FJsonValueStruct FromString(const FString& Value)
-    {
-        return FJsonValueStruct(MakeShared<FJsonValueString>(Value));
-    }
-
-    static FJsonValueStruct FromArray(const TArray<TSharedPtr<FJsonValue>>& Array)
-    {
-        return FJsonValueStruct(MakeShared<FJsonValueArray>(Array));
-    }
-
-    static FJsonValueStruct FromObject(const TSharedPtr<FJsonObject>& Object)
-    {
-        return FJsonValueStruct(MakeShared<FJsonValueObject>(Object));
-    }
-
-    // Type-checking methods
-    bool IsNull() const { return Type == EJson::None; }
-    bool IsBool() const { return Type == EJson::Boolean; }
-    bool IsNumber() const { return Type == EJson::Number; }
-    bool IsString() const { return Type == EJson::String; }
-    bool IsArray() const { return Type == EJson::Array; }
-    bool IsObject() const { return Type == EJson::Object; }
-
-    // Conversion methods
-    bool ToBool() const
-    {
-        return JsonValue.IsValid() && JsonValue->Type == EJson::Boolean ? JsonValue->AsBool() : false;
-    }
-
-    int32 ToInt() const
-    {
-        return JsonValue.IsValid() && JsonValue->Type == EJson::Number ? static_cast<int32>(JsonValue->AsNumber()) : 0;
-    }
-
-    float ToFloat() const
-    {
-        return JsonValue.IsValid() && JsonValue->Type == EJson::Number ? static_cast<float>(JsonValue->AsNumber()) : 0.0f;
-    }
-
-    FString ToString() const
-    {
-        return JsonValue.IsValid() && JsonValue->Type == EJson::String ? JsonValue->AsString() : TEXT("");
-    }
-
-    TArray<TSharedPtr<FJsonValue>> ToArray() const
-    {
-        return JsonValue.IsValid() && JsonValue->Type == EJson::Array ? JsonValue->AsArray() : TArray<TSharedPtr<FJsonValue>>();
-    }
-
-    TSharedPtr<FJsonObject> ToObject() const
-    {
-        return JsonValue.IsValid() && JsonValue->Type == EJson::Object ? JsonValue->AsObject() : nullptr;
-    }
-};
+	/**
+	*	Seconds a request waits for its response when the caller does not pass a timeout, 0 waits forever
+	*/
+	UPROPERTY(BlueprintReadWrite, meta = (AllowPrivateAccess=true))
+	float DefaultRequestTimeoutSeconds = 10.f;
 
-/**
- * 
- */
-UCLASS(Blueprintable, Blueprinttype)
-class LOBBYCLIENT_API ULobbyGameInstanceSubsystem : public UGameInstanceSubsystem
-{
-	GENERATED_BODY()
+	/**
+	*	Requests waiting for their response
+	*/
+	FLobbyRequestTracker RequestTracker;
 
-private:
+	FTSTicker::FDelegateHandle TickHandle;
 
 	/**
-	* Web socket 
+	*	Repeated database reads are answered from DBReadCache while it is enabled
 	*/
-	TSharedPtr<IWebSocket> WebSocket;
-	
+	UPROPERTY(BlueprintReadWrite, meta = (AllowPrivateAccess=true))
+	FLobbyDBCacheConfig DBCacheConfig;
+
+	FLobbyDBReadCache DBReadCache;
+
 	/**
-	* bDebug if ture then write log	
+	*	Send an identical read only once while it is in flight, the response goes to every caller
 	*/
-	uint8 bDebug : 1;
+	UPROPERTY(BlueprintReadWrite, meta = (AllowPrivateAccess=true))
+	bool bCoalesceReads = true;
+
+	struct FInFlightRead
+	{
+		FString Key;
+		/**
+		 * Callers that joined the read, each with its own request id and tracker entry
+		 */
+		TArray<FString> FollowerRequestIds;
+	};
 
 	/**
-	*	JWET Config TODO the JWTConfig must read from DataAsset	
+	*	Reads on the wire by the hash of their key
+	*/
+	TMap<uint64, FInFlightRead> InFlightReads;
+
+	int64 CoalescedRequestCount = 0;
+
+	/**
+	*	Responses made on the client, dispatched on the next tick like the ones from the server
+	*/
+	TArray<FLobbyResponse> LocalResponses;
+
+	/**
+	*	Cursors that can still receive batches, kept alive here until they close
 	*/
+	UPROPERTY()
+	TArray<TObjectPtr<ULobbyDBCursor>> OpenCursors;
+
 	UPROPERTY(BlueprintReadWrite, meta = (AllowPrivateAccess=true))
-	FJWTConfig JWTConfig;
+	FLobbyReconnectConfig ReconnectConfig;
+
+	FString ServerURL;
+
+	/**
+	*	False after DisconnectFromLobbyServer, a lost connection is only restored while this is set
+	*/
+	bool bWantConnection = false;
+
+	/**
+	*	The player the last RegisterPlayerIntoLobby was for
+	*/
+	FString RegisteredPlayerId;
+
+	/**
+	*	Envelopes that are kept or queued are serialized here first, reused between requests
+	*/
+	TArray<UTF8CHAR> EnvelopeBuffer;
+
+	/**
+	*	Received chat kept per channel and per peer, bounded by ChatConfig
+	*/
+	UPROPERTY(BlueprintReadWrite, meta = (AllowPrivateAccess=true))
+	FLobbyChatConfig ChatConfig;
+
+	FLobbyChatStore ChatStore;
+
+	/**
+	*	Reused for every received chat payload
+	*/
+	FLobbyJsonView ChatPayLoadView;
+
+	UPROPERTY(BlueprintReadWrite, meta = (AllowPrivateAccess=true))
+	FLobbyResyncConfig ResyncConfig;
+
+	/**
+	*	Position in each numbered stream, kept across reconnects until the player changes
+	*/
+	FLobbySyncTracker SyncTracker;
+
+	FLobbySyncStats SyncStats;
+
+	/**
+	*	The RESYNC request waiting for its answer, only one goes out at a time
+	*/
+	FString ResyncRequestId;
 
 public:
 
+	/**
+	*	Broadcast for every valid message received, responses and messages pushed by the server
+	*/
+	UPROPERTY(BlueprintAssignable)
+	FOnLobbyMessage OnLobbyMessage;
+
+	/**
+	*	State changes of the primary connection
+	*/
+	UPROPERTY(BlueprintAssignable)
+	FOnLobbyConnectionStateChanged OnConnectionStateChanged;
+
+	/**
+	*	True once bulk requests are rejected because the outbound queue is full, false when there is room again.
+	*	Callers that would rather wait than be rejected hold their requests back until then.
+	*/
+	UPROPERTY(BlueprintAssignable)
+	FOnLobbyOutboundBackpressure OnOutboundBackpressure;
+
+	/**
+	*	Broadcast for every chat message stored in the history, with its sequence in the conversation
+	*/
+	UPROPERTY(BlueprintAssignable)
+	FOnLobbyChatMessage OnChatMessage;
+
+	FOnLobbyChatMessageNative OnChatMessageNative;
+
+	/**
+	*	Broadcast for every stream of a resync answer, after the missed messages went out through OnLobbyMessage
+	*/
+	UPROPERTY(BlueprintAssignable)
+	FOnLobbyResync OnResync;
+
 	
 	/**
 	 * construct  
@@ -279,60 +296,242 @@ public:
 
 	~ULobbyGameInstanceSubsystem();
 
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
 private:
 
+	bool Tick(float NewDeltaTime);
+
 
 
 	
-	void OnConnected();
+	void OnConnected(int32 NewConnectionId);
 
-	void OnConnectionError(const FString& NewError);
+	void OnConnectionError(const FString& NewError, int32 NewConnectionId);
 
-	void OnMessageReceived(const FString& NewMessage);
+	void OnRawMessageReceived(const void* NewData, SIZE_T NewSize, SIZE_T NewBytesRemaining, int32 NewConnectionId);
 
-	void OnClosed(int32 NewStatusCode, const FString& NewReason, bool NewWasClean);
+	void OnMessageReceived(FLobbyInboundMessage& NewMessage, double NewNow);
 
-private:
+	/**
+	* Keep a received chat message in ChatStore and tell the listeners
+	*/
+	void StoreChatMessage(const FLobbyResponse& NewResponse);
 
-	FString GenerateSignature(const FString& NewClientSecret, const FString& NewRequestBodyString, const FString& NewClientId, int64 NewTimestamp) const;
+	/**
+	* Track a numbered message, false if it was seen already and must be dropped
+	*/
+	bool ObserveSequence(const FLobbyResponse& NewResponse);
 
-	FString MakeSendData(const FString& NewRequestBodyString, const FString& NewClientId, int64 NewTimestamp, const FString& NewSignature = "") const;
+	/**
+	* NewFromSequences are the positions sent, by stream
+	*/
+	void HandleResyncResponse(const FLobbyResponse& NewResponse, TConstArrayView<int64> NewFromSequences);
+
+	void DispatchReceivedMessages();
+
+	void OnClosed(int32 NewStatusCode, const FString& NewReason, bool NewWasClean, int32 NewConnectionId);
+
+	/**
+	* Add or remove database connections to match ChannelConfig
+	*/
+	void UpdateConnections();
 
-	TArray<FString> ParsReceivedData(const FString & NewReceivedData) const;
+	FLobbyConnection* FindConnection(int32 NewConnectionId) const;
 
-	bool IsValidSignature(const TArray<FString>& NewReceivedData, const FString& NewReceivedSignature) const;
+	ELobbyChannel GetChannel(ELobbyActionType NewAction) const;
+
+	/**
+	* The connection of the action's channel, the least busy one of a pool
+	*/
+	FLobbyConnection& GetConnectionFor(ELobbyActionType NewAction);
+
+	/**
+	* Create and connect a new WebSocket to the connection's URL, dropping the old one
+	*/
+	void OpenWebSocket(FLobbyConnection& NewConnection);
+
+	void ReleaseWebSocket(FLobbyConnection& NewConnection);
+
+	/**
+	* Close without reconnecting and fail everything waiting on the connection
+	*/
+	void CloseConnection(FLobbyConnection& NewConnection, ELobbyRequestStatus NewStatus, const FString& NewError);
+
+	/**
+	* Schedule the next attempt, or give up and fail the queued requests
+	*/
+	void HandleConnectionLost(FLobbyConnection& NewConnection);
+
+	/**
+	* Only the primary connection's changes are broadcast
+	*/
+	void SetConnectionState(FLobbyConnection& NewConnection, ELobbyConnectionState NewState);
+
+	/**
+	* Full jitter: uniform between 0 and the exponential bound of NewAttempt
+	*/
+	float GetReconnectDelaySeconds(int32 NewAttempt) const;
+
+private:
+
+	bool EnsureSigner();
 
 	FString GetClientSecret() const;
 
 	FString GetClientId() const;
 
-	void CookingDataAndSendToClient(const FString& NewData);
-	
-	bool CheckClientDataIsValid(const TArray<FString>& NewClientDataStringArray);
+	/**
+	* Frame, sign and send the body NewWriteBody writes, returns false if nothing was sent.
+	* NewAction is only used for the compression stats.
+	*/
+	bool CookingDataAndSendToClient(FLobbyConnection& NewConnection, FLobbyEnvelope::FWritePayload NewWriteBody, ELobbyActionType NewAction, bool bNewBsonBody = false);
 
-	int64 GetTimestamp() const;
+	/**
+	* Queue the envelope for the next batch frame, sending the batch early if a limit is reached.
+	* bNewRetain is set for writes that are already among the connection's unacknowledged envelopes.
+	*/
+	void EnqueueLobbyRequest(FLobbyConnection& NewConnection, const FString& NewRequestId, double NewNow, FLobbyEnvelope::FWritePayload NewWriteEnvelope, bool bNewRetain = false);
 
-	TSharedRef<FJsonObject> ConvertStringMapToJson(const TMap<FString, FString>& InputMap) const;
+	void FlushConnectionSendQueue(FLobbyConnection& NewConnection);
 
-	TSharedRef<FJsonObject> ConvertIntMapToJson(const TMap<FString, int32>& InputMap) const;
+	/**
+	* bNewIdempotent marks writes: they carry an idempotency key and are kept until answered, so they can be replayed.
+	* NewDbAction is tracked with a DATABASE request before anything is sent.
+	*/
+	FString SendLobbyRequest(ELobbyActionType NewAction, const FString& NewClientID, const FString& NewRequestId, FLobbyEnvelope::FWritePayload NewWritePayload, FOnLobbyResponseNative NewOnResponse, float NewTimeoutSeconds, ELobbySendPriority NewPriority, bool bNewIdempotent = false, EMongoDBActionType NewDbAction = EMongoDBActionType::NONE);
 
-	TSharedRef<FJsonObject> ConvertFloatMapToJson(const TMap<FString, float>& InputMap) const;
+	/**
+	* SendLobbyRequest with the envelope written as BSON, it always goes out in a frame of its own
+	*/
+	FString SendLobbyBsonRequest(ELobbyActionType NewAction, const FString& NewClientID, const FString& NewRequestId, FLobbyEnvelope::FWriteBsonPayload NewWritePayload, FOnLobbyResponseNative NewOnResponse, float NewTimeoutSeconds, ELobbySendPriority NewPriority, bool bNewIdempotent = false, EMongoDBActionType NewDbAction = EMongoDBActionType::NONE);
 
-	TSharedRef<FJsonObject> ConvertBoolMapToJson(const TMap<FString, bool>& InputMap) const;
+	/**
+	* Send a serialized envelope now or put it into its priority lane, the request is rejected if the lane is full
+	*/
+	void SendEnvelope(FLobbyConnection& NewConnection, const FString& NewRequestId, FUtf8StringView NewEnvelope, bool bNewRetain, ELobbySendPriority NewPriority, bool bNewBson = false);
+
+	/**
+	* Send a serialized envelope past the lanes, or queue it for replay while not connected
+	*/
+	void TransmitEnvelope(FLobbyConnection& NewConnection, const FString& NewRequestId, FUtf8StringView NewEnvelope, bool bNewRetain, double NewNow, bool bNewBson = false);
+
+	/**
+	* True while the tick budget lasts and nothing of the same or a higher priority waits
+	*/
+	bool CanSendDirectly(const FLobbyConnection& NewConnection, ELobbySendPriority NewPriority) const;
+
+	/**
+	* Send what the rest of this tick's budget allows from the priority lanes
+	*/
+	void PumpOutbound(FLobbyConnection& NewConnection);
 
-	TSharedRef<FJsonObject> ConvertJsonValueStructMapToJson(const TMap<FString, FJsonValueStruct>& InputMap) const;
+	void FailOutbound(FLobbyConnection& NewConnection, ELobbyRequestStatus NewStatus, const FString& NewError);
+
+	void UpdateOutboundBackpressure();
+
+	/**
+	* Returns false if the offline queue is full or there is no connection to wait for
+	*/
+	bool QueueOffline(FLobbyConnection& NewConnection, const FString& NewRequestId, FUtf8StringView NewEnvelope, bool bNewRetain, bool bNewBson = false);
+
+	void ReplayOfflineQueue(FLobbyConnection& NewConnection);
+
+	void FailOfflineQueue(FLobbyConnection& NewConnection, ELobbyRequestStatus NewStatus, const FString& NewError);
+
+	bool IsPayloadNested() const;
+
+	bool IsDBPayloadBson() const;
+
+	/**
+	* Answer a cached read on the next tick, without sending anything
+	*/
+	void AnswerLocally(const FString& NewRequestId, const FString& NewPayLoadData, FOnLobbyResponseNative NewOnResponse, float NewTimeoutSeconds);
+
+	/**
+	* Answer a request that is never sent with FAILED right away, it is not tracked
+	*/
+	static void FailWithoutSending(const FString& NewRequestId, ELobbyActionType NewAction, const FString& NewError, const FOnLobbyResponseNative& NewOnResponse);
+
+	/**
+	* Fail a request the tracker refused, its id was empty or already in flight
+	*/
+	static void FailUntracked(const FString& NewRequestId, ELobbyActionType NewAction, const FOnLobbyResponseNative& NewOnResponse);
+
+	float GetDBCacheTTLSeconds(const FString& NewCollectionName) const;
+
+	/**
+	* Join an identical read already in flight and return true, or make this request the one that
+	* is sent and wrap InOutOnResponse so its response also completes the callers joining later
+	*/
+	bool CoalesceRead(const FString& NewKey, const FString& NewRequestId, ELobbyActionType NewAction, FOnLobbyResponseNative& InOutOnResponse, float NewTimeoutSeconds, EMongoDBActionType NewDbAction = EMongoDBActionType::NONE);
 	
-	template <typename ValueType>
-	FString ConvertTMapToJson(const TMap<FString, ValueType>& InputMap) const;
+	static FOnLobbyResponseNative ToNativeDelegate(const FOnLobbyResponse& NewOnResponse);
+
+	int64 GetTimestamp() const;
 
 public:
 
 	FString GenerateRequestUniqueId() const;
 
+	/**
+	 * Replace the JWTConfig and rebuild the signer right away
+	 */
+	UFUNCTION(BlueprintCallable)
+	void SetJWTConfig(const FJWTConfig& NewJWTConfig);
+
+	/**
+	 * The key requests are signed with, for stand-in servers that have to answer them
+	 */
+	const FJWTConfig& GetJWTConfig() const { return JWTConfig; }
+
 	
 	UFUNCTION(BlueprintCallable)
 	void ConnectToLobbyServer(const FString & NewURL);
 
+	/**
+	 * Close the connection without reconnecting, queued requests are cancelled
+	 */
+	UFUNCTION(BlueprintCallable)
+	void DisconnectFromLobbyServer();
+
+	/**
+	 * State of the primary connection
+	 */
+	UFUNCTION(BlueprintPure)
+	ELobbyConnectionState GetConnectionState() const;
+
+	/**
+	 * Handle every open connection as lost, the way a WebSocket closed by the server is. For tests of the reconnect path.
+	 */
+	void SimulateConnectionLost();
+
+	/**
+	 * CONNECTED if any connection of the channel is, the primary connection's state while the channel has none
+	 */
+	UFUNCTION(BlueprintPure)
+	ELobbyConnectionState GetChannelConnectionState(ELobbyChannel NewChannel) const;
+
+	/**
+	 * Requests waiting for the connection to come back
+	 */
+	UFUNCTION(BlueprintPure)
+	int32 GetOfflineQueueLength() const;
+
+	/**
+	 * Bytes waiting in the priority lanes
+	 */
+	UFUNCTION(BlueprintPure)
+	int32 GetOutboundQueuedBytes() const;
+
+	/**
+	 * True while a request of NewPriority would be rejected because its share of the outbound queue is full
+	 */
+	UFUNCTION(BlueprintPure)
+	bool IsOutboundBackpressured(ELobbySendPriority NewPriority) const;
+
 	UFUNCTION(BlueprintCallable)
 	FString SendData(const FNGGLobbyData& NewNGGLobbyData);
 
@@ -342,8 +541,160 @@ public:
 	UFUNCTION(BlueprintCallable)
 	FString SendDBRequest(const FMongoDBData& NewMongoDBdata);
 
+	/**
+	 * Send every operation of NewMongoDBBulkData as one request, the response holds one result per operation
+	 */
+	UFUNCTION(BlueprintCallable)
+	FString SendDBBulkRequest(const FMongoDBBulkData& NewMongoDBBulkData);
+
 	UFUNCTION(BlueprintCallable)
 	FString RegisterPlayerIntoLobby(const FString& NewPlayerId);
+
+	/**
+	 * Run a FIND, FIND_WITH_OPTIONS or AGGREGATE as a server cursor that returns NewBatchSize documents at a time.
+	 * Bind to the cursor's OnBatch, the first batch is already requested.
+	 */
+	UFUNCTION(BlueprintCallable)
+	ULobbyDBCursor* OpenDBCursor(const FMongoDBData& NewQuery, int32 NewBatchSize = 100, float NewTimeoutSeconds = -1.f);
+
+	/**
+	 * Called by a cursor once it is exhausted, failed or cancelled
+	 */
+	void ReleaseDBCursor(ULobbyDBCursor* NewCursor);
+
+	/**
+	 * The variants below complete NewOnResponse exactly once with the response, a timeout or a failure.
+	 * A negative NewTimeoutSeconds uses DefaultRequestTimeoutSeconds, 0 waits forever.
+	 * Use FLobbyRequestTracker::MakeResponseFuture to wait on a TFuture instead.
+	 */
+	FString SendData(const FNGGLobbyData& NewNGGLobbyData, FOnLobbyResponseNative NewOnResponse, float NewTimeoutSeconds = -1.f);
+
+	FString SendChatMessage(const FChatData& NewChatData, FOnLobbyResponseNative NewOnResponse, float NewTimeoutSeconds = -1.f);
+
+	FString SendDBRequest(const FMongoDBData& NewMongoDBdata, FOnLobbyResponseNative NewOnResponse, float NewTimeoutSeconds = -1.f);
+
+	FString SendDBBulkRequest(const FMongoDBBulkData& NewMongoDBBulkData, FOnLobbyResponseNative NewOnResponse, float NewTimeoutSeconds = -1.f);
+
+	FString RegisterPlayerIntoLobby(const FString& NewPlayerId, FOnLobbyResponseNative NewOnResponse, float NewTimeoutSeconds = -1.f);
+
+	UFUNCTION(BlueprintCallable)
+	FString SendDataWithResponse(const FNGGLobbyData& NewNGGLobbyData, const FOnLobbyResponse& NewOnResponse, float NewTimeoutSeconds = -1.f);
+
+	UFUNCTION(BlueprintCallable)
+	FString SendChatMessageWithResponse(const FChatData& NewChatData, const FOnLobbyResponse& NewOnResponse, float NewTimeoutSeconds = -1.f);
+
+	UFUNCTION(BlueprintCallable)
+	FString SendDBRequestWithResponse(const FMongoDBData& NewMongoDBdata, const FOnLobbyResponse& NewOnResponse, float NewTimeoutSeconds = -1.f);
+
+	UFUNCTION(BlueprintCallable)
+	FString SendDBBulkRequestWithResponse(const FMongoDBBulkData& NewMongoDBBulkData, const FOnLobbyResponse& NewOnResponse, float NewTimeoutSeconds = -1.f);
+
+	UFUNCTION(BlueprintCallable)
+	FString RegisterPlayerIntoLobbyWithResponse(const FString& NewPlayerId, const FOnLobbyResponse& NewOnResponse, float NewTimeoutSeconds = -1.f);
+
+	UFUNCTION(BlueprintPure)
+	int32 GetInFlightRequestCount() const;
+
+	/**
+	 * Chat kept for the channel, or for the peer if NewPeerPlayerId is set, after NewAfterSequence and oldest first.
+	 * At most NewMaxMessages are returned if it is above 0. Returns the sequence of the newest message kept.
+	 */
+	UFUNCTION(BlueprintCallable)
+	int64 GetChatMessagesSince(const FString& NewChannelId, const FString& NewPeerPlayerId, int64 NewAfterSequence, int32 NewMaxMessages, TArray<FLobbyChatMessage>& OutMessages) const;
+
+	/**
+	 * Sequence of the oldest chat message still kept for the conversation, 0 if there is none
+	 */
+	UFUNCTION(BlueprintPure)
+	int64 GetOldestChatSequence(const FString& NewChannelId, const FString& NewPeerPlayerId) const;
+
+	UFUNCTION(BlueprintCallable)
+	void ClearChatHistory();
+
+	/**
+	 * Ask for the messages missed in every stream the client has a position in. Sent on its own after a reconnect
+	 * and when a hole shows up, while ResyncConfig is enabled. Returns the request id, empty if nothing was sent.
+	 */
+	UFUNCTION(BlueprintCallable)
+	FString RequestResync();
+
+	/**
+	 * Last sequence of the stream received without a hole before it
+	 */
+	UFUNCTION(BlueprintPure)
+	int64 GetAcknowledgedSequence(ELobbySyncStream NewStream) const;
+
+	UFUNCTION(BlueprintPure)
+	FLobbySyncStats GetSyncStats() const;
+
+	UFUNCTION(BlueprintCallable)
+	void ResetSyncStats();
+
+	/**
+	 * Requests answered by joining an identical read that was already in flight
+	 */
+	UFUNCTION(BlueprintPure)
+	int64 GetCoalescedRequestCount() const;
+
+	UFUNCTION(BlueprintPure)
+	FLobbyDBCacheStats GetDBCacheStats() const;
+
+	UFUNCTION(BlueprintCallable)
+	void ResetDBCacheStats();
+
+	/**
+	 * Compression of the frames sent, or received if bNewOutbound is false, for one action type
+	 */
+	UFUNCTION(BlueprintPure)
+	FLobbyCompressionStats GetCompressionStats(ELobbyActionType NewAction, bool bNewOutbound) const;
+
+	UFUNCTION(BlueprintCallable)
+	void ResetCompressionStats();
+
+	/**
+	 * Heap allocations per request sent and per frame received, steady state messaging should stay close to zero
+	 */
+	UFUNCTION(BlueprintPure)
+	FLobbyAllocationStats GetAllocationStats() const;
+
+	UFUNCTION(BlueprintCallable)
+	void ResetAllocationStats();
+
+	/**
+	 * Round trip percentiles of the answered requests of one action type, from send to the matching requestId
+	 */
+	UFUNCTION(BlueprintPure)
+	FLobbyLatencyStats GetLatencyStats(ELobbyActionType NewAction) const;
+
+	/**
+	 * The same for database requests, by database action
+	 */
+	UFUNCTION(BlueprintPure)
+	FLobbyLatencyStats GetDBLatencyStats(EMongoDBActionType NewDbAction) const;
+
+	UFUNCTION(BlueprintCallable)
+	void ResetLatencyStats();
+
+	/**
+	 * Received frames dropped by each check before the HMAC, and the ones that reached it and failed
+	 */
+	UFUNCTION(BlueprintPure)
+	FLobbyInboundGateStats GetInboundGateStats() const;
+
+	UFUNCTION(BlueprintCallable)
+	void ResetInboundGateStats();
+
+	/**
+	 * Drop every cached read, for example after the server data changed behind the client's back
+	 */
+	UFUNCTION(BlueprintCallable)
+	void ClearDBCache();
+
+	/**
+	 * Send the queued requests now instead of on the next tick
+	 */
+	UFUNCTION(BlueprintCallable)
+	void FlushSendQueue();
 	
 	
 	
@@ -0,0 +1,116 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LobbyInboundGate.h"
+#include "LobbySigner.h"
+#include "Hash/xxhash.h"
+
+void FLobbyInboundGate::SetConfig(const FLobbyInboundGateConfig& NewConfig)
+{
+	const int32 Capacity = FMath::Max(NewConfig.RecentFrameCapacity, 0);
+	if (Capacity != FMath::Max(Config.RecentFrameCapacity, 0))
+	{
+		RecentSignatures.Empty(Capacity);
+		RecentOrder.Empty(Capacity);
+		NextRecentSlot = 0;
+	}
+	Config = NewConfig;
+}
+
+bool FLobbyInboundGate::CheckLength(int32 NewFrameBytes)
+{
+	++CheckedFrames;
+	if (NewFrameBytes <= 0 || (Config.MaxFrameBytes > 0 && NewFrameBytes > Config.MaxFrameBytes))
+	{
+		Reject(ELobbyGateStage::FRAME_LENGTH);
+		return false;
+	}
+	return true;
+}
+
+bool FLobbyInboundGate::CheckHeader(const FLobbyFrameView& NewFrameView, FUtf8StringView NewClientId, int64 NewNow, int64& OutTimestamp)
+{
+	// The server signs with our client id, the one in the frame only has to match if it is asked for
+	if (Config.bRequireClientId && !NewFrameView[NGG_LOBBY_PROTOCOL::CLIENT_ID].Equals(NewClientId, ESearchCase::CaseSensitive))
+	{
+		Reject(ELobbyGateStage::CLIENT_ID);
+		return false;
+	}
+
+	if (!FLobbyFrameParser::ParseTimestamp(NewFrameView[NGG_LOBBY_PROTOCOL::TIMESTAMP], OutTimestamp)
+		|| (Config.MaxClockSkewSeconds > 0.f && FMath::Abs(NewNow - OutTimestamp) > static_cast<int64>(Config.MaxClockSkewSeconds * 1000.0)))
+	{
+		Reject(ELobbyGateStage::TIMESTAMP);
+		return false;
+	}
+
+	if (!RecentOrder.IsEmpty() && RecentSignatures.Contains(HashSignature(NewFrameView[NGG_LOBBY_PROTOCOL::SIGNATURE])))
+	{
+		Reject(ELobbyGateStage::REPLAY);
+		return false;
+	}
+	return true;
+}
+
+void FLobbyInboundGate::Reject(ELobbyGateStage NewStage)
+{
+	++Rejects[static_cast<int32>(NewStage)];
+}
+
+void FLobbyInboundGate::Accept(const FLobbyFrameView& NewFrameView)
+{
+	++AcceptedFrames;
+	const int32 Capacity = Config.RecentFrameCapacity;
+	if (Capacity <= 0)
+	{
+		return;
+	}
+
+	const uint64 Hash = HashSignature(NewFrameView[NGG_LOBBY_PROTOCOL::SIGNATURE]);
+	if (RecentOrder.Num() < Capacity)
+	{
+		RecentOrder.Add(Hash);
+	}
+	else
+	{
+		// Full, the oldest frame is forgotten
+		RecentSignatures.Remove(RecentOrder[NextRecentSlot]);
+		RecentOrder[NextRecentSlot] = Hash;
+		NextRecentSlot = (NextRecentSlot + 1) % Capacity;
+	}
+	RecentSignatures.Add(Hash);
+}
+
+void FLobbyInboundGate::GetStats(FLobbyInboundGateStats& OutStats) const
+{
+	OutStats.CheckedFrames = CheckedFrames;
+	OutStats.AcceptedFrames = AcceptedFrames;
+	OutStats.OversizedFrames = Rejects[static_cast<int32>(ELobbyGateStage::FRAME_LENGTH)];
+	OutStats.MalformedFrames = Rejects[static_cast<int32>(ELobbyGateStage::FRAME_FORMAT)];
+	OutStats.ClientIdMismatches = Rejects[static_cast<int32>(ELobbyGateStage::CLIENT_ID)];
+	OutStats.StaleFrames = Rejects[static_cast<int32>(ELobbyGateStage::TIMESTAMP)];
+	OutStats.ReplayedFrames = Rejects[static_cast<int32>(ELobbyGateStage::REPLAY)];
+	OutStats.BadSignatures = Rejects[static_cast<int32>(ELobbyGateStage::SIGNATURE)];
+}
+
+void FLobbyInboundGate::ResetStats()
+{
+	CheckedFrames = 0;
+	AcceptedFrames = 0;
+	for (std::atomic<int64>& Count : Rejects)
+	{
+		Count = 0;
+	}
+}
+
+uint64 FLobbyInboundGate::HashSignature(FUtf8StringView NewSignature)
+{
+	// Verify ignores hex case, the same signature in upper case is the same frame
+	ANSICHAR Lower[FLobbySigner::SIGNATURE_LENGTH];
+	const int32 Length = FMath::Min(NewSignature.Len(), FLobbySigner::SIGNATURE_LENGTH);
+	for (int32 Index = 0; Index < Length; ++Index)
+	{
+		Lower[Index] = TChar<ANSICHAR>::ToLower(static_cast<ANSICHAR>(NewSignature[Index]));
+	}
+	return FXxHash64::HashBuffer(Lower, Length).Hash;
+}
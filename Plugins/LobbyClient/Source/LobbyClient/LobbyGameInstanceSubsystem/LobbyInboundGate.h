@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LobbyTypes.h"
+#include "LobbyFrame.h"
+#include <atomic>
+
+/**
+ * The checks a received frame passes before it is decoded, cheapest first
+ */
+enum class ELobbyGateStage : uint8
+{
+	 FRAME_LENGTH
+	,FRAME_FORMAT
+	,CLIENT_ID
+	,TIMESTAMP
+	,REPLAY
+	,SIGNATURE
+	,NUM
+};
+
+/**
+ * Cheap checks that run before the HMAC of a received frame, so a stale, replayed or foreign frame is
+ * dropped without the cost of verifying it. Every stage counts what it rejects.
+ * The checks run on the receive pipe, the counters can be read from any thread.
+ */
+class LOBBYCLIENT_API FLobbyInboundGate
+{
+public:
+
+	/**
+	 * Only call it on the pipe, the recent frames are dropped when their capacity changes
+	 */
+	void SetConfig(const FLobbyInboundGateConfig& NewConfig);
+
+	bool CheckLength(int32 NewFrameBytes);
+
+	/**
+	 * Client id, timestamp window and recent frames. OutTimestamp is the one the signature covers.
+	 */
+	bool CheckHeader(const FLobbyFrameView& NewFrameView, FUtf8StringView NewClientId, int64 NewNow, int64& OutTimestamp);
+
+	/**
+	 * Count a reject found outside the gate, a frame that could not be split or a signature that did not match
+	 */
+	void Reject(ELobbyGateStage NewStage);
+
+	/**
+	 * Remember the frame as seen, only once its signature matched so forged frames can not push real ones out
+	 */
+	void Accept(const FLobbyFrameView& NewFrameView);
+
+	void GetStats(FLobbyInboundGateStats& OutStats) const;
+
+	void ResetStats();
+
+private:
+
+	static uint64 HashSignature(FUtf8StringView NewSignature);
+
+	FLobbyInboundGateConfig Config;
+
+	/**
+	 * Signature hashes of the last accepted frames, RecentOrder is a ring that decides which one leaves next
+	 */
+	TSet<uint64> RecentSignatures;
+
+	TArray<uint64> RecentOrder;
+
+	int32 NextRecentSlot = 0;
+
+	std::atomic<int64> CheckedFrames = 0;
+
+	std::atomic<int64> AcceptedFrames = 0;
+
+	std::atomic<int64> Rejects[static_cast<int32>(ELobbyGateStage::NUM)] = {};
+};
@@ -0,0 +1,157 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LobbyJsonBuilder.h"
+#include "LobbyClient.h"
+#include "LobbyBufferPool.h"
+
+namespace
+{
+	TLobbyBufferPool<UTF8CHAR>& GetPool()
+	{
+		static TLobbyBufferPool<UTF8CHAR> Pool(FLobbyJsonBufferPool::MAX_POOLED_BUFFERS, FLobbyJsonBufferPool::MAX_POOLED_BYTES);
+		return Pool;
+	}
+}
+
+TArray<UTF8CHAR> FLobbyJsonBufferPool::Acquire()
+{
+	return GetPool().Acquire();
+}
+
+void FLobbyJsonBufferPool::Release(TArray<UTF8CHAR>&& NewBuffer)
+{
+	GetPool().Release(MoveTemp(NewBuffer));
+}
+
+FLobbyJsonBuilder::FLobbyJsonBuilder()
+	: Buffer(FLobbyJsonBufferPool::Acquire())
+{
+	Writer.Emplace(Buffer);
+}
+
+FLobbyJsonBuilder::~FLobbyJsonBuilder()
+{
+	Writer.Reset();
+	FLobbyJsonBufferPool::Release(MoveTemp(Buffer));
+}
+
+bool FLobbyJsonBuilder::BeginObject()
+{
+	if (!BeforeValue())
+	{
+		return false;
+	}
+	Writer->BeginObject();
+	Scopes.Push(false);
+	return true;
+}
+
+bool FLobbyJsonBuilder::EndObject()
+{
+	if (bFailed || Scopes.IsEmpty() || Scopes.Last() || bAfterKey)
+	{
+		return Fail(TEXT("EndObject without an open object, or after a key"));
+	}
+	Writer->EndObject();
+	Scopes.Pop(EAllowShrinking::No);
+	return true;
+}
+
+bool FLobbyJsonBuilder::BeginArray()
+{
+	if (!BeforeValue())
+	{
+		return false;
+	}
+	Writer->BeginArray();
+	Scopes.Push(true);
+	return true;
+}
+
+bool FLobbyJsonBuilder::EndArray()
+{
+	if (bFailed || Scopes.IsEmpty() || !Scopes.Last())
+	{
+		return Fail(TEXT("EndArray without an open array"));
+	}
+	Writer->EndArray();
+	Scopes.Pop(EAllowShrinking::No);
+	return true;
+}
+
+bool FLobbyJsonBuilder::WriteKey(FStringView NewKey)
+{
+	if (bFailed || Scopes.IsEmpty() || Scopes.Last() || bAfterKey)
+	{
+		return Fail(TEXT("a key outside an object, or two keys in a row"));
+	}
+	Writer->WriteEscapedKey(NewKey);
+	bAfterKey = true;
+	return true;
+}
+
+bool FLobbyJsonBuilder::WriteNull()
+{
+	if (!BeforeValue())
+	{
+		return false;
+	}
+	Writer->WriteNull();
+	return true;
+}
+
+FString FLobbyJsonBuilder::ToString() const
+{
+	if (!IsComplete())
+	{
+		return FString();
+	}
+	return FString(Buffer.Num(), Buffer.GetData());
+}
+
+void FLobbyJsonBuilder::Reset()
+{
+	Buffer.Reset();
+	Writer.Emplace(Buffer);
+	Scopes.Reset();
+	bAfterKey = false;
+	bHasRoot = false;
+	bFailed = false;
+}
+
+bool FLobbyJsonBuilder::BeforeValue()
+{
+	if (bFailed)
+	{
+		return false;
+	}
+
+	if (Scopes.IsEmpty())
+	{
+		if (bHasRoot)
+		{
+			return Fail(TEXT("a second root value"));
+		}
+		bHasRoot = true;
+		return true;
+	}
+
+	// Objects take a key before every value
+	if (!Scopes.Last() && !bAfterKey)
+	{
+		return Fail(TEXT("a value without a key inside an object"));
+	}
+	bAfterKey = false;
+	return true;
+}
+
+bool FLobbyJsonBuilder::Fail(const TCHAR* NewReason)
+{
+	if (!bFailed)
+	{
+		UE_LOG(LogLobbyClient, Warning, TEXT("FLobbyJsonBuilder: %s, the document is discarded."), NewReason);
+		bFailed = true;
+	}
+	return false;
+}
@@ -0,0 +1,123 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LobbyJsonWriter.h"
+
+/**
+ * Free list of JSON output buffers, so building a document allocates nothing once the pool is warm.
+ * Shared by every thread, oversized buffers are dropped instead of kept.
+ */
+class LOBBYCLIENT_API FLobbyJsonBufferPool
+{
+public:
+
+	static TArray<UTF8CHAR> Acquire();
+
+	static void Release(TArray<UTF8CHAR>&& NewBuffer);
+
+	static const int32 MAX_POOLED_BUFFERS = 16;
+
+	static const int32 MAX_POOLED_BYTES = 64 * 1024;
+};
+
+/**
+ * One JSON document written with FLobbyJsonWriter into a pooled buffer.
+ * Unlike the writer, every call is checked: a key outside an object, a value where a key is expected or
+ * a second root marks the document as failed instead of asserting, so Blueprint mistakes can not crash.
+ *
+ *   FLobbyJsonBuilder Filter;
+ *   Filter.BeginObject();
+ *   Filter.WriteKey(TEXT("rank"));
+ *   Filter.BeginObject();
+ *   Filter.WriteKey(TEXT("$gte"));
+ *   Filter.WriteValue(1200);
+ *   Filter.EndObject();
+ *   Filter.EndObject();
+ *   MongoDBData.Filter = Filter.ToString();
+ */
+class LOBBYCLIENT_API FLobbyJsonBuilder
+{
+public:
+
+	FLobbyJsonBuilder();
+
+	~FLobbyJsonBuilder();
+
+	FLobbyJsonBuilder(const FLobbyJsonBuilder&) = delete;
+
+	FLobbyJsonBuilder& operator=(const FLobbyJsonBuilder&) = delete;
+
+	bool BeginObject();
+
+	bool EndObject();
+
+	bool BeginArray();
+
+	bool EndArray();
+
+	bool WriteKey(FStringView NewKey);
+
+	bool WriteNull();
+
+	/**
+	 * Anything FLobbyJsonWriter::WriteValue takes: strings, numbers, bools, FJsonValueStruct and nested TArray and TMap
+	 */
+	template <typename ValueType>
+	bool WriteValue(const ValueType& NewValue)
+	{
+		if (!BeforeValue())
+		{
+			return false;
+		}
+		Writer->WriteValue(NewValue);
+		return true;
+	}
+
+	/**
+	 * One root value is written and every object and array is closed
+	 */
+	bool IsComplete() const { return bHasRoot && Scopes.IsEmpty() && !bFailed; }
+
+	bool HasFailed() const { return bFailed; }
+
+	/**
+	 * The text written so far, only a valid document once IsComplete
+	 */
+	FUtf8StringView GetJson() const { return FUtf8StringView(Buffer.GetData(), Buffer.Num()); }
+
+	/**
+	 * The document as text, empty unless it is complete
+	 */
+	FString ToString() const;
+
+	/**
+	 * Start a new document in the same buffer
+	 */
+	void Reset();
+
+private:
+
+	bool BeforeValue();
+
+	bool Fail(const TCHAR* NewReason);
+
+	TArray<UTF8CHAR> Buffer;
+
+	/**
+	 * Emplaced again by Reset, the writer keeps a reference to Buffer
+	 */
+	TOptional<FLobbyJsonWriter> Writer;
+
+	/**
+	 * One entry per open scope, true for arrays
+	 */
+	TArray<bool, TInlineAllocator<16>> Scopes;
+
+	bool bAfterKey = false;
+
+	bool bHasRoot = false;
+
+	bool bFailed = false;
+};
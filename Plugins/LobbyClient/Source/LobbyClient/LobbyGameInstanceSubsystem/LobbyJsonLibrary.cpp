@@ -0,0 +1,234 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LobbyJsonLibrary.h"
+#include "LobbyClient.h"
+#include "LobbyJsonBuilder.h"
+#include "LobbyJsonView.h"
+
+namespace
+{
+	FLobbyJsonBuilder* GetBuilder(const FLobbyJsonDocument& NewDocument)
+	{
+		if (!NewDocument.Builder.IsValid())
+		{
+			UE_LOG(LogLobbyClient, Warning, TEXT("ULobbyJsonLibrary: the document was not made with MakeJsonDocument."));
+			return nullptr;
+		}
+		return NewDocument.Builder.Get();
+	}
+
+	/**
+	 * Parse NewJson and call NewRead with the value at NewPath, if there is one
+	 */
+	template <typename ReadType>
+	bool ReadPath(const FString& NewJson, const FString& NewPath, ReadType&& NewRead)
+	{
+		const FTCHARToUTF8 JsonUtf8(*NewJson, NewJson.Len());
+		const FTCHARToUTF8 PathUtf8(*NewPath, NewPath.Len());
+		FLobbyJsonView View;
+		if (!View.Parse(FUtf8StringView(reinterpret_cast<const UTF8CHAR*>(JsonUtf8.Get()), JsonUtf8.Length())))
+		{
+			return false;
+		}
+		const FLobbyJsonView::FValue Value = View.GetRoot().FindPath(FAnsiStringView(reinterpret_cast<const ANSICHAR*>(PathUtf8.Get()), PathUtf8.Length()));
+		return Value.IsValid() && NewRead(Value);
+	}
+
+	template <typename ValueType>
+	void WriteValue(const FLobbyJsonDocument& NewDocument, const ValueType& NewValue)
+	{
+		if (FLobbyJsonBuilder* Builder = GetBuilder(NewDocument))
+		{
+			Builder->WriteValue(NewValue);
+		}
+	}
+}
+
+FLobbyJsonDocument ULobbyJsonLibrary::MakeJsonDocument()
+{
+	FLobbyJsonDocument R_Document;
+	R_Document.Builder = MakeShared<FLobbyJsonBuilder>();
+	return R_Document;
+}
+
+void ULobbyJsonLibrary::BeginJsonObject(const FLobbyJsonDocument& NewDocument)
+{
+	if (FLobbyJsonBuilder* Builder = GetBuilder(NewDocument))
+	{
+		Builder->BeginObject();
+	}
+}
+
+void ULobbyJsonLibrary::EndJsonObject(const FLobbyJsonDocument& NewDocument)
+{
+	if (FLobbyJsonBuilder* Builder = GetBuilder(NewDocument))
+	{
+		Builder->EndObject();
+	}
+}
+
+void ULobbyJsonLibrary::BeginJsonArray(const FLobbyJsonDocument& NewDocument)
+{
+	if (FLobbyJsonBuilder* Builder = GetBuilder(NewDocument))
+	{
+		Builder->BeginArray();
+	}
+}
+
+void ULobbyJsonLibrary::EndJsonArray(const FLobbyJsonDocument& NewDocument)
+{
+	if (FLobbyJsonBuilder* Builder = GetBuilder(NewDocument))
+	{
+		Builder->EndArray();
+	}
+}
+
+void ULobbyJsonLibrary::WriteJsonKey(const FLobbyJsonDocument& NewDocument, const FString& NewKey)
+{
+	if (FLobbyJsonBuilder* Builder = GetBuilder(NewDocument))
+	{
+		Builder->WriteKey(NewKey);
+	}
+}
+
+void ULobbyJsonLibrary::WriteJsonString(const FLobbyJsonDocument& NewDocument, const FString& NewValue)
+{
+	WriteValue(NewDocument, FStringView(NewValue));
+}
+
+void ULobbyJsonLibrary::WriteJsonInt(const FLobbyJsonDocument& NewDocument, int64 NewValue)
+{
+	WriteValue(NewDocument, NewValue);
+}
+
+void ULobbyJsonLibrary::WriteJsonFloat(const FLobbyJsonDocument& NewDocument, double NewValue)
+{
+	WriteValue(NewDocument, NewValue);
+}
+
+void ULobbyJsonLibrary::WriteJsonBool(const FLobbyJsonDocument& NewDocument, bool bNewValue)
+{
+	WriteValue(NewDocument, bNewValue);
+}
+
+void ULobbyJsonLibrary::WriteJsonNull(const FLobbyJsonDocument& NewDocument)
+{
+	if (FLobbyJsonBuilder* Builder = GetBuilder(NewDocument))
+	{
+		Builder->WriteNull();
+	}
+}
+
+void ULobbyJsonLibrary::WriteJsonValue(const FLobbyJsonDocument& NewDocument, const FJsonValueStruct& NewValue)
+{
+	WriteValue(NewDocument, NewValue);
+}
+
+void ULobbyJsonLibrary::WriteJsonStringMap(const FLobbyJsonDocument& NewDocument, const TMap<FString, FString>& NewMap)
+{
+	WriteValue(NewDocument, NewMap);
+}
+
+void ULobbyJsonLibrary::WriteJsonIntMap(const FLobbyJsonDocument& NewDocument, const TMap<FString, int32>& NewMap)
+{
+	WriteValue(NewDocument, NewMap);
+}
+
+void ULobbyJsonLibrary::WriteJsonFloatMap(const FLobbyJsonDocument& NewDocument, const TMap<FString, float>& NewMap)
+{
+	WriteValue(NewDocument, NewMap);
+}
+
+void ULobbyJsonLibrary::WriteJsonBoolMap(const FLobbyJsonDocument& NewDocument, const TMap<FString, bool>& NewMap)
+{
+	WriteValue(NewDocument, NewMap);
+}
+
+void ULobbyJsonLibrary::WriteJsonValueMap(const FLobbyJsonDocument& NewDocument, const TMap<FString, FJsonValueStruct>& NewMap)
+{
+	WriteValue(NewDocument, NewMap);
+}
+
+void ULobbyJsonLibrary::WriteJsonStringArray(const FLobbyJsonDocument& NewDocument, const TArray<FString>& NewArray)
+{
+	WriteValue(NewDocument, NewArray);
+}
+
+void ULobbyJsonLibrary::WriteJsonIntArray(const FLobbyJsonDocument& NewDocument, const TArray<int32>& NewArray)
+{
+	WriteValue(NewDocument, NewArray);
+}
+
+void ULobbyJsonLibrary::WriteJsonFloatArray(const FLobbyJsonDocument& NewDocument, const TArray<float>& NewArray)
+{
+	WriteValue(NewDocument, NewArray);
+}
+
+void ULobbyJsonLibrary::WriteJsonBoolArray(const FLobbyJsonDocument& NewDocument, const TArray<bool>& NewArray)
+{
+	WriteValue(NewDocument, NewArray);
+}
+
+void ULobbyJsonLibrary::WriteJsonValueArray(const FLobbyJsonDocument& NewDocument, const TArray<FJsonValueStruct>& NewArray)
+{
+	WriteValue(NewDocument, NewArray);
+}
+
+bool ULobbyJsonLibrary::GetJsonString(const FLobbyJsonDocument& NewDocument, FString& OutJson)
+{
+	const FLobbyJsonBuilder* Builder = GetBuilder(NewDocument);
+	if (Builder == nullptr || !Builder->IsComplete())
+	{
+		OutJson.Reset();
+		return false;
+	}
+	OutJson = Builder->ToString();
+	return true;
+}
+
+void ULobbyJsonLibrary::ResetJsonDocument(const FLobbyJsonDocument& NewDocument)
+{
+	if (FLobbyJsonBuilder* Builder = GetBuilder(NewDocument))
+	{
+		Builder->Reset();
+	}
+}
+
+bool ULobbyJsonLibrary::GetJsonPathString(const FString& NewJson, const FString& NewPath, FString& OutValue)
+{
+	OutValue.Reset();
+	return ReadPath(NewJson, NewPath, [&OutValue](const FLobbyJsonView::FValue& NewValue)
+	{
+		return NewValue.TryGetString(OutValue);
+	});
+}
+
+bool ULobbyJsonLibrary::GetJsonPathNumber(const FString& NewJson, const FString& NewPath, double& OutValue)
+{
+	OutValue = 0.0;
+	return ReadPath(NewJson, NewPath, [&OutValue](const FLobbyJsonView::FValue& NewValue)
+	{
+		return NewValue.TryGetNumber(OutValue);
+	});
+}
+
+bool ULobbyJsonLibrary::GetJsonPathBool(const FString& NewJson, const FString& NewPath, bool& OutValue)
+{
+	OutValue = false;
+	return ReadPath(NewJson, NewPath, [&OutValue](const FLobbyJsonView::FValue& NewValue)
+	{
+		return NewValue.TryGetBool(OutValue);
+	});
+}
+
+bool ULobbyJsonLibrary::GetJsonPathText(const FString& NewJson, const FString& NewPath, FString& OutValue)
+{
+	OutValue.Reset();
+	return ReadPath(NewJson, NewPath, [&OutValue](const FLobbyJsonView::FValue& NewValue)
+	{
+		const FUtf8StringView Text = NewValue.GetText();
+		OutValue = FString(Text.Len(), Text.GetData());
+		return true;
+	});
+}
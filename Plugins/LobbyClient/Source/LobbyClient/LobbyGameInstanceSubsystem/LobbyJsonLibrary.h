@@ -0,0 +1,130 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Kismet/BlueprintFunctionLibrary.h"
+#include "LobbyTypes.h"
+#include "LobbyJsonLibrary.generated.h"
+
+/**
+ * Blueprint side of FLobbyJsonBuilder: write Data, Filter and Options documents call by call, in any nesting,
+ * without a FJsonObject per node. Mistakes like a value without a key fail the document, GetJsonString then returns false.
+ * The GetJsonPath functions read single values out of received JSON, such as FLobbyResponse::PayLoadData, without a DOM.
+ */
+UCLASS()
+class LOBBYCLIENT_API ULobbyJsonLibrary : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+
+public:
+
+	/**
+	 * A new empty document, its buffer comes from the shared pool
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Lobby|Json")
+	static FLobbyJsonDocument MakeJsonDocument();
+
+	UFUNCTION(BlueprintCallable, Category = "Lobby|Json")
+	static void BeginJsonObject(const FLobbyJsonDocument& NewDocument);
+
+	UFUNCTION(BlueprintCallable, Category = "Lobby|Json")
+	static void EndJsonObject(const FLobbyJsonDocument& NewDocument);
+
+	UFUNCTION(BlueprintCallable, Category = "Lobby|Json")
+	static void BeginJsonArray(const FLobbyJsonDocument& NewDocument);
+
+	UFUNCTION(BlueprintCallable, Category = "Lobby|Json")
+	static void EndJsonArray(const FLobbyJsonDocument& NewDocument);
+
+	/**
+	 * Every value inside an object follows a key
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Lobby|Json")
+	static void WriteJsonKey(const FLobbyJsonDocument& NewDocument, const FString& NewKey);
+
+	UFUNCTION(BlueprintCallable, Category = "Lobby|Json")
+	static void WriteJsonString(const FLobbyJsonDocument& NewDocument, const FString& NewValue);
+
+	UFUNCTION(BlueprintCallable, Category = "Lobby|Json")
+	static void WriteJsonInt(const FLobbyJsonDocument& NewDocument, int64 NewValue);
+
+	UFUNCTION(BlueprintCallable, Category = "Lobby|Json")
+	static void WriteJsonFloat(const FLobbyJsonDocument& NewDocument, double NewValue);
+
+	UFUNCTION(BlueprintCallable, Category = "Lobby|Json")
+	static void WriteJsonBool(const FLobbyJsonDocument& NewDocument, bool bNewValue);
+
+	UFUNCTION(BlueprintCallable, Category = "Lobby|Json")
+	static void WriteJsonNull(const FLobbyJsonDocument& NewDocument);
+
+	/**
+	 * Nested arrays and objects inside the value are written as they are
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Lobby|Json")
+	static void WriteJsonValue(const FLobbyJsonDocument& NewDocument, const FJsonValueStruct& NewValue);
+
+	/**
+	 * Maps and arrays are written as one object or array value
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Lobby|Json")
+	static void WriteJsonStringMap(const FLobbyJsonDocument& NewDocument, const TMap<FString, FString>& NewMap);
+
+	UFUNCTION(BlueprintCallable, Category = "Lobby|Json")
+	static void WriteJsonIntMap(const FLobbyJsonDocument& NewDocument, const TMap<FString, int32>& NewMap);
+
+	UFUNCTION(BlueprintCallable, Category = "Lobby|Json")
+	static void WriteJsonFloatMap(const FLobbyJsonDocument& NewDocument, const TMap<FString, float>& NewMap);
+
+	UFUNCTION(BlueprintCallable, Category = "Lobby|Json")
+	static void WriteJsonBoolMap(const FLobbyJsonDocument& NewDocument, const TMap<FString, bool>& NewMap);
+
+	UFUNCTION(BlueprintCallable, Category = "Lobby|Json")
+	static void WriteJsonValueMap(const FLobbyJsonDocument& NewDocument, const TMap<FString, FJsonValueStruct>& NewMap);
+
+	UFUNCTION(BlueprintCallable, Category = "Lobby|Json")
+	static void WriteJsonStringArray(const FLobbyJsonDocument& NewDocument, const TArray<FString>& NewArray);
+
+	UFUNCTION(BlueprintCallable, Category = "Lobby|Json")
+	static void WriteJsonIntArray(const FLobbyJsonDocument& NewDocument, const TArray<int32>& NewArray);
+
+	UFUNCTION(BlueprintCallable, Category = "Lobby|Json")
+	static void WriteJsonFloatArray(const FLobbyJsonDocument& NewDocument, const TArray<float>& NewArray);
+
+	UFUNCTION(BlueprintCallable, Category = "Lobby|Json")
+	static void WriteJsonBoolArray(const FLobbyJsonDocument& NewDocument, const TArray<bool>& NewArray);
+
+	UFUNCTION(BlueprintCallable, Category = "Lobby|Json")
+	static void WriteJsonValueArray(const FLobbyJsonDocument& NewDocument, const TArray<FJsonValueStruct>& NewArray);
+
+	/**
+	 * The finished document as text, false while objects or arrays are open or after a mistake
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Lobby|Json")
+	static bool GetJsonString(const FLobbyJsonDocument& NewDocument, FString& OutJson);
+
+	/**
+	 * Start over in the same buffer
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Lobby|Json")
+	static void ResetJsonDocument(const FLobbyJsonDocument& NewDocument);
+
+	/**
+	 * The value at a path like "batch[0].name", false if the text is not JSON or nothing is there.
+	 * Numbers and booleans are returned as their text.
+	 */
+	UFUNCTION(BlueprintPure, Category = "Lobby|Json")
+	static bool GetJsonPathString(const FString& NewJson, const FString& NewPath, FString& OutValue);
+
+	UFUNCTION(BlueprintPure, Category = "Lobby|Json")
+	static bool GetJsonPathNumber(const FString& NewJson, const FString& NewPath, double& OutValue);
+
+	UFUNCTION(BlueprintPure, Category = "Lobby|Json")
+	static bool GetJsonPathBool(const FString& NewJson, const FString& NewPath, bool& OutValue);
+
+	/**
+	 * Objects and arrays at the path as JSON text, to pass on or read further
+	 */
+	UFUNCTION(BlueprintPure, Category = "Lobby|Json")
+	static bool GetJsonPathText(const FString& NewJson, const FString& NewPath, FString& OutValue);
+};
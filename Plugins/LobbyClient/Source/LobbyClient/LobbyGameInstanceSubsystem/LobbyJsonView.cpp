@@ -0,0 +1,694 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LobbyJsonView.h"
+#include "LobbyBufferPool.h"
+
+namespace
+{
+	const uint64 ONES = 0x0101010101010101ull;
+	const uint64 HIGHS = 0x8080808080808080ull;
+
+	/**
+	 * True if any of the 8 bytes ends a plain run inside a string: a quote, a backslash or a control character
+	 */
+	FORCEINLINE bool HasStringStop(uint64 NewWord)
+	{
+		const uint64 Quotes = NewWord ^ (ONES * '"');
+		const uint64 Backslashes = NewWord ^ (ONES * '\\');
+		const uint64 Zeros = ((Quotes - ONES) & ~Quotes) | ((Backslashes - ONES) & ~Backslashes);
+		const uint64 Controls = (NewWord - ONES * 0x20) & ~NewWord;
+		return ((Zeros | Controls) & HIGHS) != 0;
+	}
+
+	FORCEINLINE bool IsWhitespace(uint8 NewByte)
+	{
+		return NewByte == ' ' || NewByte == '\n' || NewByte == '\r' || NewByte == '\t';
+	}
+
+	FORCEINLINE bool IsDigit(uint8 NewByte)
+	{
+		return NewByte >= '0' && NewByte <= '9';
+	}
+
+	int32 HexValue(uint8 NewByte)
+	{
+		if (NewByte >= '0' && NewByte <= '9')
+		{
+			return NewByte - '0';
+		}
+		if (NewByte >= 'a' && NewByte <= 'f')
+		{
+			return NewByte - 'a' + 10;
+		}
+		if (NewByte >= 'A' && NewByte <= 'F')
+		{
+			return NewByte - 'A' + 10;
+		}
+		return INDEX_NONE;
+	}
+
+	uint32 ReadHex4(const UTF8CHAR* NewDigits)
+	{
+		uint32 R_Value = 0;
+		for (int32 i = 0; i < 4; ++i)
+		{
+			R_Value = (R_Value << 4) | static_cast<uint32>(HexValue(static_cast<uint8>(NewDigits[i])));
+		}
+		return R_Value;
+	}
+
+	template <typename AllocatorType>
+	void AppendCodePoint(TArray<UTF8CHAR, AllocatorType>& OutText, uint32 NewCodePoint)
+	{
+		if (NewCodePoint < 0x80)
+		{
+			OutText.Add(static_cast<UTF8CHAR>(NewCodePoint));
+		}
+		else if (NewCodePoint < 0x800)
+		{
+			OutText.Add(static_cast<UTF8CHAR>(0xC0 | (NewCodePoint >> 6)));
+			OutText.Add(static_cast<UTF8CHAR>(0x80 | (NewCodePoint & 0x3F)));
+		}
+		else if (NewCodePoint < 0x10000)
+		{
+			OutText.Add(static_cast<UTF8CHAR>(0xE0 | (NewCodePoint >> 12)));
+			OutText.Add(static_cast<UTF8CHAR>(0x80 | ((NewCodePoint >> 6) & 0x3F)));
+			OutText.Add(static_cast<UTF8CHAR>(0x80 | (NewCodePoint & 0x3F)));
+		}
+		else
+		{
+			OutText.Add(static_cast<UTF8CHAR>(0xF0 | (NewCodePoint >> 18)));
+			OutText.Add(static_cast<UTF8CHAR>(0x80 | ((NewCodePoint >> 12) & 0x3F)));
+			OutText.Add(static_cast<UTF8CHAR>(0x80 | ((NewCodePoint >> 6) & 0x3F)));
+			OutText.Add(static_cast<UTF8CHAR>(0x80 | (NewCodePoint & 0x3F)));
+		}
+	}
+
+	/**
+	 * Decode the escapes of string contents Parse already checked
+	 */
+	template <typename AllocatorType>
+	void Unescape(FUtf8StringView NewRaw, TArray<UTF8CHAR, AllocatorType>& OutText)
+	{
+		OutText.Reset();
+		const UTF8CHAR* Data = NewRaw.GetData();
+		const int32 Length = NewRaw.Len();
+		for (int32 i = 0; i < Length; ++i)
+		{
+			if (Data[i] != '\\')
+			{
+				OutText.Add(Data[i]);
+				continue;
+			}
+
+			const UTF8CHAR Escape = Data[++i];
+			switch (Escape)
+			{
+			case 'b': OutText.Add(UTF8CHAR('\b')); break;
+			case 'f': OutText.Add(UTF8CHAR('\f')); break;
+			case 'n': OutText.Add(UTF8CHAR('\n')); break;
+			case 'r': OutText.Add(UTF8CHAR('\r')); break;
+			case 't': OutText.Add(UTF8CHAR('\t')); break;
+			case 'u':
+			{
+				uint32 CodePoint = ReadHex4(Data + i + 1);
+				i += 4;
+				if (CodePoint >= 0xD800 && CodePoint <= 0xDBFF && i + 6 < Length && Data[i + 1] == '\\' && Data[i + 2] == 'u')
+				{
+					const uint32 LowSurrogate = ReadHex4(Data + i + 3);
+					if (LowSurrogate >= 0xDC00 && LowSurrogate <= 0xDFFF)
+					{
+						CodePoint = 0x10000 + ((CodePoint - 0xD800) << 10) + (LowSurrogate - 0xDC00);
+						i += 6;
+					}
+				}
+				// Lone surrogates can not be written as UTF-8
+				if (CodePoint >= 0xD800 && CodePoint <= 0xDFFF)
+				{
+					CodePoint = 0xFFFD;
+				}
+				AppendCodePoint(OutText, CodePoint);
+				break;
+			}
+			default:
+				// Quote, backslash and slash stand for themselves
+				OutText.Add(Escape);
+				break;
+			}
+		}
+	}
+}
+
+bool FLobbyJsonView::Parse(FUtf8StringView NewJson)
+{
+	enum class EExpect : uint8
+	{
+		 VALUE
+		,VALUE_OR_END
+		,KEY
+		,KEY_OR_END
+		,COLON
+		,COMMA_OR_END
+	};
+
+	Json = NewJson;
+	Tape.Reset();
+
+	const UTF8CHAR* Data = Json.GetData();
+	const int32 Length = Json.Len();
+	TArray<int32, TInlineAllocator<32>> Open;
+	EExpect Expect = EExpect::VALUE;
+	bool bHasRoot = false;
+	int32 Position = 0;
+
+	// Called when a value is complete, scalars and containers alike
+	auto EndValue = [&]()
+	{
+		if (Open.IsEmpty())
+		{
+			bHasRoot = true;
+			return;
+		}
+		++Tape[Open.Last()].Count;
+		Expect = EExpect::COMMA_OR_END;
+	};
+
+	auto CloseContainer = [&]()
+	{
+		FToken& Container = Tape[Open.Pop(EAllowShrinking::No)];
+		Container.Length = Position + 1 - Container.Start;
+		Container.Next = Tape.Num();
+		++Position;
+		EndValue();
+	};
+
+	while (true)
+	{
+		while (Position < Length && IsWhitespace(static_cast<uint8>(Data[Position])))
+		{
+			++Position;
+		}
+		if (Position == Length)
+		{
+			break;
+		}
+		if (bHasRoot)
+		{
+			// Text after the root value
+			Tape.Reset();
+			return false;
+		}
+
+		const uint8 Byte = static_cast<uint8>(Data[Position]);
+		bool bValid = true;
+		switch (Expect)
+		{
+		case EExpect::COLON:
+			bValid = Byte == ':';
+			++Position;
+			Expect = EExpect::VALUE;
+			break;
+
+		case EExpect::COMMA_OR_END:
+		{
+			const bool bInObject = Tape[Open.Last()].Type == EType::OBJECT;
+			if (Byte == ',')
+			{
+				++Position;
+				Expect = bInObject ? EExpect::KEY : EExpect::VALUE;
+			}
+			else if (Byte == (bInObject ? '}' : ']'))
+			{
+				CloseContainer();
+			}
+			else
+			{
+				bValid = false;
+			}
+			break;
+		}
+
+		case EExpect::KEY_OR_END:
+			if (Byte == '}')
+			{
+				CloseContainer();
+				break;
+			}
+			[[fallthrough]];
+		case EExpect::KEY:
+		{
+			// Keys go on the tape like strings, their value follows them
+			FToken& Key = Tape.AddDefaulted_GetRef();
+			Key.Type = EType::STRING;
+			Key.Start = Position + 1;
+			Key.Next = Tape.Num();
+			Position = Key.Start;
+			bValid = Byte == '"' && ScanString(Position, Key.bEscaped);
+			Key.Length = Position - Key.Start;
+			++Position;
+			Expect = EExpect::COLON;
+			break;
+		}
+
+		case EExpect::VALUE_OR_END:
+			if (Byte == ']')
+			{
+				CloseContainer();
+				break;
+			}
+			[[fallthrough]];
+		case EExpect::VALUE:
+		{
+			const int32 TokenIndex = Tape.Num();
+			FToken& Token = Tape.AddDefaulted_GetRef();
+			Token.Start = Position;
+			Token.Next = TokenIndex + 1;
+			if (Byte == '{' || Byte == '[')
+			{
+				if (Open.Num() >= MAX_DEPTH)
+				{
+					bValid = false;
+					break;
+				}
+				Token.Type = Byte == '{' ? EType::OBJECT : EType::ARRAY;
+				Open.Push(TokenIndex);
+				++Position;
+				Expect = Byte == '{' ? EExpect::KEY_OR_END : EExpect::VALUE_OR_END;
+				break;
+			}
+
+			if (Byte == '"')
+			{
+				Token.Type = EType::STRING;
+				Token.Start = ++Position;
+				bValid = ScanString(Position, Token.bEscaped);
+				Token.Length = Position - Token.Start;
+				++Position;
+			}
+			else if (Byte == '-' || IsDigit(Byte))
+			{
+				Token.Type = EType::NUMBER;
+				bValid = ScanNumber(Position);
+				Token.Length = Position - Token.Start;
+			}
+			else if (Byte == 't' || Byte == 'f')
+			{
+				Token.Type = EType::BOOL;
+				bValid = ScanLiteral(Position, Byte == 't' ? FAnsiStringView("true", 4) : FAnsiStringView("false", 5));
+				Token.Length = Position - Token.Start;
+			}
+			else if (Byte == 'n')
+			{
+				Token.Type = EType::NULL_VALUE;
+				bValid = ScanLiteral(Position, FAnsiStringView("null", 4));
+				Token.Length = Position - Token.Start;
+			}
+			else
+			{
+				bValid = false;
+			}
+
+			if (bValid)
+			{
+				EndValue();
+			}
+			break;
+		}
+		}
+
+		if (!bValid)
+		{
+			Tape.Reset();
+			return false;
+		}
+	}
+
+	if (!bHasRoot)
+	{
+		Tape.Reset();
+		return false;
+	}
+	return true;
+}
+
+bool FLobbyJsonView::ScanString(int32& InOutPosition, bool& bOutEscaped) const
+{
+	const UTF8CHAR* Data = Json.GetData();
+	const int32 Length = Json.Len();
+	int32 Position = InOutPosition;
+	bOutEscaped = false;
+
+	while (Position < Length)
+	{
+		// Skip plain text 8 bytes at a time
+		while (Position + 8 <= Length)
+		{
+			uint64 Word;
+			FMemory::Memcpy(&Word, Data + Position, sizeof(Word));
+			if (HasStringStop(Word))
+			{
+				break;
+			}
+			Position += 8;
+		}
+		if (Position >= Length)
+		{
+			break;
+		}
+
+		const uint8 Byte = static_cast<uint8>(Data[Position]);
+		if (Byte == '"')
+		{
+			InOutPosition = Position;
+			return true;
+		}
+		if (Byte < 0x20)
+		{
+			return false;
+		}
+		if (Byte != '\\')
+		{
+			++Position;
+			continue;
+		}
+
+		bOutEscaped = true;
+		if (++Position >= Length)
+		{
+			return false;
+		}
+		switch (static_cast<uint8>(Data[Position]))
+		{
+		case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't':
+			++Position;
+			break;
+		case 'u':
+			if (Position + 4 >= Length)
+			{
+				return false;
+			}
+			for (int32 i = 1; i <= 4; ++i)
+			{
+				if (HexValue(static_cast<uint8>(Data[Position + i])) == INDEX_NONE)
+				{
+					return false;
+				}
+			}
+			Position += 5;
+			break;
+		default:
+			return false;
+		}
+	}
+	return false;
+}
+
+bool FLobbyJsonView::ScanNumber(int32& InOutPosition) const
+{
+	const UTF8CHAR* Data = Json.GetData();
+	const int32 Length = Json.Len();
+	int32 Position = InOutPosition;
+	auto Peek = [&]() { return Position < Length ? static_cast<uint8>(Data[Position]) : 0; };
+	auto SkipDigits = [&]()
+	{
+		const int32 First = Position;
+		while (IsDigit(Peek()))
+		{
+			++Position;
+		}
+		return Position > First;
+	};
+
+	if (Peek() == '-')
+	{
+		++Position;
+	}
+	if (Peek() == '0')
+	{
+		++Position;
+	}
+	else if (!SkipDigits())
+	{
+		return false;
+	}
+	if (Peek() == '.')
+	{
+		++Position;
+		if (!SkipDigits())
+		{
+			return false;
+		}
+	}
+	if (Peek() == 'e' || Peek() == 'E')
+	{
+		++Position;
+		if (Peek() == '+' || Peek() == '-')
+		{
+			++Position;
+		}
+		if (!SkipDigits())
+		{
+			return false;
+		}
+	}
+	InOutPosition = Position;
+	return true;
+}
+
+bool FLobbyJsonView::ScanLiteral(int32& InOutPosition, FAnsiStringView NewLiteral) const
+{
+	if (InOutPosition + NewLiteral.Len() > Json.Len()
+		|| FMemory::Memcmp(Json.GetData() + InOutPosition, NewLiteral.GetData(), NewLiteral.Len()) != 0)
+	{
+		return false;
+	}
+	InOutPosition += NewLiteral.Len();
+	return true;
+}
+
+FLobbyJsonView::EType FLobbyJsonView::FValue::GetType() const
+{
+	return IsValid() ? View->GetToken(Index).Type : EType::NONE;
+}
+
+int32 FLobbyJsonView::FValue::Num() const
+{
+	return IsObject() || IsArray() ? View->GetToken(Index).Count : 0;
+}
+
+FLobbyJsonView::FValue FLobbyJsonView::FValue::Find(FAnsiStringView NewKey) const
+{
+	FValue R_Value;
+	ForEachMember([&](const FValue& Key, const FValue& Value)
+	{
+		if (Key.IsKey(NewKey))
+		{
+			R_Value = Value;
+		}
+	});
+	return R_Value;
+}
+
+FLobbyJsonView::FValue FLobbyJsonView::FValue::At(int32 NewIndex) const
+{
+	if (!IsArray() || NewIndex < 0 || NewIndex >= Num())
+	{
+		return FValue();
+	}
+	int32 Child = Index + 1;
+	for (int32 i = 0; i < NewIndex; ++i)
+	{
+		Child = View->GetToken(Child).Next;
+	}
+	return FValue(View, Child);
+}
+
+FLobbyJsonView::FValue FLobbyJsonView::FValue::FindPath(FAnsiStringView NewPath) const
+{
+	FValue R_Value = *this;
+	int32 Position = 0;
+	while (Position < NewPath.Len() && R_Value.IsValid())
+	{
+		if (NewPath[Position] == '.')
+		{
+			++Position;
+			continue;
+		}
+
+		if (NewPath[Position] == '[')
+		{
+			int32 ElementIndex = 0;
+			int32 Digit = Position + 1;
+			for (; Digit < NewPath.Len() && NewPath[Digit] >= '0' && NewPath[Digit] <= '9'; ++Digit)
+			{
+				ElementIndex = ElementIndex * 10 + (NewPath[Digit] - '0');
+			}
+			if (Digit == Position + 1 || Digit >= NewPath.Len() || NewPath[Digit] != ']')
+			{
+				return FValue();
+			}
+			R_Value = R_Value.At(ElementIndex);
+			Position = Digit + 1;
+			continue;
+		}
+
+		int32 KeyEnd = Position;
+		while (KeyEnd < NewPath.Len() && NewPath[KeyEnd] != '.' && NewPath[KeyEnd] != '[')
+		{
+			++KeyEnd;
+		}
+		R_Value = R_Value.Find(NewPath.Mid(Position, KeyEnd - Position));
+		Position = KeyEnd;
+	}
+	return R_Value;
+}
+
+FUtf8StringView FLobbyJsonView::FValue::GetText() const
+{
+	if (!IsValid())
+	{
+		return FUtf8StringView();
+	}
+	const FToken& Token = View->GetToken(Index);
+	if (Token.Type == EType::STRING)
+	{
+		return View->Json.Mid(Token.Start - 1, Token.Length + 2);
+	}
+	return View->Json.Mid(Token.Start, Token.Length);
+}
+
+FUtf8StringView FLobbyJsonView::FValue::GetRawString() const
+{
+	if (!IsString())
+	{
+		return FUtf8StringView();
+	}
+	const FToken& Token = View->GetToken(Index);
+	return View->Json.Mid(Token.Start, Token.Length);
+}
+
+bool FLobbyJsonView::FValue::HasEscapes() const
+{
+	return IsValid() && View->GetToken(Index).bEscaped;
+}
+
+bool FLobbyJsonView::FValue::TryGetString(FString& OutValue) const
+{
+	switch (GetType())
+	{
+	case EType::STRING:
+	{
+		const FUtf8StringView Raw = GetRawString();
+		if (!HasEscapes())
+		{
+			OutValue = FString(Raw.Len(), Raw.GetData());
+			return true;
+		}
+		// Escaped payloads are long, their scratch comes from the arena instead of the heap
+		FLobbyMessageArena::FMark Mark;
+		TArray<UTF8CHAR>& Text = Mark.AcquireText();
+		Unescape(Raw, Text);
+		OutValue = FString(Text.Num(), Text.GetData());
+		return true;
+	}
+	case EType::NUMBER:
+	case EType::BOOL:
+	{
+		const FUtf8StringView Text = GetText();
+		OutValue = FString(Text.Len(), Text.GetData());
+		return true;
+	}
+	default:
+		return false;
+	}
+}
+
+FString FLobbyJsonView::FValue::AsString() const
+{
+	FString R_Value;
+	TryGetString(R_Value);
+	return R_Value;
+}
+
+bool FLobbyJsonView::FValue::TryGetNumber(double& OutValue) const
+{
+	if (!IsNumber())
+	{
+		return false;
+	}
+	const FUtf8StringView Text = GetText();
+	ANSICHAR Digits[64];
+	if (Text.Len() < UE_ARRAY_COUNT(Digits))
+	{
+		FMemory::Memcpy(Digits, Text.GetData(), Text.Len());
+		Digits[Text.Len()] = '\0';
+		OutValue = FCStringAnsi::Atod(Digits);
+	}
+	else
+	{
+		OutValue = FCString::Atod(*FString(Text.Len(), Text.GetData()));
+	}
+	return true;
+}
+
+bool FLobbyJsonView::FValue::TryGetNumber(int64& OutValue) const
+{
+	if (!IsNumber())
+	{
+		return false;
+	}
+
+	// Plain integers are read exactly, anything with a fraction or an exponent goes through double
+	const FUtf8StringView Text = GetText();
+	int32 Position = Text.Len() > 0 && Text[0] == '-' ? 1 : 0;
+	uint64 Magnitude = 0;
+	for (; Position < Text.Len() && IsDigit(static_cast<uint8>(Text[Position])) && Magnitude <= MAX_int64 / 10; ++Position)
+	{
+		Magnitude = Magnitude * 10 + static_cast<uint64>(Text[Position] - '0');
+	}
+	if (Position == Text.Len() && Magnitude <= static_cast<uint64>(MAX_int64))
+	{
+		OutValue = Text[0] == '-' ? -static_cast<int64>(Magnitude) : static_cast<int64>(Magnitude);
+		return true;
+	}
+
+	// MAX_int64 rounds up to 2^63 as a double, which does not fit back into an int64
+	double Value = 0.0;
+	TryGetNumber(Value);
+	OutValue = Value >= static_cast<double>(MAX_int64) ? MAX_int64 : static_cast<int64>(FMath::Max(Value, static_cast<double>(MIN_int64)));
+	return true;
+}
+
+bool FLobbyJsonView::FValue::TryGetNumber(int32& OutValue) const
+{
+	int64 Value = 0;
+	if (!TryGetNumber(Value))
+	{
+		return false;
+	}
+	OutValue = static_cast<int32>(FMath::Clamp<int64>(Value, MIN_int32, MAX_int32));
+	return true;
+}
+
+bool FLobbyJsonView::FValue::TryGetBool(bool& OutValue) const
+{
+	if (GetType() != EType::BOOL)
+	{
+		return false;
+	}
+	OutValue = View->Json[View->GetToken(Index).Start] == 't';
+	return true;
+}
+
+bool FLobbyJsonView::FValue::IsKey(FAnsiStringView NewKey) const
+{
+	const FUtf8StringView Raw = GetRawString();
+	if (!HasEscapes())
+	{
+		return Raw.Len() == NewKey.Len() && FMemory::Memcmp(Raw.GetData(), NewKey.GetData(), NewKey.Len()) == 0;
+	}
+	TArray<UTF8CHAR, TInlineAllocator<128>> Key;
+	Unescape(Raw, Key);
+	return Key.Num() == NewKey.Len() && FMemory::Memcmp(Key.GetData(), NewKey.GetData(), NewKey.Len()) == 0;
+}
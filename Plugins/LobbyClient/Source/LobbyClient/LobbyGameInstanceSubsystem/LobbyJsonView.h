@@ -0,0 +1,197 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Lazy reader of UTF-8 JSON text. Parse validates the text in one structural scan and records a tape:
+ * one entry per value with its offset, its length and the index of the value after it, so siblings are
+ * skipped without looking at what they contain. Nothing is decoded until a value is asked for, and the
+ * tape is reused between Parse calls, so a warm view reads a response without allocating.
+ * The view does not own the text, it must outlive every FValue taken from it.
+ */
+class LOBBYCLIENT_API FLobbyJsonView
+{
+public:
+
+	enum class EType : uint8
+	{
+		 NONE
+		,OBJECT
+		,ARRAY
+		,STRING
+		,NUMBER
+		,BOOL
+		,NULL_VALUE
+	};
+
+	/**
+	 * Deeper documents are refused, so a hostile frame can not grow the scan stack without bound
+	 */
+	static const int32 MAX_DEPTH = 512;
+
+	/**
+	 * One value on the tape, an invalid one when a lookup finds nothing. Every accessor is safe on an invalid value.
+	 */
+	class LOBBYCLIENT_API FValue
+	{
+	public:
+
+		FValue() = default;
+
+		bool IsValid() const { return View != nullptr; }
+
+		EType GetType() const;
+
+		bool IsObject() const { return GetType() == EType::OBJECT; }
+
+		bool IsArray() const { return GetType() == EType::ARRAY; }
+
+		bool IsString() const { return GetType() == EType::STRING; }
+
+		bool IsNumber() const { return GetType() == EType::NUMBER; }
+
+		/**
+		 * Members of an object or elements of an array, 0 for anything else
+		 */
+		int32 Num() const;
+
+		/**
+		 * The member with this key, the last one if the key repeats like FJsonObject does
+		 */
+		FValue Find(FAnsiStringView NewKey) const;
+
+		FValue At(int32 NewIndex) const;
+
+		/**
+		 * Walk keys and indices, for example "batch[0].name". Keys holding '.' or '[' need Find.
+		 */
+		FValue FindPath(FAnsiStringView NewPath) const;
+
+		/**
+		 * The value as JSON text, strings with their quotes and escapes
+		 */
+		FUtf8StringView GetText() const;
+
+		/**
+		 * String contents without the quotes, still escaped if HasEscapes
+		 */
+		FUtf8StringView GetRawString() const;
+
+		bool HasEscapes() const;
+
+		/**
+		 * Strings are unescaped, numbers and booleans give their text like FJsonValue::TryGetString
+		 */
+		bool TryGetString(FString& OutValue) const;
+
+		FString AsString() const;
+
+		bool TryGetNumber(double& OutValue) const;
+
+		bool TryGetNumber(int64& OutValue) const;
+
+		bool TryGetNumber(int32& OutValue) const;
+
+		bool TryGetBool(bool& OutValue) const;
+
+		/**
+		 * Call NewVisitor(const FValue&) for every element of an array
+		 */
+		template <typename VisitorType>
+		void ForEachElement(VisitorType&& NewVisitor) const
+		{
+			if (!IsArray())
+			{
+				return;
+			}
+			for (int32 Child = Index + 1; Child < View->GetToken(Index).Next; Child = View->GetToken(Child).Next)
+			{
+				NewVisitor(FValue(View, Child));
+			}
+		}
+
+		/**
+		 * Call NewVisitor(const FValue& Key, const FValue& Value) for every member of an object, in text order
+		 */
+		template <typename VisitorType>
+		void ForEachMember(VisitorType&& NewVisitor) const
+		{
+			if (!IsObject())
+			{
+				return;
+			}
+			for (int32 Key = Index + 1; Key < View->GetToken(Index).Next; Key = View->GetToken(Key + 1).Next)
+			{
+				NewVisitor(FValue(View, Key), FValue(View, Key + 1));
+			}
+		}
+
+	private:
+
+		friend class FLobbyJsonView;
+
+		FValue(const FLobbyJsonView* NewView, int32 NewIndex)
+			: View(NewView)
+			, Index(NewIndex)
+		{
+		}
+
+		bool IsKey(FAnsiStringView NewKey) const;
+
+		const FLobbyJsonView* View = nullptr;
+
+		int32 Index = INDEX_NONE;
+	};
+
+	/**
+	 * Scan NewJson and build the tape. False if it is not exactly one valid JSON value.
+	 */
+	bool Parse(FUtf8StringView NewJson);
+
+	/**
+	 * Invalid until Parse succeeded
+	 */
+	FValue GetRoot() const { return Tape.IsEmpty() ? FValue() : FValue(this, 0); }
+
+	int32 GetTokenCount() const { return Tape.Num(); }
+
+private:
+
+	struct FToken
+	{
+		EType Type = EType::NONE;
+
+		bool bEscaped = false;
+
+		/**
+		 * Bytes of the value, strings without their quotes
+		 */
+		int32 Start = 0;
+
+		int32 Length = 0;
+
+		/**
+		 * The tape index after this value and everything inside it
+		 */
+		int32 Next = 0;
+
+		/**
+		 * Members or elements of a container
+		 */
+		int32 Count = 0;
+	};
+
+	const FToken& GetToken(int32 NewIndex) const { return Tape[NewIndex]; }
+
+	bool ScanString(int32& InOutPosition, bool& bOutEscaped) const;
+
+	bool ScanNumber(int32& InOutPosition) const;
+
+	bool ScanLiteral(int32& InOutPosition, FAnsiStringView NewLiteral) const;
+
+	FUtf8StringView Json;
+
+	TArray<FToken> Tape;
+};
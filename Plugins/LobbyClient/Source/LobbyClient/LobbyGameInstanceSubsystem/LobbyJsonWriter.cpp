@@ -0,0 +1,402 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LobbyJsonWriter.h"
+#include "LobbyTypes.h"
+#include "Dom/JsonObject.h"
+#include "Dom/JsonValue.h"
+
+namespace
+{
+	const ANSICHAR HexDigits[] = "0123456789abcdef";
+}
+
+FLobbyJsonWriter::FLobbyJsonWriter(TArray<UTF8CHAR>& NewBuffer)
+	: Buffer(NewBuffer)
+{
+}
+
+void FLobbyJsonWriter::BeginObject()
+{
+	BeforeValue();
+	Put(UTF8CHAR('{'));
+	HasValues.Push(false);
+}
+
+void FLobbyJsonWriter::EndObject()
+{
+	check(HasValues.Num() > 0);
+	HasValues.Pop(EAllowShrinking::No);
+	Put(UTF8CHAR('}'));
+}
+
+void FLobbyJsonWriter::BeginArray()
+{
+	BeforeValue();
+	Put(UTF8CHAR('['));
+	HasValues.Push(false);
+}
+
+void FLobbyJsonWriter::EndArray()
+{
+	check(HasValues.Num() > 0);
+	HasValues.Pop(EAllowShrinking::No);
+	Put(UTF8CHAR(']'));
+}
+
+void FLobbyJsonWriter::WriteKey(FAnsiStringView NewKey)
+{
+	check(HasValues.Num() > 0 && !bAfterKey);
+	if (HasValues.Last())
+	{
+		Put(UTF8CHAR(','));
+	}
+	HasValues.Last() = true;
+
+	Put(UTF8CHAR('"'));
+	Put(NewKey.GetData(), NewKey.Len());
+	Put(UTF8CHAR('"'));
+	Put(UTF8CHAR(':'));
+	bAfterKey = true;
+}
+
+void FLobbyJsonWriter::WriteEscapedKey(FUtf8StringView NewKey)
+{
+	check(HasValues.Num() > 0 && !bAfterKey);
+	if (HasValues.Last())
+	{
+		Put(UTF8CHAR(','));
+	}
+	HasValues.Last() = true;
+
+	Put(UTF8CHAR('"'));
+	PutEscapedUtf8(NewKey);
+	Put(UTF8CHAR('"'));
+	Put(UTF8CHAR(':'));
+	bAfterKey = true;
+}
+
+void FLobbyJsonWriter::WriteEscapedKey(FStringView NewKey)
+{
+	check(HasValues.Num() > 0 && !bAfterKey);
+	if (HasValues.Last())
+	{
+		Put(UTF8CHAR(','));
+	}
+	HasValues.Last() = true;
+
+	Put(UTF8CHAR('"'));
+	PutText(NewKey, true);
+	Put(UTF8CHAR('"'));
+	Put(UTF8CHAR(':'));
+	bAfterKey = true;
+}
+
+void FLobbyJsonWriter::WriteString(FStringView NewValue)
+{
+	BeforeValue();
+	Put(UTF8CHAR('"'));
+	PutText(NewValue, true);
+	Put(UTF8CHAR('"'));
+}
+
+void FLobbyJsonWriter::WriteString(FUtf8StringView NewValue)
+{
+	BeforeValue();
+	Put(UTF8CHAR('"'));
+	PutEscapedUtf8(NewValue);
+	Put(UTF8CHAR('"'));
+}
+
+void FLobbyJsonWriter::WriteNull()
+{
+	BeforeValue();
+	Put("null", 4);
+}
+
+void FLobbyJsonWriter::WriteBool(bool bNewValue)
+{
+	BeforeValue();
+	if (bNewValue)
+	{
+		Put("true", 4);
+	}
+	else
+	{
+		Put("false", 5);
+	}
+}
+
+void FLobbyJsonWriter::WriteInt(int64 NewValue)
+{
+	BeforeValue();
+	ANSICHAR Digits[24];
+	const int32 Length = FCStringAnsi::Snprintf(Digits, UE_ARRAY_COUNT(Digits), "%lld", static_cast<long long>(NewValue));
+	Put(Digits, Length);
+}
+
+void FLobbyJsonWriter::WriteDouble(double NewValue)
+{
+	if (!FMath::IsFinite(NewValue))
+	{
+		WriteNull();
+		return;
+	}
+
+	BeforeValue();
+	ANSICHAR Digits[32];
+	int32 Length = FCStringAnsi::Snprintf(Digits, UE_ARRAY_COUNT(Digits), "%.15g", NewValue);
+	if (FCStringAnsi::Atod(Digits) != NewValue)
+	{
+		Length = FCStringAnsi::Snprintf(Digits, UE_ARRAY_COUNT(Digits), "%.17g", NewValue);
+	}
+	Put(Digits, Length);
+}
+
+void FLobbyJsonWriter::WriteRawValue(FStringView NewJson)
+{
+	BeforeValue();
+	PutText(NewJson, false);
+}
+
+void FLobbyJsonWriter::WriteRawValue(FUtf8StringView NewJson)
+{
+	BeforeValue();
+	if (!bEmbedded)
+	{
+		Buffer.Append(NewJson.GetData(), NewJson.Len());
+		return;
+	}
+	for (const UTF8CHAR Char : NewJson)
+	{
+		Put(Char);
+	}
+}
+
+void FLobbyJsonWriter::BeginEmbeddedString()
+{
+	check(!bEmbedded);
+	BeforeValue();
+	Put(UTF8CHAR('"'));
+	bEmbedded = true;
+	HasValues.Push(false);
+}
+
+void FLobbyJsonWriter::EndEmbeddedString()
+{
+	check(bEmbedded);
+	HasValues.Pop(EAllowShrinking::No);
+	bEmbedded = false;
+	Put(UTF8CHAR('"'));
+}
+
+void FLobbyJsonWriter::WriteValue(const FJsonValue& NewValue)
+{
+	switch (NewValue.Type)
+	{
+	case EJson::Boolean:
+		WriteBool(NewValue.AsBool());
+		break;
+	case EJson::Number:
+		WriteDouble(NewValue.AsNumber());
+		break;
+	case EJson::String:
+		WriteString(NewValue.AsString());
+		break;
+	case EJson::Array:
+		WriteValue(NewValue.AsArray());
+		break;
+	case EJson::Object:
+	{
+		const TSharedPtr<FJsonObject>& Object = NewValue.AsObject();
+		if (!Object.IsValid())
+		{
+			WriteNull();
+			break;
+		}
+		BeginObject();
+		for (const TPair<FString, TSharedPtr<FJsonValue>>& Field : Object->Values)
+		{
+			WriteEscapedKey(FStringView(Field.Key));
+			WriteValue(Field.Value);
+		}
+		EndObject();
+		break;
+	}
+	default:
+		WriteNull();
+		break;
+	}
+}
+
+void FLobbyJsonWriter::WriteValue(const TSharedPtr<FJsonValue>& NewValue)
+{
+	if (NewValue.IsValid())
+	{
+		WriteValue(*NewValue);
+	}
+	else
+	{
+		WriteNull();
+	}
+}
+
+void FLobbyJsonWriter::WriteValue(const FJsonValueStruct& NewValue)
+{
+	WriteValue(NewValue.JsonValue);
+}
+
+void FLobbyJsonWriter::BeforeValue()
+{
+	if (bAfterKey)
+	{
+		bAfterKey = false;
+		return;
+	}
+	if (HasValues.Num() > 0)
+	{
+		if (HasValues.Last())
+		{
+			Put(UTF8CHAR(','));
+		}
+		HasValues.Last() = true;
+	}
+}
+
+void FLobbyJsonWriter::Put(UTF8CHAR NewChar)
+{
+	if (!bEmbedded)
+	{
+		Buffer.Add(NewChar);
+		return;
+	}
+
+	// Inside an embedded string every byte is escaped once more
+	const uint8 Byte = static_cast<uint8>(NewChar);
+	switch (Byte)
+	{
+	case '"':  Buffer.Add(UTF8CHAR('\\')); Buffer.Add(UTF8CHAR('"')); break;
+	case '\\': Buffer.Add(UTF8CHAR('\\')); Buffer.Add(UTF8CHAR('\\')); break;
+	case '\n': Buffer.Add(UTF8CHAR('\\')); Buffer.Add(UTF8CHAR('n')); break;
+	case '\t': Buffer.Add(UTF8CHAR('\\')); Buffer.Add(UTF8CHAR('t')); break;
+	case '\b': Buffer.Add(UTF8CHAR('\\')); Buffer.Add(UTF8CHAR('b')); break;
+	case '\f': Buffer.Add(UTF8CHAR('\\')); Buffer.Add(UTF8CHAR('f')); break;
+	case '\r': Buffer.Add(UTF8CHAR('\\')); Buffer.Add(UTF8CHAR('r')); break;
+	default:
+		if (Byte < 0x20)
+		{
+			const UTF8CHAR Escape[] = { UTF8CHAR('\\'), UTF8CHAR('u'), UTF8CHAR('0'), UTF8CHAR('0'),
+				static_cast<UTF8CHAR>(HexDigits[Byte >> 4]), static_cast<UTF8CHAR>(HexDigits[Byte & 0x0F]) };
+			Buffer.Append(Escape, UE_ARRAY_COUNT(Escape));
+		}
+		else
+		{
+			Buffer.Add(NewChar);
+		}
+		break;
+	}
+}
+
+void FLobbyJsonWriter::Put(const ANSICHAR* NewText, int32 NewLength)
+{
+	if (!bEmbedded)
+	{
+		Buffer.Append(reinterpret_cast<const UTF8CHAR*>(NewText), NewLength);
+		return;
+	}
+	for (int32 i = 0; i < NewLength; ++i)
+	{
+		Put(static_cast<UTF8CHAR>(NewText[i]));
+	}
+}
+
+void FLobbyJsonWriter::PutText(FStringView NewText, bool bNewEscape)
+{
+	const TCHAR* Data = NewText.GetData();
+	const int32 Length = NewText.Len();
+	for (int32 i = 0; i < Length; ++i)
+	{
+		uint32 CodePoint = static_cast<uint32>(Data[i]);
+		if (sizeof(TCHAR) == 2 && CodePoint >= 0xD800 && CodePoint <= 0xDBFF && i + 1 < Length)
+		{
+			const uint32 LowSurrogate = static_cast<uint32>(Data[i + 1]);
+			if (LowSurrogate >= 0xDC00 && LowSurrogate <= 0xDFFF)
+			{
+				CodePoint = 0x10000 + ((CodePoint - 0xD800) << 10) + (LowSurrogate - 0xDC00);
+				++i;
+			}
+		}
+		PutCodePoint(CodePoint, bNewEscape);
+	}
+}
+
+void FLobbyJsonWriter::PutCodePoint(uint32 NewCodePoint, bool bNewEscape)
+{
+	if (NewCodePoint < 0x80)
+	{
+		if (bNewEscape)
+		{
+			switch (NewCodePoint)
+			{
+			case '"':  Put("\\\"", 2); return;
+			case '\\': Put("\\\\", 2); return;
+			case '\n': Put("\\n", 2); return;
+			case '\t': Put("\\t", 2); return;
+			case '\b': Put("\\b", 2); return;
+			case '\f': Put("\\f", 2); return;
+			case '\r': Put("\\r", 2); return;
+			default:
+				if (NewCodePoint < 0x20)
+				{
+					const ANSICHAR Escape[] = { '\\', 'u', '0', '0', HexDigits[NewCodePoint >> 4], HexDigits[NewCodePoint & 0x0F] };
+					Put(Escape, UE_ARRAY_COUNT(Escape));
+					return;
+				}
+				break;
+			}
+		}
+		Put(static_cast<UTF8CHAR>(NewCodePoint));
+		return;
+	}
+
+	// Lone surrogates and values past Unicode become the replacement character
+	if ((NewCodePoint >= 0xD800 && NewCodePoint <= 0xDFFF) || NewCodePoint > 0x10FFFF)
+	{
+		NewCodePoint = 0xFFFD;
+	}
+
+	if (NewCodePoint < 0x800)
+	{
+		Put(static_cast<UTF8CHAR>(0xC0 | (NewCodePoint >> 6)));
+		Put(static_cast<UTF8CHAR>(0x80 | (NewCodePoint & 0x3F)));
+	}
+	else if (NewCodePoint < 0x10000)
+	{
+		Put(static_cast<UTF8CHAR>(0xE0 | (NewCodePoint >> 12)));
+		Put(static_cast<UTF8CHAR>(0x80 | ((NewCodePoint >> 6) & 0x3F)));
+		Put(static_cast<UTF8CHAR>(0x80 | (NewCodePoint & 0x3F)));
+	}
+	else
+	{
+		Put(static_cast<UTF8CHAR>(0xF0 | (NewCodePoint >> 18)));
+		Put(static_cast<UTF8CHAR>(0x80 | ((NewCodePoint >> 12) & 0x3F)));
+		Put(static_cast<UTF8CHAR>(0x80 | ((NewCodePoint >> 6) & 0x3F)));
+		Put(static_cast<UTF8CHAR>(0x80 | (NewCodePoint & 0x3F)));
+	}
+}
+
+void FLobbyJsonWriter::PutEscapedUtf8(FUtf8StringView NewText)
+{
+	for (const UTF8CHAR Char : NewText)
+	{
+		const uint8 Byte = static_cast<uint8>(Char);
+		if (Byte < 0x80)
+		{
+			PutCodePoint(Byte, true);
+		}
+		else
+		{
+			Put(Char);
+		}
+	}
+}
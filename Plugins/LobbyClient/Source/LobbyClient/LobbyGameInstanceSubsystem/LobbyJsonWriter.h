@@ -0,0 +1,160 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FJsonValue;
+struct FJsonValueStruct;
+
+/**
+ * Writes compact JSON as UTF-8 straight into a caller owned buffer, no DOM is built.
+ * String escaping follows TJsonWriter so the output matches FJsonObjectConverter.
+ */
+class LOBBYCLIENT_API FLobbyJsonWriter
+{
+public:
+
+	explicit FLobbyJsonWriter(TArray<UTF8CHAR>& NewBuffer);
+
+	void BeginObject();
+
+	void EndObject();
+
+	void BeginArray();
+
+	void EndArray();
+
+	/**
+	 * Object keys are ASCII literals in this module, so they are written without escaping
+	 */
+	void WriteKey(FAnsiStringView NewKey);
+
+	/**
+	 * Keys that come from received data, escaped like string values
+	 */
+	void WriteEscapedKey(FUtf8StringView NewKey);
+
+	void WriteEscapedKey(FStringView NewKey);
+
+	void WriteString(FStringView NewValue);
+
+	/**
+	 * UTF-8 text is copied as it is, only the characters JSON needs escaped are
+	 */
+	void WriteString(FUtf8StringView NewValue);
+
+	void WriteNull();
+
+	void WriteBool(bool bNewValue);
+
+	void WriteInt(int64 NewValue);
+
+	/**
+	 * Shortest form that reads back to the same double, NaN and infinities become null
+	 */
+	void WriteDouble(double NewValue);
+
+	/**
+	 * Copy already serialized JSON text as one value
+	 */
+	void WriteRawValue(FStringView NewJson);
+
+	void WriteRawValue(FUtf8StringView NewJson);
+
+	/**
+	 * Everything written until EndEmbeddedString becomes the contents of one JSON string value,
+	 * escaped on the fly. This is how a payload is nested as an escaped string in one pass.
+	 */
+	void BeginEmbeddedString();
+
+	void EndEmbeddedString();
+
+	/**
+	 * WriteValue picks the writer for a C++ value. Arrays and string keyed maps are written element by element,
+	 * so nested containers become nested JSON without a FJsonObject in between.
+	 */
+	void WriteValue(FStringView NewValue) { WriteString(NewValue); }
+
+	void WriteValue(const TCHAR* NewValue) { WriteString(FStringView(NewValue)); }
+
+	void WriteValue(bool bNewValue) { WriteBool(bNewValue); }
+
+	void WriteValue(int32 NewValue) { WriteInt(NewValue); }
+
+	void WriteValue(int64 NewValue) { WriteInt(NewValue); }
+
+	void WriteValue(float NewValue) { WriteDouble(NewValue); }
+
+	void WriteValue(double NewValue) { WriteDouble(NewValue); }
+
+	/**
+	 * An existing DOM value, written recursively
+	 */
+	void WriteValue(const FJsonValue& NewValue);
+
+	void WriteValue(const TSharedPtr<FJsonValue>& NewValue);
+
+	void WriteValue(const FJsonValueStruct& NewValue);
+
+	template <typename ElementType, typename AllocatorType>
+	void WriteValue(const TArray<ElementType, AllocatorType>& NewArray)
+	{
+		BeginArray();
+		for (const ElementType& Element : NewArray)
+		{
+			WriteValue(Element);
+		}
+		EndArray();
+	}
+
+	template <typename ValueType>
+	void WriteValue(const TMap<FString, ValueType>& NewMap)
+	{
+		BeginObject();
+		for (const TPair<FString, ValueType>& Pair : NewMap)
+		{
+			WriteEscapedKey(FStringView(Pair.Key));
+			WriteValue(Pair.Value);
+		}
+		EndObject();
+	}
+
+	/**
+	 * Nesting of the objects, arrays and embedded strings still open
+	 */
+	int32 GetDepth() const { return HasValues.Num(); }
+
+	TArray<UTF8CHAR>& GetBuffer() const { return Buffer; }
+
+private:
+
+	/**
+	 * Comma handling before every value
+	 */
+	void BeforeValue();
+
+	void Put(UTF8CHAR NewChar);
+
+	void Put(const ANSICHAR* NewText, int32 NewLength);
+
+	/**
+	 * Transcode NewText to UTF-8, escaping it as the contents of a JSON string if requested
+	 */
+	void PutText(FStringView NewText, bool bNewEscape);
+
+	void PutCodePoint(uint32 NewCodePoint, bool bNewEscape);
+
+	void PutEscapedUtf8(FUtf8StringView NewText);
+
+	TArray<UTF8CHAR>& Buffer;
+
+	/**
+	 * One entry per open object, array or embedded string, true once it holds a value
+	 */
+	TArray<bool, TInlineAllocator<16>> HasValues;
+
+	bool bAfterKey = false;
+
+	bool bEmbedded = false;
+};
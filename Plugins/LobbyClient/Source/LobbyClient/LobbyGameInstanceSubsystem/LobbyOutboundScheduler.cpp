@@ -0,0 +1,184 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LobbyOutboundScheduler.h"
+
+ELobbySendPriority FLobbyOutboundScheduler::GetPriority(const FLobbyOutboundConfig& NewConfig, ELobbyActionType NewAction, EMongoDBActionType NewDbAction)
+{
+	if (NewAction == ELobbyActionType::DATABASE)
+	{
+		if (const ELobbySendPriority* Priority = NewConfig.DBActionPriorities.Find(NewDbAction))
+		{
+			return *Priority;
+		}
+	}
+	if (const ELobbySendPriority* Priority = NewConfig.ActionPriorities.Find(NewAction))
+	{
+		return *Priority;
+	}
+
+	switch (NewAction)
+	{
+	case ELobbyActionType::TEXT_CHAT:
+	case ELobbyActionType::REGISTER_PLAYER_INTO_LOBBY:
+	case ELobbyActionType::REQUEST_STATUS:
+	case ELobbyActionType::RESYNC:
+		return ELobbySendPriority::HIGH;
+
+	case ELobbyActionType::DATABASE:
+		switch (NewDbAction)
+		{
+		case EMongoDBActionType::AGGREGATE:
+		case EMongoDBActionType::INSERT_MANY:
+		case EMongoDBActionType::DELETE_MANY:
+		case EMongoDBActionType::UPDATE_MANY:
+		case EMongoDBActionType::UPDATE_MANY_WITH_OPTIONS:
+		case EMongoDBActionType::RUN_COMMAND:
+		case EMongoDBActionType::BULK_WRITE:
+			return ELobbySendPriority::BULK;
+
+		default:
+			return ELobbySendPriority::NORMAL;
+		}
+
+	default:
+		return ELobbySendPriority::NORMAL;
+	}
+}
+
+bool FLobbyOutboundScheduler::CanAdmit(const FLobbyOutboundConfig& NewConfig, ELobbySendPriority NewPriority, int32 NewBytes) const
+{
+	float Ratio = 1.f;
+	switch (NewPriority)
+	{
+	case ELobbySendPriority::NORMAL:
+		Ratio = NewConfig.NormalAdmissionRatio;
+		break;
+
+	case ELobbySendPriority::BULK:
+		Ratio = NewConfig.BulkAdmissionRatio;
+		break;
+
+	default:
+		break;
+	}
+
+	const int64 Limit = static_cast<int64>(FMath::Max(NewConfig.MaxQueuedBytes, 0) * FMath::Clamp(Ratio, 0.f, 1.f));
+	return static_cast<int64>(QueuedBytes) + NewBytes <= Limit;
+}
+
+bool FLobbyOutboundScheduler::Enqueue(const FLobbyOutboundConfig& NewConfig, ELobbySendPriority NewPriority, const FString& NewRequestId, double NewNow, FUtf8StringView NewEnvelope, bool bNewRetain, bool bNewBson)
+{
+	if (!CanAdmit(NewConfig, NewPriority, NewEnvelope.Len()))
+	{
+		return false;
+	}
+
+	FLane& Lane = Lanes[static_cast<int32>(NewPriority)];
+	Lane.Queue.Enqueue(NewRequestId, NewNow, NewEnvelope, bNewBson, bNewRetain);
+	QueuedBytes += NewEnvelope.Len();
+	return true;
+}
+
+void FLobbyOutboundScheduler::Drain(const FLobbyOutboundConfig& NewConfig, int32 NewBudgetBytes, FLobbySendQueue& OutDrained)
+{
+	int32 Taken[NUM_LANES] = {};
+	int32 DrainedBytes = 0;
+	bool bWaiting = !IsEmpty();
+	while (bWaiting && (DrainedBytes < NewBudgetBytes || OutDrained.IsEmpty()))
+	{
+		bWaiting = false;
+		for (int32 LaneIndex = 0; LaneIndex < NUM_LANES; ++LaneIndex)
+		{
+			FLane& Lane = Lanes[LaneIndex];
+			int32& Index = Taken[LaneIndex];
+			if (Index >= Lane.Queue.Num())
+			{
+				// An idle lane does not save up deficit for later
+				Lane.Deficit = 0;
+				continue;
+			}
+
+			Lane.Deficit += GetWeight(NewConfig, LaneIndex) * QUANTUM_BYTES;
+			while (Index < Lane.Queue.Num() && (DrainedBytes < NewBudgetBytes || OutDrained.IsEmpty()))
+			{
+				const FUtf8StringView Envelope = Lane.Queue.GetEnvelope(Index);
+				if (Envelope.Len() > Lane.Deficit)
+				{
+					break;
+				}
+				OutDrained.Enqueue(Lane.Queue.GetRequestIds()[Index], Lane.Queue.GetOldestEnqueueTime(), Envelope, Lane.Queue.IsBson(Index), Lane.Queue.IsRetained(Index));
+				Lane.Deficit -= Envelope.Len();
+				DrainedBytes += Envelope.Len();
+				++Index;
+			}
+			bWaiting |= Index < Lane.Queue.Num();
+		}
+	}
+
+	for (int32 LaneIndex = 0; LaneIndex < NUM_LANES; ++LaneIndex)
+	{
+		FLane& Lane = Lanes[LaneIndex];
+		const int32 Count = Taken[LaneIndex];
+		if (Count > 0)
+		{
+			const int32 BytesBefore = Lane.Queue.NumBytes();
+			Lane.Queue.RemoveFirst(Count);
+			QueuedBytes -= BytesBefore - Lane.Queue.NumBytes();
+		}
+		if (Lane.Queue.IsEmpty())
+		{
+			Lane.Deficit = 0;
+		}
+	}
+}
+
+bool FLobbyOutboundScheduler::IsClearFor(ELobbySendPriority NewPriority) const
+{
+	for (int32 LaneIndex = 0; LaneIndex <= static_cast<int32>(NewPriority); ++LaneIndex)
+	{
+		if (!Lanes[LaneIndex].Queue.IsEmpty())
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+TArray<FString> FLobbyOutboundScheduler::Reset()
+{
+	TArray<FString> R_RequestIds;
+	for (FLane& Lane : Lanes)
+	{
+		R_RequestIds.Append(Lane.Queue.GetRequestIds());
+		Lane.Queue.Reset();
+		Lane.Deficit = 0;
+	}
+	QueuedBytes = 0;
+	return R_RequestIds;
+}
+
+int32 FLobbyOutboundScheduler::Num() const
+{
+	int32 R_Num = 0;
+	for (const FLane& Lane : Lanes)
+	{
+		R_Num += Lane.Queue.Num();
+	}
+	return R_Num;
+}
+
+int32 FLobbyOutboundScheduler::GetWeight(const FLobbyOutboundConfig& NewConfig, int32 NewLane)
+{
+	switch (static_cast<ELobbySendPriority>(NewLane))
+	{
+	case ELobbySendPriority::HIGH:
+		return FMath::Max(NewConfig.HighWeight, 1);
+
+	case ELobbySendPriority::NORMAL:
+		return FMath::Max(NewConfig.NormalWeight, 1);
+
+	default:
+		return FMath::Max(NewConfig.BulkWeight, 1);
+	}
+}
@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LobbyTypes.h"
+#include "LobbySendQueue.h"
+
+/**
+ * Outgoing envelopes waiting for their turn, one lane per ELobbySendPriority.
+ * Lanes are drained by deficit round robin, so a lane gets a share of the budget in proportion to its weight
+ * and a bulk payload can not hold back the chat behind it. The bytes in all lanes are bounded, a lane only
+ * admits an envelope while the total stays under its share of FLobbyOutboundConfig::MaxQueuedBytes.
+ */
+class LOBBYCLIENT_API FLobbyOutboundScheduler
+{
+public:
+
+	static constexpr int32 NUM_LANES = 3;
+
+	/**
+	 * Deficit a lane earns per unit of weight and round
+	 */
+	static constexpr int32 QUANTUM_BYTES = 1024;
+
+	static ELobbySendPriority GetPriority(const FLobbyOutboundConfig& NewConfig, ELobbyActionType NewAction, EMongoDBActionType NewDbAction = EMongoDBActionType::NONE);
+
+	/**
+	 * Whether NewBytes more fit into the share of the budget NewPriority may fill
+	 */
+	bool CanAdmit(const FLobbyOutboundConfig& NewConfig, ELobbySendPriority NewPriority, int32 NewBytes) const;
+
+	/**
+	 * Copy the envelope into its lane, returns false without queueing if it does not fit
+	 */
+	bool Enqueue(const FLobbyOutboundConfig& NewConfig, ELobbySendPriority NewPriority, const FString& NewRequestId, double NewNow, FUtf8StringView NewEnvelope, bool bNewRetain, bool bNewBson = false);
+
+	/**
+	 * Move envelopes in weighted order into OutDrained until NewBudgetBytes are used up, with their BSON and retain bits.
+	 * At least one envelope is taken, so one larger than the budget still gets out.
+	 */
+	void Drain(const FLobbyOutboundConfig& NewConfig, int32 NewBudgetBytes, FLobbySendQueue& OutDrained);
+
+	/**
+	 * True if nothing of NewPriority or a higher priority is waiting
+	 */
+	bool IsClearFor(ELobbySendPriority NewPriority) const;
+
+	/**
+	 * Drop every lane, returns the request ids that were waiting
+	 */
+	TArray<FString> Reset();
+
+	bool IsEmpty() const { return Num() == 0; }
+
+	int32 Num() const;
+
+	int32 GetQueuedBytes() const { return QueuedBytes; }
+
+	int32 GetQueuedBytes(ELobbySendPriority NewPriority) const { return Lanes[static_cast<int32>(NewPriority)].Queue.NumBytes(); }
+
+private:
+
+	struct FLane
+	{
+		FLobbySendQueue Queue;
+		int32 Deficit = 0;
+	};
+
+	static int32 GetWeight(const FLobbyOutboundConfig& NewConfig, int32 NewLane);
+
+	FLane Lanes[NUM_LANES];
+
+	int32 QueuedBytes = 0;
+};
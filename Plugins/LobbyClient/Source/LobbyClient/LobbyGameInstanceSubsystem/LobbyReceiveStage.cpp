@@ -0,0 +1,321 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LobbyReceiveStage.h"
+#include "LobbyJsonWriter.h"
+#include "LobbyEnumNames.h"
+#include "LobbyStats.h"
+#include "LobbyClient.h"
+
+FLobbyReceiveStage::FLobbyReceiveStage()
+	: Pipe(TEXT("LobbyReceivePipe"))
+{
+}
+
+FLobbyReceiveStage::~FLobbyReceiveStage()
+{
+	// The tasks still queued use the members and the pipe, they finish before either goes
+	Pipe.WaitUntilEmpty();
+}
+
+void FLobbyReceiveStage::SetKey(const FString& NewClientSecret, const FString& NewClientId)
+{
+	Pipe.Launch(TEXT("LobbyReceiveSetKey"), [This = this, NewClientSecret, NewClientId]()
+	{
+		This->Signer.SetKey(NewClientSecret, NewClientId);
+	});
+}
+
+void FLobbyReceiveStage::SetMaxInflatedBytes(int32 NewMaxInflatedBytes)
+{
+	Pipe.Launch(TEXT("LobbyReceiveSetMaxInflatedBytes"), [This = this, NewMaxInflatedBytes]()
+	{
+		This->MaxInflatedBytes = NewMaxInflatedBytes;
+	});
+}
+
+void FLobbyReceiveStage::SetGateConfig(const FLobbyInboundGateConfig& NewConfig)
+{
+	Pipe.Launch(TEXT("LobbyReceiveSetGateConfig"), [This = this, NewConfig]()
+	{
+		This->Gate.SetConfig(NewConfig);
+	});
+}
+
+void FLobbyReceiveStage::Enqueue(TArray<uint8>&& NewFrame, bool bNewDebug, int32 NewConnectionId, const TSharedPtr<FLobbyFramePool, ESPMode::ThreadSafe>& NewFramePool)
+{
+	Pipe.Launch(TEXT("LobbyReceiveFrame"), [This = this, Frame = MoveTemp(NewFrame), bNewDebug, NewConnectionId, FramePool = NewFramePool]() mutable
+	{
+		int64 Allocations = 0;
+		{
+			FLobbyAllocationCounter Counter(Allocations);
+			This->ProcessFrame(FUtf8StringView(reinterpret_cast<const UTF8CHAR*>(Frame.GetData()), Frame.Num()), bNewDebug, NewConnectionId);
+		}
+		++This->ProcessedFrames;
+		This->ProcessAllocations += Allocations;
+
+		// The connection collects its next frame into this buffer
+		if (FramePool.IsValid())
+		{
+			FramePool->Release(MoveTemp(Frame));
+		}
+	});
+}
+
+void FLobbyReceiveStage::GetAllocationStats(int64& OutFrames, int64& OutAllocations) const
+{
+	OutFrames = ProcessedFrames;
+	OutAllocations = ProcessAllocations;
+}
+
+void FLobbyReceiveStage::ResetAllocationStats()
+{
+	ProcessedFrames = 0;
+	ProcessAllocations = 0;
+}
+
+void FLobbyReceiveStage::ProcessFrame(FUtf8StringView NewFrame, bool bNewDebug, int32 NewConnectionId)
+{
+	SCOPE_CYCLE_COUNTER(STAT_LobbyProcessFrame);
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Lobby_ProcessFrame, LobbyChannel);
+	ELobbyInboundResult Result = ELobbyInboundResult::VALID;
+	FFrameInfo FrameInfo;
+	FrameInfo.ConnectionId = NewConnectionId;
+	FLobbyFrameView FrameView;
+	FUtf8StringView Body;
+	int64 Timestamp = 0;
+	if (!Gate.CheckLength(NewFrame.Len()))
+	{
+		Result = ELobbyInboundResult::INVALID_FRAME;
+	}
+	else if (!FLobbyFrameParser::Parse(NewFrame, FrameView))
+	{
+		Gate.Reject(ELobbyGateStage::FRAME_FORMAT);
+		Result = ELobbyInboundResult::INVALID_FRAME;
+	}
+	// Stale, replayed and foreign frames are dropped before they are inflated or verified
+	else if (!Gate.CheckHeader(FrameView, Signer.GetClientIdUtf8(), FLobbyFrameWriter::GetCurrentTimestamp(), Timestamp))
+	{
+		Result = ELobbyInboundResult::REJECTED;
+	}
+	else if (!GetBody(FrameView, Body, FrameInfo))
+	{
+		Gate.Reject(ELobbyGateStage::FRAME_FORMAT);
+		Result = ELobbyInboundResult::INVALID_FRAME;
+	}
+	// The server signs with our client id, not with the id written in the frame
+	else if (!Signer.Verify(Timestamp, Body, FrameView[NGG_LOBBY_PROTOCOL::SIGNATURE]))
+	{
+		Gate.Reject(ELobbyGateStage::SIGNATURE);
+		Result = ELobbyInboundResult::INVALID_SIGNATURE;
+	}
+	else
+	{
+		Gate.Accept(FrameView);
+		if ((FrameView.Flags & NGG_LOBBY_PROTOCOL_V2::FRAME_FLAG_BSON) != 0 ? !DecodeBsonBody(Body, FrameInfo) : !DecodeBody(Body, FrameInfo))
+		{
+			Result = ELobbyInboundResult::INVALID_BODY;
+		}
+	}
+
+	if (Result == ELobbyInboundResult::REJECTED)
+	{
+		// Shedding stays cheap, the frame is neither copied into the log nor handed to the game thread
+		UE_LOG(LogLobbyClient, Verbose, TEXT("A received frame was dropped before its signature was checked."));
+	}
+	else if (Result != ELobbyInboundResult::VALID)
+	{
+		// An oversized frame is not worth logging in full
+		const FUtf8StringView Logged = NewFrame.Left(1024);
+		UE_LOG(LogLobbyClient, Error, TEXT("The data is not valid please check it, data : %s"), *FString(Logged.Len(), Logged.GetData()));
+		Processed.Enqueue(MakeMessage(Result, FrameInfo));
+	}
+	else if (bNewDebug && (FrameView.Flags & NGG_LOBBY_PROTOCOL_V2::FRAME_FLAG_BSON) == 0)
+	{
+		UE_LOG(LogLobbyClient, Log, TEXT("Valid Data, WebSocket message received: %s"), *FString(Body.Len(), Body.GetData()));
+	}
+}
+
+FLobbyInboundMessage FLobbyReceiveStage::MakeMessage(ELobbyInboundResult NewResult, FFrameInfo& InOutFrameInfo) const
+{
+	FLobbyInboundMessage R_Message;
+	R_Message.Result = NewResult;
+	R_Message.ConnectionId = InOutFrameInfo.ConnectionId;
+	R_Message.CompressedBytes = InOutFrameInfo.CompressedBytes;
+	R_Message.InflatedBytes = InOutFrameInfo.InflatedBytes;
+	R_Message.InflateSeconds = InOutFrameInfo.InflateSeconds;
+	InOutFrameInfo.CompressedBytes = 0;
+	InOutFrameInfo.InflatedBytes = 0;
+	InOutFrameInfo.InflateSeconds = 0.0;
+	return R_Message;
+}
+
+bool FLobbyReceiveStage::GetBody(const FLobbyFrameView& NewFrameView, FUtf8StringView& OutBody, FFrameInfo& InOutFrameInfo)
+{
+	const FUtf8StringView WireBody = NewFrameView[NGG_LOBBY_PROTOCOL::JSON];
+	if ((NewFrameView.Flags & NGG_LOBBY_PROTOCOL_V2::FRAME_FLAG_DEFLATE) == 0)
+	{
+		OutBody = WireBody;
+		return true;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	if (!Inflater.Inflate(WireBody, MaxInflatedBytes, InflatedBody))
+	{
+		return false;
+	}
+	InOutFrameInfo.CompressedBytes = WireBody.Len();
+	InOutFrameInfo.InflatedBytes = InflatedBody.Num();
+	InOutFrameInfo.InflateSeconds = FPlatformTime::Seconds() - StartTime;
+	OutBody = FUtf8StringView(InflatedBody.GetData(), InflatedBody.Num());
+	return true;
+}
+
+bool FLobbyReceiveStage::DecodeBody(FUtf8StringView NewBody, FFrameInfo& InOutFrameInfo)
+{
+	SCOPE_CYCLE_COUNTER(STAT_LobbyDecodeBody);
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Lobby_DecodeBody, LobbyChannel);
+	if (!BodyView.Parse(NewBody))
+	{
+		return false;
+	}
+
+	const FLobbyJsonView::FValue Body = BodyView.GetRoot();
+	if (Body.IsObject())
+	{
+		FLobbyInboundMessage Message = MakeMessage(ELobbyInboundResult::VALID, InOutFrameInfo);
+		DecodeResponse(Body, Message.Response);
+		Processed.Enqueue(MoveTemp(Message));
+		return true;
+	}
+
+	if (!Body.IsArray())
+	{
+		return false;
+	}
+
+	// A batch frame, every envelope in it is a response of its own
+	Body.ForEachElement([this, &InOutFrameInfo](const FLobbyJsonView::FValue& Element)
+	{
+		const bool bValid = Element.IsObject();
+		FLobbyInboundMessage Message = MakeMessage(bValid ? ELobbyInboundResult::VALID : ELobbyInboundResult::INVALID_BODY, InOutFrameInfo);
+		if (bValid)
+		{
+			DecodeResponse(Element, Message.Response);
+		}
+		Processed.Enqueue(MoveTemp(Message));
+	});
+	return true;
+}
+
+bool FLobbyReceiveStage::DecodeBsonBody(FUtf8StringView NewBody, FFrameInfo& InOutFrameInfo)
+{
+	SCOPE_CYCLE_COUNTER(STAT_LobbyDecodeBody);
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Lobby_DecodeBsonBody, LobbyChannel);
+	if (!FLobbyBsonView::IsValid(NewBody))
+	{
+		return false;
+	}
+
+	FLobbyInboundMessage Message = MakeMessage(ELobbyInboundResult::VALID, InOutFrameInfo);
+	DecodeBsonResponse(FLobbyBsonView(NewBody), Message.Response);
+	Processed.Enqueue(MoveTemp(Message));
+	return true;
+}
+
+void FLobbyReceiveStage::DecodeBsonResponse(const FLobbyBsonView& NewEnvelope, FLobbyResponse& OutResponse)
+{
+	FLobbyBsonView::FElement Element;
+	if (NewEnvelope.Find("requestId", Element))
+	{
+		const FUtf8StringView RequestId = Element.AsString();
+		OutResponse.RequestId = FString(RequestId.Len(), RequestId.GetData());
+	}
+
+	if (NewEnvelope.Find("action", Element))
+	{
+		FLobbyEnumNames::FromName(Element.AsString(), OutResponse.Action);
+	}
+
+	if (NewEnvelope.Find("payLoadData", Element))
+	{
+		if (Element.Type == NGG_LOBBY_BSON::STRING)
+		{
+			const FUtf8StringView PayLoad = Element.AsString();
+			OutResponse.PayLoadData = FString(PayLoad.Len(), PayLoad.GetData());
+		}
+		else
+		{
+			if (Element.Type == NGG_LOBBY_BSON::DOCUMENT || Element.Type == NGG_LOBBY_BSON::ARRAY)
+			{
+				OutResponse.PayLoadBson.Append(reinterpret_cast<const uint8*>(Element.Value.GetData()), Element.Value.Len());
+			}
+
+			// Blueprints, the read cache and the cursors read the JSON text
+			PayLoadJson.Reset();
+			{
+				FLobbyJsonWriter Writer(PayLoadJson);
+				FLobbyBsonView::WriteJsonValue(Writer, Element);
+			}
+			OutResponse.PayLoadData = FString(PayLoadJson.Num(), PayLoadJson.GetData());
+		}
+	}
+
+	// Numbered pushes, the game thread drops the ones it has already seen
+	if (NewEnvelope.Find("stream", Element))
+	{
+		FLobbyEnumNames::FromName(Element.AsString(), OutResponse.Stream);
+	}
+
+	if (NewEnvelope.Find("sequence", Element))
+	{
+		OutResponse.Sequence = Element.AsInt();
+	}
+
+	if (NewEnvelope.Find("error", Element) && !Element.AsString().IsEmpty())
+	{
+		const FUtf8StringView Error = Element.AsString();
+		OutResponse.Error = FString(Error.Len(), Error.GetData());
+		OutResponse.Status = ELobbyRequestStatus::FAILED;
+	}
+}
+
+void FLobbyReceiveStage::DecodeResponse(const FLobbyJsonView::FValue& NewEnvelope, FLobbyResponse& OutResponse)
+{
+	// Only these fields are decoded, the payload is copied out as the text it is
+	NewEnvelope.Find("requestId").TryGetString(OutResponse.RequestId);
+
+	const FLobbyJsonView::FValue Action = NewEnvelope.Find("action");
+	if (Action.IsString() && !Action.HasEscapes())
+	{
+		FLobbyEnumNames::FromName(Action.GetRawString(), OutResponse.Action);
+	}
+	else if (Action.IsString())
+	{
+		FLobbyEnumNames::FromName(FStringView(Action.AsString()), OutResponse.Action);
+	}
+
+	const FLobbyJsonView::FValue PayLoad = NewEnvelope.Find("payLoadData");
+	if (PayLoad.IsObject() || PayLoad.IsArray())
+	{
+		const FUtf8StringView PayLoadText = PayLoad.GetText();
+		OutResponse.PayLoadData = FString(PayLoadText.Len(), PayLoadText.GetData());
+	}
+	else
+	{
+		PayLoad.TryGetString(OutResponse.PayLoadData);
+	}
+
+	// Numbered pushes, the game thread drops the ones it has already seen
+	const FLobbyJsonView::FValue Stream = NewEnvelope.Find("stream");
+	if (Stream.IsString())
+	{
+		FLobbyEnumNames::FromName(Stream.GetRawString(), OutResponse.Stream);
+	}
+	NewEnvelope.Find("sequence").TryGetNumber(OutResponse.Sequence);
+
+	if (NewEnvelope.Find("error").TryGetString(OutResponse.Error) && !OutResponse.Error.IsEmpty())
+	{
+		OutResponse.Status = ELobbyRequestStatus::FAILED;
+	}
+}
@@ -0,0 +1,186 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "Tasks/Pipe.h"
+#include "LobbyTypes.h"
+#include "LobbyFrame.h"
+#include "LobbySigner.h"
+#include "LobbyCompression.h"
+#include "LobbyBson.h"
+#include "LobbyJsonView.h"
+#include "LobbyInboundGate.h"
+#include "LobbyBufferPool.h"
+#include <atomic>
+
+enum class ELobbyInboundResult : uint8
+{
+	 VALID
+	,INVALID_FRAME
+	,INVALID_SIGNATURE
+	,INVALID_BODY
+	/**
+	 * Dropped by the gate before its signature was checked, never handed to the game thread
+	 */
+	,REJECTED
+};
+
+/**
+ * One received frame after the receive stage is done with it
+ */
+struct FLobbyInboundMessage
+{
+	ELobbyInboundResult Result = ELobbyInboundResult::INVALID_FRAME;
+
+	/**
+	 * The connection the frame arrived on
+	 */
+	int32 ConnectionId = INDEX_NONE;
+
+	/**
+	 * Only set on the first message of a deflated frame: the body on the wire, inflated, and the time inflating took
+	 */
+	int32 CompressedBytes = 0;
+
+	int32 InflatedBytes = 0;
+
+	double InflateSeconds = 0.0;
+
+	FLobbyResponse Response;
+};
+
+/**
+ * Parses, verifies and decodes received frames on a task pipe, off the game thread.
+ * Frames are processed one at a time in arrival order, results are queued for the game thread.
+ * The tasks only borrow the stage, destroying it waits for the ones in flight so the pipe never dies under them.
+ */
+class LOBBYCLIENT_API FLobbyReceiveStage
+{
+public:
+
+	FLobbyReceiveStage();
+
+	~FLobbyReceiveStage();
+
+	FLobbyReceiveStage(const FLobbyReceiveStage&) = delete;
+	FLobbyReceiveStage& operator=(const FLobbyReceiveStage&) = delete;
+
+	/**
+	 * Rekey the receive signer, ordered with the frames already queued
+	 */
+	void SetKey(const FString& NewClientSecret, const FString& NewClientId);
+
+	/**
+	 * Deflated frames that expand past this are dropped as invalid
+	 */
+	void SetMaxInflatedBytes(int32 NewMaxInflatedBytes);
+
+	/**
+	 * Limits of the checks that run before the HMAC, ordered with the frames already queued
+	 */
+	void SetGateConfig(const FLobbyInboundGateConfig& NewConfig);
+
+	/**
+	 * What the gate rejected at each stage, safe on any thread
+	 */
+	void GetGateStats(FLobbyInboundGateStats& OutStats) const { Gate.GetStats(OutStats); }
+
+	void ResetGateStats() { Gate.ResetStats(); }
+
+	/**
+	 * Hand a complete frame to the pipe, the buffer goes back to NewFramePool once it is processed. Called on the game thread.
+	 */
+	void Enqueue(TArray<uint8>&& NewFrame, bool bNewDebug, int32 NewConnectionId, const TSharedPtr<FLobbyFramePool, ESPMode::ThreadSafe>& NewFramePool = nullptr);
+
+	/**
+	 * Take the next processed message. Called on the game thread.
+	 */
+	bool Dequeue(FLobbyInboundMessage& OutMessage) { return Processed.Dequeue(OutMessage); }
+
+	bool HasProcessedMessages() const { return !Processed.IsEmpty(); }
+
+	/**
+	 * Frames processed on the pipe and the heap allocations made while processing them
+	 */
+	void GetAllocationStats(int64& OutFrames, int64& OutAllocations) const;
+
+	void ResetAllocationStats();
+
+	/**
+	 * Split, verify and decode one frame and queue what came out of it. Runs on the pipe.
+	 */
+	void ProcessFrame(FUtf8StringView NewFrame, bool bNewDebug, int32 NewConnectionId = INDEX_NONE);
+
+	/**
+	 * Read the envelope fields of one response straight from the tape
+	 */
+	static void DecodeResponse(const FLobbyJsonView::FValue& NewEnvelope, FLobbyResponse& OutResponse);
+
+private:
+
+	/**
+	 * What every message of one frame carries, the compression numbers only go to the first one
+	 */
+	struct FFrameInfo
+	{
+		int32 ConnectionId = INDEX_NONE;
+		int32 CompressedBytes = 0;
+		int32 InflatedBytes = 0;
+		double InflateSeconds = 0.0;
+	};
+
+	FLobbyInboundMessage MakeMessage(ELobbyInboundResult NewResult, FFrameInfo& InOutFrameInfo) const;
+
+	/**
+	 * The body as it was signed, inflated into InflatedBody if the frame is deflated
+	 */
+	bool GetBody(const FLobbyFrameView& NewFrameView, FUtf8StringView& OutBody, FFrameInfo& InOutFrameInfo);
+
+	/**
+	 * Queue one message for an envelope body, or one per envelope for a batch body
+	 */
+	bool DecodeBody(FUtf8StringView NewBody, FFrameInfo& InOutFrameInfo);
+
+	/**
+	 * A BSON body carries one envelope, the payload is kept as BSON and also written out as JSON text
+	 */
+	bool DecodeBsonBody(FUtf8StringView NewBody, FFrameInfo& InOutFrameInfo);
+
+	void DecodeBsonResponse(const FLobbyBsonView& NewEnvelope, FLobbyResponse& OutResponse);
+
+	/**
+	 * Only used on the pipe
+	 */
+	FLobbySigner Signer;
+
+	FLobbyInflater Inflater;
+
+	FLobbyInboundGate Gate;
+
+	/**
+	 * Reused between frames, a deflated body is expanded here once
+	 */
+	TArray<UTF8CHAR> InflatedBody;
+
+	int32 MaxInflatedBytes = 16 * 1024 * 1024;
+
+	/**
+	 * Tape of the current JSON body, reused between frames
+	 */
+	FLobbyJsonView BodyView;
+
+	/**
+	 * BSON payloads are written out as JSON here before they become PayLoadData
+	 */
+	TArray<UTF8CHAR> PayLoadJson;
+
+	UE::Tasks::FPipe Pipe;
+
+	TQueue<FLobbyInboundMessage, EQueueMode::Mpsc> Processed;
+
+	std::atomic<int64> ProcessedFrames = 0;
+
+	std::atomic<int64> ProcessAllocations = 0;
+};
@@ -0,0 +1,186 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LobbyRequestTracker.h"
+#include "LobbyClient.h"
+
+bool FLobbyRequestTracker::Add(const FString& NewRequestId, ELobbyActionType NewAction, double NewNow, double NewTimeoutSeconds, FOnLobbyResponseNative&& NewOnResponse, EMongoDBActionType NewDbAction)
+{
+	if (NewRequestId.IsEmpty() || SlotByRequestId.Contains(NewRequestId))
+	{
+		UE_LOG(LogLobbyClient, Warning, TEXT("FLobbyRequestTracker: the request id '%s' is empty or already in flight."), *NewRequestId);
+		return false;
+	}
+
+	const int32 Slot = AllocateSlot();
+	FEntry& Entry = Entries[Slot];
+	Entry.RequestId = NewRequestId;
+	Entry.OnResponse = MoveTemp(NewOnResponse);
+	Entry.SendTime = NewNow;
+	Entry.Action = NewAction;
+	Entry.DbAction = NewDbAction;
+	SlotByRequestId.Add(NewRequestId, Slot);
+
+	if (NewTimeoutSeconds > 0.0)
+	{
+		DeadlineHeap.HeapPush(FDeadline{ NewNow + NewTimeoutSeconds, Slot, Entry.Generation });
+	}
+	return true;
+}
+
+bool FLobbyRequestTracker::Complete(FLobbyResponse& NewResponse, double NewNow)
+{
+	int32 Slot = INDEX_NONE;
+	if (!SlotByRequestId.RemoveAndCopyValue(NewResponse.RequestId, Slot))
+	{
+		return false;
+	}
+
+	const ELobbyActionType Action = Entries[Slot].Action;
+	const EMongoDBActionType DbAction = Entries[Slot].DbAction;
+	FOnLobbyResponseNative OnResponse = ReleaseSlot(Slot, NewResponse, NewNow);
+	ActionLatency.FindOrAdd(Action).Add(NewResponse.RoundTripSeconds);
+	if (DbAction != EMongoDBActionType::NONE)
+	{
+		DBActionLatency.FindOrAdd(DbAction).Add(NewResponse.RoundTripSeconds);
+	}
+	OnResponse.ExecuteIfBound(NewResponse);
+	return true;
+}
+
+FLobbyLatencyStats FLobbyRequestTracker::GetLatencyStats(ELobbyActionType NewAction) const
+{
+	const FLobbyLatencyHistogram* Histogram = ActionLatency.Find(NewAction);
+	return Histogram ? Histogram->GetStats() : FLobbyLatencyStats();
+}
+
+FLobbyLatencyStats FLobbyRequestTracker::GetDBLatencyStats(EMongoDBActionType NewDbAction) const
+{
+	const FLobbyLatencyHistogram* Histogram = DBActionLatency.Find(NewDbAction);
+	return Histogram ? Histogram->GetStats() : FLobbyLatencyStats();
+}
+
+void FLobbyRequestTracker::ResetLatencyStats()
+{
+	ActionLatency.Reset();
+	DBActionLatency.Reset();
+}
+
+bool FLobbyRequestTracker::Fail(const FString& NewRequestId, ELobbyRequestStatus NewStatus, const FString& NewError, double NewNow)
+{
+	int32 Slot = INDEX_NONE;
+	if (!SlotByRequestId.RemoveAndCopyValue(NewRequestId, Slot))
+	{
+		return false;
+	}
+
+	FLobbyResponse Response;
+	Response.Status = NewStatus;
+	Response.Error = NewError;
+	FOnLobbyResponseNative OnResponse = ReleaseSlot(Slot, Response, NewNow);
+	OnResponse.ExecuteIfBound(Response);
+	return true;
+}
+
+void FLobbyRequestTracker::ExpireTimedOut(double NewNow)
+{
+	TArray<TPair<FOnLobbyResponseNative, FLobbyResponse>, TInlineAllocator<8>> Expired;
+	while (DeadlineHeap.Num() > 0 && DeadlineHeap.HeapTop().Deadline <= NewNow)
+	{
+		FDeadline Deadline;
+		DeadlineHeap.HeapPop(Deadline, EAllowShrinking::No);
+
+		FEntry& Entry = Entries[Deadline.Slot];
+		if (!Entry.bInUse || Entry.Generation != Deadline.Generation)
+		{
+			// The request already completed, the record is stale
+			continue;
+		}
+
+		SlotByRequestId.Remove(Entry.RequestId);
+		FLobbyResponse Response;
+		Response.Status = ELobbyRequestStatus::TIMED_OUT;
+		Response.Error = TEXT("The request timed out.");
+		FOnLobbyResponseNative OnResponse = ReleaseSlot(Deadline.Slot, Response, NewNow);
+		Expired.Emplace(MoveTemp(OnResponse), MoveTemp(Response));
+	}
+
+	// Callbacks may send new requests, so they run after the table is consistent again
+	for (TPair<FOnLobbyResponseNative, FLobbyResponse>& Pair : Expired)
+	{
+		Pair.Key.ExecuteIfBound(Pair.Value);
+	}
+}
+
+void FLobbyRequestTracker::FailAll(ELobbyRequestStatus NewStatus, const FString& NewError, double NewNow)
+{
+	TArray<FString> RequestIds;
+	SlotByRequestId.GenerateKeyArray(RequestIds);
+	for (const FString& RequestId : RequestIds)
+	{
+		Fail(RequestId, NewStatus, NewError, NewNow);
+	}
+}
+
+TFuture<FLobbyResponse> FLobbyRequestTracker::MakeResponseFuture(FOnLobbyResponseNative& OutOnResponse)
+{
+	TSharedRef<TPromise<FLobbyResponse>> Promise = MakeShared<TPromise<FLobbyResponse>>();
+	OutOnResponse = FOnLobbyResponseNative::CreateLambda([Promise](const FLobbyResponse& NewResponse)
+	{
+		Promise->SetValue(NewResponse);
+	});
+	return Promise->GetFuture();
+}
+
+int32 FLobbyRequestTracker::AllocateSlot()
+{
+	int32 Slot = FirstFree;
+	if (Slot != INDEX_NONE)
+	{
+		FirstFree = Entries[Slot].NextFree;
+	}
+	else
+	{
+		Slot = Entries.AddDefaulted();
+	}
+
+	Entries[Slot].NextFree = INDEX_NONE;
+	Entries[Slot].bInUse = true;
+	return Slot;
+}
+
+FOnLobbyResponseNative FLobbyRequestTracker::ReleaseSlot(int32 NewSlot, FLobbyResponse& OutResponse, double NewNow)
+{
+	FEntry& Entry = Entries[NewSlot];
+	OutResponse.RequestId = MoveTemp(Entry.RequestId);
+	if (OutResponse.Action == ELobbyActionType::NONE)
+	{
+		OutResponse.Action = Entry.Action;
+	}
+	OutResponse.RoundTripSeconds = static_cast<float>(NewNow - Entry.SendTime);
+
+	FOnLobbyResponseNative R_OnResponse = MoveTemp(Entry.OnResponse);
+	Entry.OnResponse.Unbind();
+	Entry.RequestId.Reset();
+	Entry.bInUse = false;
+	++Entry.Generation;
+	Entry.NextFree = FirstFree;
+	FirstFree = NewSlot;
+
+	if (DeadlineHeap.Num() > 64 && DeadlineHeap.Num() > SlotByRequestId.Num() * 4)
+	{
+		CompactDeadlines();
+	}
+	return R_OnResponse;
+}
+
+void FLobbyRequestTracker::CompactDeadlines()
+{
+	// Drop the records of requests that completed before their deadline
+	DeadlineHeap.RemoveAllSwap([this](const FDeadline& Deadline)
+	{
+		const FEntry& Entry = Entries[Deadline.Slot];
+		return !Entry.bInUse || Entry.Generation != Deadline.Generation;
+	}, EAllowShrinking::No);
+	DeadlineHeap.Heapify();
+}
@@ -0,0 +1,119 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "LobbyTypes.h"
+#include "LobbyStats.h"
+
+/**
+ * In-flight requests keyed by requestId. Slots are recycled through a free list and
+ * deadlines live in a lazily cleaned min-heap, so adding and completing a request
+ * does not depend on how many requests are outstanding.
+ */
+class LOBBYCLIENT_API FLobbyRequestTracker
+{
+public:
+
+	/**
+	 * Track a request before it is sent. NewTimeoutSeconds <= 0 means the request never times out.
+	 * Returns false and leaves NewOnResponse untouched if the request id is empty or already in flight,
+	 * the request must then not be sent. NewDbAction of a DATABASE request counts its round trip under it as well.
+	 */
+	bool Add(const FString& NewRequestId, ELobbyActionType NewAction, double NewNow, double NewTimeoutSeconds, FOnLobbyResponseNative&& NewOnResponse, EMongoDBActionType NewDbAction = EMongoDBActionType::NONE);
+
+	/**
+	 * Complete the request NewResponse answers. Returns false if nothing waits for it.
+	 */
+	bool Complete(FLobbyResponse& NewResponse, double NewNow);
+
+	/**
+	 * Finish the request without a response, for example when it could not be sent.
+	 */
+	bool Fail(const FString& NewRequestId, ELobbyRequestStatus NewStatus, const FString& NewError, double NewNow);
+
+	/**
+	 * Time out every request whose deadline is at or before NewNow.
+	 */
+	void ExpireTimedOut(double NewNow);
+
+	/**
+	 * Finish every outstanding request with NewStatus.
+	 */
+	void FailAll(ELobbyRequestStatus NewStatus, const FString& NewError, double NewNow);
+
+	bool Contains(const FString& NewRequestId) const { return SlotByRequestId.Contains(NewRequestId); }
+
+	int32 Num() const { return SlotByRequestId.Num(); }
+
+	/**
+	 * The action of a tracked request, NONE if nothing waits for it
+	 */
+	ELobbyActionType GetAction(const FString& NewRequestId) const
+	{
+		const int32* Slot = SlotByRequestId.Find(NewRequestId);
+		return Slot ? Entries[*Slot].Action : ELobbyActionType::NONE;
+	}
+
+	/**
+	 * Round trips of the answered requests of NewAction
+	 */
+	FLobbyLatencyStats GetLatencyStats(ELobbyActionType NewAction) const;
+
+	FLobbyLatencyStats GetDBLatencyStats(EMongoDBActionType NewDbAction) const;
+
+	void ResetLatencyStats();
+
+	/**
+	 * Returns a delegate that fulfils the returned future when the request completes.
+	 */
+	static TFuture<FLobbyResponse> MakeResponseFuture(FOnLobbyResponseNative& OutOnResponse);
+
+private:
+
+	struct FEntry
+	{
+		FString RequestId;
+		FOnLobbyResponseNative OnResponse;
+		double SendTime = 0.0;
+		ELobbyActionType Action = ELobbyActionType::NONE;
+		EMongoDBActionType DbAction = EMongoDBActionType::NONE;
+		/**
+		 * Bumped every time the slot is released, stale heap records compare against it
+		 */
+		uint32 Generation = 0;
+		int32 NextFree = INDEX_NONE;
+		bool bInUse = false;
+	};
+
+	struct FDeadline
+	{
+		double Deadline;
+		int32 Slot;
+		uint32 Generation;
+
+		bool operator<(const FDeadline& Other) const { return Deadline < Other.Deadline; }
+	};
+
+	int32 AllocateSlot();
+
+	/**
+	 * Release the slot and hand back its delegate so the caller can fire it after the table is consistent
+	 */
+	FOnLobbyResponseNative ReleaseSlot(int32 NewSlot, FLobbyResponse& OutResponse, double NewNow);
+
+	void CompactDeadlines();
+
+	TArray<FEntry> Entries;
+
+	int32 FirstFree = INDEX_NONE;
+
+	TMap<FString, int32> SlotByRequestId;
+
+	TArray<FDeadline> DeadlineHeap;
+
+	TMap<ELobbyActionType, FLobbyLatencyHistogram> ActionLatency;
+
+	TMap<EMongoDBActionType, FLobbyLatencyHistogram> DBActionLatency;
+};
@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LobbySendQueue.h"
+
+void FLobbySendQueue::Enqueue(const FString& NewRequestId, double NewNow, FLobbyEnvelope::FWritePayload NewWriteEnvelope, bool bNewRetain)
+{
+	if (IsEmpty())
+	{
+		OldestEnqueueTime = NewNow;
+	}
+
+	{
+		FLobbyJsonWriter Writer(Envelopes);
+		NewWriteEnvelope(Writer);
+	}
+	EnvelopeEnds.Add(Envelopes.Num());
+	RequestIds.Add(NewRequestId);
+	BsonEnvelopes.Add(false);
+	RetainedEnvelopes.Add(bNewRetain);
+}
+
+void FLobbySendQueue::Enqueue(const FString& NewRequestId, double NewNow, FUtf8StringView NewEnvelope, bool bNewBson, bool bNewRetain)
+{
+	if (IsEmpty())
+	{
+		OldestEnqueueTime = NewNow;
+	}
+
+	Envelopes.Append(NewEnvelope.GetData(), NewEnvelope.Len());
+	EnvelopeEnds.Add(Envelopes.Num());
+	RequestIds.Add(NewRequestId);
+	BsonEnvelopes.Add(bNewBson);
+	RetainedEnvelopes.Add(bNewRetain);
+}
+
+void FLobbySendQueue::WriteBody(FLobbyJsonWriter& NewWriter) const
+{
+	check(BsonEnvelopes.Find(true) == INDEX_NONE);
+	if (EnvelopeEnds.Num() == 1)
+	{
+		NewWriter.WriteRawValue(FUtf8StringView(Envelopes.GetData(), Envelopes.Num()));
+		return;
+	}
+
+	NewWriter.BeginArray();
+	int32 Start = 0;
+	for (const int32 End : EnvelopeEnds)
+	{
+		NewWriter.WriteRawValue(FUtf8StringView(Envelopes.GetData() + Start, End - Start));
+		Start = End;
+	}
+	NewWriter.EndArray();
+}
+
+void FLobbySendQueue::RemoveFirst(int32 NewCount)
+{
+	if (NewCount >= RequestIds.Num())
+	{
+		Reset();
+		return;
+	}
+	if (NewCount <= 0)
+	{
+		return;
+	}
+
+	const int32 RemovedBytes = EnvelopeEnds[NewCount - 1];
+	Envelopes.RemoveAt(0, RemovedBytes, EAllowShrinking::No);
+	EnvelopeEnds.RemoveAt(0, NewCount, EAllowShrinking::No);
+	for (int32& End : EnvelopeEnds)
+	{
+		End -= RemovedBytes;
+	}
+	RequestIds.RemoveAt(0, NewCount, EAllowShrinking::No);
+	BsonEnvelopes.RemoveAt(0, NewCount);
+	RetainedEnvelopes.RemoveAt(0, NewCount);
+}
+
+void FLobbySendQueue::Reset()
+{
+	Envelopes.Reset();
+	EnvelopeEnds.Reset();
+	RequestIds.Reset();
+	BsonEnvelopes.Reset();
+	RetainedEnvelopes.Reset();
+	OldestEnqueueTime = 0.0;
+}
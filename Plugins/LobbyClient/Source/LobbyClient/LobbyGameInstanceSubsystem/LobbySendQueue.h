@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LobbyEnvelope.h"
+
+/**
+ * Envelopes waiting to go out in one batch frame. Each envelope is serialized once when it is queued,
+ * the batch body is a JSON array of them. A batch of one is written as the bare envelope, byte for byte
+ * what an unbatched send produces. The offline queue and the priority lanes also hold BSON envelopes,
+ * those are never written as a batch.
+ */
+class LOBBYCLIENT_API FLobbySendQueue
+{
+public:
+
+	/**
+	 * Serialize the envelope NewWriteEnvelope writes to the end of the queue
+	 */
+	void Enqueue(const FString& NewRequestId, double NewNow, FLobbyEnvelope::FWritePayload NewWriteEnvelope, bool bNewRetain = false);
+
+	/**
+	 * Queue an envelope that is already serialized. bNewRetain records whether it is kept until answered once it is sent.
+	 */
+	void Enqueue(const FString& NewRequestId, double NewNow, FUtf8StringView NewEnvelope, bool bNewBson = false, bool bNewRetain = false);
+
+	/**
+	 * Write the queued envelopes as one frame body
+	 */
+	void WriteBody(FLobbyJsonWriter& NewWriter) const;
+
+	/**
+	 * Drop the queued envelopes, the buffers are kept for the next batch
+	 */
+	void Reset();
+
+	/**
+	 * Drop the oldest NewCount envelopes, the enqueue time stays the one of the first envelope ever queued
+	 */
+	void RemoveFirst(int32 NewCount);
+
+	bool IsEmpty() const { return RequestIds.IsEmpty(); }
+
+	int32 Num() const { return RequestIds.Num(); }
+
+	int32 NumBytes() const { return Envelopes.Num(); }
+
+	/**
+	 * Enqueue time of the first envelope, only meaningful if the queue is not empty
+	 */
+	double GetOldestEnqueueTime() const { return OldestEnqueueTime; }
+
+	const TArray<FString>& GetRequestIds() const { return RequestIds; }
+
+	bool IsBson(int32 NewIndex) const { return BsonEnvelopes[NewIndex]; }
+
+	bool IsRetained(int32 NewIndex) const { return RetainedEnvelopes[NewIndex]; }
+
+	FUtf8StringView GetEnvelope(int32 NewIndex) const
+	{
+		const int32 Start = NewIndex > 0 ? EnvelopeEnds[NewIndex - 1] : 0;
+		return FUtf8StringView(Envelopes.GetData() + Start, EnvelopeEnds[NewIndex] - Start);
+	}
+
+private:
+
+	/**
+	 * The serialized envelopes back to back
+	 */
+	TArray<UTF8CHAR> Envelopes;
+
+	/**
+	 * End offset of every envelope in Envelopes
+	 */
+	TArray<int32> EnvelopeEnds;
+
+	TArray<FString> RequestIds;
+
+	/**
+	 * One bit per envelope, set for BSON
+	 */
+	TBitArray<> BsonEnvelopes;
+
+	/**
+	 * One bit per envelope, set for idempotent requests that are kept for replay
+	 */
+	TBitArray<> RetainedEnvelopes;
+
+	double OldestEnqueueTime = 0.0;
+};
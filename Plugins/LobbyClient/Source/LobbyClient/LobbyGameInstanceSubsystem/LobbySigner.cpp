@@ -0,0 +1,112 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LobbySigner.h"
+#include "LobbyFrame.h"
+#include "LobbyStats.h"
+
+namespace OpenSSLWrapper
+{
+	#include "openssl/hmac.h"
+	#include "openssl/evp.h"
+}
+
+namespace
+{
+	const ANSICHAR HexDigits[] = "0123456789abcdef";
+}
+
+FLobbySigner::FLobbySigner()
+	: KeyContext(OpenSSLWrapper::HMAC_CTX_new())
+	, WorkContext(OpenSSLWrapper::HMAC_CTX_new())
+{
+}
+
+FLobbySigner::~FLobbySigner()
+{
+	OpenSSLWrapper::HMAC_CTX_free(KeyContext);
+	OpenSSLWrapper::HMAC_CTX_free(WorkContext);
+}
+
+void FLobbySigner::SetKey(const FString& NewClientSecret, const FString& NewClientId)
+{
+	FTCHARToUTF8 SecretUtf8(*NewClientSecret, NewClientSecret.Len());
+	bHasKey = OpenSSLWrapper::HMAC_Init_ex(KeyContext, SecretUtf8.Get(), SecretUtf8.Length(), OpenSSLWrapper::EVP_sha256(), nullptr) == 1;
+
+	FTCHARToUTF8 ClientIdConverter(*NewClientId, NewClientId.Len());
+	ClientIdUtf8.Reset();
+	ClientIdUtf8.Append(reinterpret_cast<const UTF8CHAR*>(ClientIdConverter.Get()), ClientIdConverter.Length());
+
+	KeyedClientSecret = NewClientSecret;
+	KeyedClientId = NewClientId;
+}
+
+bool FLobbySigner::IsKeyedFor(const FString& NewClientSecret, const FString& NewClientId) const
+{
+	return bHasKey
+		&& KeyedClientSecret.Equals(NewClientSecret, ESearchCase::CaseSensitive)
+		&& KeyedClientId.Equals(NewClientId, ESearchCase::CaseSensitive);
+}
+
+bool FLobbySigner::Sign(int64 NewTimestamp, FUtf8StringView NewBody, UTF8CHAR* OutSignature)
+{
+	SCOPE_CYCLE_COUNTER(STAT_LobbySign);
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Lobby_Sign, LobbyChannel);
+	if (!bHasKey)
+	{
+		return false;
+	}
+
+	UTF8CHAR TimestampDigits[24];
+	const int32 TimestampLength = FLobbyFrameWriter::FormatTimestamp(NewTimestamp, TimestampDigits);
+
+	// Copying the keyed state reuses the digest buffers of WorkContext after the first call
+	if (OpenSSLWrapper::HMAC_CTX_copy(WorkContext, KeyContext) != 1)
+	{
+		return false;
+	}
+	OpenSSLWrapper::HMAC_Update(WorkContext, reinterpret_cast<const unsigned char*>(ClientIdUtf8.GetData()), ClientIdUtf8.Num());
+	OpenSSLWrapper::HMAC_Update(WorkContext, reinterpret_cast<const unsigned char*>(TimestampDigits), TimestampLength);
+	OpenSSLWrapper::HMAC_Update(WorkContext, reinterpret_cast<const unsigned char*>(NewBody.GetData()), NewBody.Len());
+
+	unsigned char Digest[SIGNATURE_LENGTH / 2];
+	unsigned int DigestLength = 0;
+	if (OpenSSLWrapper::HMAC_Final(WorkContext, Digest, &DigestLength) != 1 || DigestLength != sizeof(Digest))
+	{
+		return false;
+	}
+
+	for (int32 i = 0; i < static_cast<int32>(DigestLength); ++i)
+	{
+		OutSignature[i * 2] = static_cast<UTF8CHAR>(HexDigits[Digest[i] >> 4]);
+		OutSignature[i * 2 + 1] = static_cast<UTF8CHAR>(HexDigits[Digest[i] & 0x0F]);
+	}
+	return true;
+}
+
+bool FLobbySigner::Verify(int64 NewTimestamp, FUtf8StringView NewBody, FUtf8StringView NewReceivedSignature)
+{
+	SCOPE_CYCLE_COUNTER(STAT_LobbyVerify);
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Lobby_Verify, LobbyChannel);
+	if (NewReceivedSignature.Len() != SIGNATURE_LENGTH)
+	{
+		return false;
+	}
+
+	UTF8CHAR Expected[SIGNATURE_LENGTH];
+	if (!Sign(NewTimestamp, NewBody, Expected))
+	{
+		return false;
+	}
+
+	// Every character is compared so the time taken does not reveal the first mismatch. Only 'A' to 'F' are
+	// lowercased, any other byte keeps its value and can match nothing but itself in the lowercase hex expected.
+	uint8 Difference = 0;
+	for (int32 i = 0; i < SIGNATURE_LENGTH; ++i)
+	{
+		const uint8 Received = static_cast<uint8>(NewReceivedSignature[i]);
+		const uint8 UpperHexBit = static_cast<uint8>(static_cast<uint8>(Received - 'A') < 6) << 5;
+		Difference |= static_cast<uint8>(Received | UpperHexBit) ^ static_cast<uint8>(Expected[i]);
+	}
+	return Difference == 0;
+}
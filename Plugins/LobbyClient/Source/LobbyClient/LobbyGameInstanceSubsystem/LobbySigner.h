@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+namespace OpenSSLWrapper
+{
+	struct hmac_ctx_st;
+}
+
+/**
+ * HMAC-SHA256 signer for one connection. The keyed state is built once in SetKey and copied
+ * for every signature, the client id, timestamp and body are fed to the digest piece by piece.
+ * Not thread safe, give every thread its own signer.
+ */
+class LOBBYCLIENT_API FLobbySigner
+{
+public:
+
+	/**
+	 * Hex characters of a SHA-256 signature
+	 */
+	static constexpr int32 SIGNATURE_LENGTH = 64;
+
+	FLobbySigner();
+
+	~FLobbySigner();
+
+	FLobbySigner(const FLobbySigner&) = delete;
+	FLobbySigner& operator=(const FLobbySigner&) = delete;
+
+	/**
+	 * Convert the secret once and precompute the keyed HMAC state.
+	 */
+	void SetKey(const FString& NewClientSecret, const FString& NewClientId);
+
+	bool HasKey() const { return bHasKey; }
+
+	/**
+	 * True if the signer was keyed with exactly this secret and client id
+	 */
+	bool IsKeyedFor(const FString& NewClientSecret, const FString& NewClientId) const;
+
+	/**
+	 * Write the lowercase hex signature of ClientId + Timestamp + Body into OutSignature.
+	 */
+	bool Sign(int64 NewTimestamp, FUtf8StringView NewBody, UTF8CHAR* OutSignature);
+
+	/**
+	 * Constant-time, allocation-free comparison against a received signature, hex case is ignored.
+	 */
+	bool Verify(int64 NewTimestamp, FUtf8StringView NewBody, FUtf8StringView NewReceivedSignature);
+
+	/**
+	 * The client id as UTF-8, the same bytes that start every outgoing frame
+	 */
+	FUtf8StringView GetClientIdUtf8() const { return FUtf8StringView(ClientIdUtf8.GetData(), ClientIdUtf8.Num()); }
+
+private:
+
+	OpenSSLWrapper::hmac_ctx_st* KeyContext = nullptr;
+
+	OpenSSLWrapper::hmac_ctx_st* WorkContext = nullptr;
+
+	TArray<UTF8CHAR> ClientIdUtf8;
+
+	FString KeyedClientSecret;
+
+	FString KeyedClientId;
+
+	bool bHasKey = false;
+};
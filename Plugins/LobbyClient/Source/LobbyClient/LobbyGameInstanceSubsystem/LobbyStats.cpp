@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LobbyStats.h"
+
+DEFINE_STAT(STAT_LobbyCookAndSend);
+DEFINE_STAT(STAT_LobbyMessageReceived);
+DEFINE_STAT(STAT_LobbyProcessFrame);
+DEFINE_STAT(STAT_LobbyDecodeBody);
+DEFINE_STAT(STAT_LobbySign);
+DEFINE_STAT(STAT_LobbyVerify);
+DEFINE_STAT(STAT_LobbyMessagesSent);
+DEFINE_STAT(STAT_LobbyMessagesReceived);
+DEFINE_STAT(STAT_LobbyBytesSent);
+DEFINE_STAT(STAT_LobbyBytesReceived);
+
+CSV_DEFINE_CATEGORY_MODULE(LOBBYCLIENT_API, Lobby, false);
+
+UE_TRACE_CHANNEL_DEFINE(LobbyChannel);
+
+void FLobbyLatencyHistogram::Add(double NewSeconds)
+{
+	const double Milliseconds = FMath::Max(NewSeconds * 1000.0, 0.0);
+	int32 Index = 0;
+	if (Milliseconds > MIN_MILLISECONDS)
+	{
+		Index = FMath::Min(FMath::CeilToInt32(FMath::Loge(Milliseconds / MIN_MILLISECONDS) / FMath::Loge(BUCKET_GROWTH)), NUM_BUCKETS - 1);
+	}
+	++Buckets[Index];
+	++Count;
+	SumMilliseconds += Milliseconds;
+	MaxMilliseconds = FMath::Max(MaxMilliseconds, Milliseconds);
+}
+
+FLobbyLatencyStats FLobbyLatencyHistogram::GetStats() const
+{
+	FLobbyLatencyStats R_Stats;
+	R_Stats.Count = Count;
+	if (Count > 0)
+	{
+		R_Stats.P50Milliseconds = static_cast<float>(GetPercentile(0.5));
+		R_Stats.P99Milliseconds = static_cast<float>(GetPercentile(0.99));
+		R_Stats.MaxMilliseconds = static_cast<float>(MaxMilliseconds);
+		R_Stats.MeanMilliseconds = static_cast<float>(SumMilliseconds / Count);
+	}
+	return R_Stats;
+}
+
+void FLobbyLatencyHistogram::Reset()
+{
+	*this = FLobbyLatencyHistogram();
+}
+
+double FLobbyLatencyHistogram::GetBucketBound(int32 NewIndex)
+{
+	return MIN_MILLISECONDS * FMath::Pow(BUCKET_GROWTH, static_cast<double>(NewIndex));
+}
+
+double FLobbyLatencyHistogram::GetPercentile(double NewFraction) const
+{
+	const int64 Wanted = FMath::Max<int64>(1, static_cast<int64>(FMath::CeilToDouble(NewFraction * Count)));
+	int64 Seen = 0;
+	for (int32 Index = 0; Index < NUM_BUCKETS; ++Index)
+	{
+		Seen += Buckets[Index];
+		if (Seen >= Wanted)
+		{
+			// The last bucket is open ended, and no bound says more than the slowest request
+			return FMath::Min(GetBucketBound(Index), MaxMilliseconds);
+		}
+	}
+	return MaxMilliseconds;
+}
@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Trace/Trace.h"
+#include "LobbyTypes.h"
+
+/**
+ * "stat Lobby" shows the time spent framing, signing, verifying and decoding, and the messages and bytes
+ * of the current frame. Compiled out without STATS.
+ */
+DECLARE_STATS_GROUP(TEXT("Lobby"), STATGROUP_Lobby, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Cook and send"), STAT_LobbyCookAndSend, STATGROUP_Lobby, LOBBYCLIENT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Message received"), STAT_LobbyMessageReceived, STATGROUP_Lobby, LOBBYCLIENT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Process frame"), STAT_LobbyProcessFrame, STATGROUP_Lobby, LOBBYCLIENT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Decode body"), STAT_LobbyDecodeBody, STATGROUP_Lobby, LOBBYCLIENT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Sign"), STAT_LobbySign, STATGROUP_Lobby, LOBBYCLIENT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Verify"), STAT_LobbyVerify, STATGROUP_Lobby, LOBBYCLIENT_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Messages sent"), STAT_LobbyMessagesSent, STATGROUP_Lobby, LOBBYCLIENT_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Messages received"), STAT_LobbyMessagesReceived, STATGROUP_Lobby, LOBBYCLIENT_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Bytes sent"), STAT_LobbyBytesSent, STATGROUP_Lobby, LOBBYCLIENT_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Bytes received"), STAT_LobbyBytesReceived, STATGROUP_Lobby, LOBBYCLIENT_API);
+
+/**
+ * The same counters per frame in CSV captures, recorded only with -csvCategories=Lobby
+ */
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(LOBBYCLIENT_API, Lobby);
+
+/**
+ * Insights scopes of the lobby client, traced only with -trace=cpu,Lobby
+ */
+UE_TRACE_CHANNEL_EXTERN(LobbyChannel, LOBBYCLIENT_API);
+
+/**
+ * Round trip times of one kind of request, in buckets 10% wide from 0.1 ms to about a minute.
+ * Percentiles are read from the bucket bounds, so they are within 10% of the exact value. Not thread safe.
+ */
+class LOBBYCLIENT_API FLobbyLatencyHistogram
+{
+public:
+
+	void Add(double NewSeconds);
+
+	FLobbyLatencyStats GetStats() const;
+
+	void Reset();
+
+private:
+
+	static constexpr int32 NUM_BUCKETS = 140;
+
+	static constexpr double MIN_MILLISECONDS = 0.1;
+
+	static constexpr double BUCKET_GROWTH = 1.1;
+
+	/**
+	 * Bucket Index holds the times above the bound of Index - 1 up to its own
+	 */
+	static double GetBucketBound(int32 NewIndex);
+
+	double GetPercentile(double NewFraction) const;
+
+	uint32 Buckets[NUM_BUCKETS] = {};
+
+	int64 Count = 0;
+
+	double SumMilliseconds = 0.0;
+
+	double MaxMilliseconds = 0.0;
+};
@@ -0,0 +1,108 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LobbySyncTracker.h"
+#include "LobbyJsonWriter.h"
+#include "LobbyEnumNames.h"
+
+FLobbySyncTracker::EObserveResult FLobbySyncTracker::Observe(ELobbySyncStream NewStream, int64 NewSequence)
+{
+	FStream& Stream = GetStream(NewStream);
+	if (!Stream.bHasBaseline)
+	{
+		// What came before the first message was part of the state the client loaded
+		Stream.bHasBaseline = true;
+		Stream.Acknowledged = NewSequence;
+		return EObserveResult::IN_ORDER;
+	}
+
+	if (NewSequence <= Stream.Acknowledged || Stream.Ahead.Contains(NewSequence))
+	{
+		return EObserveResult::DUPLICATE;
+	}
+
+	if (NewSequence == Stream.Acknowledged + 1)
+	{
+		Stream.Acknowledged = NewSequence;
+		Advance(Stream);
+		return EObserveResult::IN_ORDER;
+	}
+
+	Stream.Ahead.Add(NewSequence);
+	if (Stream.Ahead.Num() > MAX_AHEAD)
+	{
+		int64 Oldest = MAX_int64;
+		for (const int64 Sequence : Stream.Ahead)
+		{
+			Oldest = FMath::Min(Oldest, Sequence);
+		}
+		Stream.Acknowledged = Oldest - 1;
+		Advance(Stream);
+	}
+	return EObserveResult::AHEAD;
+}
+
+void FLobbySyncTracker::Rebase(ELobbySyncStream NewStream, int64 NewSequence)
+{
+	FStream& Stream = GetStream(NewStream);
+	Stream.bHasBaseline = true;
+	Stream.Acknowledged = NewSequence;
+	Stream.Ahead.Reset();
+}
+
+int64 FLobbySyncTracker::GetAcknowledged(ELobbySyncStream NewStream) const
+{
+	return GetStream(NewStream).Acknowledged;
+}
+
+bool FLobbySyncTracker::HasGap(ELobbySyncStream NewStream) const
+{
+	return GetStream(NewStream).Ahead.Num() > 0;
+}
+
+bool FLobbySyncTracker::HasBaseline() const
+{
+	for (const FStream& Stream : Streams)
+	{
+		if (Stream.bHasBaseline)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void FLobbySyncTracker::WriteResyncPayload(FLobbyJsonWriter& NewWriter, int32 NewMaxDeltaMessages) const
+{
+	NewWriter.BeginObject();
+	NewWriter.WriteKey("streams");
+	NewWriter.BeginObject();
+	for (int32 Index = 0; Index < UE_ARRAY_COUNT(Streams); ++Index)
+	{
+		if (Streams[Index].bHasBaseline)
+		{
+			NewWriter.WriteKey(NGG_LOBBY_ENUM_NAMES::SYNC_STREAMS[Index]);
+			NewWriter.WriteInt(Streams[Index].Acknowledged);
+		}
+	}
+	NewWriter.EndObject();
+	NewWriter.WriteKey("maxDeltas");
+	NewWriter.WriteInt(FMath::Max(NewMaxDeltaMessages, 1));
+	NewWriter.EndObject();
+}
+
+void FLobbySyncTracker::Reset()
+{
+	for (FStream& Stream : Streams)
+	{
+		Stream = FStream();
+	}
+}
+
+void FLobbySyncTracker::Advance(FStream& InOutStream)
+{
+	while (InOutStream.Ahead.Remove(InOutStream.Acknowledged + 1) > 0)
+	{
+		++InOutStream.Acknowledged;
+	}
+}
@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LobbyTypes.h"
+
+class FLobbyJsonWriter;
+
+/**
+ * How far the client got in each stream the server numbers. The acknowledged sequence only moves over
+ * messages received without a hole, so after a reconnect the server sends back what is really missing.
+ * Messages past a hole are kept aside until it closes, a second copy of any of them is reported as a duplicate.
+ * Game thread only.
+ */
+class LOBBYCLIENT_API FLobbySyncTracker
+{
+public:
+
+	enum class EObserveResult : uint8
+	{
+		/**
+		 * The next message of the stream, or the first one the client sees
+		 */
+		IN_ORDER,
+		/**
+		 * Some messages before this one are missing
+		 */
+		AHEAD,
+		/**
+		 * Seen already
+		 */
+		DUPLICATE
+	};
+
+	EObserveResult Observe(ELobbySyncStream NewStream, int64 NewSequence);
+
+	/**
+	 * Move the stream to NewSequence after a snapshot, what was kept past a hole is forgotten
+	 */
+	void Rebase(ELobbySyncStream NewStream, int64 NewSequence);
+
+	int64 GetAcknowledged(ELobbySyncStream NewStream) const;
+
+	/**
+	 * True while messages past a hole wait for the ones before them
+	 */
+	bool HasGap(ELobbySyncStream NewStream) const;
+
+	/**
+	 * True once any stream received a message, before that there is nothing to catch up on
+	 */
+	bool HasBaseline() const;
+
+	/**
+	 * The RESYNC payload: {"streams":{"CHAT":12,...},"maxDeltas":500}, with the streams the client has a position in
+	 */
+	void WriteResyncPayload(FLobbyJsonWriter& NewWriter, int32 NewMaxDeltaMessages) const;
+
+	void Reset();
+
+private:
+
+	/**
+	 * Messages kept past a hole, when there are more the oldest hole is given up
+	 */
+	static constexpr int32 MAX_AHEAD = 1024;
+
+	struct FStream
+	{
+		bool bHasBaseline = false;
+
+		int64 Acknowledged = 0;
+
+		TSet<int64> Ahead;
+	};
+
+	FStream& GetStream(ELobbySyncStream NewStream) { return Streams[static_cast<int32>(NewStream)]; }
+
+	const FStream& GetStream(ELobbySyncStream NewStream) const { return Streams[static_cast<int32>(NewStream)]; }
+
+	/**
+	 * Move Acknowledged over the kept messages that follow it
+	 */
+	static void Advance(FStream& InOutStream);
+
+	FStream Streams[static_cast<int32>(ELobbySyncStream::SUBSCRIPTIONS) + 1];
+};
@@ -0,0 +1,1128 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Dom/JsonObject.h"
+#include "Dom/JsonValue.h"
+#include "LobbyTypes.generated.h"
+
+UENUM(Blueprintable)
+enum class ELobbyFramingMode : uint8
+{
+	 LEGACY						UMETA(DisplayName = "Legacy")
+	,LENGTH_PREFIXED			UMETA(DisplayName = "Length Prefixed")
+};
+
+/**
+ * How database requests are encoded, BSON needs the length-prefixed framing
+ */
+UENUM(BlueprintType)
+enum class ELobbyPayloadEncoding : uint8
+{
+	 JSON						UMETA(DisplayName = "JSON")
+	,BSON						UMETA(DisplayName = "BSON")
+};
+
+UENUM(BlueprintType)
+enum class ELobbyConnectionState : uint8
+{
+	 DISCONNECTED				UMETA(DisplayName = "Disconnected")
+	,CONNECTING					UMETA(DisplayName = "Connecting")
+	,CONNECTED					UMETA(DisplayName = "Connected")
+	,WAITING_TO_RECONNECT		UMETA(DisplayName = "Waiting To Reconnect")
+};
+
+UENUM(BlueprintType)
+enum class ELobbySendPriority : uint8
+{
+	 HIGH						UMETA(DisplayName = "High")
+	,NORMAL						UMETA(DisplayName = "Normal")
+	,BULK						UMETA(DisplayName = "Bulk")
+};
+
+UENUM(BlueprintType)
+enum class ELobbyChannel : uint8
+{
+	 PRIMARY					UMETA(DisplayName = "Primary")
+	,DATABASE					UMETA(DisplayName = "Database")
+};
+
+UENUM(Blueprintable)
+enum class ELobbyActionType : uint8
+{
+	 NONE						UMETA(DisplayName = "None")
+	,DATABASE					UMETA(DisplayName = "Data Base")
+	,TEXT_CHAT					UMETA(DisplayName = "Text Chat")
+	,FIND_PLAYER				UMETA(DisplayName = "Find Player")
+	,REGISTER_PLAYER_INTO_LOBBY UMETA(DisplayName = "Register Player")
+	,REQUEST_STATUS 			UMETA(DisplayName = "Request Status")
+	,RESYNC						UMETA(DisplayName = "Resync")
+};
+
+/**
+ * Streams the server numbers message by message, so a client coming back says how far it got in each
+ */
+UENUM(BlueprintType)
+enum class ELobbySyncStream : uint8
+{
+	 NONE						UMETA(DisplayName = "None")
+	,CHAT						UMETA(DisplayName = "Chat")
+	,LOBBY						UMETA(DisplayName = "Lobby")
+	,SUBSCRIPTIONS				UMETA(DisplayName = "Subscriptions")
+};
+
+UENUM(Blueprintable)
+enum class EMongoDBActionType : uint8
+{
+	NONE							UMETA(DisplayName = "None")
+	,AGGREGATE 						UMETA(DisplayName = "Aggregate")
+	,DROP_COLLECTION				UMETA(DisplayName = "Drop Collection")
+	,CREATE_COLLECTION				UMETA(DisplayName = "Create Collection")
+    ,FIND							UMETA(DisplayName = "Find")
+    ,FIND_WITH_OPTIONS				UMETA(DisplayName = "Find With Options")
+    ,FIND_ONE						UMETA(DisplayName = "Find One")
+	,FIND_ONE_WITH_OPTIONS			UMETA(DisplayName = "Find One With Options")
+	,INSERT_ONE						UMETA(DisplayName = "Insert One")
+	,INSERT_MANY					UMETA(DisplayName = "Insert Many")
+	,LIST_DATABASES					UMETA(DisplayName = "List Databases")
+	,LIST_COLLECTION_NAMES			UMETA(DisplayName = "List Collection Names")
+	,LIST_INDEXES					UMETA(DisplayName = "List Indexes")
+	,CREATE_INDEX					UMETA(DisplayName = "Create Index")
+	,DELETE_ONE						UMETA(DisplayName = "Delete One")
+    ,DELETE_MANY					UMETA(DisplayName = "Delete Many")
+    ,GET_ESTIMATED_DOCUMENT_COUNT	UMETA(DisplayName = "Get Estimated Document Count")	
+    ,COUNT_DOCUMENTS 				UMETA(DisplayName = "Count Documents")
+    ,RENAME_COLLECTION              UMETA(DisplayName = "Rename Collection")
+	,RUN_COMMAND					UMETA(DisplayName = "Run Command")
+	,REPLACE_ONE					UMETA(DisplayName = "Replace One")
+	,UPDATE_ONE						UMETA(DisplayName = "Update One")
+	,UPDATE_ONE_WITH_OPTIONS 		UMETA(DisplayName = "Update One With Options")
+	,UPDATE_MANY			 		UMETA(DisplayName = "Update Many")
+	,UPDATE_MANY_WITH_OPTIONS 		UMETA(DisplayName = "Update Many with Options")
+	,FIND_ONE_AND_DELETE 			UMETA(DisplayName = "Find one and delete")
+	,FIND_ONE_AND_REPLACE 			UMETA(DisplayName = "Find one and Replace")
+	,FIND_ONE_AND_UPDATE 			UMETA(DisplayName = "Find one and Update")
+	,BULK_WRITE						UMETA(DisplayName = "Bulk Write")
+	,GET_MORE						UMETA(DisplayName = "Get More")
+	,KILL_CURSOR					UMETA(DisplayName = "Kill Cursor")
+};
+
+UENUM(Blueprintable)
+enum class EMongoDBBulkOperationType : uint8
+{
+	 INSERT_ONE						UMETA(DisplayName = "Insert One")
+	,UPDATE_ONE						UMETA(DisplayName = "Update One")
+	,UPDATE_MANY					UMETA(DisplayName = "Update Many")
+	,REPLACE_ONE					UMETA(DisplayName = "Replace One")
+	,DELETE_ONE						UMETA(DisplayName = "Delete One")
+	,DELETE_MANY					UMETA(DisplayName = "Delete Many")
+};
+
+
+USTRUCT(BlueprintType, Blueprintable)
+struct FNGGLobbyData 
+{
+	GENERATED_BODY()
+
+	/**
+	* Client custom ID
+	*/
+	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "ClientID"))
+	FString ClientID = "";
+
+	/**
+	* The Lobby action type
+	*/
+	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "Action"))
+	ELobbyActionType Action = ELobbyActionType::NONE;
+
+	/**
+	* 
+	* The PayLoadData can be JSON data
+	*/
+	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "PayLoadData"))
+	FString PayLoadData = "";
+
+	/**
+	 *	The Request id  
+	 */
+	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "RequestId"))
+	FString requestId = "";
+
+
+};
+
+USTRUCT(BlueprintType, Blueprintable)
+struct FChatData
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "SenderPlayerId"))
+	FString SenderPlayerId = "";
+
+	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "Message"))
+	FString Message = "";
+
+	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "RecipientPlayerId"))
+	FString RecipientPlayerId = "";
+};
+
+USTRUCT(BlueprintType, Blueprintable)
+struct FMongoDBData
+{
+	GENERATED_BODY()
+	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "SenderPlayerId"))
+	FString SenderPlayerId = "";
+	
+	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "DbName"))
+	FString DbName = "";
+
+	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "CollectionName"))
+	FString CollectionName = "";
+
+	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "DbAction"))
+	EMongoDBActionType DbAction = EMongoDBActionType::NONE;
+
+	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "Data"))
+	FString Data = "";
+
+	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "Filter"))
+	FString Filter = "";
+
+	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "Options"))
+	FString Options = "";
+
+	/**
+	* Documents per batch for FIND, FIND_WITH_OPTIONS, AGGREGATE and GET_MORE, 0 returns the whole result at once
+	*/
+	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "BatchSize"))
+	int32 BatchSize = 0;
+
+	/**
+	* The server cursor GET_MORE and KILL_CURSOR work on
+	*/
+	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "CursorId"))
+	FString CursorId = "";
+
+	/**
+	* Documents built in C++ with FLobbyBsonWriter, used instead of Data, Filter and Options when they are not empty
+	*/
+	TArray<UTF8CHAR> DataBson;
+
+	TArray<UTF8CHAR> FilterBson;
+
+	TArray<UTF8CHAR> OptionsBson;
+};
+
+/**
+ * One write inside a bulk request. Document and Filter are JSON text like FMongoDBData::Data and Filter.
+ */
+USTRUCT(BlueprintType, Blueprintable)
+struct FMongoDBBulkOperation
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "OperationType"))
+	EMongoDBBulkOperationType OperationType = EMongoDBBulkOperationType::INSERT_ONE;
+
+	/**
+	* The inserted or replacement document, or the update for the update operations
+	*/
+	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "Document"))
+	FString Document = "";
+
+	/**
+	* Unused for inserts
+	*/
+	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "Filter"))
+	FString Filter = "";
+
+	/**
+	* Only used by updates and replaces
+	*/
+	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "Upsert"))
+	bool bUpsert = false;
+};
+
+/**
+ * Many writes to one collection sent as a single DATABASE envelope with the BULK_WRITE action.
+ * Build it with the chained helpers below in C++ or with UMongoDBBulkLibrary in Blueprint.
+ */
+USTRUCT(BlueprintType, Blueprintable)
+struct FMongoDBBulkData
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "SenderPlayerId"))
+	FString SenderPlayerId = "";
+
+	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "DbName"))
+	FString DbName = "";
+
+	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "CollectionName"))
+	FString CollectionName = "";
+
+	/**
+	* Ordered bulks stop at the first failed operation, unordered ones try every operation
+	*/
+	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "Ordered"))
+	bool bOrdered = true;
+
+	UPROPERTY(BlueprintReadWrite, Meta = (DisplayName = "Operations"))
+	TArray<FMongoDBBulkOperation> Operations;
+
+	FMongoDBBulkData& InsertOne(const FString& NewDocument)
+	{
+		return AddOperation(EMongoDBBulkOperationType::INSERT_ONE, NewDocument, FString(), false);
+	}
+
+	FMongoDBBulkData& UpdateOne(const FString& NewFilter, const FString& NewUpdate, bool bNewUpsert = false)
+	{
+		return AddOperation(EMongoDBBulkOperationType::UPDATE_ONE, NewUpdate, NewFilter, bNewUpsert);
+	}
+
+	FMongoDBBulkData& UpdateMany(const FString& NewFilter, const FString& NewUpdate, bool bNewUpsert = false)
+	{
+		return AddOperation(EMongoDBBulkOperationType::UPDATE_MANY, NewUpdate, NewFilter, bNewUpsert);
+	}
+
+	FMongoDBBulkData& ReplaceOne(const FString& NewFilter, const FString& NewDocument, bool bNewUpsert = false)
+	{
+		return AddOperation(EMongoDBBulkOperationType::REPLACE_ONE, NewDocument, NewFilter, bNewUpsert);
+	}
+
+	FMongoDBBulkData& DeleteOne(const FString& NewFilter)
+	{
+		return AddOperation(EMongoDBBulkOperationType::DELETE_ONE, FString(), NewFilter, false);
+	}
+
+	FMongoDBBulkData& DeleteMany(const FString& NewFilter)
+	{
+		return AddOperation(EMongoDBBulkOperationType::DELETE_MANY, FString(), NewFilter, false);
+	}
+
+	FMongoDBBulkData& AddOperation(EMongoDBBulkOperationType NewOperationType, const FString& NewDocument, const FString& NewFilter, bool bNewUpsert)
+	{
+		FMongoDBBulkOperation& Operation = Operations.AddDefaulted_GetRef();
+		Operation.OperationType = NewOperationType;
+		Operation.Document = NewDocument;
+		Operation.Filter = NewFilter;
+		Operation.bUpsert = bNewUpsert;
+		return *this;
+	}
+
+	int32 Num() const { return Operations.Num(); }
+
+	/**
+	* Empty the operation list, for example after committing it
+	*/
+	void Reset() { Operations.Reset(); }
+};
+
+/**
+ * Outcome of one operation of a bulk request, in the order the operations were added
+ */
+USTRUCT(BlueprintType, Blueprintable)
+struct FMongoDBBulkOperationResult
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "Index"))
+	int32 Index = INDEX_NONE;
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "Succeeded"))
+	bool bSucceeded = false;
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "Error"))
+	FString Error = "";
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "InsertedId"))
+	FString InsertedId = "";
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "UpsertedId"))
+	FString UpsertedId = "";
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "MatchedCount"))
+	int32 MatchedCount = 0;
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "ModifiedCount"))
+	int32 ModifiedCount = 0;
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "DeletedCount"))
+	int32 DeletedCount = 0;
+};
+
+/**
+ * payLoadData of a BULK_WRITE response. Operations an ordered bulk never reached have no result.
+ */
+USTRUCT(BlueprintType, Blueprintable)
+struct FMongoDBBulkResult
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "Results"))
+	TArray<FMongoDBBulkOperationResult> Results;
+};
+
+USTRUCT(BlueprintType)
+struct FJsonValueStruct
+{
+    GENERATED_BODY()
+
+public:
+    // The type of JSON value
+    EJson Type = EJson::None;
+
+    // Stored value
+    TSharedPtr<FJsonValue> JsonValue;
+
+    // Default constructor
+    FJsonValueStruct()
+        : Type(EJson::None), JsonValue(nullptr) {}
+
+    // Initialize with a shared JSON value
+	explicit FJsonValueStruct(TSharedPtr<FJsonValue> InValue)
+	: Type(InValue.IsValid() ? InValue->Type : EJson::None), JsonValue(InValue) {}
+    // Factory methods to create JSON values
+    static FJsonValueStruct FromBool(bool Value)
+    {
+        return FJsonValueStruct(MakeShared<FJsonValueBoolean>(Value));
+    }
+
+    static FJsonValueStruct FromInt(int32 Value)
+    {
+        return FJsonValueStruct(MakeShared<FJsonValueNumber>(static_cast<double>(Value)));
+    }
+
+    static FJsonValueStruct FromFloat(float Value)
+    {
+        return FJsonValueStruct(MakeShared<FJsonValueNumber>(static_cast<double>(Value)));
+    }
+
+    static FJsonValueStruct FromString(const FString& Value)
+    {
+        return FJsonValueStruct(MakeShared<FJsonValueString>(Value));
+    }
+
+    static FJsonValueStruct FromArray(const TArray<TSharedPtr<FJsonValue>>& Array)
+    {
+        return FJsonValueStruct(MakeShared<FJsonValueArray>(Array));
+    }
+
+    static FJsonValueStruct FromObject(const TSharedPtr<FJsonObject>& Object)
+    {
+        return FJsonValueStruct(MakeShared<FJsonValueObject>(Object));
+    }
+
+    // Type-checking methods
+    bool IsNull() const { return Type == EJson::None; }
+    bool IsBool() const { return Type == EJson::Boolean; }
+    bool IsNumber() const { return Type == EJson::Number; }
+    bool IsString() const { return Type == EJson::String; }
+    bool IsArray() const { return Type == EJson::Array; }
+    bool IsObject() const { return Type == EJson::Object; }
+
+    // Conversion methods
+    bool ToBool() const
+    {
+        return JsonValue.IsValid() && JsonValue->Type == EJson::Boolean ? JsonValue->AsBool() : false;
+    }
+
+    int32 ToInt() const
+    {
+        return JsonValue.IsValid() && JsonValue->Type == EJson::Number ? static_cast<int32>(JsonValue->AsNumber()) : 0;
+    }
+
+    float ToFloat() const
+    {
+        return JsonValue.IsValid() && JsonValue->Type == EJson::Number ? static_cast<float>(JsonValue->AsNumber()) : 0.0f;
+    }
+
+    FString ToString() const
+    {
+        return JsonValue.IsValid() && JsonValue->Type == EJson::String ? JsonValue->AsString() : TEXT("");
+    }
+
+    TArray<TSharedPtr<FJsonValue>> ToArray() const
+    {
+        return JsonValue.IsValid() && JsonValue->Type == EJson::Array ? JsonValue->AsArray() : TArray<TSharedPtr<FJsonValue>>();
+    }
+
+    TSharedPtr<FJsonObject> ToObject() const
+    {
+        return JsonValue.IsValid() && JsonValue->Type == EJson::Object ? JsonValue->AsObject() : nullptr;
+    }
+};
+
+class FLobbyJsonBuilder;
+
+/**
+ * Blueprint handle of a JSON document built with ULobbyJsonLibrary. Copies of the handle write into the same document.
+ */
+USTRUCT(BlueprintType)
+struct FLobbyJsonDocument
+{
+	GENERATED_BODY()
+
+	TSharedPtr<FLobbyJsonBuilder> Builder;
+};
+
+UENUM(BlueprintType)
+enum class ELobbyRequestStatus : uint8
+{
+	 SUCCESS					UMETA(DisplayName = "Success")
+	,FAILED						UMETA(DisplayName = "Failed")
+	,TIMED_OUT					UMETA(DisplayName = "Timed Out")
+	,CANCELLED					UMETA(DisplayName = "Cancelled")
+	,REJECTED					UMETA(DisplayName = "Rejected")
+};
+
+USTRUCT(BlueprintType, Blueprintable)
+struct FLobbyResponse
+{
+	GENERATED_BODY()
+
+	/**
+	 *	The Request id the server answered, empty for messages the server pushed on its own
+	 */
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "RequestId"))
+	FString RequestId = "";
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "Action"))
+	ELobbyActionType Action = ELobbyActionType::NONE;
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "Status"))
+	ELobbyRequestStatus Status = ELobbyRequestStatus::SUCCESS;
+
+	/**
+	 *	The PayLoadData of the response, objects and arrays are kept as JSON text
+	 */
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "PayLoadData"))
+	FString PayLoadData = "";
+
+	/**
+	 *	The payload document as the server sent it when it answered in BSON, read it with FLobbyBsonView.
+	 *	PayLoadData holds the same document as JSON text.
+	 */
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "PayLoadBson"))
+	TArray<uint8> PayLoadBson;
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "Error"))
+	FString Error = "";
+
+	/**
+	 *	Seconds between sending the request and completing it, 0 for pushed messages
+	 */
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "RoundTripSeconds"))
+	float RoundTripSeconds = 0.f;
+
+	/**
+	 *	The stream a pushed message belongs to, NONE when the server does not number it
+	 */
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "Stream"))
+	ELobbySyncStream Stream = ELobbySyncStream::NONE;
+
+	/**
+	 *	Position of the message in its stream, one up per message
+	 */
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "Sequence"))
+	int64 Sequence = 0;
+};
+
+/**
+ * Outbound batching. Off by default because the server must accept a JSON array of envelopes as a frame body.
+ */
+USTRUCT(BlueprintType, Blueprintable)
+struct FLobbySendBatchConfig
+{
+	GENERATED_BODY()
+
+	/**
+	*	Queue outgoing requests and send them once per tick as one signed frame
+	*/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "Enabled"))
+	bool bEnabled = false;
+
+	/**
+	*	Send right away once this many requests are queued
+	*/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "MaxMessages", ClampMin = "1"))
+	int32 MaxMessages = 32;
+
+	/**
+	*	Send right away once the queued envelopes reach this many bytes
+	*/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "MaxBytes", ClampMin = "1"))
+	int32 MaxBytes = 16 * 1024;
+
+	/**
+	*	Send right away once the oldest queued request waited this long, for ticks slower than this
+	*/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "MaxLatencyMilliseconds", ClampMin = "0"))
+	float MaxLatencyMilliseconds = 50.f;
+};
+
+/**
+ * Client side cache for repeated database reads, off by default
+ */
+USTRUCT(BlueprintType, Blueprintable)
+struct FLobbyDBCacheConfig
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "Enabled"))
+	bool bEnabled = false;
+
+	/**
+	*	Seconds a cached read stays valid for collections without their own TTL
+	*/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "DefaultTTLSeconds", ClampMin = "0"))
+	float DefaultTTLSeconds = 5.f;
+
+	/**
+	*	TTL per collection name, 0 keeps the collection out of the cache
+	*/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "CollectionTTLSeconds"))
+	TMap<FString, float> CollectionTTLSeconds;
+
+	/**
+	*	Least recently used entries are evicted above this size
+	*/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "MaxBytes", ClampMin = "0"))
+	int32 MaxBytes = 1024 * 1024;
+};
+
+USTRUCT(BlueprintType, Blueprintable)
+struct FLobbyDBCacheStats
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "Hits"))
+	int64 Hits = 0;
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "Misses"))
+	int64 Misses = 0;
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "Evictions"))
+	int64 Evictions = 0;
+
+	/**
+	*	Collections invalidated by a write the client sent
+	*/
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "Invalidations"))
+	int64 Invalidations = 0;
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "Entries"))
+	int32 Entries = 0;
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "Bytes"))
+	int32 Bytes = 0;
+};
+
+/**
+ * Reconnect after the connection drops, and keep requests made meanwhile for replay
+ */
+USTRUCT(BlueprintType, Blueprintable)
+struct FLobbyReconnectConfig
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "Enabled"))
+	bool bEnabled = true;
+
+	/**
+	*	Upper bound of the first delay, every attempt multiplies it up to MaxDelaySeconds.
+	*	The actual delay is drawn uniformly below the bound, so clients dropped together do not come back together.
+	*/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "InitialDelaySeconds", ClampMin = "0"))
+	float InitialDelaySeconds = 1.f;
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "MaxDelaySeconds", ClampMin = "0"))
+	float MaxDelaySeconds = 30.f;
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "Multiplier", ClampMin = "1"))
+	float Multiplier = 2.f;
+
+	/**
+	*	Attempts before giving up, 0 keeps trying
+	*/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "MaxAttempts", ClampMin = "0"))
+	int32 MaxAttempts = 0;
+
+	/**
+	*	Requests made while disconnected beyond these limits fail right away
+	*/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "OfflineQueueMaxMessages", ClampMin = "0"))
+	int32 OfflineQueueMaxMessages = 256;
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "OfflineQueueMaxBytes", ClampMin = "0"))
+	int32 OfflineQueueMaxBytes = 256 * 1024;
+};
+
+/**
+ * Outgoing requests are split into priority lanes and sent under a byte budget per tick.
+ * While nothing of the same or higher priority waits and the budget lasts, a request goes out right away.
+ */
+USTRUCT(BlueprintType, Blueprintable)
+struct FLobbyOutboundConfig
+{
+	GENERATED_BODY()
+
+	/**
+	*	Bytes sent per tick and connection before requests start to wait in their lanes
+	*/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "MaxBytesPerTick", ClampMin = "1"))
+	int32 MaxBytesPerTick = 256 * 1024;
+
+	/**
+	*	Hard bound for the requests waiting on one connection, requests that do not fit are rejected
+	*/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "MaxQueuedBytes", ClampMin = "0"))
+	int32 MaxQueuedBytes = 4 * 1024 * 1024;
+
+	/**
+	*	Share of MaxQueuedBytes the normal and bulk lanes may fill, the rest is kept for the lanes above them
+	*/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "NormalAdmissionRatio", ClampMin = "0", ClampMax = "1"))
+	float NormalAdmissionRatio = 0.75f;
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "BulkAdmissionRatio", ClampMin = "0", ClampMax = "1"))
+	float BulkAdmissionRatio = 0.5f;
+
+	/**
+	*	Relative share of the budget each lane gets while several are waiting
+	*/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "HighWeight", ClampMin = "1"))
+	int32 HighWeight = 8;
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "NormalWeight", ClampMin = "1"))
+	int32 NormalWeight = 4;
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "BulkWeight", ClampMin = "1"))
+	int32 BulkWeight = 1;
+
+	/**
+	*	Overrides of the built-in priority per action, DATABASE requests use DBActionPriorities first
+	*/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "ActionPriorities"))
+	TMap<ELobbyActionType, ELobbySendPriority> ActionPriorities;
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "DBActionPriorities"))
+	TMap<EMongoDBActionType, ELobbySendPriority> DBActionPriorities;
+};
+
+/**
+ * Separate connections per channel, so a large database result does not hold back the chat behind it.
+ * Every connection is signed with the same JWTConfig, responses are matched by request id on any of them.
+ */
+USTRUCT(BlueprintType, Blueprintable)
+struct FLobbyChannelConfig
+{
+	GENERATED_BODY()
+
+	/**
+	*	All traffic shares the primary connection while this is disabled
+	*/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "Enabled"))
+	bool bEnabled = false;
+
+	/**
+	*	Connections of the database channel, each request goes to the one with the least waiting
+	*/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "DatabaseConnections", ClampMin = "1", ClampMax = "8"))
+	int32 DatabaseConnections = 1;
+
+	/**
+	*	Server of the database channel, empty uses the URL passed to ConnectToLobbyServer
+	*/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "DatabaseURL"))
+	FString DatabaseURL = "";
+
+	/**
+	*	Channel per action, DATABASE requests go to the database channel and everything else to the primary one unless listed
+	*/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "ActionChannels"))
+	TMap<ELobbyActionType, ELobbyChannel> ActionChannels;
+};
+
+/**
+ * Deflate NGG2 frame bodies above a size, off by default.
+ * The signature always covers the uncompressed body, so the server verifies what it inflated.
+ */
+USTRUCT(BlueprintType, Blueprintable)
+struct FLobbyCompressionConfig
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "Enabled"))
+	bool bEnabled = false;
+
+	/**
+	*	Smaller bodies are sent as they are
+	*/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "MinBytes", ClampMin = "0"))
+	int32 MinBytes = 1024;
+
+	/**
+	*	zlib level, 1 is the fastest and 9 the smallest
+	*/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "Level", ClampMin = "1", ClampMax = "9"))
+	int32 Level = 6;
+
+	/**
+	*	Received frames that inflate past this are dropped
+	*/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "MaxInflatedBytes", ClampMin = "1024"))
+	int32 MaxInflatedBytes = 16 * 1024 * 1024;
+
+	/**
+	*	Only compress on a connection once the server sent a compressed frame on it
+	*/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "WaitForServer"))
+	bool bWaitForServer = true;
+};
+
+USTRUCT(BlueprintType, Blueprintable)
+struct FLobbyCompressionStats
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "Messages"))
+	int64 Messages = 0;
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "RawBytes"))
+	int64 RawBytes = 0;
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "CompressedBytes"))
+	int64 CompressedBytes = 0;
+
+	/**
+	*	Compressed size over raw size
+	*/
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "Ratio"))
+	float Ratio = 1.f;
+
+	/**
+	*	Time spent deflating or inflating
+	*/
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "CpuSeconds"))
+	double CpuSeconds = 0.0;
+
+	void Add(int32 NewRawBytes, int32 NewCompressedBytes, double NewSeconds)
+	{
+		++Messages;
+		RawBytes += NewRawBytes;
+		CompressedBytes += NewCompressedBytes;
+		CpuSeconds += NewSeconds;
+		Ratio = RawBytes > 0 ? static_cast<float>(static_cast<double>(CompressedBytes) / RawBytes) : 1.f;
+	}
+};
+
+/**
+ * Round trip times of the requests of one kind that got an answer, timeouts and cancellations are not counted
+ */
+USTRUCT(BlueprintType, Blueprintable)
+struct FLobbyLatencyStats
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "Count"))
+	int64 Count = 0;
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "P50Milliseconds"))
+	float P50Milliseconds = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "P99Milliseconds"))
+	float P99Milliseconds = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "MaxMilliseconds"))
+	float MaxMilliseconds = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "MeanMilliseconds"))
+	float MeanMilliseconds = 0.f;
+};
+
+USTRUCT(BlueprintType, Blueprintable)
+struct FLobbyAllocationStats
+{
+	GENERATED_BODY()
+
+	/**
+	*	Requests written and handed to a connection
+	*/
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "SentMessages"))
+	int64 SentMessages = 0;
+
+	/**
+	*	FMalloc calls made while sending them, only counted in non-shipping builds
+	*/
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "SendAllocations"))
+	int64 SendAllocations = 0;
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "ReceivedFrames"))
+	int64 ReceivedFrames = 0;
+
+	/**
+	*	FMalloc calls made while the receive stage parsed, verified and decoded them
+	*/
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "ReceiveAllocations"))
+	int64 ReceiveAllocations = 0;
+
+	/**
+	*	Frame and retained envelope buffers served from the connection pools
+	*/
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "PoolHits"))
+	int64 PoolHits = 0;
+
+	/**
+	*	Buffers that had to start empty, the pool was cold or drained
+	*/
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "PoolMisses"))
+	int64 PoolMisses = 0;
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "AllocationsPerSend"))
+	float AllocationsPerSend = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "AllocationsPerReceive"))
+	float AllocationsPerReceive = 0.f;
+};
+
+/**
+ * Checks a received frame passes before its signature is verified, every limit is off at 0
+ */
+USTRUCT(BlueprintType, Blueprintable)
+struct FLobbyInboundGateConfig
+{
+	GENERATED_BODY()
+
+	/**
+	*	Bigger frames are invalid and close the connection
+	*/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "MaxFrameBytes", ClampMin = "0"))
+	int32 MaxFrameBytes = 16 * 1024 * 1024;
+
+	/**
+	*	Drop frames whose client id is not ours, only for servers that write it back
+	*/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "RequireClientId"))
+	bool bRequireClientId = false;
+
+	/**
+	*	Frames timestamped further from the local clock than this are dropped as stale
+	*/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "MaxClockSkewSeconds", ClampMin = "0"))
+	float MaxClockSkewSeconds = 300.f;
+
+	/**
+	*	Signatures of the last accepted frames, a frame seen again is dropped as a replay
+	*/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "RecentFrameCapacity", ClampMin = "0"))
+	int32 RecentFrameCapacity = 4096;
+};
+
+USTRUCT(BlueprintType, Blueprintable)
+struct FLobbyInboundGateStats
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "CheckedFrames"))
+	int64 CheckedFrames = 0;
+
+	/**
+	*	Frames that passed every check and their signature
+	*/
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "AcceptedFrames"))
+	int64 AcceptedFrames = 0;
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "OversizedFrames"))
+	int64 OversizedFrames = 0;
+
+	/**
+	*	Frames that could not be split into their sections
+	*/
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "MalformedFrames"))
+	int64 MalformedFrames = 0;
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "ClientIdMismatches"))
+	int64 ClientIdMismatches = 0;
+
+	/**
+	*	Timestamps outside the window or not a number
+	*/
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "StaleFrames"))
+	int64 StaleFrames = 0;
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "ReplayedFrames"))
+	int64 ReplayedFrames = 0;
+
+	/**
+	*	Frames that reached the HMAC and failed it, the only reject that cost a verification
+	*/
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "BadSignatures"))
+	int64 BadSignatures = 0;
+};
+
+/**
+ * Received chat kept per channel and per direct message peer, the oldest messages make room for new ones
+ */
+USTRUCT(BlueprintType, Blueprintable)
+struct FLobbyChatConfig
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "Enabled"))
+	bool bEnabled = true;
+
+	/**
+	*	Messages kept per channel or peer
+	*/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "MessagesPerConversation", ClampMin = "1"))
+	int32 MessagesPerConversation = 500;
+
+	/**
+	*	Channels and peers kept, the one quiet for the longest is dropped first
+	*/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "MaxConversations", ClampMin = "1"))
+	int32 MaxConversations = 64;
+
+	/**
+	*	Longer messages are cut, so the history stays bounded in bytes as well
+	*/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "MaxMessageChars", ClampMin = "1"))
+	int32 MaxMessageChars = 1024;
+};
+
+USTRUCT(BlueprintType, Blueprintable)
+struct FLobbyChatMessage
+{
+	GENERATED_BODY()
+
+	/**
+	*	One up for every message of the conversation, starting at 1
+	*/
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "Sequence"))
+	int64 Sequence = 0;
+
+	/**
+	*	Empty for the lobby wide chat and for direct messages
+	*/
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "ChannelId"))
+	FString ChannelId = "";
+
+	/**
+	*	The other player of a direct message, empty for channel messages
+	*/
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "PeerPlayerId"))
+	FString PeerPlayerId = "";
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "SenderPlayerId"))
+	FString SenderPlayerId = "";
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "Message"))
+	FString Message = "";
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "ReceivedTime"))
+	FDateTime ReceivedTime;
+};
+
+/**
+ * Catching up after a reconnect. The client sends the last sequence it has of each stream in a RESYNC request,
+ * the server pushes the messages missed since then and answers with the sequence each stream is at. A stream
+ * that fell too far behind gets a snapshot in the answer instead of its messages.
+ */
+USTRUCT(BlueprintType, Blueprintable)
+struct FLobbyResyncConfig
+{
+	GENERATED_BODY()
+
+	/**
+	*	Resync after every reconnect, and whenever a numbered message shows that some before it are missing
+	*/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "Enabled"))
+	bool bEnabled = true;
+
+	/**
+	*	Missed messages the server may push for one stream, a larger gap is answered with a snapshot
+	*/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (DisplayName = "MaxDeltaMessages", ClampMin = "1"))
+	int32 MaxDeltaMessages = 500;
+};
+
+USTRUCT(BlueprintType, Blueprintable)
+struct FLobbyResyncResult
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "Stream"))
+	ELobbySyncStream Stream = ELobbySyncStream::NONE;
+
+	/**
+	*	The missed messages were replaced by the snapshot, the state of the stream has to be rebuilt from it
+	*/
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "Snapshot"))
+	bool bSnapshot = false;
+
+	/**
+	*	Last sequence the client had when it asked
+	*/
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "FromSequence"))
+	int64 FromSequence = 0;
+
+	/**
+	*	Sequence the stream is at now
+	*/
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "ToSequence"))
+	int64 ToSequence = 0;
+
+	/**
+	*	The snapshot document as JSON text, empty when the messages were pushed instead
+	*/
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "SnapshotPayLoad"))
+	FString SnapshotPayLoad = "";
+};
+
+USTRUCT(BlueprintType, Blueprintable)
+struct FLobbySyncStats
+{
+	GENERATED_BODY()
+
+	/**
+	*	Received messages that carried a stream sequence
+	*/
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "SequencedMessages"))
+	int64 SequencedMessages = 0;
+
+	/**
+	*	Sequenced messages already seen, dropped before anyone got them
+	*/
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "DuplicateMessages"))
+	int64 DuplicateMessages = 0;
+
+	/**
+	*	Messages that arrived with some before them missing
+	*/
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "Gaps"))
+	int64 Gaps = 0;
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "ResyncRequests"))
+	int64 ResyncRequests = 0;
+
+	/**
+	*	Streams brought up to date by the missed messages alone
+	*/
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "DeltaResyncs"))
+	int64 DeltaResyncs = 0;
+
+	UPROPERTY(BlueprintReadOnly, Meta = (DisplayName = "SnapshotResyncs"))
+	int64 SnapshotResyncs = 0;
+};
+
+DECLARE_DELEGATE_OneParam(FOnLobbyResponseNative, const FLobbyResponse& /*Response*/);
+DECLARE_DYNAMIC_DELEGATE_OneParam(FOnLobbyResponse, const FLobbyResponse&, Response);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnLobbyMessage, const FLobbyResponse&, Response);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnLobbyConnectionStateChanged, ELobbyConnectionState, State);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnLobbyOutboundBackpressure, bool, bBackpressured);
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnLobbyChatMessageNative, const FLobbyChatMessage& /*Message*/);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnLobbyChatMessage, const FLobbyChatMessage&, Message);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnLobbyResync, const FLobbyResyncResult&, Result);
@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MongoDBBulkLibrary.h"
+#include "LobbyJsonView.h"
+
+FMongoDBBulkData UMongoDBBulkLibrary::MakeMongoDBBulkData(const FString& NewSenderPlayerId, const FString& NewDbName, const FString& NewCollectionName, bool bNewOrdered)
+{
+	FMongoDBBulkData R_BulkData;
+	R_BulkData.SenderPlayerId = NewSenderPlayerId;
+	R_BulkData.DbName = NewDbName;
+	R_BulkData.CollectionName = NewCollectionName;
+	R_BulkData.bOrdered = bNewOrdered;
+	return R_BulkData;
+}
+
+void UMongoDBBulkLibrary::AddInsertOne(FMongoDBBulkData& NewBulkData, const FString& NewDocument)
+{
+	NewBulkData.InsertOne(NewDocument);
+}
+
+void UMongoDBBulkLibrary::AddUpdateOne(FMongoDBBulkData& NewBulkData, const FString& NewFilter, const FString& NewUpdate, bool bNewUpsert)
+{
+	NewBulkData.UpdateOne(NewFilter, NewUpdate, bNewUpsert);
+}
+
+void UMongoDBBulkLibrary::AddUpdateMany(FMongoDBBulkData& NewBulkData, const FString& NewFilter, const FString& NewUpdate, bool bNewUpsert)
+{
+	NewBulkData.UpdateMany(NewFilter, NewUpdate, bNewUpsert);
+}
+
+void UMongoDBBulkLibrary::AddReplaceOne(FMongoDBBulkData& NewBulkData, const FString& NewFilter, const FString& NewDocument, bool bNewUpsert)
+{
+	NewBulkData.ReplaceOne(NewFilter, NewDocument, bNewUpsert);
+}
+
+void UMongoDBBulkLibrary::AddDeleteOne(FMongoDBBulkData& NewBulkData, const FString& NewFilter)
+{
+	NewBulkData.DeleteOne(NewFilter);
+}
+
+void UMongoDBBulkLibrary::AddDeleteMany(FMongoDBBulkData& NewBulkData, const FString& NewFilter)
+{
+	NewBulkData.DeleteMany(NewFilter);
+}
+
+void UMongoDBBulkLibrary::ResetMongoDBBulkData(FMongoDBBulkData& NewBulkData)
+{
+	NewBulkData.Reset();
+}
+
+int32 UMongoDBBulkLibrary::GetBulkOperationCount(const FMongoDBBulkData& NewBulkData)
+{
+	return NewBulkData.Num();
+}
+
+bool UMongoDBBulkLibrary::GetBulkResult(const FLobbyResponse& NewResponse, FMongoDBBulkResult& OutResult)
+{
+	return ParseBulkResult(NewResponse.PayLoadData, OutResult);
+}
+
+bool UMongoDBBulkLibrary::ParseBulkResult(const FString& NewPayLoadData, FMongoDBBulkResult& OutResult)
+{
+	OutResult.Results.Reset();
+
+	const FTCHARToUTF8 PayLoadUtf8(*NewPayLoadData, NewPayLoadData.Len());
+	FLobbyJsonView PayLoadView;
+	if (!PayLoadView.Parse(FUtf8StringView(reinterpret_cast<const UTF8CHAR*>(PayLoadUtf8.Get()), PayLoadUtf8.Length())))
+	{
+		return false;
+	}
+
+	const FLobbyJsonView::FValue PayLoad = PayLoadView.GetRoot();
+	const FLobbyJsonView::FValue Results = PayLoad.IsObject() ? PayLoad.Find("results") : PayLoad;
+	if (!Results.IsArray())
+	{
+		return false;
+	}
+
+	OutResult.Results.Reserve(Results.Num());
+	Results.ForEachElement([&OutResult](const FLobbyJsonView::FValue& ResultObject)
+	{
+		if (!ResultObject.IsObject())
+		{
+			return;
+		}
+
+		FMongoDBBulkOperationResult& Result = OutResult.Results.AddDefaulted_GetRef();
+		// Servers that leave out the index answer in operation order
+		Result.Index = OutResult.Results.Num() - 1;
+		ResultObject.Find("index").TryGetNumber(Result.Index);
+		ResultObject.Find("ok").TryGetBool(Result.bSucceeded);
+		ResultObject.Find("error").TryGetString(Result.Error);
+		ResultObject.Find("insertedId").TryGetString(Result.InsertedId);
+		ResultObject.Find("upsertedId").TryGetString(Result.UpsertedId);
+		ResultObject.Find("matchedCount").TryGetNumber(Result.MatchedCount);
+		ResultObject.Find("modifiedCount").TryGetNumber(Result.ModifiedCount);
+		ResultObject.Find("deletedCount").TryGetNumber(Result.DeletedCount);
+	});
+	return true;
+}
@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Kismet/BlueprintFunctionLibrary.h"
+#include "LobbyTypes.h"
+#include "MongoDBBulkLibrary.generated.h"
+
+/**
+ * Blueprint builders for FMongoDBBulkData and the reader for BULK_WRITE responses.
+ * Accumulate the writes of a match, then commit them with ULobbyGameInstanceSubsystem::SendDBBulkRequest.
+ */
+UCLASS()
+class LOBBYCLIENT_API UMongoDBBulkLibrary : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+
+public:
+
+	UFUNCTION(BlueprintPure, Category = "Lobby|Database")
+	static FMongoDBBulkData MakeMongoDBBulkData(const FString& NewSenderPlayerId, const FString& NewDbName, const FString& NewCollectionName, bool bNewOrdered = true);
+
+	UFUNCTION(BlueprintCallable, Category = "Lobby|Database")
+	static void AddInsertOne(UPARAM(ref) FMongoDBBulkData& NewBulkData, const FString& NewDocument);
+
+	UFUNCTION(BlueprintCallable, Category = "Lobby|Database")
+	static void AddUpdateOne(UPARAM(ref) FMongoDBBulkData& NewBulkData, const FString& NewFilter, const FString& NewUpdate, bool bNewUpsert = false);
+
+	UFUNCTION(BlueprintCallable, Category = "Lobby|Database")
+	static void AddUpdateMany(UPARAM(ref) FMongoDBBulkData& NewBulkData, const FString& NewFilter, const FString& NewUpdate, bool bNewUpsert = false);
+
+	UFUNCTION(BlueprintCallable, Category = "Lobby|Database")
+	static void AddReplaceOne(UPARAM(ref) FMongoDBBulkData& NewBulkData, const FString& NewFilter, const FString& NewDocument, bool bNewUpsert = false);
+
+	UFUNCTION(BlueprintCallable, Category = "Lobby|Database")
+	static void AddDeleteOne(UPARAM(ref) FMongoDBBulkData& NewBulkData, const FString& NewFilter);
+
+	UFUNCTION(BlueprintCallable, Category = "Lobby|Database")
+	static void AddDeleteMany(UPARAM(ref) FMongoDBBulkData& NewBulkData, const FString& NewFilter);
+
+	UFUNCTION(BlueprintCallable, Category = "Lobby|Database")
+	static void ResetMongoDBBulkData(UPARAM(ref) FMongoDBBulkData& NewBulkData);
+
+	UFUNCTION(BlueprintPure, Category = "Lobby|Database")
+	static int32 GetBulkOperationCount(const FMongoDBBulkData& NewBulkData);
+
+	/**
+	 * Read the per-operation results of a BULK_WRITE response, false if the payload has none
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Lobby|Database")
+	static bool GetBulkResult(const FLobbyResponse& NewResponse, FMongoDBBulkResult& OutResult);
+
+	/**
+	 * Accepts {"results":[...]} or the bare array
+	 */
+	static bool ParseBulkResult(const FString& NewPayLoadData, FMongoDBBulkResult& OutResult);
+};
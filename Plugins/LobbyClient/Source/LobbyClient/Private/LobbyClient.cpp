@@ -2,6 +2,8 @@
 
 #include "LobbyClient.h"
 
+DEFINE_LOG_CATEGORY(LogLobbyClient);
+
 #define LOCTEXT_NAMESPACE "FLobbyClientModule"
 
 void FLobbyClientModule::StartupModule()
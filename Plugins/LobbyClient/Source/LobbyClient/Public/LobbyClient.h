@@ -5,6 +5,8 @@
 #include "CoreMinimal.h"
 #include "Modules/ModuleManager.h"
 
+LOBBYCLIENT_API DECLARE_LOG_CATEGORY_EXTERN(LogLobbyClient, Log, All);
+
 class FLobbyClientModule : public IModuleInterface
 {
 public:
@@ -0,0 +1,48 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+
+public class LobbyClientTests : ModuleRules
+{
+	public LobbyClientTests(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		PublicDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"Core",
+			}
+			);
+
+
+		PrivateDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"CoreUObject",
+				"Engine",
+				"OpenSSL",
+				"Json",
+				"JsonUtilities",
+				"WebSockets",
+				"LobbyClient"
+			}
+			);
+
+		// The loopback server only needs the interfaces, the module is loaded when a test starts the server,
+		// so the WebSocketNetworking plugin has to be enabled by the project that runs these tests
+		PrivateIncludePathModuleNames.AddRange(
+			new string[]
+			{
+				"WebSocketNetworking"
+			}
+			);
+
+		DynamicallyLoadedModuleNames.AddRange(
+			new string[]
+			{
+				"WebSocketNetworking"
+			}
+			);
+	}
+}
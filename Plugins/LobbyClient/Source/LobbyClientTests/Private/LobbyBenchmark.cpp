@@ -0,0 +1,665 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LobbyBenchmark.h"
+#include "LobbyClient.h"
+#include "LobbyGameInstanceSubsystem.h"
+#include "LobbyEnvelope.h"
+#include "LobbyEnumNames.h"
+#include "LobbySigner.h"
+#include "LobbyBufferPool.h"
+#include "LobbyFrame.h"
+#include "LobbyJsonView.h"
+#include "LobbyReceiveStage.h"
+#include "Misc/App.h"
+#include "Misc/EngineVersion.h"
+#include "Misc/FileHelper.h"
+#include <JsonObjectConverter.h>
+
+namespace OpenSSLWrapper
+{
+	#include "openssl/hmac.h"
+	#include "openssl/evp.h"
+}
+
+namespace
+{
+	FChatData MakeBenchmarkChatData()
+	{
+		FChatData R_ChatData;
+		R_ChatData.SenderPlayerId = TEXT("player-0001");
+		R_ChatData.RecipientPlayerId = TEXT("player-0002");
+		R_ChatData.Message = TEXT("gg! \"rematch\" in 5? meet at {lobby 3}");
+		return R_ChatData;
+	}
+
+	FMongoDBData MakeBenchmarkDBData()
+	{
+		FMongoDBData R_MongoDBData;
+		R_MongoDBData.SenderPlayerId = TEXT("player-0001");
+		R_MongoDBData.DbName = TEXT("lobby");
+		R_MongoDBData.CollectionName = TEXT("matches");
+		R_MongoDBData.DbAction = EMongoDBActionType::FIND_WITH_OPTIONS;
+		R_MongoDBData.Filter = TEXT("{\"region\":\"eu-west\",\"rank\":{\"$gte\":1200},\"tags\":[\"ranked\",\"5v5\"]}");
+		R_MongoDBData.Options = TEXT("{\"sort\":{\"createdAt\":-1},\"limit\":50}");
+		R_MongoDBData.BatchSize = 50;
+		R_MongoDBData.CursorId = TEXT("cursor-0001");
+		return R_MongoDBData;
+	}
+
+	/**
+	 * The answer to the benchmark chat message the way the server frames it
+	 */
+	void CookBenchmarkResponse(FLobbySigner& NewSigner, bool bNewLengthPrefixed, TArray<UTF8CHAR>& OutFrame)
+	{
+		const FChatData ChatData = MakeBenchmarkChatData();
+		FLobbyEnvelope::CookFrame(OutFrame, NewSigner, bNewLengthPrefixed, FLobbyFrameWriter::GetCurrentTimestamp(), [&](FLobbyJsonWriter& NewWriter)
+		{
+			FLobbyEnvelope::WriteEnvelope(NewWriter, ELobbyActionType::TEXT_CHAT, ChatData.SenderPlayerId, TEXT("00000000-0000-0000-0000-000000000000"), bNewLengthPrefixed, [&](FLobbyJsonWriter& NewPayloadWriter)
+			{
+				FLobbyEnvelope::WriteChatPayload(NewPayloadWriter, ChatData);
+			});
+		});
+	}
+
+	/**
+	 * What the subsystem sent before the hand written serializers: the converter with its defaults, pretty printed.
+	 * StaticStruct<T>() is exported from LobbyClient, the struct's own StaticStruct() is not.
+	 */
+	template <typename StructType>
+	FString ToBaselineJson(const StructType& NewStruct)
+	{
+		FString R_Json;
+		FJsonObjectConverter::UStructToJsonObjectString(StaticStruct<StructType>(), &NewStruct, R_Json);
+		return R_Json;
+	}
+
+	/**
+	 * Where the hand written serializers knowingly differ from the baseline text, everything else has to match:
+	 * - whitespace: the baseline is pretty printed, the serializers write compact text
+	 * - payLoadData: the nested payload is compact text as well, so the JSON it holds is compared instead
+	 * - batchSize and cursorId: left out while unset, the baseline wrote 0 and ""
+	 * Keys are compared by name and order, strings by their value after unescaping.
+	 */
+	const TCHAR* const NESTED_PAYLOAD_FIELD = TEXT("payLoadData");
+
+	const TCHAR* const OMITTED_WHEN_UNSET_FIELDS[] = { TEXT("batchSize"), TEXT("cursorId") };
+
+	TSharedPtr<FJsonObject> ParseJsonObject(const FString& NewJson)
+	{
+		TSharedPtr<FJsonObject> R_JsonObject;
+		FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(NewJson), R_JsonObject);
+		return R_JsonObject;
+	}
+
+	bool IsOmittedWhenUnset(const FString& NewKey, const FJsonValue& NewValue)
+	{
+		for (const TCHAR* const Field : OMITTED_WHEN_UNSET_FIELDS)
+		{
+			if (NewKey.Equals(Field, ESearchCase::CaseSensitive))
+			{
+				return NewValue.Type == EJson::Number ? NewValue.AsNumber() == 0.0 : NewValue.Type == EJson::String && NewValue.AsString().IsEmpty();
+			}
+		}
+		return false;
+	}
+
+	bool IsSameValue(const FJsonValue& NewBaseline, const FJsonValue& NewWritten)
+	{
+		if (NewBaseline.Type == EJson::String && NewWritten.Type == EJson::String)
+		{
+			return NewBaseline.AsString().Equals(NewWritten.AsString(), ESearchCase::CaseSensitive);
+		}
+		return FJsonValue::CompareEqual(NewBaseline, NewWritten);
+	}
+
+	/**
+	 * False with the first difference in OutDifference, unless it is one of the known differences above
+	 */
+	bool CompareJsonObjects(const TSharedPtr<FJsonObject>& NewBaseline, const TSharedPtr<FJsonObject>& NewWritten, FString& OutDifference)
+	{
+		if (!NewBaseline.IsValid() || !NewWritten.IsValid())
+		{
+			OutDifference = TEXT("not a JSON object");
+			return false;
+		}
+
+		// The reader adds the members in text order
+		const TArray<TPair<FString, TSharedPtr<FJsonValue>>> Written = NewWritten->Values.Array();
+		int32 WrittenIndex = 0;
+		for (const TPair<FString, TSharedPtr<FJsonValue>>& Field : NewBaseline->Values)
+		{
+			if (!Written.IsValidIndex(WrittenIndex) || !Written[WrittenIndex].Key.Equals(Field.Key, ESearchCase::CaseSensitive))
+			{
+				if (IsOmittedWhenUnset(Field.Key, *Field.Value))
+				{
+					continue;
+				}
+				OutDifference = FString::Printf(TEXT("%s is missing or out of order"), *Field.Key);
+				return false;
+			}
+
+			const FJsonValue& WrittenValue = *Written[WrittenIndex++].Value;
+			if (Field.Key.Equals(NESTED_PAYLOAD_FIELD, ESearchCase::CaseSensitive) && Field.Value->Type == EJson::String && WrittenValue.Type == EJson::String)
+			{
+				if (!CompareJsonObjects(ParseJsonObject(Field.Value->AsString()), ParseJsonObject(WrittenValue.AsString()), OutDifference))
+				{
+					OutDifference = FString::Printf(TEXT("%s: %s"), *Field.Key, *OutDifference);
+					return false;
+				}
+				continue;
+			}
+			if (!IsSameValue(*Field.Value, WrittenValue))
+			{
+				OutDifference = FString::Printf(TEXT("%s differs"), *Field.Key);
+				return false;
+			}
+		}
+
+		if (Written.IsValidIndex(WrittenIndex))
+		{
+			OutDifference = FString::Printf(TEXT("%s is not in the baseline"), *Written[WrittenIndex].Key);
+			return false;
+		}
+		return true;
+	}
+
+	/**
+	 * NewWritten against the unmodified baseline text, allowing only the known differences
+	 */
+	void CompareWithBaseline(const FString& NewName, const FString& NewBaseline, const TArray<UTF8CHAR>& NewWritten, TArray<FString>& OutMismatches)
+	{
+		const FString Written(NewWritten.Num(), NewWritten.GetData());
+		FString Difference;
+		if (!CompareJsonObjects(ParseJsonObject(NewBaseline), ParseJsonObject(Written), Difference))
+		{
+			OutMismatches.Add(FString::Printf(TEXT("%s: %s, baseline %s, written %s"), *NewName, *Difference, *NewBaseline, *Written));
+		}
+	}
+
+	/**
+	 * Every property of NewStruct in NewExpected against NewRead, except NewSkippedField
+	 */
+	void CompareFields(const FString& NewName, const UStruct* NewStruct, const void* NewExpected, const void* NewRead, TArray<FString>& OutMismatches, FName NewSkippedField = NAME_None)
+	{
+		for (TFieldIterator<FProperty> It(NewStruct); It; ++It)
+		{
+			const FProperty* Property = *It;
+			if (Property->GetFName() == NewSkippedField || Property->Identical_InContainer(NewExpected, NewRead))
+			{
+				continue;
+			}
+			FString Expected;
+			FString Read;
+			Property->ExportText_InContainer(0, Expected, NewExpected, nullptr, nullptr, PPF_None);
+			Property->ExportText_InContainer(0, Read, NewRead, nullptr, nullptr, PPF_None);
+			OutMismatches.Add(FString::Printf(TEXT("%s: %s is %s, it reads back as %s"), *NewName, *Property->GetName(), *Expected, *Read));
+		}
+	}
+
+	/**
+	 * Read NewJson into a StructType with the converter, the way the baseline read its structs
+	 */
+	template <typename StructType>
+	bool ReadStruct(const FString& NewName, const FString& NewJson, StructType& OutStruct, TArray<FString>& OutMismatches)
+	{
+		const TSharedPtr<FJsonObject> JsonObject = ParseJsonObject(NewJson);
+		if (!JsonObject.IsValid() || !FJsonObjectConverter::JsonObjectToUStruct(JsonObject.ToSharedRef(), StaticStruct<StructType>(), &OutStruct))
+		{
+			OutMismatches.Add(FString::Printf(TEXT("%s: %s does not read back"), *NewName, *NewJson));
+			return false;
+		}
+		return true;
+	}
+
+	/**
+	 * Parse NewWritten back into a StructType and compare it with NewExpected field by field
+	 */
+	template <typename StructType>
+	void CompareRoundTrip(const FString& NewName, const StructType& NewExpected, const TArray<UTF8CHAR>& NewWritten, TArray<FString>& OutMismatches)
+	{
+		StructType Read;
+		if (ReadStruct(NewName, FString(NewWritten.Num(), NewWritten.GetData()), Read, OutMismatches))
+		{
+			CompareFields(NewName, StaticStruct<StructType>(), &NewExpected, &Read, OutMismatches);
+		}
+	}
+
+	template <typename EnumType>
+	void CompareEnumNames(TArray<FString>& OutMismatches)
+	{
+		const UEnum* Enum = StaticEnum<EnumType>();
+		const TConstArrayView<FAnsiStringView> Table = FLobbyEnumNames::GetTable(EnumType());
+
+		// NumEnums counts the _MAX entry UHT adds
+		if (Enum->NumEnums() - 1 != Table.Num())
+		{
+			OutMismatches.Add(FString::Printf(TEXT("%s: %d enumerators, %d names in the table"), *Enum->GetName(), Enum->NumEnums() - 1, Table.Num()));
+		}
+
+		for (int32 Index = 0; Index < FMath::Min(Enum->NumEnums() - 1, Table.Num()); ++Index)
+		{
+			const EnumType Value = static_cast<EnumType>(Enum->GetValueByIndex(Index));
+			const FString Expected = Enum->GetAuthoredNameStringByValue(static_cast<int64>(Value));
+			const FUtf8StringView Written = FLobbyEnumNames::ToName(Value);
+			EnumType ReadBack = EnumType();
+			if (!Expected.Equals(FString(Written.Len(), Written.GetData()), ESearchCase::CaseSensitive)
+				|| !FLobbyEnumNames::FromName(FStringView(Expected), ReadBack) || ReadBack != Value)
+			{
+				OutMismatches.Add(FString::Printf(TEXT("%s: %s is written as %s"), *Enum->GetName(), *Expected, *FString(Written.Len(), Written.GetData())));
+			}
+		}
+	}
+
+	template <typename FunctionType>
+	FLobbySendBenchmarkResult Measure(int32 NewIterations, FunctionType&& NewSendOne)
+	{
+		NewIterations = FMath::Max(NewIterations, 1);
+		FLobbySendBenchmarkResult R_Result;
+
+		// Warm up caches and reusable buffers before counting
+		R_Result.WireBytes = NewSendOne();
+
+		const uint64 AllocationsBefore = FLobbyAllocationCounter::GetTotal();
+		const double StartTime = FPlatformTime::Seconds();
+		for (int32 i = 0; i < NewIterations; ++i)
+		{
+			R_Result.WireBytes = NewSendOne();
+		}
+		const double ElapsedSeconds = FPlatformTime::Seconds() - StartTime;
+
+		R_Result.MicrosecondsPerMessage = ElapsedSeconds * 1000000.0 / NewIterations;
+		R_Result.AllocationsPerMessage = static_cast<double>(FLobbyAllocationCounter::GetTotal() - AllocationsBefore) / NewIterations;
+		return R_Result;
+	}
+}
+
+FLobbySendBenchmarkResult FLobbyBenchmark::RunLegacySendPipeline(int32 NewIterations)
+{
+	const FJWTConfig Config;
+	const FChatData ChatData = MakeBenchmarkChatData();
+	const int64 Timestamp = FDateTime::UtcNow().ToUnixTimestamp() * 1000;
+
+	return Measure(NewIterations, [&]()
+	{
+		FString PayLoadJson;
+		FJsonObjectConverter::UStructToJsonObjectString(StaticStruct<FChatData>(), &ChatData, PayLoadJson);
+		FNGGLobbyData LobbyData{};
+		LobbyData.Action = ELobbyActionType::TEXT_CHAT;
+		LobbyData.ClientID = ChatData.SenderPlayerId;
+		LobbyData.PayLoadData = PayLoadJson;
+		LobbyData.requestId = TEXT("00000000-0000-0000-0000-000000000000");
+
+		FString JsonString;
+		FJsonObjectConverter::UStructToJsonObjectString(StaticStruct<FNGGLobbyData>(), &LobbyData, JsonString);
+
+		FString DataWithoutSignature = Config.ClientId + FString::Printf(TEXT("%lld"), Timestamp) + JsonString;
+
+		FString MessageStr = Config.ClientId + FString::Printf(TEXT("%lld"), Timestamp) + JsonString;
+		unsigned char Result[64];
+		unsigned int ResultLength;
+		FTCHARToUTF8 SecretUtf8(*Config.ClientSecret);
+		FTCHARToUTF8 MessageUtf8(*MessageStr);
+		OpenSSLWrapper::HMAC(OpenSSLWrapper::EVP_sha256(), SecretUtf8.Get(), SecretUtf8.Length(),
+			reinterpret_cast<const unsigned char*>(MessageUtf8.Get()), MessageUtf8.Length(),
+			Result, &ResultLength);
+		FString Signature = BytesToHex(Result, ResultLength).ToLower();
+
+		FString CookedData = Config.ClientId + FString::Printf(TEXT("%lld"), Timestamp) + JsonString + Signature;
+
+		// IWebSocket::Send(FString) converts to UTF-8 before queueing the frame
+		FTCHARToUTF8 WireData(*CookedData);
+		return WireData.Length();
+	});
+}
+
+FLobbySendBenchmarkResult FLobbyBenchmark::RunSendPipeline(int32 NewIterations, bool bNewLengthPrefixed)
+{
+	const FJWTConfig Config;
+	const FChatData ChatData = MakeBenchmarkChatData();
+	const FString RequestId = TEXT("00000000-0000-0000-0000-000000000000");
+	const int64 Timestamp = FDateTime::UtcNow().ToUnixTimestamp() * 1000;
+
+	FLobbySigner Signer;
+	Signer.SetKey(Config.ClientSecret, Config.ClientId);
+	TArray<UTF8CHAR> SendBuffer;
+
+	return Measure(NewIterations, [&]()
+	{
+		FLobbyEnvelope::CookFrame(SendBuffer, Signer, bNewLengthPrefixed, Timestamp, [&](FLobbyJsonWriter& NewWriter)
+		{
+			FLobbyEnvelope::WriteEnvelope(NewWriter, ELobbyActionType::TEXT_CHAT, ChatData.SenderPlayerId, RequestId, bNewLengthPrefixed, [&](FLobbyJsonWriter& NewPayloadWriter)
+			{
+				FLobbyEnvelope::WriteChatPayload(NewPayloadWriter, ChatData);
+			});
+		});
+		return SendBuffer.Num();
+	});
+}
+
+FLobbySendBenchmarkResult FLobbyBenchmark::RunDBPayloadSerializer(int32 NewIterations, bool bNewReflection)
+{
+	const FMongoDBData MongoDBData = MakeBenchmarkDBData();
+
+	if (bNewReflection)
+	{
+		return Measure(NewIterations, [&]()
+		{
+			const FString Json = ToBaselineJson(MongoDBData);
+			FTCHARToUTF8 Utf8Json(*Json, Json.Len());
+			return Utf8Json.Length();
+		});
+	}
+
+	TArray<UTF8CHAR> Buffer;
+	return Measure(NewIterations, [&]()
+	{
+		Buffer.Reset();
+		{
+			FLobbyJsonWriter Writer(Buffer);
+			FLobbyEnvelope::WriteDBPayload(Writer, MongoDBData);
+		}
+		return Buffer.Num();
+	});
+}
+
+FLobbySendBenchmarkResult FLobbyBenchmark::RunSign(int32 NewIterations)
+{
+	const FJWTConfig Config;
+	FLobbySigner Signer;
+	Signer.SetKey(Config.ClientSecret, Config.ClientId);
+	TArray<UTF8CHAR> Frame;
+	CookBenchmarkResponse(Signer, true, Frame);
+
+	FLobbyFrameView FrameView;
+	int64 Timestamp = 0;
+	FLobbyFrameParser::Parse(FUtf8StringView(Frame.GetData(), Frame.Num()), FrameView);
+	FLobbyFrameParser::ParseTimestamp(FrameView[NGG_LOBBY_PROTOCOL::TIMESTAMP], Timestamp);
+	const FUtf8StringView Body = FrameView[NGG_LOBBY_PROTOCOL::JSON];
+	UTF8CHAR Signature[FLobbySigner::SIGNATURE_LENGTH];
+
+	return Measure(NewIterations, [&]()
+	{
+		return Signer.Sign(Timestamp, Body, Signature) ? Body.Len() : 0;
+	});
+}
+
+FLobbySendBenchmarkResult FLobbyBenchmark::RunVerify(int32 NewIterations)
+{
+	const FJWTConfig Config;
+	FLobbySigner Signer;
+	Signer.SetKey(Config.ClientSecret, Config.ClientId);
+	TArray<UTF8CHAR> Frame;
+	CookBenchmarkResponse(Signer, true, Frame);
+
+	FLobbyFrameView FrameView;
+	int64 Timestamp = 0;
+	FLobbyFrameParser::Parse(FUtf8StringView(Frame.GetData(), Frame.Num()), FrameView);
+	FLobbyFrameParser::ParseTimestamp(FrameView[NGG_LOBBY_PROTOCOL::TIMESTAMP], Timestamp);
+	const FUtf8StringView Body = FrameView[NGG_LOBBY_PROTOCOL::JSON];
+
+	// A frame that fails to verify reports 0 bytes instead of a misleading time
+	return Measure(NewIterations, [&]()
+	{
+		return Signer.Verify(Timestamp, Body, FrameView[NGG_LOBBY_PROTOCOL::SIGNATURE]) ? Body.Len() : 0;
+	});
+}
+
+FLobbySendBenchmarkResult FLobbyBenchmark::RunParseFrame(int32 NewIterations, bool bNewLengthPrefixed)
+{
+	const FJWTConfig Config;
+	FLobbySigner Signer;
+	Signer.SetKey(Config.ClientSecret, Config.ClientId);
+	TArray<UTF8CHAR> Frame;
+	CookBenchmarkResponse(Signer, bNewLengthPrefixed, Frame);
+	const FUtf8StringView FrameText(Frame.GetData(), Frame.Num());
+
+	return Measure(NewIterations, [&]()
+	{
+		FLobbyFrameView FrameView;
+		return FLobbyFrameParser::Parse(FrameText, FrameView) ? FrameText.Len() : 0;
+	});
+}
+
+FLobbySendBenchmarkResult FLobbyBenchmark::RunReceivePipeline(int32 NewIterations, bool bNewLengthPrefixed)
+{
+	const FJWTConfig Config;
+	FLobbySigner Signer;
+	Signer.SetKey(Config.ClientSecret, Config.ClientId);
+	TArray<UTF8CHAR> Frame;
+	CookBenchmarkResponse(Signer, bNewLengthPrefixed, Frame);
+	const FUtf8StringView FrameText(Frame.GetData(), Frame.Num());
+
+	FLobbyJsonView BodyView;
+	FLobbyResponse Response;
+
+	return Measure(NewIterations, [&]()
+	{
+		FLobbyFrameView FrameView;
+		int64 Timestamp = 0;
+		if (!FLobbyFrameParser::Parse(FrameText, FrameView)
+			|| !FLobbyFrameParser::ParseTimestamp(FrameView[NGG_LOBBY_PROTOCOL::TIMESTAMP], Timestamp)
+			|| !Signer.Verify(Timestamp, FrameView[NGG_LOBBY_PROTOCOL::JSON], FrameView[NGG_LOBBY_PROTOCOL::SIGNATURE])
+			|| !BodyView.Parse(FrameView[NGG_LOBBY_PROTOCOL::JSON]))
+		{
+			return 0;
+		}
+
+		Response = FLobbyResponse();
+		FLobbyReceiveStage::DecodeResponse(BodyView.GetRoot(), Response);
+		return FrameText.Len();
+	});
+}
+
+bool FLobbyBenchmark::VerifySerializers(TArray<FString>& OutMismatches)
+{
+	const int32 MismatchesBefore = OutMismatches.Num();
+	TArray<UTF8CHAR> Written;
+
+	CompareEnumNames<ELobbyActionType>(OutMismatches);
+	CompareEnumNames<EMongoDBActionType>(OutMismatches);
+	CompareEnumNames<EMongoDBBulkOperationType>(OutMismatches);
+	CompareEnumNames<ELobbySyncStream>(OutMismatches);
+
+	TArray<FChatData> ChatSamples;
+	ChatSamples.Add(MakeBenchmarkChatData());
+	ChatSamples.AddDefaulted();
+	ChatSamples.Add_GetRef(MakeBenchmarkChatData()).Message = TEXT("line\n\ttab \\ slash / \x01 caf\u00e9 \U0001F3C6");
+
+	for (int32 ChatIndex = 0; ChatIndex < ChatSamples.Num(); ++ChatIndex)
+	{
+		const FChatData& ChatData = ChatSamples[ChatIndex];
+		Written.Reset();
+		{
+			FLobbyJsonWriter Writer(Written);
+			FLobbyEnvelope::WriteChatPayload(Writer, ChatData);
+		}
+		const FString ChatName = FString::Printf(TEXT("FChatData %d"), ChatIndex);
+		const FString ChatJson = ToBaselineJson(ChatData);
+		CompareWithBaseline(ChatName, ChatJson, Written, OutMismatches);
+		CompareRoundTrip(ChatName, ChatData, Written, OutMismatches);
+
+		// The legacy envelope nests the payload as an escaped string, the baseline nested it pretty printed
+		for (const FAnsiStringView ActionName : NGG_LOBBY_ENUM_NAMES::ACTION_TYPES)
+		{
+			FNGGLobbyData LobbyData;
+			FLobbyEnumNames::FromName(ActionName, LobbyData.Action);
+			LobbyData.ClientID = ChatData.SenderPlayerId;
+			LobbyData.PayLoadData = ChatJson;
+			LobbyData.requestId = TEXT("00000000-0000-0000-0000-000000000000");
+
+			Written.Reset();
+			{
+				FLobbyJsonWriter Writer(Written);
+				FLobbyEnvelope::WriteEnvelope(Writer, LobbyData.Action, LobbyData.ClientID, LobbyData.requestId, false, [&](FLobbyJsonWriter& NewPayloadWriter)
+				{
+					FLobbyEnvelope::WriteChatPayload(NewPayloadWriter, ChatData);
+				});
+			}
+			const FString LobbyName = FString::Printf(TEXT("FNGGLobbyData %d %s"), ChatIndex, *FString(ActionName.Len(), ActionName.GetData()));
+			CompareWithBaseline(LobbyName, ToBaselineJson(LobbyData), Written, OutMismatches);
+
+			// The payload text differs from the baseline's, so it is compared as the chat data it holds
+			FNGGLobbyData ReadLobbyData;
+			FChatData ReadChatData;
+			if (ReadStruct(LobbyName, FString(Written.Num(), Written.GetData()), ReadLobbyData, OutMismatches)
+				&& ReadStruct(LobbyName, ReadLobbyData.PayLoadData, ReadChatData, OutMismatches))
+			{
+				CompareFields(LobbyName, StaticStruct<FNGGLobbyData>(), &LobbyData, &ReadLobbyData, OutMismatches, GET_MEMBER_NAME_CHECKED(FNGGLobbyData, PayLoadData));
+				CompareFields(LobbyName, StaticStruct<FChatData>(), &ChatData, &ReadChatData, OutMismatches);
+			}
+		}
+	}
+
+	// One request with the cursor fields set and one that leaves them at their defaults, like every request before cursors
+	TArray<FMongoDBData> DBSamples;
+	DBSamples.Add_GetRef(MakeBenchmarkDBData()).Data = TEXT("{\"name\":\"Ren\u00e9e\",\"note\":\"a\tb\"}");
+	FMongoDBData& DefaultsSample = DBSamples.AddDefaulted_GetRef();
+	DefaultsSample.SenderPlayerId = TEXT("player-0001");
+	DefaultsSample.DbName = TEXT("lobby");
+	DefaultsSample.CollectionName = TEXT("players");
+	DefaultsSample.Filter = TEXT("{\"playerId\":\"player-0001\"}");
+
+	for (int32 DBIndex = 0; DBIndex < DBSamples.Num(); ++DBIndex)
+	{
+		FMongoDBData& MongoDBData = DBSamples[DBIndex];
+		for (const FAnsiStringView DbActionName : NGG_LOBBY_ENUM_NAMES::DB_ACTION_TYPES)
+		{
+			FLobbyEnumNames::FromName(DbActionName, MongoDBData.DbAction);
+			Written.Reset();
+			{
+				FLobbyJsonWriter Writer(Written);
+				FLobbyEnvelope::WriteDBPayload(Writer, MongoDBData);
+			}
+			const FString DBName = FString::Printf(TEXT("FMongoDBData %d %s"), DBIndex, *FString(DbActionName.Len(), DbActionName.GetData()));
+			CompareWithBaseline(DBName, ToBaselineJson(MongoDBData), Written, OutMismatches);
+			CompareRoundTrip(DBName, MongoDBData, Written, OutMismatches);
+		}
+	}
+
+	return OutMismatches.Num() == MismatchesBefore;
+}
+
+bool FLobbyBenchmarkReport::IsPassing() const
+{
+	return SerializerMismatches.Num() == 0 && (!bHasEndToEnd || (EndToEnd.bCompleted && EndToEnd.Failed == 0));
+}
+
+void FLobbyBenchmark::RunStages(int32 NewIterations, FLobbyBenchmarkReport& OutReport)
+{
+	OutReport.Iterations = NewIterations;
+	OutReport.Stages.Emplace(TEXT("send.legacy"), RunLegacySendPipeline(NewIterations));
+	OutReport.Stages.Emplace(TEXT("send.singlePass.legacyFraming"), RunSendPipeline(NewIterations, false));
+	OutReport.Stages.Emplace(TEXT("send.singlePass.ngg2"), RunSendPipeline(NewIterations, true));
+	OutReport.Stages.Emplace(TEXT("dbPayload.reflection"), RunDBPayloadSerializer(NewIterations, true));
+	OutReport.Stages.Emplace(TEXT("dbPayload.handWritten"), RunDBPayloadSerializer(NewIterations, false));
+	OutReport.Stages.Emplace(TEXT("sign"), RunSign(NewIterations));
+	OutReport.Stages.Emplace(TEXT("verify"), RunVerify(NewIterations));
+	OutReport.Stages.Emplace(TEXT("parseFrame.legacy"), RunParseFrame(NewIterations, false));
+	OutReport.Stages.Emplace(TEXT("parseFrame.ngg2"), RunParseFrame(NewIterations, true));
+	OutReport.Stages.Emplace(TEXT("receive.legacy"), RunReceivePipeline(NewIterations, false));
+	OutReport.Stages.Emplace(TEXT("receive.ngg2"), RunReceivePipeline(NewIterations, true));
+	VerifySerializers(OutReport.SerializerMismatches);
+}
+
+bool FLobbyBenchmark::SaveReport(const FLobbyBenchmarkReport& NewReport, const FString& NewPath)
+{
+	TArray<UTF8CHAR> Json;
+	{
+		FLobbyJsonWriter Writer(Json);
+		Writer.BeginObject();
+		Writer.WriteKey("schemaVersion");
+		Writer.WriteInt(1);
+		Writer.WriteKey("timestamp");
+		Writer.WriteString(FDateTime::UtcNow().ToIso8601());
+		Writer.WriteKey("engineVersion");
+		Writer.WriteString(FEngineVersion::Current().ToString());
+		Writer.WriteKey("buildVersion");
+		Writer.WriteString(FStringView(FApp::GetBuildVersion()));
+		Writer.WriteKey("buildConfiguration");
+		Writer.WriteString(FStringView(LexToString(FApp::GetBuildConfiguration())));
+		Writer.WriteKey("platform");
+		Writer.WriteString(FStringView(FPlatformProperties::IniPlatformName()));
+		Writer.WriteKey("cpu");
+		Writer.WriteString(FPlatformMisc::GetCPUBrand().TrimStartAndEnd());
+		Writer.WriteKey("iterations");
+		Writer.WriteInt(NewReport.Iterations);
+		Writer.WriteKey("passed");
+		Writer.WriteBool(NewReport.IsPassing());
+
+		Writer.WriteKey("stages");
+		Writer.BeginArray();
+		for (const TPair<FString, FLobbySendBenchmarkResult>& Stage : NewReport.Stages)
+		{
+			Writer.BeginObject();
+			Writer.WriteKey("name");
+			Writer.WriteString(Stage.Key);
+			Writer.WriteKey("wireBytes");
+			Writer.WriteInt(Stage.Value.WireBytes);
+			Writer.WriteKey("microsecondsPerMessage");
+			Writer.WriteDouble(Stage.Value.MicrosecondsPerMessage);
+			Writer.WriteKey("allocationsPerMessage");
+			Writer.WriteDouble(Stage.Value.AllocationsPerMessage);
+			Writer.EndObject();
+		}
+		Writer.EndArray();
+
+		Writer.WriteKey("serializerMismatches");
+		Writer.BeginArray();
+		for (const FString& Mismatch : NewReport.SerializerMismatches)
+		{
+			Writer.WriteString(Mismatch);
+		}
+		Writer.EndArray();
+
+		Writer.WriteKey("endToEnd");
+		if (!NewReport.bHasEndToEnd)
+		{
+			Writer.WriteNull();
+		}
+		else
+		{
+			const FLobbyEndToEndResult& EndToEnd = NewReport.EndToEnd;
+			Writer.BeginObject();
+			Writer.WriteKey("completed");
+			Writer.WriteBool(EndToEnd.bCompleted);
+			Writer.WriteKey("requests");
+			Writer.WriteInt(EndToEnd.Requests);
+			Writer.WriteKey("succeeded");
+			Writer.WriteInt(EndToEnd.Succeeded);
+			Writer.WriteKey("failed");
+			Writer.WriteInt(EndToEnd.Failed);
+			Writer.WriteKey("seconds");
+			Writer.WriteDouble(EndToEnd.Seconds);
+			Writer.WriteKey("requestsPerSecond");
+			Writer.WriteDouble(EndToEnd.RequestsPerSecond);
+			Writer.WriteKey("p50Milliseconds");
+			Writer.WriteDouble(EndToEnd.Latency.P50Milliseconds);
+			Writer.WriteKey("p99Milliseconds");
+			Writer.WriteDouble(EndToEnd.Latency.P99Milliseconds);
+			Writer.WriteKey("maxMilliseconds");
+			Writer.WriteDouble(EndToEnd.Latency.MaxMilliseconds);
+			Writer.WriteKey("meanMilliseconds");
+			Writer.WriteDouble(EndToEnd.Latency.MeanMilliseconds);
+			Writer.WriteKey("serverFrames");
+			Writer.WriteInt(EndToEnd.ServerStats.Frames);
+			Writer.WriteKey("serverInvalidFrames");
+			Writer.WriteInt(EndToEnd.ServerStats.InvalidFrames);
+			// Seen from the client, what the server received is what the client sent
+			Writer.WriteKey("bytesSent");
+			Writer.WriteInt(EndToEnd.ServerStats.BytesReceived);
+			Writer.WriteKey("bytesReceived");
+			Writer.WriteInt(EndToEnd.ServerStats.BytesSent);
+			Writer.EndObject();
+		}
+		Writer.EndObject();
+	}
+
+	if (!FFileHelper::SaveArrayToFile(TArrayView<const uint8>(reinterpret_cast<const uint8*>(Json.GetData()), Json.Num()), *NewPath))
+	{
+		UE_LOG(LogLobbyClient, Error, TEXT("The benchmark report could not be written to %s."), *NewPath);
+		return false;
+	}
+	UE_LOG(LogLobbyClient, Display, TEXT("Benchmark report written to %s"), *NewPath);
+	return true;
+}
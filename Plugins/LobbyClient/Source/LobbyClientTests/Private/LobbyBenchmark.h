@@ -0,0 +1,104 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LobbyEndToEndBenchmark.h"
+
+/**
+ * Cost of one message on one send path or through one stage of the pipeline
+ */
+struct FLobbySendBenchmarkResult
+{
+	int32 WireBytes = 0;
+	double MicrosecondsPerMessage = 0.0;
+	/**
+	 * FMalloc calls per message, only counted in non-shipping builds
+	 */
+	double AllocationsPerMessage = 0.0;
+};
+
+/**
+ * Everything one suite run measured, saved as JSON so the runs of two builds can be compared
+ */
+struct FLobbyBenchmarkReport
+{
+	int32 Iterations = 0;
+
+	/**
+	 * Name of the stage and its cost, in the order they ran
+	 */
+	TArray<TPair<FString, FLobbySendBenchmarkResult>> Stages;
+
+	TArray<FString> SerializerMismatches;
+
+	bool bHasEndToEnd = false;
+
+	FLobbyEndToEndResult EndToEnd;
+
+	/**
+	 * The serializers match and the end to end run, if there was one, got every request answered
+	 */
+	bool IsPassing() const;
+};
+
+/**
+ * Microbenchmarks for the lobby message pipeline, run by the LobbyClient automation tests in LobbyBenchmarkTests.cpp.
+ * Headless: UnrealEditor-Cmd <Project> -ExecCmds="Automation RunTests LobbyClient; Quit" -unattended -nullrhi -nosound
+ */
+struct FLobbyBenchmark
+{
+	/**
+	 * The old send path: reflection based JSON twice, string concatenation, one-shot HMAC and the UTF-16 to UTF-8 copy
+	 */
+	static FLobbySendBenchmarkResult RunLegacySendPipeline(int32 NewIterations);
+
+	/**
+	 * The single pass path: envelope written as UTF-8 into a reused buffer and signed in place
+	 */
+	static FLobbySendBenchmarkResult RunSendPipeline(int32 NewIterations, bool bNewLengthPrefixed);
+
+	/**
+	 * One FMongoDBData payload, through FJsonObjectConverter or through the hand written serializer into a reused buffer
+	 */
+	static FLobbySendBenchmarkResult RunDBPayloadSerializer(int32 NewIterations, bool bNewReflection);
+
+	/**
+	 * HMAC of one chat envelope with the keyed signer, WireBytes is the signed body
+	 */
+	static FLobbySendBenchmarkResult RunSign(int32 NewIterations);
+
+	/**
+	 * Check of a received signature against the body of one response frame
+	 */
+	static FLobbySendBenchmarkResult RunVerify(int32 NewIterations);
+
+	/**
+	 * Split one response frame into its parts without verifying or decoding it
+	 */
+	static FLobbySendBenchmarkResult RunParseFrame(int32 NewIterations, bool bNewLengthPrefixed);
+
+	/**
+	 * What the receive stage does with one response frame: split, verify, parse the body and decode the envelope.
+	 * Runs on the calling thread, without the gate and the queue to the game thread.
+	 */
+	static FLobbySendBenchmarkResult RunReceivePipeline(int32 NewIterations, bool bNewLengthPrefixed);
+
+	/**
+	 * Round trip check of the hand written serializers: the enum name tables against UEnum, the chat, envelope
+	 * and database output against the unmodified text FJsonObjectConverter wrote for the baseline, with only the
+	 * known differences listed in the source allowed, and that output read back into its struct field by field.
+	 * Returns false and describes every difference in OutMismatches.
+	 */
+	static bool VerifySerializers(TArray<FString>& OutMismatches);
+
+	/**
+	 * Every microbenchmark above NewIterations times, and the serializer check
+	 */
+	static void RunStages(int32 NewIterations, FLobbyBenchmarkReport& OutReport);
+
+	/**
+	 * Write the report as JSON, together with the engine, build and machine it was measured on
+	 */
+	static bool SaveReport(const FLobbyBenchmarkReport& NewReport, const FString& NewPath);
+};
@@ -0,0 +1,155 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LobbyBenchmark.h"
+#include "LobbyClient.h"
+#include "LobbyGameInstanceSubsystem.h"
+#include "LobbyTestUtils.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Paths.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/**
+	 * A count that can be raised from the command line, like -LobbyBenchIterations=100000
+	 */
+	int32 GetBenchmarkCount(const TCHAR* NewParam, int32 NewDefault)
+	{
+		int32 R_Count = NewDefault;
+		FParse::Value(FCommandLine::Get(), NewParam, R_Count);
+		return FMath::Max(R_Count, 1);
+	}
+
+	/**
+	 * <NewName>-<time>.json in Saved/Benchmarks, or in the directory given with -LobbyBenchReportDir=
+	 */
+	FString GetReportPath(const TCHAR* NewName)
+	{
+		FString Directory = FPaths::ProjectSavedDir() / TEXT("Benchmarks");
+		FParse::Value(FCommandLine::Get(), TEXT("LobbyBenchReportDir="), Directory);
+		return Directory / FString::Printf(TEXT("%s-%s.json"), NewName, *FDateTime::Now().ToString());
+	}
+
+	/**
+	 * Shared between the test that starts the end to end run and the latent command that waits for it
+	 */
+	struct FLobbyEndToEndTestState
+	{
+		TStrongObjectPtr<UGameInstance> GameInstance;
+
+		FLobbyEndToEndResult Result;
+
+		bool bFinished = false;
+	};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLobbySerializersTest, "LobbyClient.Serializers",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FLobbySerializersTest::RunTest(const FString& Parameters)
+{
+	TArray<FString> Mismatches;
+	FLobbyBenchmark::VerifySerializers(Mismatches);
+	for (const FString& Mismatch : Mismatches)
+	{
+		AddError(Mismatch);
+	}
+	return Mismatches.Num() == 0;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLobbyBenchmarkStagesTest, "LobbyClient.Benchmark.Stages",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FLobbyBenchmarkStagesTest::RunTest(const FString& Parameters)
+{
+	FLobbyBenchmarkReport Report;
+	FLobbyBenchmark::RunStages(GetBenchmarkCount(TEXT("LobbyBenchIterations="), 10000), Report);
+
+	for (const TPair<FString, FLobbySendBenchmarkResult>& Stage : Report.Stages)
+	{
+		AddInfo(FString::Printf(TEXT("%-30s bytes=%5d  us/msg=%8.3f  allocs/msg=%6.2f"),
+			*Stage.Key, Stage.Value.WireBytes, Stage.Value.MicrosecondsPerMessage, Stage.Value.AllocationsPerMessage));
+
+		// A stage whose frame did not parse or verify reports 0 bytes, its time would mean nothing
+		if (Stage.Value.WireBytes <= 0)
+		{
+			AddError(FString::Printf(TEXT("The stage %s processed nothing."), *Stage.Key));
+		}
+	}
+	for (const FString& Mismatch : Report.SerializerMismatches)
+	{
+		AddError(FString::Printf(TEXT("serializers: %s"), *Mismatch));
+	}
+
+	TestTrue(TEXT("The report is written"), FLobbyBenchmark::SaveReport(Report, GetReportPath(TEXT("LobbyStages"))));
+	return !HasAnyErrors();
+}
+
+/**
+ * Wait for the end to end run, check it and shut its game instance down
+ */
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FLobbyWaitForEndToEndCommand, FAutomationTestBase*, Test, TSharedRef<FLobbyEndToEndTestState>, State);
+
+bool FLobbyWaitForEndToEndCommand::Update()
+{
+	if (!State->bFinished)
+	{
+		return false;
+	}
+
+	const FLobbyEndToEndResult& Result = State->Result;
+	Test->AddInfo(FString::Printf(TEXT("end to end: %d/%d answered in %.2f s, %.0f req/s, p50=%.3f ms  p99=%.3f ms  max=%.3f ms"),
+		Result.Succeeded, Result.Requests, Result.Seconds, Result.RequestsPerSecond,
+		Result.Latency.P50Milliseconds, Result.Latency.P99Milliseconds, Result.Latency.MaxMilliseconds));
+	if (!Result.bCompleted)
+	{
+		Test->AddError(TEXT("The end to end run did not complete, see the log for why."));
+	}
+	if (Result.Failed > 0)
+	{
+		Test->AddError(FString::Printf(TEXT("%d of %d requests failed."), Result.Failed, Result.Requests));
+	}
+	if (Result.ServerStats.InvalidFrames > 0)
+	{
+		Test->AddError(FString::Printf(TEXT("The loopback server dropped %lld invalid frames."), Result.ServerStats.InvalidFrames));
+	}
+
+	FLobbyBenchmarkReport Report;
+	Report.bHasEndToEnd = true;
+	Report.EndToEnd = Result;
+	Test->TestTrue(TEXT("The report is written"), FLobbyBenchmark::SaveReport(Report, GetReportPath(TEXT("LobbyEndToEnd"))));
+
+	NGG_LOBBY_TESTS::ShutdownGameInstance(State->GameInstance);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLobbyBenchmarkEndToEndTest, "LobbyClient.Benchmark.EndToEnd",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::PerfFilter)
+
+bool FLobbyBenchmarkEndToEndTest::RunTest(const FString& Parameters)
+{
+	const TSharedRef<FLobbyEndToEndTestState> State = MakeShared<FLobbyEndToEndTestState>();
+	State->GameInstance.Reset(NGG_LOBBY_TESTS::CreateGameInstance());
+
+	ULobbyGameInstanceSubsystem* Subsystem = State->GameInstance->GetSubsystem<ULobbyGameInstanceSubsystem>();
+	if (!TestNotNull(TEXT("The lobby subsystem"), Subsystem))
+	{
+		NGG_LOBBY_TESTS::ShutdownGameInstance(State->GameInstance);
+		return false;
+	}
+
+	// The run finishes on its own, at the latest when its timeout is up
+	FLobbyEndToEndBenchmark::Run(Subsystem, GetBenchmarkCount(TEXT("LobbyBenchRequests="), 10000), 64, 120.f,
+		FLobbyEndToEndBenchmark::FOnFinished::CreateLambda([State](const FLobbyEndToEndResult& NewResult)
+	{
+		State->Result = NewResult;
+		State->bFinished = true;
+	}));
+	ADD_LATENT_AUTOMATION_COMMAND(FLobbyWaitForEndToEndCommand(this, State));
+	return true;
+}
+
+#endif
@@ -0,0 +1,216 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LobbyBson.h"
+#include "LobbyTestUtils.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+using NGG_LOBBY_TESTS::ToUtf8;
+using NGG_LOBBY_TESTS::ToString;
+
+namespace
+{
+	FUtf8StringView ToView(const TArray<UTF8CHAR>& NewBuffer)
+	{
+		return FUtf8StringView(NewBuffer.GetData(), NewBuffer.Num());
+	}
+
+	void PatchInt32(TArray<UTF8CHAR>& InOutBuffer, int32 NewOffset, int32 NewValue)
+	{
+		FMemory::Memcpy(InOutBuffer.GetData() + NewOffset, &NewValue, sizeof(int32));
+	}
+
+	/**
+	 * NewLevels documents inside the root, each under the key "d"
+	 */
+	TArray<UTF8CHAR> MakeNestedDocument(int32 NewLevels)
+	{
+		TArray<UTF8CHAR> R_Buffer;
+		FLobbyBsonWriter Writer(R_Buffer);
+		Writer.BeginObject();
+		for (int32 Level = 0; Level < NewLevels; ++Level)
+		{
+			Writer.WriteKey("d");
+			Writer.BeginObject();
+		}
+		for (int32 Level = 0; Level <= NewLevels; ++Level)
+		{
+			Writer.EndObject();
+		}
+		return R_Buffer;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLobbyBsonViewFindTest, "LobbyClient.BsonView.Find",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FLobbyBsonViewFindTest::RunTest(const FString& Parameters)
+{
+	TArray<UTF8CHAR> Buffer;
+	FLobbyBsonWriter Writer(Buffer);
+	Writer.BeginObject();
+	Writer.WriteKey("ss");
+	Writer.WriteString(ToUtf8("long key"));
+	Writer.WriteKey("s");
+	Writer.WriteString(ToUtf8("hi"));
+	Writer.WriteKey("n");
+	Writer.WriteInt(7);
+	Writer.WriteKey("big");
+	Writer.WriteInt(5000000000);
+	Writer.WriteKey("d");
+	Writer.BeginObject();
+	Writer.WriteKey("k");
+	Writer.WriteBool(true);
+	Writer.EndObject();
+	Writer.WriteKey("a");
+	Writer.BeginArray();
+	Writer.WriteDouble(1.5);
+	Writer.WriteString(ToUtf8("x"));
+	Writer.EndArray();
+	Writer.WriteKey("z");
+	Writer.WriteNull();
+	Writer.EndObject();
+
+	if (!TestTrue(TEXT("A written document is valid"), FLobbyBsonView::IsValid(ToView(Buffer))))
+	{
+		return false;
+	}
+
+	const FLobbyBsonView View(ToView(Buffer));
+	FLobbyBsonView::FElement Element;
+	TestTrue(TEXT("A string is found"), View.Find("s", Element));
+	TestEqual(TEXT("A key that prefixes another one finds its own value"), ToString(Element.AsString()), FString(TEXT("hi")));
+	TestTrue(TEXT("An int32 is found"), View.Find("n", Element) && Element.Type == NGG_LOBBY_BSON::INT32);
+	TestEqual(TEXT("The int32"), Element.AsInt(), static_cast<int64>(7));
+	TestTrue(TEXT("An int64 is found"), View.Find("big", Element) && Element.Type == NGG_LOBBY_BSON::INT64);
+	TestEqual(TEXT("The int64"), Element.AsInt(), static_cast<int64>(5000000000));
+	TestTrue(TEXT("A null is found"), View.Find("z", Element) && Element.Type == NGG_LOBBY_BSON::NULL_VALUE);
+	TestEqual(TEXT("A null is no string"), Element.AsString().Len(), 0);
+
+	TestTrue(TEXT("A nested document is found"), View.Find("d", Element));
+	const FLobbyBsonView Nested = Element.AsDocument();
+	TestTrue(TEXT("A key of the nested document is found"), Nested.Find("k", Element) && Element.AsBool());
+	TestFalse(TEXT("A key of the nested document is not found at the root"), View.Find("k", Element));
+
+	TestTrue(TEXT("An array is found"), View.Find("a", Element) && Element.Type == NGG_LOBBY_BSON::ARRAY);
+	const FLobbyBsonView Array = Element.AsDocument();
+	TestTrue(TEXT("The first array element is keyed 0"), Array.Find("0", Element));
+	TestEqual(TEXT("The first array element"), Element.AsDouble(), 1.5);
+	TestTrue(TEXT("The second array element is keyed 1"), Array.Find("1", Element));
+	TestEqual(TEXT("The second array element"), ToString(Element.AsString()), FString(TEXT("x")));
+
+	TestFalse(TEXT("A missing key is not found"), View.Find("missing", Element));
+	TestFalse(TEXT("A prefix of a key is not found"), View.Find("b", Element));
+	TestFalse(TEXT("An empty key is not found"), View.Find("", Element));
+	TestFalse(TEXT("An empty view finds nothing"), FLobbyBsonView().Find("s", Element));
+
+	int32 Offset = 0;
+	int32 Elements = 0;
+	while (View.Next(Offset, Element))
+	{
+		++Elements;
+	}
+	TestEqual(TEXT("Next steps over every element"), Elements, 7);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLobbyBsonViewIsValidTest, "LobbyClient.BsonView.IsValid",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FLobbyBsonViewIsValidTest::RunTest(const FString& Parameters)
+{
+	// {"s":"hi"}: length at 0, type at 4, key at 5, string length at 7, string at 11, terminator at 14
+	TArray<UTF8CHAR> Valid;
+	FLobbyBsonWriter Writer(Valid);
+	Writer.BeginObject();
+	Writer.WriteKey("s");
+	Writer.WriteString(ToUtf8("hi"));
+	Writer.EndObject();
+	if (!TestEqual(TEXT("The layout the cases patch"), Valid.Num(), 15) || !TestTrue(TEXT("The document is valid"), FLobbyBsonView::IsValid(ToView(Valid))))
+	{
+		return false;
+	}
+
+	const TArray<UTF8CHAR> Empty = { UTF8CHAR(5), UTF8CHAR(0), UTF8CHAR(0), UTF8CHAR(0), UTF8CHAR(0) };
+	TestTrue(TEXT("An empty document is valid"), FLobbyBsonView::IsValid(ToView(Empty)));
+
+	struct FHostileCase
+	{
+		const TCHAR* Name;
+		TFunction<void(TArray<UTF8CHAR>&)> Patch;
+	};
+	const FHostileCase HostileCases[] =
+	{
+		{ TEXT("No bytes"), [](TArray<UTF8CHAR>& Bytes) { Bytes.Reset(); } },
+		{ TEXT("Shorter than the smallest document"), [](TArray<UTF8CHAR>& Bytes) { Bytes.SetNum(4); PatchInt32(Bytes, 0, 4); } },
+		{ TEXT("A length one too large"), [](TArray<UTF8CHAR>& Bytes) { PatchInt32(Bytes, 0, 16); } },
+		{ TEXT("A length one too small"), [](TArray<UTF8CHAR>& Bytes) { PatchInt32(Bytes, 0, 14); } },
+		{ TEXT("A negative length"), [](TArray<UTF8CHAR>& Bytes) { PatchInt32(Bytes, 0, -15); } },
+		{ TEXT("A huge length"), [](TArray<UTF8CHAR>& Bytes) { PatchInt32(Bytes, 0, MAX_int32); } },
+		{ TEXT("A missing document terminator"), [](TArray<UTF8CHAR>& Bytes) { Bytes.Last() = UTF8CHAR('x'); } },
+		{ TEXT("Trailing bytes"), [](TArray<UTF8CHAR>& Bytes) { Bytes.Add(UTF8CHAR(0)); PatchInt32(Bytes, 0, Bytes.Num()); } },
+		{ TEXT("An unknown type"), [](TArray<UTF8CHAR>& Bytes) { Bytes[4] = UTF8CHAR(0x7F); } },
+		{ TEXT("A string of length 0"), [](TArray<UTF8CHAR>& Bytes) { PatchInt32(Bytes, 7, 0); } },
+		{ TEXT("A negative string length"), [](TArray<UTF8CHAR>& Bytes) { PatchInt32(Bytes, 7, -1); } },
+		{ TEXT("A string length past the document"), [](TArray<UTF8CHAR>& Bytes) { PatchInt32(Bytes, 7, 4); } },
+		{ TEXT("A huge string length"), [](TArray<UTF8CHAR>& Bytes) { PatchInt32(Bytes, 7, MAX_int32); } },
+		{ TEXT("A string without its terminator"), [](TArray<UTF8CHAR>& Bytes) { Bytes[13] = UTF8CHAR('!'); } },
+		{ TEXT("A string one byte short"), [](TArray<UTF8CHAR>& Bytes) { PatchInt32(Bytes, 7, 2); } },
+		{ TEXT("A key without its terminator"), [](TArray<UTF8CHAR>& Bytes)
+			{
+				Bytes = { UTF8CHAR(8), UTF8CHAR(0), UTF8CHAR(0), UTF8CHAR(0), UTF8CHAR(NGG_LOBBY_BSON::STRING), UTF8CHAR('a'), UTF8CHAR('b'), UTF8CHAR(0) };
+			} },
+		{ TEXT("A type byte without a key"), [](TArray<UTF8CHAR>& Bytes)
+			{
+				Bytes = { UTF8CHAR(6), UTF8CHAR(0), UTF8CHAR(0), UTF8CHAR(0), UTF8CHAR(NGG_LOBBY_BSON::INT32), UTF8CHAR(0) };
+			} },
+		{ TEXT("An int32 cut short"), [](TArray<UTF8CHAR>& Bytes)
+			{
+				Bytes = { UTF8CHAR(9), UTF8CHAR(0), UTF8CHAR(0), UTF8CHAR(0), UTF8CHAR(NGG_LOBBY_BSON::INT32), UTF8CHAR('n'), UTF8CHAR(0), UTF8CHAR(1), UTF8CHAR(0) };
+			} },
+	};
+	for (const FHostileCase& HostileCase : HostileCases)
+	{
+		TArray<UTF8CHAR> Bytes = Valid;
+		HostileCase.Patch(Bytes);
+		TestFalse(FString::Printf(TEXT("%s is refused"), HostileCase.Name), FLobbyBsonView::IsValid(ToView(Bytes)));
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLobbyBsonViewNestedTest, "LobbyClient.BsonView.Nested",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FLobbyBsonViewNestedTest::RunTest(const FString& Parameters)
+{
+	// {"d":{}}: the nested length at 7, the nested terminator at 11
+	TArray<UTF8CHAR> Valid = MakeNestedDocument(1);
+	if (!TestEqual(TEXT("The layout the cases patch"), Valid.Num(), 13) || !TestTrue(TEXT("A nested document is valid"), FLobbyBsonView::IsValid(ToView(Valid))))
+	{
+		return false;
+	}
+
+	const int32 NestedLengths[] = { -1, 0, 4, 6, MAX_int32 };
+	for (const int32 NestedLength : NestedLengths)
+	{
+		TArray<UTF8CHAR> Bytes = Valid;
+		PatchInt32(Bytes, 7, NestedLength);
+		TestFalse(FString::Printf(TEXT("A nested length of %d is refused"), NestedLength), FLobbyBsonView::IsValid(ToView(Bytes)));
+	}
+
+	TArray<UTF8CHAR> Bytes = Valid;
+	Bytes[11] = UTF8CHAR('x');
+	TestFalse(TEXT("A nested document without its terminator is refused"), FLobbyBsonView::IsValid(ToView(Bytes)));
+
+	Bytes = Valid;
+	Bytes[4] = UTF8CHAR(NGG_LOBBY_BSON::ARRAY);
+	TestTrue(TEXT("An empty array is valid"), FLobbyBsonView::IsValid(ToView(Bytes)));
+
+	TestTrue(TEXT("Nesting down to the limit is valid"), FLobbyBsonView::IsValid(ToView(MakeNestedDocument(NGG_LOBBY_BSON::MAX_DEPTH))));
+	TestFalse(TEXT("Nesting past the limit is refused"), FLobbyBsonView::IsValid(ToView(MakeNestedDocument(NGG_LOBBY_BSON::MAX_DEPTH + 1))));
+	return true;
+}
+
+#endif
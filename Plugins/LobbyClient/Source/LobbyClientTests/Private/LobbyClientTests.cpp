@@ -0,0 +1,6 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Modules/ModuleManager.h"
+
+// Automation tests, benchmarks, the load commandlet and the loopback server, never part of a shipped game
+IMPLEMENT_MODULE(FDefaultModuleImpl, LobbyClientTests)
@@ -0,0 +1,141 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LobbyEndToEndBenchmark.h"
+#include "LobbyClient.h"
+#include "LobbyGameInstanceSubsystem.h"
+
+bool FLobbyEndToEndBenchmark::Run(ULobbyGameInstanceSubsystem* NewSubsystem, int32 NewRequests, int32 NewWindow, float NewTimeoutSeconds, FOnFinished NewOnFinished, uint32 NewPort)
+{
+	const TSharedRef<FLobbyEndToEndBenchmark> Benchmark = MakeShared<FLobbyEndToEndBenchmark>();
+	Benchmark->Subsystem = NewSubsystem;
+	Benchmark->OnFinished = MoveTemp(NewOnFinished);
+	Benchmark->Result.Requests = FMath::Max(NewRequests, 1);
+	Benchmark->Window = FMath::Max(NewWindow, 1);
+	Benchmark->TimeoutSeconds = NewTimeoutSeconds;
+	Benchmark->Deadline = FPlatformTime::Seconds() + NewTimeoutSeconds;
+
+	// A connected subsystem is talking to a real server, the run would take it over
+	if (NewSubsystem == nullptr || NewSubsystem->GetConnectionState() != ELobbyConnectionState::DISCONNECTED)
+	{
+		UE_LOG(LogLobbyClient, Error, TEXT("The end to end benchmark needs a disconnected lobby subsystem."));
+		Benchmark->Finish(false);
+		return false;
+	}
+
+	const FJWTConfig& Config = NewSubsystem->GetJWTConfig();
+	if (!Benchmark->Server.Start(NewPort, Config.ClientSecret, Config.ClientId))
+	{
+		Benchmark->Finish(false);
+		return false;
+	}
+
+	NewSubsystem->ConnectToLobbyServer(Benchmark->Server.GetURL());
+	FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([Benchmark](float NewDeltaTime)
+	{
+		return Benchmark->Tick(NewDeltaTime);
+	}));
+	return true;
+}
+
+bool FLobbyEndToEndBenchmark::Tick(float NewDeltaTime)
+{
+	if (bFinished)
+	{
+		return false;
+	}
+
+	ULobbyGameInstanceSubsystem* BoundSubsystem = Subsystem.Get();
+	if (BoundSubsystem == nullptr)
+	{
+		Finish(false);
+		return false;
+	}
+
+	if (FPlatformTime::Seconds() > Deadline)
+	{
+		UE_LOG(LogLobbyClient, Warning, TEXT("The end to end benchmark timed out after %.0f seconds with %d of %d requests answered."), TimeoutSeconds, Answered, Result.Requests);
+		Finish(false);
+		return false;
+	}
+
+	if (StartTime == 0.0)
+	{
+		if (BoundSubsystem->GetConnectionState() != ELobbyConnectionState::CONNECTED)
+		{
+			return true;
+		}
+		StartTime = FPlatformTime::Seconds();
+	}
+
+	SendRequests(*BoundSubsystem);
+	return !bFinished;
+}
+
+void FLobbyEndToEndBenchmark::SendRequests(ULobbyGameInstanceSubsystem& NewSubsystem)
+{
+	while (!bFinished && Sent < Result.Requests && Sent - Answered < Window)
+	{
+		FChatData ChatData;
+		ChatData.SenderPlayerId = TEXT("bench-player-0001");
+		ChatData.RecipientPlayerId = TEXT("bench-player-0002");
+		ChatData.Message = FString::Printf(TEXT("benchmark message %d"), Sent);
+		++Sent;
+		NewSubsystem.SendChatMessage(ChatData, FOnLobbyResponseNative::CreateSP(this, &FLobbyEndToEndBenchmark::OnResponse, FPlatformTime::Seconds()), TimeoutSeconds);
+	}
+}
+
+void FLobbyEndToEndBenchmark::OnResponse(const FLobbyResponse& NewResponse, double NewSentTime)
+{
+	if (bFinished)
+	{
+		return;
+	}
+
+	++Answered;
+	if (NewResponse.Status == ELobbyRequestStatus::SUCCESS)
+	{
+		++Result.Succeeded;
+		Latency.Add(FPlatformTime::Seconds() - NewSentTime);
+	}
+	else
+	{
+		++Result.Failed;
+	}
+
+	if (Answered >= Result.Requests)
+	{
+		Finish(true);
+	}
+	else if (ULobbyGameInstanceSubsystem* BoundSubsystem = Subsystem.Get())
+	{
+		// Refilled right away, waiting for the next tick would measure the frame rate
+		SendRequests(*BoundSubsystem);
+	}
+}
+
+void FLobbyEndToEndBenchmark::Finish(bool bNewCompleted)
+{
+	if (bFinished)
+	{
+		return;
+	}
+	bFinished = true;
+
+	if (StartTime > 0.0)
+	{
+		Result.Seconds = FPlatformTime::Seconds() - StartTime;
+		Result.RequestsPerSecond = Result.Seconds > 0.0 ? Answered / Result.Seconds : 0.0;
+	}
+	Result.bCompleted = bNewCompleted;
+	Result.Latency = Latency.GetStats();
+	Result.ServerStats = Server.GetStats();
+
+	// Requests still queued are cancelled here, their callbacks find the run finished
+	if (ULobbyGameInstanceSubsystem* BoundSubsystem = Subsystem.Get(); BoundSubsystem != nullptr && Server.IsRunning())
+	{
+		BoundSubsystem->DisconnectFromLobbyServer();
+	}
+	Server.Stop();
+	OnFinished.ExecuteIfBound(Result);
+}
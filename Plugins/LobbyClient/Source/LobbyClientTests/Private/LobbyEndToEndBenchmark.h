@@ -0,0 +1,96 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "LobbyTypes.h"
+#include "LobbyStats.h"
+#include "LobbyLoopbackServer.h"
+
+class ULobbyGameInstanceSubsystem;
+
+/**
+ * One run of chat requests through the subsystem to the loopback server and back
+ */
+struct FLobbyEndToEndResult
+{
+	/**
+	 * False if the run could not start, timed out or lost the subsystem
+	 */
+	bool bCompleted = false;
+	int32 Requests = 0;
+	int32 Succeeded = 0;
+	int32 Failed = 0;
+	/**
+	 * From the connection coming up to the last answer
+	 */
+	double Seconds = 0.0;
+	double RequestsPerSecond = 0.0;
+	/**
+	 * From SendChatMessage to the response delegate, so queueing, both stages and the sockets are all in it
+	 */
+	FLobbyLatencyStats Latency;
+	FLobbyLoopbackServerStats ServerStats;
+};
+
+/**
+ * Throughput and latency of the whole client against FLobbyLoopbackServer on this machine. The subsystem sends
+ * as the game configured it, framing, batching and compression included, and keeps a fixed number of requests unanswered.
+ * The run owns itself through its ticker until it finishes. Game thread only.
+ */
+class FLobbyEndToEndBenchmark : public TSharedFromThis<FLobbyEndToEndBenchmark>
+{
+public:
+
+	DECLARE_DELEGATE_OneParam(FOnFinished, const FLobbyEndToEndResult& /*Result*/);
+
+	static constexpr uint32 DEFAULT_PORT = 18830;
+
+	/**
+	 * Start the loopback server with the subsystem's key, connect NewSubsystem to it and send NewRequests chat messages,
+	 * at most NewWindow of them unanswered. The subsystem must be disconnected, it is disconnected again at the end.
+	 * NewOnFinished is called once whatever the outcome, also when false is returned.
+	 */
+	static bool Run(ULobbyGameInstanceSubsystem* NewSubsystem, int32 NewRequests, int32 NewWindow, float NewTimeoutSeconds, FOnFinished NewOnFinished, uint32 NewPort = DEFAULT_PORT);
+
+private:
+
+	bool Tick(float NewDeltaTime);
+
+	/**
+	 * Fill the window back up
+	 */
+	void SendRequests(ULobbyGameInstanceSubsystem& NewSubsystem);
+
+	void OnResponse(const FLobbyResponse& NewResponse, double NewSentTime);
+
+	void Finish(bool bNewCompleted);
+
+	TWeakObjectPtr<ULobbyGameInstanceSubsystem> Subsystem;
+
+	FLobbyLoopbackServer Server;
+
+	FLobbyLatencyHistogram Latency;
+
+	FLobbyEndToEndResult Result;
+
+	FOnFinished OnFinished;
+
+	int32 Window = 1;
+
+	int32 Sent = 0;
+
+	int32 Answered = 0;
+
+	float TimeoutSeconds = 0.f;
+
+	double Deadline = 0.0;
+
+	/**
+	 * 0 until the connection is up
+	 */
+	double StartTime = 0.0;
+
+	bool bFinished = false;
+};
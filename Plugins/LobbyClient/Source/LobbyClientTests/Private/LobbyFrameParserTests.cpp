@@ -0,0 +1,156 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LobbyFrame.h"
+#include "LobbyTestUtils.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+using NGG_LOBBY_TESTS::ToUtf8;
+using NGG_LOBBY_TESTS::ToString;
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLobbyFrameParserLengthPrefixedTest, "LobbyClient.FrameParser.LengthPrefixed",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FLobbyFrameParserLengthPrefixedTest::RunTest(const FString& Parameters)
+{
+	FLobbyFrameView FrameView;
+	TestTrue(TEXT("A valid frame parses"), FLobbyFrameParser::Parse(ToUtf8("NGG2:2:id3:1232:{}3:sig"), FrameView));
+	TestEqual(TEXT("Version"), static_cast<int32>(FrameView.Version), 2);
+	TestEqual(TEXT("Client id"), ToString(FrameView[NGG_LOBBY_PROTOCOL::CLIENT_ID]), FString(TEXT("id")));
+	TestEqual(TEXT("Timestamp"), ToString(FrameView[NGG_LOBBY_PROTOCOL::TIMESTAMP]), FString(TEXT("123")));
+	TestEqual(TEXT("Body"), ToString(FrameView[NGG_LOBBY_PROTOCOL::JSON]), FString(TEXT("{}")));
+	TestEqual(TEXT("Signature"), ToString(FrameView[NGG_LOBBY_PROTOCOL::SIGNATURE]), FString(TEXT("sig")));
+
+	// The length decides where the body ends, braces and delimiters inside it do not
+	TestTrue(TEXT("A body with delimiters parses"), FLobbyFrameParser::ParseLengthPrefixed(ToUtf8("NGG2:2:id3:1236:{\"}:\"}3:sig"), FrameView));
+	TestEqual(TEXT("Body with delimiters"), ToString(FrameView[NGG_LOBBY_PROTOCOL::JSON]), FString(TEXT("{\"}:\"}")));
+	TestTrue(TEXT("Empty sections parse"), FLobbyFrameParser::ParseLengthPrefixed(ToUtf8("NGG2:0:0:0:0:"), FrameView));
+
+	TestTrue(TEXT("Both flags parse"), FLobbyFrameParser::ParseLengthPrefixed(ToUtf8("NGG2zb:2:id3:1232:{}3:sig"), FrameView));
+	TestEqual(TEXT("Flags"), static_cast<int32>(FrameView.Flags),
+		static_cast<int32>(NGG_LOBBY_PROTOCOL_V2::FRAME_FLAG_DEFLATE | NGG_LOBBY_PROTOCOL_V2::FRAME_FLAG_BSON));
+
+	const ANSICHAR* const HostileFrames[] =
+	{
+		"NGG2",
+		"NGG2:",
+		"NGG2zz:2:id3:1232:{}3:sig",
+		"NGG2x:2:id3:1232:{}3:sig",
+		"NGG2z",
+		"NGG2:2:id3:1232:{}3:sigX",
+		"NGG2:2:id3:1232:{}4:sig",
+		"NGG2:2:id3:1232:{}",
+		"NGG2:2:id3:1232:{}3sig",
+		"NGG2::id3:1232:{}3:sig",
+		"NGG2:-2:id3:1232:{}3:sig",
+		"NGG2: 2:id3:1232:{}3:sig",
+		"NGG2:2:id3:123999999999:{}3:sig",
+		"NGG2:2:id3:1232147483648:{}3:sig",
+		"NGG2:2:id3:1234294967298:{}3:sig",
+		"NGG2:2:id3:12300000000002:{}3:sig",
+	};
+	for (const ANSICHAR* const HostileFrame : HostileFrames)
+	{
+		TestFalse(FString::Printf(TEXT("%s is refused"), ANSI_TO_TCHAR(HostileFrame)), FLobbyFrameParser::ParseLengthPrefixed(ToUtf8(HostileFrame), FrameView));
+		TestFalse(TEXT("A refused frame leaves an invalid view"), FrameView.IsValid());
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLobbyFrameParserLegacyTest, "LobbyClient.FrameParser.Legacy",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FLobbyFrameParserLegacyTest::RunTest(const FString& Parameters)
+{
+	FLobbyFrameView FrameView;
+	TestTrue(TEXT("A valid frame parses"), FLobbyFrameParser::Parse(ToUtf8("0123456789abcdef0123456789abcdef1700000000000{\"a\":\"}{\\\"\"}sig"), FrameView));
+	TestEqual(TEXT("Version"), static_cast<int32>(FrameView.Version), 1);
+	TestEqual(TEXT("Client id"), ToString(FrameView[NGG_LOBBY_PROTOCOL::CLIENT_ID]), FString(TEXT("0123456789abcdef0123456789abcdef")));
+	TestEqual(TEXT("Timestamp"), ToString(FrameView[NGG_LOBBY_PROTOCOL::TIMESTAMP]), FString(TEXT("1700000000000")));
+	TestEqual(TEXT("Braces in strings do not end the body"), ToString(FrameView[NGG_LOBBY_PROTOCOL::JSON]), FString(TEXT("{\"a\":\"}{\\\"\"}")));
+	TestEqual(TEXT("Signature"), ToString(FrameView[NGG_LOBBY_PROTOCOL::SIGNATURE]), FString(TEXT("sig")));
+
+	// A 32 character client id may start with the magic of the length-prefixed layout
+	TestTrue(TEXT("A client id starting with NGG2 parses"), FLobbyFrameParser::Parse(ToUtf8("NGG2:56789abcdef0123456789abcdef1700000000000{\"b\":{}}sig"), FrameView));
+	TestEqual(TEXT("Version of a legacy frame with the magic"), static_cast<int32>(FrameView.Version), 1);
+	TestEqual(TEXT("Client id with the magic"), ToString(FrameView[NGG_LOBBY_PROTOCOL::CLIENT_ID]), FString(TEXT("NGG2:56789abcdef0123456789abcdef")));
+	TestEqual(TEXT("Body of a legacy frame with the magic"), ToString(FrameView[NGG_LOBBY_PROTOCOL::JSON]), FString(TEXT("{\"b\":{}}")));
+
+	// A batch body is an array of envelopes, brackets inside strings do not end it
+	TestTrue(TEXT("A batch frame parses"), FLobbyFrameParser::Parse(ToUtf8("0123456789abcdef0123456789abcdef1700000000000[{\"a\":\"]\"},{\"b\":[1,{}]}]sig"), FrameView));
+	TestEqual(TEXT("Batch body"), ToString(FrameView[NGG_LOBBY_PROTOCOL::JSON]), FString(TEXT("[{\"a\":\"]\"},{\"b\":[1,{}]}]")));
+	TestEqual(TEXT("Batch signature"), ToString(FrameView[NGG_LOBBY_PROTOCOL::SIGNATURE]), FString(TEXT("sig")));
+
+	const ANSICHAR* const HostileFrames[] =
+	{
+		"",
+		"0123456789abcdef0123456789abcdef",
+		"0123456789abcdef0123456789abcdef1700000000000",
+		"0123456789abcdef0123456789abcdef1700000000000{\"a\":1",
+		"0123456789abcdef0123456789abcdef1700000000000{\"a\":\"}sig",
+		"0123456789abcdef0123456789abcdef1700000000000{{}sig",
+		"0123456789abcdef0123456789abcdef1700000000000[{},{}sig",
+		"0123456789abcdef0123456789abcdef1700000000000[\"]sig",
+	};
+	for (const ANSICHAR* const HostileFrame : HostileFrames)
+	{
+		TestFalse(FString::Printf(TEXT("%s is refused"), ANSI_TO_TCHAR(HostileFrame)), FLobbyFrameParser::Parse(ToUtf8(HostileFrame), FrameView));
+		TestFalse(TEXT("A refused frame leaves an invalid view"), FrameView.IsValid());
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLobbyFrameParserTimestampTest, "LobbyClient.FrameParser.Timestamp",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FLobbyFrameParserTimestampTest::RunTest(const FString& Parameters)
+{
+	int64 Timestamp = 0;
+	TestTrue(TEXT("Digits parse"), FLobbyFrameParser::ParseTimestamp(ToUtf8("1700000000123"), Timestamp));
+	TestEqual(TEXT("Timestamp"), Timestamp, static_cast<int64>(1700000000123));
+	TestTrue(TEXT("18 digits parse"), FLobbyFrameParser::ParseTimestamp(ToUtf8("999999999999999999"), Timestamp));
+
+	const ANSICHAR* const HostileTimestamps[] = { "", "-1", "+1", " 1", "1 ", "12a", "0x10", "9999999999999999999" };
+	for (const ANSICHAR* const HostileTimestamp : HostileTimestamps)
+	{
+		TestFalse(FString::Printf(TEXT("'%s' is refused"), ANSI_TO_TCHAR(HostileTimestamp)), FLobbyFrameParser::ParseTimestamp(ToUtf8(HostileTimestamp), Timestamp));
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLobbyFrameWriterRoundTripTest, "LobbyClient.FrameParser.WriterRoundTrip",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FLobbyFrameWriterRoundTripTest::RunTest(const FString& Parameters)
+{
+	const FUtf8StringView ClientId = ToUtf8("NGG2ef0123456789abcdef0123456789");
+	const FUtf8StringView Body = ToUtf8("{\"payLoadData\":\"}{\"}");
+	const FUtf8StringView Signature = ToUtf8("0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef");
+
+	for (const bool bLengthPrefixed : { false, true })
+	{
+		TArray<UTF8CHAR> Buffer;
+		FLobbyFrameWriter Writer(Buffer, bLengthPrefixed);
+		Writer.BeginBody(ClientId, 1700000000123);
+		Buffer.Append(Body.GetData(), Body.Len());
+		Writer.EndBody();
+		Writer.WriteSignature(Signature);
+
+		FLobbyFrameView FrameView;
+		const FString Layout = bLengthPrefixed ? TEXT("length-prefixed") : TEXT("legacy");
+		if (!TestTrue(FString::Printf(TEXT("The %s frame parses"), *Layout), FLobbyFrameParser::Parse(FUtf8StringView(Buffer.GetData(), Buffer.Num()), FrameView)))
+		{
+			continue;
+		}
+		TestEqual(FString::Printf(TEXT("The %s version"), *Layout), static_cast<int32>(FrameView.Version), bLengthPrefixed ? 2 : 1);
+		TestEqual(FString::Printf(TEXT("The %s client id"), *Layout), ToString(FrameView[NGG_LOBBY_PROTOCOL::CLIENT_ID]), ToString(ClientId));
+		TestEqual(FString::Printf(TEXT("The %s timestamp"), *Layout), ToString(FrameView[NGG_LOBBY_PROTOCOL::TIMESTAMP]), FString(TEXT("1700000000123")));
+		TestEqual(FString::Printf(TEXT("The %s body"), *Layout), ToString(FrameView[NGG_LOBBY_PROTOCOL::JSON]), ToString(Body));
+		TestEqual(FString::Printf(TEXT("The %s signature"), *Layout), ToString(FrameView[NGG_LOBBY_PROTOCOL::SIGNATURE]), ToString(Signature));
+	}
+	return true;
+}
+
+#endif
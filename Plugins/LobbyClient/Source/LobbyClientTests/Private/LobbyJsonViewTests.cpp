@@ -0,0 +1,247 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LobbyJsonView.h"
+#include "LobbyTestUtils.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+using NGG_LOBBY_TESTS::ToUtf8;
+using NGG_LOBBY_TESTS::ToString;
+
+namespace
+{
+	/**
+	 * NewDepth arrays, one inside the other
+	 */
+	TArray<UTF8CHAR> MakeNestedArrays(int32 NewDepth)
+	{
+		TArray<UTF8CHAR> R_Json;
+		R_Json.Init(UTF8CHAR('['), NewDepth);
+		for (int32 Level = 0; Level < NewDepth; ++Level)
+		{
+			R_Json.Add(UTF8CHAR(']'));
+		}
+		return R_Json;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLobbyJsonViewStructureTest, "LobbyClient.JsonView.Structure",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FLobbyJsonViewStructureTest::RunTest(const FString& Parameters)
+{
+	FLobbyJsonView View;
+	if (!TestTrue(TEXT("An object parses"), View.Parse(ToUtf8(" {\"a\":[1,{\"b\":\"x\"},[]],\"c\":{},\"n\":null,\"d\":{\"e\":{\"f\":true}},\"dup\":1,\"dup\":2}\n"))))
+	{
+		return false;
+	}
+
+	const FLobbyJsonView::FValue Root = View.GetRoot();
+	TestTrue(TEXT("The root is an object"), Root.IsObject());
+	TestEqual(TEXT("Members of the root"), Root.Num(), 6);
+
+	const FLobbyJsonView::FValue Array = Root.Find("a");
+	TestTrue(TEXT("A member array"), Array.IsArray());
+	TestEqual(TEXT("Elements of the array"), Array.Num(), 3);
+	TestEqual(TEXT("The array as text"), ToString(Array.GetText()), FString(TEXT("[1,{\"b\":\"x\"},[]]")));
+	TestEqual(TEXT("An object in the array"), Array.At(1).Find("b").AsString(), FString(TEXT("x")));
+	TestTrue(TEXT("An empty array in the array"), Array.At(2).IsArray() && Array.At(2).Num() == 0);
+	TestFalse(TEXT("An index past the end"), Array.At(3).IsValid());
+	TestFalse(TEXT("A negative index"), Array.At(-1).IsValid());
+	TestTrue(TEXT("An empty object"), Root.Find("c").IsObject() && Root.Find("c").Num() == 0);
+	TestTrue(TEXT("A null"), Root.Find("n").GetType() == FLobbyJsonView::EType::NULL_VALUE);
+
+	int32 Dup = 0;
+	TestTrue(TEXT("A repeated key is found"), Root.Find("dup").TryGetNumber(Dup));
+	TestEqual(TEXT("A repeated key gives its last value"), Dup, 2);
+
+	bool bFlag = false;
+	TestTrue(TEXT("A path through objects"), Root.FindPath("d.e.f").TryGetBool(bFlag) && bFlag);
+	TestEqual(TEXT("A path through an array"), Root.FindPath("a[1].b").AsString(), FString(TEXT("x")));
+	const ANSICHAR* const MissingPaths[] = { "missing", "missing.b", "a[9]", "a[x]", "a[1", "a[]", "d.e.f.g", "a.b" };
+	for (const ANSICHAR* const MissingPath : MissingPaths)
+	{
+		TestFalse(FString::Printf(TEXT("The path %s finds nothing"), ANSI_TO_TCHAR(MissingPath)), Root.FindPath(MissingPath).IsValid());
+	}
+
+	// Every accessor is safe on an invalid value and on the wrong type
+	const FLobbyJsonView::FValue Missing = Root.Find("missing");
+	FString Text;
+	double Number = 0.0;
+	TestEqual(TEXT("An invalid value has no members"), Missing.Num(), 0);
+	TestEqual(TEXT("An invalid value has no text"), Missing.GetText().Len(), 0);
+	TestFalse(TEXT("An invalid value is no string"), Missing.TryGetString(Text));
+	TestFalse(TEXT("An invalid value is no number"), Missing.TryGetNumber(Number));
+	TestFalse(TEXT("An invalid value is no bool"), Missing.TryGetBool(bFlag));
+	TestFalse(TEXT("An array has no keys"), Array.Find("a").IsValid());
+	TestFalse(TEXT("An object has no indices"), Root.At(0).IsValid());
+	TestFalse(TEXT("An object is no string"), Root.TryGetString(Text));
+
+	int32 Members = 0;
+	Root.ForEachMember([&Members](const FLobbyJsonView::FValue& Key, const FLobbyJsonView::FValue& Value)
+	{
+		++Members;
+	});
+	TestEqual(TEXT("ForEachMember visits every member"), Members, 6);
+	int32 Elements = 0;
+	Root.ForEachElement([&Elements](const FLobbyJsonView::FValue& Element)
+	{
+		++Elements;
+	});
+	TestEqual(TEXT("ForEachElement skips an object"), Elements, 0);
+
+	// The tape is reused, a refused text leaves nothing behind and the next one parses again
+	TestFalse(TEXT("A refused text"), View.Parse(ToUtf8("{\"a\":")));
+	TestFalse(TEXT("A refused text leaves no root"), View.GetRoot().IsValid());
+	TestTrue(TEXT("A scalar root parses"), View.Parse(ToUtf8(" 42 ")));
+	TestTrue(TEXT("The scalar root"), View.GetRoot().TryGetNumber(Dup) && Dup == 42);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLobbyJsonViewStringsTest, "LobbyClient.JsonView.Strings",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FLobbyJsonViewStringsTest::RunTest(const FString& Parameters)
+{
+	FLobbyJsonView View;
+	if (!TestTrue(TEXT("Escapes parse"), View.Parse(ToUtf8("{\"s\":\"a\\nb\\\"c\\\\d\\/e\\u00e9\\ud83d\\ude00\\ud800x\",\"k\\u0065y\":\"plain\",\"long\":\"0123456789abcdef0123\\\"456789\",\"utf8\":\"\xc3\xa9\"}"))))
+	{
+		return false;
+	}
+
+	const FLobbyJsonView::FValue Root = View.GetRoot();
+	const FLobbyJsonView::FValue Escaped = Root.Find("s");
+	TestTrue(TEXT("An escaped string knows it"), Escaped.HasEscapes());
+	TestEqual(TEXT("The raw string keeps its escapes"), ToString(Escaped.GetRawString()), FString(TEXT("a\\nb\\\"c\\\\d\\/e\\u00e9\\ud83d\\ude00\\ud800x")));
+	TestEqual(TEXT("The text keeps its quotes"), ToString(Escaped.GetText()), FString(TEXT("\"a\\nb\\\"c\\\\d\\/e\\u00e9\\ud83d\\ude00\\ud800x\"")));
+	// A surrogate pair is one code point, a lone surrogate becomes the replacement character
+	TestEqual(TEXT("The unescaped string"), Escaped.AsString(), FString(TEXT("a\nb\"c\\d/e\u00e9\U0001F600\uFFFDx")));
+
+	TestEqual(TEXT("An escaped key is found"), Root.Find("key").AsString(), FString(TEXT("plain")));
+	TestFalse(TEXT("A plain string knows it"), Root.Find("key").HasEscapes());
+	TestEqual(TEXT("A long string with an escape"), Root.Find("long").AsString(), FString(TEXT("0123456789abcdef0123\"456789")));
+	TestEqual(TEXT("UTF-8 text"), Root.Find("utf8").AsString(), FString(TEXT("\u00e9")));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLobbyJsonViewNumbersTest, "LobbyClient.JsonView.Numbers",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FLobbyJsonViewNumbersTest::RunTest(const FString& Parameters)
+{
+	FLobbyJsonView View;
+	if (!TestTrue(TEXT("Numbers parse"), View.Parse(ToUtf8("[0,-0,1.5,-2e3,9223372036854775807,-9223372036854775808,9223372036854775808,1e300,-1e300,2147483648,true,\"7\"]"))))
+	{
+		return false;
+	}
+
+	const FLobbyJsonView::FValue Root = View.GetRoot();
+	auto GetInt64 = [&Root](int32 NewIndex)
+	{
+		int64 R_Value = -1;
+		Root.At(NewIndex).TryGetNumber(R_Value);
+		return R_Value;
+	};
+	double Double = 0.0;
+	TestTrue(TEXT("A fraction"), Root.At(2).TryGetNumber(Double) && Double == 1.5);
+	TestTrue(TEXT("An exponent"), Root.At(3).TryGetNumber(Double) && Double == -2000.0);
+	TestEqual(TEXT("Zero"), GetInt64(0), static_cast<int64>(0));
+	TestEqual(TEXT("Negative zero"), GetInt64(1), static_cast<int64>(0));
+	TestEqual(TEXT("A fraction as an integer"), GetInt64(2), static_cast<int64>(1));
+	TestEqual(TEXT("The largest int64"), GetInt64(4), MAX_int64);
+	TestEqual(TEXT("The smallest int64"), GetInt64(5), MIN_int64);
+	TestEqual(TEXT("Past the largest int64"), GetInt64(6), MAX_int64);
+	TestEqual(TEXT("A huge exponent"), GetInt64(7), MAX_int64);
+	TestEqual(TEXT("A huge negative exponent"), GetInt64(8), MIN_int64);
+	int32 Int32 = 0;
+	TestTrue(TEXT("Past the largest int32"), Root.At(9).TryGetNumber(Int32) && Int32 == MAX_int32);
+
+	TestFalse(TEXT("A bool is no number"), Root.At(10).TryGetNumber(Double));
+	TestFalse(TEXT("A string is no number"), Root.At(11).TryGetNumber(Double));
+	TestEqual(TEXT("A number as a string keeps its text"), Root.At(3).AsString(), FString(TEXT("-2e3")));
+	TestEqual(TEXT("A bool as a string keeps its text"), Root.At(10).AsString(), FString(TEXT("true")));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLobbyJsonViewHostileTest, "LobbyClient.JsonView.Hostile",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FLobbyJsonViewHostileTest::RunTest(const FString& Parameters)
+{
+	const ANSICHAR* const HostileTexts[] =
+	{
+		"",
+		" \n\t",
+		"{",
+		"[",
+		"}",
+		"]",
+		"{\"a\":",
+		"{\"a\":1",
+		"[1,2",
+		"{\"a\":1}}",
+		"[1]]",
+		"{} {}",
+		"[]x",
+		"[1,]",
+		"[,1]",
+		"[1,,2]",
+		"{\"a\":1,}",
+		"{,}",
+		"{\"a\" 1}",
+		"{\"a\":}",
+		"{\"a\"}",
+		"{a:1}",
+		"{'a':1}",
+		"{1:1}",
+		"{\"a\":1 \"b\":2}",
+		"[1 2]",
+		"[\"a\":1]",
+		"\"abc",
+		"\"abc\\\"",
+		"\"a\\x\"",
+		"\"a\\",
+		"\"\\u12\"",
+		"\"\\u12G4\"",
+		"\"a\tb\"",
+		"\"a\nb\"",
+		"\"0123456789abcdef\x01\"",
+		"01",
+		"-01",
+		"-",
+		"--1",
+		"+1",
+		".5",
+		"1.",
+		"1.e5",
+		"1e",
+		"1e+",
+		"0x10",
+		"tru",
+		"truex",
+		"nul",
+		"NaN",
+		"Infinity",
+	};
+
+	FLobbyJsonView View;
+	for (const ANSICHAR* const HostileText : HostileTexts)
+	{
+		TestFalse(FString::Printf(TEXT("'%s' is refused"), ANSI_TO_TCHAR(HostileText)), View.Parse(ToUtf8(HostileText)));
+		TestFalse(TEXT("A refused text leaves no root"), View.GetRoot().IsValid());
+	}
+	TestFalse(TEXT("A NUL byte in a string is refused"), View.Parse(ToUtf8(FAnsiStringView("\"a\0b\"", 5))));
+	TestFalse(TEXT("A NUL byte between values is refused"), View.Parse(ToUtf8(FAnsiStringView("[1,\0 2]", 7))));
+	TestFalse(TEXT("Text cut inside a valid document is refused"), View.Parse(ToUtf8("{\"a\":[1,2]}").Left(9)));
+
+	// The depth limit refuses only what is past it
+	const TArray<UTF8CHAR> Deepest = MakeNestedArrays(FLobbyJsonView::MAX_DEPTH);
+	const TArray<UTF8CHAR> TooDeep = MakeNestedArrays(FLobbyJsonView::MAX_DEPTH + 1);
+	TestTrue(TEXT("Nesting down to the limit parses"), View.Parse(FUtf8StringView(Deepest.GetData(), Deepest.Num())));
+	TestFalse(TEXT("Nesting past the limit is refused"), View.Parse(FUtf8StringView(TooDeep.GetData(), TooDeep.Num())));
+	return true;
+}
+
+#endif
@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LobbyLoadCommandlet.h"
+#include "LobbyClient.h"
+#include "LobbyGameInstanceSubsystem.h"
+#include "LobbyLoadGenerator.h"
+#include "LobbyLoopbackServer.h"
+#include "LobbyEndToEndBenchmark.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Misc/Paths.h"
+
+ULobbyLoadCommandlet::ULobbyLoadCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+	HelpDescription = TEXT("Simulate many lobby clients sending chat and database traffic, and report the latency of every client.");
+	HelpUsage = TEXT("-run=LobbyLoad -Clients=1000 -Duration=60 -RequestsPerSecond=1 -Chat=70 -DB=30 [-URL=ws://host:port | -Port=18830] [-NGG2] [-Output=<file>]");
+}
+
+int32 ULobbyLoadCommandlet::Main(const FString& NewParams)
+{
+	const TCHAR* Params = *NewParams;
+	const FJWTConfig DefaultKey;
+	FLobbyLoadConfig Config;
+	Config.ClientSecret = DefaultKey.ClientSecret;
+	Config.ClientId = DefaultKey.ClientId;
+	FParse::Value(Params, TEXT("Clients="), Config.Clients);
+	FParse::Value(Params, TEXT("ConnectsPerSecond="), Config.ConnectsPerSecond);
+	FParse::Value(Params, TEXT("Duration="), Config.DurationSeconds);
+	FParse::Value(Params, TEXT("RequestsPerSecond="), Config.RequestsPerSecond);
+	FParse::Value(Params, TEXT("Chat="), Config.ChatWeight);
+	FParse::Value(Params, TEXT("DB="), Config.DBWeight);
+	FParse::Value(Params, TEXT("Timeout="), Config.TimeoutSeconds);
+	FParse::Value(Params, TEXT("ClientSecret="), Config.ClientSecret);
+	FParse::Value(Params, TEXT("ClientId="), Config.ClientId);
+	Config.bLengthPrefixed = FParse::Param(Params, TEXT("NGG2"));
+
+	FString URL;
+	FParse::Value(Params, TEXT("URL="), URL);
+	uint32 Port = FLobbyEndToEndBenchmark::DEFAULT_PORT;
+	FParse::Value(Params, TEXT("Port="), Port);
+	FString OutputFile = FPaths::ProjectSavedDir() / TEXT("LoadTests") / FString::Printf(TEXT("LobbyLoad-%s.json"), *FDateTime::Now().ToString());
+	FParse::Value(Params, TEXT("Output="), OutputFile);
+
+	FLobbyLoopbackServer Server;
+	if (URL.IsEmpty())
+	{
+		if (!Server.Start(Port, Config.ClientSecret, Config.ClientId))
+		{
+			return 1;
+		}
+		URL = Server.GetURL();
+	}
+
+	FLobbyLoadGenerator Generator(Config);
+	Generator.Start(URL);
+
+	// One loop for every client: the engine's WebSocket thread does the socket work, its events,
+	// the loopback server and the receive stage's results are all picked up here
+	double LastTime = FPlatformTime::Seconds();
+	double NextSummaryTime = LastTime + 5.0;
+	while (!IsEngineExitRequested())
+	{
+		const double Now = FPlatformTime::Seconds();
+		FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+		FTSTicker::GetCoreTicker().Tick(static_cast<float>(Now - LastTime));
+		LastTime = Now;
+
+		if (!Generator.Tick(Now))
+		{
+			break;
+		}
+
+		if (Now >= NextSummaryTime)
+		{
+			UE_LOG(LogLobbyClient, Display, TEXT("%s"), *Generator.GetSummary(Now));
+			NextSummaryTime = Now + 5.0;
+		}
+		FPlatformProcess::Sleep(0.001f);
+	}
+
+	UE_LOG(LogLobbyClient, Display, TEXT("%s"), *Generator.GetSummary(FPlatformTime::Seconds()));
+	Generator.SaveReport(OutputFile);
+	Generator.Stop();
+	Server.Stop();
+	return Generator.IsClean() ? 0 : 1;
+}
@@ -0,0 +1,27 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "LobbyLoadCommandlet.generated.h"
+
+/**
+ * Headless capacity run: many simulated lobby clients against a lobby server, or against the loopback stand-in in this process.
+ *   UnrealEditor-Cmd <Project> -run=LobbyLoad -Clients=1000 -Duration=60 -RequestsPerSecond=1 -Chat=70 -DB=30
+ *     [-ConnectsPerSecond=500] [-Timeout=10] [-URL=ws://host:port | -Port=18830] [-NGG2] [-ClientId=.. -ClientSecret=..] [-Output=<file>]
+ * Without -URL both ends of every connection live in this process, so the file descriptor limit (ulimit -n) has to be above twice -Clients.
+ * How many clients one run sustains has not been measured, the 5000 it was written for is a target and not a result.
+ * Returns 0 if every client registered and no request failed or timed out.
+ */
+UCLASS()
+class ULobbyLoadCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	ULobbyLoadCommandlet();
+
+	virtual int32 Main(const FString& NewParams) override;
+};
@@ -0,0 +1,471 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LobbyLoadGenerator.h"
+#include "LobbyClient.h"
+#include "LobbyFrame.h"
+#include "LobbyJsonWriter.h"
+#include "LobbyEnumNames.h"
+#include "WebSocketsModule.h"
+#include "Misc/FileHelper.h"
+
+namespace
+{
+	void WriteLatency(FLobbyJsonWriter& NewWriter, const FLobbyLatencyStats& NewLatency)
+	{
+		NewWriter.WriteKey("count");
+		NewWriter.WriteInt(NewLatency.Count);
+		NewWriter.WriteKey("p50Milliseconds");
+		NewWriter.WriteDouble(NewLatency.P50Milliseconds);
+		NewWriter.WriteKey("p99Milliseconds");
+		NewWriter.WriteDouble(NewLatency.P99Milliseconds);
+		NewWriter.WriteKey("maxMilliseconds");
+		NewWriter.WriteDouble(NewLatency.MaxMilliseconds);
+		NewWriter.WriteKey("meanMilliseconds");
+		NewWriter.WriteDouble(NewLatency.MeanMilliseconds);
+	}
+}
+
+FLobbyLoadGenerator::FLobbyLoadGenerator(const FLobbyLoadConfig& NewConfig)
+	: Config(NewConfig)
+	, ReceiveStage(MakeShared<FLobbyReceiveStage, ESPMode::ThreadSafe>())
+	, FramePool(MakeShared<FLobbyFramePool, ESPMode::ThreadSafe>(256, 64 * 1024))
+{
+	Config.Clients = FMath::Max(Config.Clients, 1);
+	Config.ConnectsPerSecond = FMath::Max(Config.ConnectsPerSecond, 1.f);
+	if (Config.ChatWeight <= 0 && Config.DBWeight <= 0)
+	{
+		Config.ChatWeight = 1;
+	}
+
+	Signer.SetKey(Config.ClientSecret, Config.ClientId);
+	ReceiveStage->SetKey(Config.ClientSecret, Config.ClientId);
+
+	Clients.SetNum(Config.Clients);
+	for (int32 Index = 0; Index < Clients.Num(); ++Index)
+	{
+		Clients[Index].PlayerId = FString::Printf(TEXT("load-player-%05d"), Index);
+	}
+
+	DBQuery.DbName = TEXT("lobby");
+	DBQuery.CollectionName = TEXT("players");
+	DBQuery.DbAction = EMongoDBActionType::FIND_WITH_OPTIONS;
+	DBQuery.Filter = TEXT("{\"online\":true}");
+	DBQuery.Options = TEXT("{\"limit\":20}");
+}
+
+FLobbyLoadGenerator::~FLobbyLoadGenerator()
+{
+	Stop();
+}
+
+void FLobbyLoadGenerator::Start(const FString& NewURL)
+{
+	URL = NewURL;
+	StartTime = FPlatformTime::Seconds();
+	TrafficEndTime = StartTime + Clients.Num() / Config.ConnectsPerSecond + Config.DurationSeconds;
+	NextExpireTime = StartTime + 1.0;
+	UE_LOG(LogLobbyClient, Display, TEXT("Load run: %d clients on %s, %.0f connections per second, %.1f requests per second each for %.0f seconds."),
+		Clients.Num(), *URL, Config.ConnectsPerSecond, Config.RequestsPerSecond, Config.DurationSeconds);
+}
+
+bool FLobbyLoadGenerator::Tick(double NewNow)
+{
+	// Ramp up, a burst of thousands of handshakes would only measure the listen backlog
+	const int32 DueClients = FMath::Min(Clients.Num(), FMath::CeilToInt32((NewNow - StartTime) * Config.ConnectsPerSecond));
+	while (NextClientToConnect < DueClients)
+	{
+		Connect(NextClientToConnect++);
+	}
+
+	if (NewNow < TrafficEndTime)
+	{
+		for (FClient& Client : Clients)
+		{
+			if (!Client.Stats.bRegistered || Client.NextSendTime > NewNow)
+			{
+				continue;
+			}
+
+			SendTraffic(Client, NewNow);
+			// A client that fell behind starts over instead of sending its backlog at once
+			Client.NextSendTime = FMath::Max(Client.NextSendTime, NewNow - 1.0) + GetNextInterval();
+		}
+	}
+
+	FLobbyInboundMessage Message;
+	while (ReceiveStage->Dequeue(Message))
+	{
+		OnMessage(Message, FPlatformTime::Seconds());
+	}
+
+	if (NewNow >= NextExpireTime)
+	{
+		ExpireRequests(NewNow);
+		NextExpireTime = NewNow + 1.0;
+	}
+
+	return NewNow < TrafficEndTime || NumPending > 0;
+}
+
+void FLobbyLoadGenerator::Stop()
+{
+	for (FClient& Client : Clients)
+	{
+		if (Client.WebSocket.IsValid())
+		{
+			// Unbound first, the close events arrive after the generator may be gone
+			IWebSocket& WebSocket = *Client.WebSocket;
+			WebSocket.OnConnected().RemoveAll(this);
+			WebSocket.OnConnectionError().RemoveAll(this);
+			WebSocket.OnClosed().RemoveAll(this);
+			WebSocket.OnRawMessage().RemoveAll(this);
+			WebSocket.Close();
+			Client.WebSocket.Reset();
+		}
+	}
+	NumConnected = 0;
+}
+
+FLobbyLatencyStats FLobbyLoadGenerator::GetLatencyStats(ELobbyActionType NewAction) const
+{
+	const FLobbyLatencyHistogram* Latency = ActionLatency.Find(NewAction);
+	return Latency != nullptr ? Latency->GetStats() : FLobbyLatencyStats();
+}
+
+bool FLobbyLoadGenerator::IsClean() const
+{
+	return NumRegistered == Clients.Num() && TotalFailed == 0 && TotalTimedOut == 0 && InvalidFrames == 0;
+}
+
+void FLobbyLoadGenerator::Connect(int32 NewClientIndex)
+{
+	FClient& Client = Clients[NewClientIndex];
+	// The same subprotocol the subsystem asks for, so a real server sees the handshake it knows
+	Client.WebSocket = FWebSocketsModule::Get().CreateWebSocket(URL, TEXT("wss"));
+	if (!Client.WebSocket.IsValid())
+	{
+		++NumConnectErrors;
+		return;
+	}
+
+	IWebSocket& WebSocket = *Client.WebSocket;
+	WebSocket.OnConnected().AddRaw(this, &FLobbyLoadGenerator::OnConnected, NewClientIndex);
+	WebSocket.OnConnectionError().AddRaw(this, &FLobbyLoadGenerator::OnConnectionError, NewClientIndex);
+	WebSocket.OnClosed().AddRaw(this, &FLobbyLoadGenerator::OnClosed, NewClientIndex);
+	WebSocket.OnRawMessage().AddRaw(this, &FLobbyLoadGenerator::OnRawMessage, NewClientIndex);
+	WebSocket.Connect();
+}
+
+void FLobbyLoadGenerator::OnConnected(int32 NewClientIndex)
+{
+	FClient& Client = Clients[NewClientIndex];
+	Client.Stats.bConnected = true;
+	++NumConnected;
+	PeakConnected = FMath::Max(PeakConnected, NumConnected);
+	SendRegister(Client, FPlatformTime::Seconds());
+}
+
+void FLobbyLoadGenerator::OnConnectionError(const FString& NewError, int32 NewClientIndex)
+{
+	++NumConnectErrors;
+	UE_LOG(LogLobbyClient, Verbose, TEXT("Load client %d could not connect: %s"), NewClientIndex, *NewError);
+}
+
+void FLobbyLoadGenerator::OnClosed(int32 NewStatusCode, const FString& NewReason, bool bNewWasClean, int32 NewClientIndex)
+{
+	FClient& Client = Clients[NewClientIndex];
+	if (Client.Stats.bConnected)
+	{
+		--NumConnected;
+	}
+	// What it still waits for times out, the client is not reconnected
+	if (Client.Stats.bRegistered)
+	{
+		--NumRegistered;
+	}
+	Client.Stats.bConnected = false;
+	Client.Stats.bRegistered = false;
+	UE_LOG(LogLobbyClient, Verbose, TEXT("Load client %d was closed with %d: %s"), NewClientIndex, NewStatusCode, *NewReason);
+}
+
+void FLobbyLoadGenerator::OnRawMessage(const void* NewData, SIZE_T NewSize, SIZE_T NewBytesRemaining, int32 NewClientIndex)
+{
+	FClient& Client = Clients[NewClientIndex];
+	Client.ReceiveBuffer.Append(static_cast<const uint8*>(NewData), static_cast<int32>(NewSize));
+	if (NewBytesRemaining == 0)
+	{
+		// Verified and decoded on the receive pipe like the subsystem's frames, the client index comes back as the connection id
+		ReceiveStage->Enqueue(MoveTemp(Client.ReceiveBuffer), false, NewClientIndex, FramePool);
+		Client.ReceiveBuffer = FramePool->Acquire();
+	}
+}
+
+void FLobbyLoadGenerator::SendRegister(FClient& NewClient, double NewNow)
+{
+	Send(NewClient, ELobbyActionType::REGISTER_PLAYER_INTO_LOBBY, NewNow, [this](FLobbyJsonWriter& NewWriter)
+	{
+		FLobbyEnvelope::WriteTextPayload(NewWriter, FStringView(), Config.bLengthPrefixed);
+	});
+}
+
+void FLobbyLoadGenerator::SendTraffic(FClient& NewClient, double NewNow)
+{
+	const int32 ChatWeight = FMath::Max(Config.ChatWeight, 0);
+	if (FMath::RandHelper(ChatWeight + FMath::Max(Config.DBWeight, 0)) < ChatWeight)
+	{
+		FChatData ChatData;
+		ChatData.SenderPlayerId = NewClient.PlayerId;
+		ChatData.RecipientPlayerId = Clients[FMath::RandHelper(Clients.Num())].PlayerId;
+		ChatData.Message = TEXT("load test message");
+		Send(NewClient, ELobbyActionType::TEXT_CHAT, NewNow, [&ChatData](FLobbyJsonWriter& NewWriter)
+		{
+			FLobbyEnvelope::WriteChatPayload(NewWriter, ChatData);
+		});
+	}
+	else
+	{
+		DBQuery.SenderPlayerId = NewClient.PlayerId;
+		Send(NewClient, ELobbyActionType::DATABASE, NewNow, [this](FLobbyJsonWriter& NewWriter)
+		{
+			FLobbyEnvelope::WriteDBPayload(NewWriter, DBQuery);
+		});
+	}
+}
+
+void FLobbyLoadGenerator::Send(FClient& NewClient, ELobbyActionType NewAction, double NewNow, FLobbyEnvelope::FWritePayload NewWritePayload)
+{
+	if (!NewClient.WebSocket.IsValid() || !NewClient.Stats.bConnected)
+	{
+		return;
+	}
+
+	const FString RequestId = FString::Printf(TEXT("%s-%lld"), *NewClient.PlayerId, NewClient.NextRequestNumber++);
+	const bool bCooked = FLobbyEnvelope::CookFrame(SendBuffer, Signer, Config.bLengthPrefixed, FLobbyFrameWriter::GetCurrentTimestamp(), [&](FLobbyJsonWriter& NewWriter)
+	{
+		FLobbyEnvelope::WriteEnvelope(NewWriter, NewAction, NewClient.PlayerId, RequestId, Config.bLengthPrefixed, NewWritePayload);
+	});
+	if (!bCooked)
+	{
+		return;
+	}
+
+	// Legacy frames go out as text like the subsystem sends them, NGG2 frames as binary
+	NewClient.WebSocket->Send(SendBuffer.GetData(), SendBuffer.Num(), Config.bLengthPrefixed);
+	NewClient.Pending.Add(RequestId, FPendingRequest{ NewNow, NewAction });
+	++NewClient.Stats.Sent;
+	++TotalSent;
+	++NumPending;
+}
+
+void FLobbyLoadGenerator::OnMessage(FLobbyInboundMessage& NewMessage, double NewNow)
+{
+	if (!Clients.IsValidIndex(NewMessage.ConnectionId))
+	{
+		return;
+	}
+
+	if (NewMessage.Result != ELobbyInboundResult::VALID)
+	{
+		++InvalidFrames;
+		return;
+	}
+
+	FClient& Client = Clients[NewMessage.ConnectionId];
+	FPendingRequest Request;
+	if (!Client.Pending.RemoveAndCopyValue(NewMessage.Response.RequestId, Request))
+	{
+		++UnmatchedMessages;
+		return;
+	}
+	--NumPending;
+
+	if (NewMessage.Response.Status == ELobbyRequestStatus::FAILED)
+	{
+		++Client.Stats.Failed;
+		++TotalFailed;
+		return;
+	}
+
+	++Client.Stats.Answered;
+	++TotalAnswered;
+	const double Seconds = NewNow - Request.SentTime;
+	Client.Latency.Add(Seconds);
+	ActionLatency.FindOrAdd(Request.Action).Add(Seconds);
+
+	if (Request.Action == ELobbyActionType::REGISTER_PLAYER_INTO_LOBBY && Client.Stats.bConnected && !Client.Stats.bRegistered)
+	{
+		Client.Stats.bRegistered = true;
+		++NumRegistered;
+		Client.NextSendTime = NewNow + GetNextInterval();
+	}
+}
+
+void FLobbyLoadGenerator::ExpireRequests(double NewNow)
+{
+	if (NumPending == 0)
+	{
+		return;
+	}
+
+	const double SentBefore = NewNow - Config.TimeoutSeconds;
+	for (FClient& Client : Clients)
+	{
+		for (auto It = Client.Pending.CreateIterator(); It; ++It)
+		{
+			if (It->Value.SentTime < SentBefore)
+			{
+				It.RemoveCurrent();
+				++Client.Stats.TimedOut;
+				++TotalTimedOut;
+				--NumPending;
+			}
+		}
+	}
+}
+
+double FLobbyLoadGenerator::GetNextInterval() const
+{
+	if (Config.RequestsPerSecond <= 0.f)
+	{
+		return UE_DOUBLE_BIG_NUMBER;
+	}
+	// Exponential gaps, so the clients do not fall into step with each other
+	return -FMath::Loge(1.0 - FMath::FRand()) / Config.RequestsPerSecond;
+}
+
+FString FLobbyLoadGenerator::GetSummary(double NewNow) const
+{
+	const FLobbyLatencyStats Chat = GetLatencyStats(ELobbyActionType::TEXT_CHAT);
+	const FLobbyLatencyStats DB = GetLatencyStats(ELobbyActionType::DATABASE);
+	return FString::Printf(TEXT("%.0fs connected=%d/%d registered=%d sent=%lld answered=%lld failed=%lld timedOut=%lld pending=%lld chat p99=%.2f ms db p99=%.2f ms"),
+		NewNow - StartTime, NumConnected, Clients.Num(), NumRegistered, TotalSent, TotalAnswered, TotalFailed, TotalTimedOut, NumPending,
+		Chat.P99Milliseconds, DB.P99Milliseconds);
+}
+
+bool FLobbyLoadGenerator::SaveReport(const FString& NewPath) const
+{
+	const double TrafficSeconds = FMath::Max(FMath::Min(FPlatformTime::Seconds(), TrafficEndTime) - StartTime, UE_DOUBLE_SMALL_NUMBER);
+
+	TArray<UTF8CHAR> Json;
+	{
+		FLobbyJsonWriter Writer(Json);
+		Writer.BeginObject();
+		Writer.WriteKey("schemaVersion");
+		Writer.WriteInt(1);
+		Writer.WriteKey("timestamp");
+		Writer.WriteString(FDateTime::UtcNow().ToIso8601());
+		Writer.WriteKey("url");
+		Writer.WriteString(URL);
+
+		Writer.WriteKey("config");
+		Writer.BeginObject();
+		Writer.WriteKey("clients");
+		Writer.WriteInt(Config.Clients);
+		Writer.WriteKey("connectsPerSecond");
+		Writer.WriteDouble(Config.ConnectsPerSecond);
+		Writer.WriteKey("durationSeconds");
+		Writer.WriteDouble(Config.DurationSeconds);
+		Writer.WriteKey("requestsPerSecond");
+		Writer.WriteDouble(Config.RequestsPerSecond);
+		Writer.WriteKey("chatWeight");
+		Writer.WriteInt(Config.ChatWeight);
+		Writer.WriteKey("dbWeight");
+		Writer.WriteInt(Config.DBWeight);
+		Writer.WriteKey("timeoutSeconds");
+		Writer.WriteDouble(Config.TimeoutSeconds);
+		Writer.WriteKey("lengthPrefixed");
+		Writer.WriteBool(Config.bLengthPrefixed);
+		Writer.EndObject();
+
+		Writer.WriteKey("totals");
+		Writer.BeginObject();
+		Writer.WriteKey("peakConnected");
+		Writer.WriteInt(PeakConnected);
+		Writer.WriteKey("registered");
+		Writer.WriteInt(NumRegistered);
+		Writer.WriteKey("connectErrors");
+		Writer.WriteInt(NumConnectErrors);
+		Writer.WriteKey("sent");
+		Writer.WriteInt(TotalSent);
+		Writer.WriteKey("answered");
+		Writer.WriteInt(TotalAnswered);
+		Writer.WriteKey("failed");
+		Writer.WriteInt(TotalFailed);
+		Writer.WriteKey("timedOut");
+		Writer.WriteInt(TotalTimedOut);
+		Writer.WriteKey("invalidFrames");
+		Writer.WriteInt(InvalidFrames);
+		Writer.WriteKey("unmatchedMessages");
+		Writer.WriteInt(UnmatchedMessages);
+		Writer.WriteKey("trafficSeconds");
+		Writer.WriteDouble(TrafficSeconds);
+		Writer.WriteKey("answeredPerSecond");
+		Writer.WriteDouble(TotalAnswered / TrafficSeconds);
+		Writer.EndObject();
+
+		Writer.WriteKey("actions");
+		Writer.BeginArray();
+		for (const TPair<ELobbyActionType, FLobbyLatencyHistogram>& Action : ActionLatency)
+		{
+			Writer.BeginObject();
+			Writer.WriteKey("action");
+			Writer.WriteString(FLobbyEnumNames::ToName(Action.Key));
+			WriteLatency(Writer, Action.Value.GetStats());
+			Writer.EndObject();
+		}
+		Writer.EndArray();
+
+		// How evenly the server treats its clients: the p99 of the median client and of the worst one
+		TArray<float> ClientP99;
+		ClientP99.Reserve(Clients.Num());
+		Writer.WriteKey("clients");
+		Writer.BeginArray();
+		for (const FClient& Client : Clients)
+		{
+			const FLobbyLatencyStats Latency = Client.Latency.GetStats();
+			if (Latency.Count > 0)
+			{
+				ClientP99.Add(Latency.P99Milliseconds);
+			}
+
+			Writer.BeginObject();
+			Writer.WriteKey("playerId");
+			Writer.WriteString(Client.PlayerId);
+			Writer.WriteKey("connected");
+			Writer.WriteBool(Client.Stats.bConnected);
+			Writer.WriteKey("registered");
+			Writer.WriteBool(Client.Stats.bRegistered);
+			Writer.WriteKey("sent");
+			Writer.WriteInt(Client.Stats.Sent);
+			Writer.WriteKey("answered");
+			Writer.WriteInt(Client.Stats.Answered);
+			Writer.WriteKey("failed");
+			Writer.WriteInt(Client.Stats.Failed);
+			Writer.WriteKey("timedOut");
+			Writer.WriteInt(Client.Stats.TimedOut);
+			WriteLatency(Writer, Latency);
+			Writer.EndObject();
+		}
+		Writer.EndArray();
+
+		ClientP99.Sort();
+		Writer.WriteKey("clientP99Milliseconds");
+		Writer.BeginObject();
+		Writer.WriteKey("median");
+		Writer.WriteDouble(ClientP99.Num() > 0 ? ClientP99[ClientP99.Num() / 2] : 0.0);
+		Writer.WriteKey("worst");
+		Writer.WriteDouble(ClientP99.Num() > 0 ? ClientP99.Last() : 0.0);
+		Writer.EndObject();
+
+		Writer.EndObject();
+	}
+
+	if (!FFileHelper::SaveArrayToFile(TArrayView<const uint8>(reinterpret_cast<const uint8*>(Json.GetData()), Json.Num()), *NewPath))
+	{
+		UE_LOG(LogLobbyClient, Error, TEXT("The load report could not be written to %s."), *NewPath);
+		return false;
+	}
+	UE_LOG(LogLobbyClient, Display, TEXT("Load report written to %s"), *NewPath);
+	return true;
+}
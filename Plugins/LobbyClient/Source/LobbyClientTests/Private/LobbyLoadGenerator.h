@@ -0,0 +1,264 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IWebSocket.h"
+#include "LobbyTypes.h"
+#include "LobbySigner.h"
+#include "LobbyStats.h"
+#include "LobbyReceiveStage.h"
+#include "LobbyBufferPool.h"
+#include "LobbyEnvelope.h"
+
+/**
+ * Shape of one load run, read from the commandlet line
+ */
+struct FLobbyLoadConfig
+{
+	/**
+	 * Simulated players, each on a WebSocket of its own
+	 */
+	int32 Clients = 100;
+
+	/**
+	 * New connections opened per second while ramping up
+	 */
+	float ConnectsPerSecond = 500.f;
+
+	/**
+	 * How long the traffic runs once every client had its turn to connect
+	 */
+	float DurationSeconds = 60.f;
+
+	/**
+	 * Requests per second of one client, spaced like arrivals of a Poisson process
+	 */
+	float RequestsPerSecond = 1.f;
+
+	/**
+	 * Share of chat messages and database reads in the traffic
+	 */
+	int32 ChatWeight = 70;
+
+	int32 DBWeight = 30;
+
+	/**
+	 * Unanswered requests count as timed out after this
+	 */
+	float TimeoutSeconds = 10.f;
+
+	/**
+	 * NGG2 framing with nested payloads instead of the legacy layout
+	 */
+	bool bLengthPrefixed = false;
+
+	/**
+	 * The key every client signs with, the server has to know it
+	 */
+	FString ClientSecret;
+
+	FString ClientId;
+};
+
+/**
+ * What one simulated client saw
+ */
+struct FLobbyLoadClientStats
+{
+	bool bConnected = false;
+	bool bRegistered = false;
+	int64 Sent = 0;
+	int64 Answered = 0;
+	int64 Failed = 0;
+	int64 TimedOut = 0;
+};
+
+/**
+ * Many lightweight lobby clients in one process, for capacity runs against a lobby server or FLobbyLoopbackServer.
+ * A client is a WebSocket, a player id and its unanswered requests, nothing of a game instance. Frames are written
+ * with FLobbyEnvelope and signed by one shared FLobbySigner on the calling thread. Every client's received frames
+ * go through one shared FLobbyReceiveStage, tagged with the client index as connection id. The WebSockets are
+ * serviced by the engine's WebSocket thread and their events arrive on the ticking thread, so there is no thread per client.
+ * Not thread safe, Tick it from one thread together with the core ticker.
+ */
+class FLobbyLoadGenerator
+{
+public:
+
+	explicit FLobbyLoadGenerator(const FLobbyLoadConfig& NewConfig);
+
+	~FLobbyLoadGenerator();
+
+	FLobbyLoadGenerator(const FLobbyLoadGenerator&) = delete;
+	FLobbyLoadGenerator& operator=(const FLobbyLoadGenerator&) = delete;
+
+	/**
+	 * Begin ramping up connections to NewURL
+	 */
+	void Start(const FString& NewURL);
+
+	/**
+	 * Connect, send and time out what is due, and take the received frames. Returns false once the run is over
+	 * and every request was answered or timed out.
+	 */
+	bool Tick(double NewNow);
+
+	/**
+	 * Close every WebSocket
+	 */
+	void Stop();
+
+	int32 GetNumConnected() const { return NumConnected; }
+
+	/**
+	 * Round trip times of every client together, per action
+	 */
+	FLobbyLatencyStats GetLatencyStats(ELobbyActionType NewAction) const;
+
+	/**
+	 * True if every client connected and registered, and no request failed or timed out
+	 */
+	bool IsClean() const;
+
+	/**
+	 * The run as JSON: config, totals, latency per action, and one entry per client
+	 */
+	bool SaveReport(const FString& NewPath) const;
+
+	/**
+	 * One line of totals for the log
+	 */
+	FString GetSummary(double NewNow) const;
+
+private:
+
+	struct FPendingRequest
+	{
+		double SentTime = 0.0;
+
+		ELobbyActionType Action = ELobbyActionType::NONE;
+	};
+
+	struct FClient
+	{
+		FString PlayerId;
+
+		TSharedPtr<IWebSocket> WebSocket;
+
+		/**
+		 * Collects the fragments of the frame being received
+		 */
+		TArray<uint8> ReceiveBuffer;
+
+		/**
+		 * Keyed by request id, each client numbers its own requests
+		 */
+		TMap<FString, FPendingRequest> Pending;
+
+		int64 NextRequestNumber = 0;
+
+		double NextSendTime = 0.0;
+
+		FLobbyLoadClientStats Stats;
+
+		FLobbyLatencyHistogram Latency;
+	};
+
+	void Connect(int32 NewClientIndex);
+
+	void OnConnected(int32 NewClientIndex);
+
+	void OnConnectionError(const FString& NewError, int32 NewClientIndex);
+
+	void OnClosed(int32 NewStatusCode, const FString& NewReason, bool bNewWasClean, int32 NewClientIndex);
+
+	void OnRawMessage(const void* NewData, SIZE_T NewSize, SIZE_T NewBytesRemaining, int32 NewClientIndex);
+
+	/**
+	 * Register the client's player, the traffic starts once the server answered
+	 */
+	void SendRegister(FClient& NewClient, double NewNow);
+
+	/**
+	 * One chat message to another simulated player or one database read, picked by the weights
+	 */
+	void SendTraffic(FClient& NewClient, double NewNow);
+
+	/**
+	 * Frame and sign the envelope into the shared buffer and send it, then wait for the answer
+	 */
+	void Send(FClient& NewClient, ELobbyActionType NewAction, double NewNow, FLobbyEnvelope::FWritePayload NewWritePayload);
+
+	void OnMessage(FLobbyInboundMessage& NewMessage, double NewNow);
+
+	void ExpireRequests(double NewNow);
+
+	/**
+	 * Seconds to the next request of a client
+	 */
+	double GetNextInterval() const;
+
+	FLobbyLoadConfig Config;
+
+	FString URL;
+
+	TArray<FClient> Clients;
+
+	FLobbySigner Signer;
+
+	TArray<UTF8CHAR> SendBuffer;
+
+	TSharedRef<FLobbyReceiveStage, ESPMode::ThreadSafe> ReceiveStage;
+
+	TSharedRef<FLobbyFramePool, ESPMode::ThreadSafe> FramePool;
+
+	/**
+	 * The same database read for every client, only the sender changes
+	 */
+	FMongoDBData DBQuery;
+
+	TMap<ELobbyActionType, FLobbyLatencyHistogram> ActionLatency;
+
+	int32 NextClientToConnect = 0;
+
+	int32 NumConnected = 0;
+
+	int32 PeakConnected = 0;
+
+	int32 NumConnectErrors = 0;
+
+	int32 NumRegistered = 0;
+
+	/**
+	 * Totals of every client, kept as they change so the log line costs nothing
+	 */
+	int64 TotalSent = 0;
+
+	int64 TotalAnswered = 0;
+
+	int64 TotalFailed = 0;
+
+	int64 TotalTimedOut = 0;
+
+	int64 NumPending = 0;
+
+	/**
+	 * Frames the receive stage dropped
+	 */
+	int64 InvalidFrames = 0;
+
+	/**
+	 * Messages no request waited for: pushes, or answers that came after their request timed out
+	 */
+	int64 UnmatchedMessages = 0;
+
+	double StartTime = 0.0;
+
+	/**
+	 * Ramp up plus the configured duration, no new requests after this
+	 */
+	double TrafficEndTime = 0.0;
+
+	double NextExpireTime = 0.0;
+};
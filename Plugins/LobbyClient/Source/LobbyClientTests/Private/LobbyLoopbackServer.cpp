@@ -0,0 +1,260 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LobbyLoopbackServer.h"
+#include "LobbyClient.h"
+#include "LobbyFrame.h"
+#include "LobbyEnvelope.h"
+#include "LobbyJsonWriter.h"
+#include "LobbyBson.h"
+#include "IWebSocketNetworkingModule.h"
+#include "IWebSocketServer.h"
+#include "INetworkingWebSocket.h"
+#include "WebSocketNetworkingDelegates.h"
+
+FLobbyLoopbackServer::FLobbyLoopbackServer()
+{
+}
+
+FLobbyLoopbackServer::~FLobbyLoopbackServer()
+{
+	Stop();
+}
+
+bool FLobbyLoopbackServer::Start(uint32 NewPort, const FString& NewClientSecret, const FString& NewClientId)
+{
+	Stop();
+	Signer.SetKey(NewClientSecret, NewClientId);
+	Stats = FLobbyLoopbackServerStats();
+	RequestIdCounts.Reset();
+
+	IWebSocketNetworkingModule* WebSocketNetworking = FModuleManager::LoadModulePtr<IWebSocketNetworkingModule>(TEXT("WebSocketNetworking"));
+	if (WebSocketNetworking == nullptr)
+	{
+		UE_LOG(LogLobbyClient, Error, TEXT("The loopback server needs the WebSocketNetworking plugin, enable it in the project."));
+		return false;
+	}
+
+	Server = WebSocketNetworking->CreateServer();
+	if (!Server.IsValid() || !Server->Init(NewPort, FWebSocketClientConnectedCallBack::CreateRaw(this, &FLobbyLoopbackServer::OnClientConnected), TEXT("127.0.0.1")))
+	{
+		UE_LOG(LogLobbyClient, Error, TEXT("The loopback server could not listen on port %u."), NewPort);
+		Server.Reset();
+		return false;
+	}
+
+	Port = NewPort;
+	TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FLobbyLoopbackServer::Tick));
+	UE_LOG(LogLobbyClient, Log, TEXT("The loopback server is listening on %s."), *GetURL());
+	return true;
+}
+
+void FLobbyLoopbackServer::Stop()
+{
+	if (TickHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+		TickHandle.Reset();
+	}
+
+	// The sockets belong to the server's context, they go before it
+	Clients.Reset();
+	Server.Reset();
+	Port = 0;
+}
+
+int32 FLobbyLoopbackServer::GetRequestIdCount(const FString& NewRequestId) const
+{
+	const int32* Count = RequestIdCounts.Find(NewRequestId);
+	return Count != nullptr ? *Count : 0;
+}
+
+void FLobbyLoopbackServer::CountRequestId(const FString& NewRequestId)
+{
+	if (bCountRequestIds)
+	{
+		++RequestIdCounts.FindOrAdd(NewRequestId);
+	}
+}
+
+FString FLobbyLoopbackServer::GetURL() const
+{
+	return FString::Printf(TEXT("ws://127.0.0.1:%u"), Port);
+}
+
+bool FLobbyLoopbackServer::Tick(float NewDeltaTime)
+{
+	Server->Tick();
+	for (auto It = Clients.CreateIterator(); It; ++It)
+	{
+		if (It->Value.bClosed)
+		{
+			It.RemoveCurrent();
+		}
+	}
+	return true;
+}
+
+void FLobbyLoopbackServer::OnClientConnected(INetworkingWebSocket* NewSocket)
+{
+	const int32 ClientId = NextClientId++;
+	FClient& Client = Clients.Add(ClientId);
+	Client.Socket.Reset(NewSocket);
+	NewSocket->SetReceiveCallBack(FWebSocketPacketReceivedCallBack::CreateRaw(this, &FLobbyLoopbackServer::OnClientReceived, ClientId));
+	NewSocket->SetSocketClosedCallBack(FWebSocketInfoCallBack::CreateRaw(this, &FLobbyLoopbackServer::OnClientClosed, ClientId));
+	NewSocket->SetErrorCallBack(FWebSocketInfoCallBack::CreateRaw(this, &FLobbyLoopbackServer::OnClientClosed, ClientId));
+	++Stats.Connections;
+}
+
+void FLobbyLoopbackServer::OnClientReceived(void* NewData, int32 NewSize, int32 NewClientId)
+{
+	FClient* Client = Clients.Find(NewClientId);
+	if (Client == nullptr || Client->bClosed)
+	{
+		return;
+	}
+
+	// Every message is taken as one whole frame, the benchmarks and load runs stay below the socket's receive buffer
+	++Stats.Frames;
+	Stats.BytesReceived += NewSize;
+	if (!AnswerFrame(FUtf8StringView(static_cast<const UTF8CHAR*>(NewData), NewSize), ReplyBuffer))
+	{
+		++Stats.InvalidFrames;
+		UE_LOG(LogLobbyClient, Warning, TEXT("The loopback server dropped an invalid frame of %d bytes."), NewSize);
+		return;
+	}
+
+	Client->Socket->Send(reinterpret_cast<const uint8*>(ReplyBuffer.GetData()), ReplyBuffer.Num(), false);
+	Stats.BytesSent += ReplyBuffer.Num();
+}
+
+void FLobbyLoopbackServer::OnClientClosed(int32 NewClientId)
+{
+	if (FClient* Client = Clients.Find(NewClientId))
+	{
+		Client->bClosed = true;
+	}
+}
+
+bool FLobbyLoopbackServer::AnswerFrame(FUtf8StringView NewFrame, TArray<UTF8CHAR>& OutReply)
+{
+	FLobbyFrameView FrameView;
+	int64 Timestamp = 0;
+	if (!FLobbyFrameParser::Parse(NewFrame, FrameView) || !FLobbyFrameParser::ParseTimestamp(FrameView[NGG_LOBBY_PROTOCOL::TIMESTAMP], Timestamp))
+	{
+		return false;
+	}
+
+	FUtf8StringView Body = FrameView[NGG_LOBBY_PROTOCOL::JSON];
+	if ((FrameView.Flags & NGG_LOBBY_PROTOCOL_V2::FRAME_FLAG_DEFLATE) != 0)
+	{
+		if (!Inflater.Inflate(Body, MAX_INFLATED_BYTES, InflatedBody))
+		{
+			return false;
+		}
+		Body = FUtf8StringView(InflatedBody.GetData(), InflatedBody.Num());
+	}
+
+	if (!Signer.Verify(Timestamp, Body, FrameView[NGG_LOBBY_PROTOCOL::SIGNATURE]))
+	{
+		return false;
+	}
+
+	const bool bLengthPrefixed = FrameView.Version == 2;
+	const int64 Now = FLobbyFrameWriter::GetCurrentTimestamp();
+	if ((FrameView.Flags & NGG_LOBBY_PROTOCOL_V2::FRAME_FLAG_BSON) != 0)
+	{
+		if (!FLobbyBsonView::IsValid(Body))
+		{
+			return false;
+		}
+
+		const FLobbyBsonView Envelope(Body);
+		++Stats.Requests;
+		FLobbyBsonView::FElement RequestId;
+		if (bCountRequestIds && Envelope.Find("requestId", RequestId))
+		{
+			CountRequestId(FString(RequestId.AsString().Len(), RequestId.AsString().GetData()));
+		}
+		return FLobbyEnvelope::CookFrame(OutReply, Signer, bLengthPrefixed, Now, [&Envelope](FLobbyJsonWriter& NewWriter)
+		{
+			FLobbyBsonView::FElement Element;
+			NewWriter.BeginObject();
+			if (Envelope.Find("requestId", Element))
+			{
+				NewWriter.WriteKey("requestId");
+				NewWriter.WriteString(Element.AsString());
+			}
+			if (Envelope.Find("action", Element))
+			{
+				NewWriter.WriteKey("action");
+				NewWriter.WriteString(Element.AsString());
+			}
+			if (Envelope.Find("payLoadData", Element))
+			{
+				NewWriter.WriteKey("payLoadData");
+				FLobbyBsonView::WriteJsonValue(NewWriter, Element);
+			}
+			NewWriter.EndObject();
+		});
+	}
+
+	if (!BodyView.Parse(Body))
+	{
+		return false;
+	}
+
+	const FLobbyJsonView::FValue Root = BodyView.GetRoot();
+	if (Root.IsObject())
+	{
+		++Stats.Requests;
+		if (bCountRequestIds)
+		{
+			CountRequestId(Root.Find("requestId").AsString());
+		}
+		return FLobbyEnvelope::CookFrame(OutReply, Signer, bLengthPrefixed, Now, [&Root](FLobbyJsonWriter& NewWriter)
+		{
+			WriteAnswer(NewWriter, Root);
+		});
+	}
+
+	if (!Root.IsArray())
+	{
+		return false;
+	}
+
+	// A batch frame is answered with one batch frame, in the same order
+	Stats.Requests += Root.Num();
+	if (bCountRequestIds)
+	{
+		Root.ForEachElement([this](const FLobbyJsonView::FValue& Element)
+		{
+			CountRequestId(Element.Find("requestId").AsString());
+		});
+	}
+	return FLobbyEnvelope::CookFrame(OutReply, Signer, bLengthPrefixed, Now, [&Root](FLobbyJsonWriter& NewWriter)
+	{
+		NewWriter.BeginArray();
+		Root.ForEachElement([&NewWriter](const FLobbyJsonView::FValue& Element)
+		{
+			WriteAnswer(NewWriter, Element);
+		});
+		NewWriter.EndArray();
+	});
+}
+
+void FLobbyLoopbackServer::WriteAnswer(FLobbyJsonWriter& NewWriter, const FLobbyJsonView::FValue& NewEnvelope)
+{
+	NewWriter.BeginObject();
+	for (const FAnsiStringView Key : { FAnsiStringView("requestId"), FAnsiStringView("action"), FAnsiStringView("payLoadData") })
+	{
+		// Copied as the text it is, a nested payload stays nested and an escaped one stays a string
+		const FLobbyJsonView::FValue Value = NewEnvelope.Find(Key);
+		if (Value.IsValid())
+		{
+			NewWriter.WriteKey(Key);
+			NewWriter.WriteRawValue(Value.GetText());
+		}
+	}
+	NewWriter.EndObject();
+}
@@ -0,0 +1,146 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "LobbySigner.h"
+#include "LobbyCompression.h"
+#include "LobbyJsonView.h"
+
+class IWebSocketServer;
+class INetworkingWebSocket;
+class FLobbyJsonWriter;
+
+/**
+ * What the loopback server saw since it was started
+ */
+struct FLobbyLoopbackServerStats
+{
+	int64 Connections = 0;
+	int64 Frames = 0;
+	int64 InvalidFrames = 0;
+	/**
+	 * Envelopes answered, a batch frame counts once per envelope in it
+	 */
+	int64 Requests = 0;
+	int64 BytesReceived = 0;
+	int64 BytesSent = 0;
+};
+
+/**
+ * In-process stand-in for the lobby server, for benchmarks and load runs on one machine.
+ * Every frame is verified like the client verifies them, every request is answered with an envelope
+ * carrying its requestId, action and payload, signed with the same key and framed the way the request came in.
+ * Answers are always JSON, pushes, chat fan-out and the database are not simulated.
+ * Listens on the loopback interface and ticks on the core ticker, needs the WebSocketNetworking plugin. Game thread only.
+ */
+class FLobbyLoopbackServer
+{
+public:
+
+	/**
+	 * Deflated requests that expand past this are answered as invalid
+	 */
+	static constexpr int32 MAX_INFLATED_BYTES = 16 * 1024 * 1024;
+
+	FLobbyLoopbackServer();
+
+	~FLobbyLoopbackServer();
+
+	FLobbyLoopbackServer(const FLobbyLoopbackServer&) = delete;
+	FLobbyLoopbackServer& operator=(const FLobbyLoopbackServer&) = delete;
+
+	/**
+	 * Listen on NewPort and answer frames signed with this key. Fails if the port is taken or WebSocketNetworking is not enabled.
+	 */
+	bool Start(uint32 NewPort, const FString& NewClientSecret, const FString& NewClientId);
+
+	/**
+	 * Close every connection and stop listening
+	 */
+	void Stop();
+
+	bool IsRunning() const { return Server.IsValid(); }
+
+	/**
+	 * ws://127.0.0.1:<port>, the URL to connect the clients to
+	 */
+	FString GetURL() const;
+
+	int32 GetNumConnections() const { return Clients.Num(); }
+
+	const FLobbyLoopbackServerStats& GetStats() const { return Stats; }
+
+	/**
+	 * Count how often every requestId arrives, off by default so load runs do not pay for it
+	 */
+	void SetCountRequestIds(bool bNewCount) { bCountRequestIds = bNewCount; }
+
+	/**
+	 * How often NewRequestId arrived since counting was switched on, replays and duplicates included
+	 */
+	int32 GetRequestIdCount(const FString& NewRequestId) const;
+
+	/**
+	 * Verify one received frame and write the answer into OutReply. False if the frame or its body is not valid.
+	 * No socket is involved, so benchmarks can call it directly.
+	 */
+	bool AnswerFrame(FUtf8StringView NewFrame, TArray<UTF8CHAR>& OutReply);
+
+private:
+
+	struct FClient
+	{
+		TUniquePtr<INetworkingWebSocket> Socket;
+
+		/**
+		 * The socket is only deleted on the next tick, never inside its own callback
+		 */
+		bool bClosed = false;
+	};
+
+	bool Tick(float NewDeltaTime);
+
+	void OnClientConnected(INetworkingWebSocket* NewSocket);
+
+	void OnClientReceived(void* NewData, int32 NewSize, int32 NewClientId);
+
+	void OnClientClosed(int32 NewClientId);
+
+	/**
+	 * Copy the requestId, action and payLoadData of one JSON request envelope into an answer
+	 */
+	static void WriteAnswer(FLobbyJsonWriter& NewWriter, const FLobbyJsonView::FValue& NewEnvelope);
+
+	void CountRequestId(const FString& NewRequestId);
+
+	TUniquePtr<IWebSocketServer> Server;
+
+	uint32 Port = 0;
+
+	FTSTicker::FDelegateHandle TickHandle;
+
+	TMap<int32, FClient> Clients;
+
+	int32 NextClientId = 0;
+
+	FLobbySigner Signer;
+
+	FLobbyInflater Inflater;
+
+	TArray<UTF8CHAR> InflatedBody;
+
+	FLobbyJsonView BodyView;
+
+	/**
+	 * Every answer is written here, reused between frames
+	 */
+	TArray<UTF8CHAR> ReplyBuffer;
+
+	FLobbyLoopbackServerStats Stats;
+
+	bool bCountRequestIds = false;
+
+	TMap<FString, int32> RequestIdCounts;
+};
@@ -0,0 +1,154 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LobbyGameInstanceSubsystem.h"
+#include "LobbyLoopbackServer.h"
+#include "LobbyTestUtils.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/**
+	 * Next to the end to end benchmark's port, so both can run in one session
+	 */
+	const uint32 RECONNECT_TEST_PORT = 18831;
+
+	/**
+	 * Long enough for a second copy of the write to reach the server after the first answer
+	 */
+	const double DUPLICATE_GRACE_SECONDS = 0.5;
+
+	struct FLobbyReconnectTestState
+	{
+		TStrongObjectPtr<UGameInstance> GameInstance;
+
+		FLobbyLoopbackServer Server;
+
+		FString RequestId;
+
+		bool bSent = false;
+
+		int32 Answers = 0;
+
+		ELobbyRequestStatus Status = ELobbyRequestStatus::FAILED;
+
+		double AnsweredTime = 0.0;
+
+		double Deadline = 0.0;
+	};
+
+	/**
+	 * The configs are only exposed to Blueprints, the tests set them through reflection
+	 */
+	template <typename ConfigType>
+	ConfigType& GetSubsystemConfig(ULobbyGameInstanceSubsystem& NewSubsystem, const TCHAR* NewName)
+	{
+		const FStructProperty* Property = FindFProperty<FStructProperty>(ULobbyGameInstanceSubsystem::StaticClass(), NewName);
+		check(Property != nullptr && Property->Struct == StaticStruct<ConfigType>());
+		return *Property->ContainerPtrToValuePtr<ConfigType>(&NewSubsystem);
+	}
+
+	void FinishReconnectTest(FLobbyReconnectTestState& NewState)
+	{
+		if (ULobbyGameInstanceSubsystem* Subsystem = NewState.GameInstance->GetSubsystem<ULobbyGameInstanceSubsystem>())
+		{
+			Subsystem->DisconnectFromLobbyServer();
+		}
+		NewState.Server.Stop();
+		NGG_LOBBY_TESTS::ShutdownGameInstance(NewState.GameInstance);
+	}
+}
+
+/**
+ * Send one retained write into the batch, lose the connection before the batch goes out, flush, reconnect,
+ * then check the server saw the write once
+ */
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FLobbyBatchedWriteReconnectCommand, FAutomationTestBase*, Test, TSharedRef<FLobbyReconnectTestState>, State);
+
+bool FLobbyBatchedWriteReconnectCommand::Update()
+{
+	ULobbyGameInstanceSubsystem* Subsystem = State->GameInstance->GetSubsystem<ULobbyGameInstanceSubsystem>();
+	const double Now = FPlatformTime::Seconds();
+	if (Now > State->Deadline)
+	{
+		Test->AddError(FString::Printf(TEXT("Timed out, the write was %s and answered %d times."), State->bSent ? TEXT("sent") : TEXT("never sent"), State->Answers));
+		FinishReconnectTest(*State);
+		return true;
+	}
+
+	if (!State->bSent)
+	{
+		if (Subsystem->GetConnectionState() != ELobbyConnectionState::CONNECTED)
+		{
+			return false;
+		}
+
+		// Chat messages carry an idempotency key, with reconnect enabled they are retained until answered
+		FChatData ChatData;
+		ChatData.SenderPlayerId = TEXT("test-player-0001");
+		ChatData.RecipientPlayerId = TEXT("test-player-0002");
+		ChatData.Message = TEXT("sent once");
+		const TWeakPtr<FLobbyReconnectTestState> WeakState = State;
+		State->RequestId = Subsystem->SendChatMessage(ChatData, FOnLobbyResponseNative::CreateLambda([WeakState](const FLobbyResponse& NewResponse)
+		{
+			if (const TSharedPtr<FLobbyReconnectTestState> PinnedState = WeakState.Pin())
+			{
+				++PinnedState->Answers;
+				PinnedState->Status = NewResponse.Status;
+				PinnedState->AnsweredTime = FPlatformTime::Seconds();
+			}
+		}), 10.f);
+		State->bSent = true;
+
+		// Nothing ticked since the send, the write is still waiting in the batch
+		Subsystem->SimulateConnectionLost();
+		Test->TestTrue(TEXT("The connection waits to reconnect"), Subsystem->GetConnectionState() == ELobbyConnectionState::WAITING_TO_RECONNECT);
+		Subsystem->FlushSendQueue();
+		return false;
+	}
+
+	if (State->Answers == 0 || Now - State->AnsweredTime < DUPLICATE_GRACE_SECONDS)
+	{
+		return false;
+	}
+
+	Test->TestEqual(TEXT("The write is answered once"), State->Answers, 1);
+	Test->TestTrue(TEXT("The write succeeds"), State->Status == ELobbyRequestStatus::SUCCESS);
+	Test->TestEqual(TEXT("The write reaches the server once"), State->Server.GetRequestIdCount(State->RequestId), 1);
+	FinishReconnectTest(*State);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLobbyBatchedWriteReconnectTest, "LobbyClient.Reconnect.BatchedWriteSentOnce",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ProductFilter)
+
+bool FLobbyBatchedWriteReconnectTest::RunTest(const FString& Parameters)
+{
+	const TSharedRef<FLobbyReconnectTestState> State = MakeShared<FLobbyReconnectTestState>();
+	State->GameInstance.Reset(NGG_LOBBY_TESTS::CreateGameInstance());
+	ULobbyGameInstanceSubsystem* Subsystem = State->GameInstance->GetSubsystem<ULobbyGameInstanceSubsystem>();
+	if (!TestNotNull(TEXT("The lobby subsystem"), Subsystem))
+	{
+		NGG_LOBBY_TESTS::ShutdownGameInstance(State->GameInstance);
+		return false;
+	}
+
+	const FJWTConfig& Config = Subsystem->GetJWTConfig();
+	if (!TestTrue(TEXT("The loopback server starts"), State->Server.Start(RECONNECT_TEST_PORT, Config.ClientSecret, Config.ClientId)))
+	{
+		NGG_LOBBY_TESTS::ShutdownGameInstance(State->GameInstance);
+		return false;
+	}
+	State->Server.SetCountRequestIds(true);
+
+	GetSubsystemConfig<FLobbySendBatchConfig>(*Subsystem, TEXT("SendBatchConfig")).bEnabled = true;
+	GetSubsystemConfig<FLobbyReconnectConfig>(*Subsystem, TEXT("ReconnectConfig")).bEnabled = true;
+	State->Deadline = FPlatformTime::Seconds() + 20.0;
+	Subsystem->ConnectToLobbyServer(State->Server.GetURL());
+	ADD_LATENT_AUTOMATION_COMMAND(FLobbyBatchedWriteReconnectCommand(this, State));
+	return true;
+}
+
+#endif
@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "UObject/StrongObjectPtr.h"
+
+/**
+ * Helpers shared by the automation tests of this module
+ */
+namespace NGG_LOBBY_TESTS
+{
+	inline FUtf8StringView ToUtf8(FAnsiStringView NewText)
+	{
+		return FUtf8StringView(reinterpret_cast<const UTF8CHAR*>(NewText.GetData()), NewText.Len());
+	}
+
+	inline FString ToString(FUtf8StringView NewText)
+	{
+		return FString(NewText.Len(), NewText.GetData());
+	}
+
+	/**
+	 * A game instance of its own, so a test never takes over a subsystem the editor or a game is using
+	 */
+	inline UGameInstance* CreateGameInstance()
+	{
+		UGameInstance* R_GameInstance = NewObject<UGameInstance>(GEngine);
+		R_GameInstance->InitializeStandalone();
+		return R_GameInstance;
+	}
+
+	inline void ShutdownGameInstance(TStrongObjectPtr<UGameInstance>& InOutGameInstance)
+	{
+		UWorld* World = InOutGameInstance->GetWorld();
+		InOutGameInstance->Shutdown();
+		if (World != nullptr)
+		{
+			GEngine->DestroyWorldContext(World);
+			World->DestroyWorld(false);
+		}
+		InOutGameInstance.Reset();
+	}
+}